@@ -11,8 +11,15 @@
 //--------------------------------------------------------------------------------------
 #pragma once
 
-#include <sal.h>
+#include <string.h>
 
+// Visual Studio before 2012 has no <atomic>, so keeps the original barriers.
+// Everything else uses C++11 atomics, which also makes the pipe portable.
+#if defined( _XBOX_VER ) || ( defined( _MSC_VER ) && _MSC_VER < 1700 )
+    #define DXUT_LOCKFREEPIPE_BARRIERS
+#endif
+
+#ifdef DXUT_LOCKFREEPIPE_BARRIERS
 #ifdef _XBOX_VER
     // Prevent the CPU from rearranging loads
     // and stores, sufficiently for read-acquire
@@ -37,6 +44,49 @@
     #define DXUTExportBarrier _ReadWriteBarrier
 #endif
 
+typedef volatile unsigned long DXUTPipeOffset;
+
+// Reading a control value and then having a barrier is known as a "read-acquire."
+inline unsigned long DXUTPipeLoadAcquire( const DXUTPipeOffset& offset )
+{
+    unsigned long value = offset;
+    DXUTImportBarrier();
+    return value;
+}
+
+// Having a barrier and then writing a control value is called "write-release."
+inline void DXUTPipeStoreRelease( DXUTPipeOffset& offset, unsigned long value )
+{
+    DXUTExportBarrier();
+    offset = value;
+}
+
+// Only the owning thread writes an offset, so it can read its own offset freely
+inline unsigned long DXUTPipeLoadOwned( const DXUTPipeOffset& offset )
+{
+    return offset;
+}
+#else
+#include <atomic>
+
+typedef std::atomic<unsigned long> DXUTPipeOffset;
+
+inline unsigned long DXUTPipeLoadAcquire( const DXUTPipeOffset& offset )
+{
+    return offset.load( std::memory_order_acquire );
+}
+
+inline void DXUTPipeStoreRelease( DXUTPipeOffset& offset, unsigned long value )
+{
+    offset.store( value, std::memory_order_release );
+}
+
+inline unsigned long DXUTPipeLoadOwned( const DXUTPipeOffset& offset )
+{
+    return offset.load( std::memory_order_relaxed );
+}
+#endif
+
 //
 // Pipe class designed for use by at most two threads: one reader, one writer.
 // Access by more than two threads isn't guaranteed to be safe. 
@@ -45,7 +95,7 @@
 // as a template parameter and restricted to powers of two less than 31.
 //
 
-template <BYTE cbBufferSizeLog2> class DXUTLockFreePipe
+template <unsigned char cbBufferSizeLog2> class DXUTLockFreePipe
 {
 public:
     DXUTLockFreePipe() : m_readOffset( 0 ),
@@ -53,24 +103,29 @@ public:
                          {
                          }
 
-    DWORD                       GetBufferSize() const
+    unsigned long               GetBufferSize() const
     {
         return c_cbBufferSize;
     }
 
-    __forceinline unsigned long BytesAvailable() const
+    inline unsigned long        BytesAvailable() const
     {
-        return m_writeOffset - m_readOffset;
+        return DXUTPipeLoadAcquire( m_writeOffset ) - DXUTPipeLoadAcquire( m_readOffset );
     }
 
-    bool __forceinline          Read( void* pvDest, unsigned long cbDest )
+    inline bool                 Read( void* pvDest, unsigned long cbDest )
     {
         // Store the read and write offsets into local variables--this is
         // essentially a snapshot of their values so that they stay constant
         // for the duration of the function (and so we don't end up with cache 
         // misses due to false sharing).
-        DWORD readOffset = m_readOffset;
-        DWORD writeOffset = m_writeOffset;
+        //
+        // The write offset is loaded with acquire semantics, so that our view of
+        // the data is at least as up to date as the write offset we read. This
+        // prevents the compiler or CPU from moving any of the data reads before
+        // the control value read.
+        unsigned long readOffset = DXUTPipeLoadOwned( m_readOffset );
+        unsigned long writeOffset = DXUTPipeLoadAcquire( m_writeOffset );
 
         // Compare the two offsets to see if we have anything to read.
         // Note that we don't do anything to synchronize the offsets here.
@@ -87,23 +142,12 @@ public:
         // evenly into ULONG_MAX+1. That, and the fact that the offsets are 
         // unsigned, means that the calculation returns correct results even
         // when the values wrap around.
-        DWORD cbAvailable = writeOffset - readOffset;
+        unsigned long cbAvailable = writeOffset - readOffset;
         if( cbDest > cbAvailable )
         {
             return false;
         }
 
-        // The data has been made available, but we need to make sure
-        // that our view on the data is up to date -- at least as up to
-        // date as the control values we just read. We need to prevent
-        // the compiler or CPU from moving any of the data reads before
-        // the control value reads. This import barrier serves this
-        // purpose, on Xbox 360 and on Windows.
-
-        // Reading a control value and then having a barrier is known
-        // as a "read-acquire."
-        DXUTImportBarrier();
-
         unsigned char* pbDest = ( unsigned char* )pvDest;
 
         unsigned long actualReadOffset = readOffset & c_sizeMask;
@@ -118,7 +162,7 @@ public:
         // then the previous comparison would have failed since that would imply
         // that there were less than cbDest bytes available to read.
         //
-        unsigned long cbTailBytes = min( bytesLeft, c_cbBufferSize - actualReadOffset );
+        unsigned long cbTailBytes = MinBytes( bytesLeft, c_cbBufferSize - actualReadOffset );
         memcpy( pbDest, m_pbBuffer + actualReadOffset, cbTailBytes );
         bytesLeft -= cbTailBytes;
 
@@ -132,46 +176,44 @@ public:
         // we don't free the memory before we have finished reading it. That is,
         // we need to make sure that the write to m_readOffset can't get reordered
         // above the reads of the buffer data. The only way to guarantee this is to
-        // have an export barrier to prevent both compiler and CPU rearrangements.
-        DXUTExportBarrier();
-
+        // store it with release semantics to prevent both compiler and CPU
+        // rearrangements.
+        //
         // Advance the read offset. From the CPUs point of view this is several
         // operations--read, modify, store--and we'd normally want to make sure that
         // all of the operations happened atomically. But in the case of a single
         // reader, only one thread updates this value and so the only operation that
-        // must be atomic is the store. That's lucky, because 32-bit aligned stores are
-        // atomic on all modern processors.
+        // must be atomic is the store.
         // 
         readOffset += cbDest;
-        m_readOffset = readOffset;
+        DXUTPipeStoreRelease( m_readOffset, readOffset );
 
         return true;
     }
 
-    bool __forceinline          Write( const void* pvSrc, unsigned long cbSrc )
+    inline bool                 Write( const void* pvSrc, unsigned long cbSrc )
     {
         // Reading the read offset here has the same caveats as reading
         // the write offset had in the Read() function above. 
-        DWORD readOffset = m_readOffset;
-        DWORD writeOffset = m_writeOffset;
+        //
+        // It is theoretically possible for writes of the data to be reordered
+        // above the read to see if the space is available. Improbable perhaps,
+        // but possible. Loading the read offset with acquire semantics
+        // guarantees that the reordering will not happen.
+        unsigned long readOffset = DXUTPipeLoadAcquire( m_readOffset );
+        unsigned long writeOffset = DXUTPipeLoadOwned( m_writeOffset );
 
         // Compute the available write size. This comparison relies on
         // the fact that the buffer size is always a power of 2, and the
         // offsets are unsigned integers, so that when the write pointer
         // wraps around the subtraction still yields a value (assuming
         // we haven't messed up somewhere else) between 0 and c_cbBufferSize - 1.
-        DWORD cbAvailable = c_cbBufferSize - ( writeOffset - readOffset );
+        unsigned long cbAvailable = c_cbBufferSize - ( writeOffset - readOffset );
         if( cbSrc > cbAvailable )
         {
             return false;
         }
 
-        // It is theoretically possible for writes of the data to be reordered
-        // above the reads to see if the data is available. Improbable perhaps,
-        // but possible. This barrier guarantees that the reordering will not
-        // happen.
-        DXUTImportBarrier();
-
         // Write the data
         const unsigned char* pbSrc = ( const unsigned char* )pvSrc;
         unsigned long actualWriteOffset = writeOffset & c_sizeMask;
@@ -179,7 +221,7 @@ public:
 
         // See the explanation in the Read() function as to why we don't 
         // explicitly check against the read offset here.
-        unsigned long cbTailBytes = min( bytesLeft, c_cbBufferSize - actualWriteOffset );
+        unsigned long cbTailBytes = MinBytes( bytesLeft, c_cbBufferSize - actualWriteOffset );
         memcpy( m_pbBuffer + actualWriteOffset, pbSrc, cbTailBytes );
         bytesLeft -= cbTailBytes;
 
@@ -192,25 +234,27 @@ public:
         // of the write offset will imply that there's data to be read, we need to 
         // make sure that the data all actually gets written before the update to
         // the write offset. The writes could be reordered by the compiler (on any
-        // platform) or by the CPU (on Xbox 360). We need a barrier which prevents
-        // the writes from being reordered past each other.
+        // platform) or by the CPU (on Xbox 360). Storing the offset with release
+        // semantics prevents the writes from being reordered past each other.
         //
-        // Having a barrier and then writing a control value is called "write-release."
-        DXUTExportBarrier();
-
         // See comments in Read() as to why this operation isn't interlocked.
         writeOffset += cbSrc;
-        m_writeOffset = writeOffset;
+        DXUTPipeStoreRelease( m_writeOffset, writeOffset );
 
         return true;
     }
 
 private:
+    static inline unsigned long MinBytes( unsigned long a, unsigned long b )
+    {
+        return a < b ? a : b;
+    }
+
     // Values derived from the buffer size template parameter
     //
-    const static BYTE c_cbBufferSizeLog2 = min( cbBufferSizeLog2, 31 );
-    const static DWORD c_cbBufferSize = ( 1 << c_cbBufferSizeLog2 );
-    const static DWORD c_sizeMask = c_cbBufferSize - 1;
+    const static unsigned char c_cbBufferSizeLog2 = cbBufferSizeLog2 < 31 ? cbBufferSizeLog2 : 31;
+    const static unsigned long c_cbBufferSize = ( 1ul << c_cbBufferSizeLog2 );
+    const static unsigned long c_sizeMask = c_cbBufferSize - 1;
 
     // Leave these private and undefined to prevent their use
     DXUTLockFreePipe( const DXUTLockFreePipe& );
@@ -218,10 +262,10 @@ private:
 
     // Member data
     //
-    BYTE                        m_pbBuffer[c_cbBufferSize];
+    unsigned char               m_pbBuffer[c_cbBufferSize];
     // Note that these offsets are not clamped to the buffer size.
     // Instead the calculations rely on wrapping at ULONG_MAX+1.
     // See the comments in Read() for details.
-    volatile DWORD __declspec( align( 4 ) ) m_readOffset;
-    volatile DWORD __declspec( align( 4 ) ) m_writeOffset;
+    DXUTPipeOffset              m_readOffset;
+    DXUTPipeOffset              m_writeOffset;
 };
\ No newline at end of file
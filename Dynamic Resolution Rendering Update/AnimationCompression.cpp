@@ -0,0 +1,382 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "AnimationCompression.h"
+
+#include <math.h>
+#include <string.h>
+
+namespace
+{
+	// AnimationKey as floats
+	const unsigned int cTranslationOffset	= 0;
+	const unsigned int cRotationOffset		= 3;
+	const unsigned int cScaleOffset			= 7;
+	typedef char AnimationKeyIsFloats[ sizeof( AnimationKey ) == 10 * sizeof( float ) ? 1 : -1 ];
+
+	const unsigned int cRotationBytes		= 6;
+	const unsigned int cRotationMax			= 0x7fff;		// 15 bits a component
+	const unsigned int cRangeMax			= 0xffff;		// 16 bits a component
+	const double cWideRangeMax				= 4294967295.0;	// 32 bits a component
+	const float cSqrt2						= 1.41421356f;
+
+	void Append( std::vector<unsigned char>& data, unsigned long long value, unsigned int bytes )
+	{
+		for( unsigned int byte = 0; byte < bytes; ++byte )
+		{
+			data.push_back( (unsigned char)( value >> ( 8 * byte ) ) );
+		}
+	}
+
+	unsigned long long Read( const unsigned char* pData, unsigned int bytes )
+	{
+		unsigned long long value = 0;
+		for( unsigned int byte = 0; byte < bytes; ++byte )
+		{
+			value |= (unsigned long long)pData[ byte ] << ( 8 * byte );
+		}
+		return value;
+	}
+
+	void NormalizeRotation( float* pRotation )
+	{
+		float lengthSq = pRotation[0] * pRotation[0] + pRotation[1] * pRotation[1] + pRotation[2] * pRotation[2] + pRotation[3] * pRotation[3];
+		if( 0.0f == lengthSq )
+		{
+			pRotation[3] = 1.0f;
+			return;
+		}
+		float invLength = 1.0f / sqrtf( lengthSq );
+		for( unsigned int i = 0; i < 4; ++i )
+		{
+			pRotation[i] *= invLength;
+		}
+	}
+
+	bool IsConstant( const AnimationKey* pKeys, unsigned int numKeys, unsigned int offset, unsigned int components )
+	{
+		const float* pFirst = (const float*)&pKeys[0] + offset;
+		for( unsigned int key = 1; key < numKeys; ++key )
+		{
+			if( 0 != memcmp( pFirst, (const float*)&pKeys[key] + offset, components * sizeof( float ) ) )
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Range of a three component part of the keys, returning the largest error 16 bit
+	// quantization across it would give
+	float GetRange( const AnimationKey* pKeys, unsigned int numKeys, unsigned int offset, float* pMin, float* pExtent )
+	{
+		float maxValue[3];
+		for( unsigned int i = 0; i < 3; ++i )
+		{
+			pMin[i] = maxValue[i] = ( (const float*)&pKeys[0] )[ offset + i ];
+		}
+		for( unsigned int key = 1; key < numKeys; ++key )
+		{
+			const float* pValue = (const float*)&pKeys[key] + offset;
+			for( unsigned int i = 0; i < 3; ++i )
+			{
+				pMin[i] = pValue[i] < pMin[i] ? pValue[i] : pMin[i];
+				maxValue[i] = pValue[i] > maxValue[i] ? pValue[i] : maxValue[i];
+			}
+		}
+		float maxExtent = 0.0f;
+		for( unsigned int i = 0; i < 3; ++i )
+		{
+			pExtent[i] = maxValue[i] - pMin[i];
+			maxExtent = pExtent[i] > maxExtent ? pExtent[i] : maxExtent;
+		}
+		return 0.5f * maxExtent / cRangeMax;
+	}
+
+	void EncodeRange( std::vector<unsigned char>& data, const float* pValue, const float* pMin, const float* pExtent, bool bWide )
+	{
+		for( unsigned int i = 0; i < 3; ++i )
+		{
+			double normalized = pExtent[i] > 0.0f ? ( (double)pValue[i] - pMin[i] ) / pExtent[i] : 0.0;
+			normalized = normalized < 0.0 ? 0.0 : ( normalized > 1.0 ? 1.0 : normalized );
+			if( bWide )
+			{
+				Append( data, (unsigned long long)( normalized * cWideRangeMax + 0.5 ), 4 );
+			}
+			else
+			{
+				Append( data, (unsigned long long)( normalized * cRangeMax + 0.5 ), 2 );
+			}
+		}
+	}
+
+	const unsigned char* DecodeRange( const unsigned char* pData, const float* pMin, const float* pExtent, bool bWide, float* pValue )
+	{
+		for( unsigned int i = 0; i < 3; ++i )
+		{
+			if( bWide )
+			{
+				pValue[i] = pMin[i] + (float)( Read( pData, 4 ) * ( pExtent[i] / cWideRangeMax ) );
+				pData += 4;
+			}
+			else
+			{
+				pValue[i] = pMin[i] + (float)Read( pData, 2 ) * ( pExtent[i] / cRangeMax );
+				pData += 2;
+			}
+		}
+		return pData;
+	}
+
+	// Smallest three: q and -q are the same rotation, so the largest component is made
+	// positive and rebuilt from the others, which are then within +-1/sqrt(2)
+	void EncodeRotation( std::vector<unsigned char>& data, const float* pRotation )
+	{
+		unsigned int largest = 0;
+		for( unsigned int i = 1; i < 4; ++i )
+		{
+			largest = fabsf( pRotation[i] ) > fabsf( pRotation[largest] ) ? i : largest;
+		}
+		float sign = pRotation[largest] < 0.0f ? -1.0f : 1.0f;
+
+		unsigned long long value = largest;
+		unsigned int shift = 2;
+		for( unsigned int i = 0; i < 4; ++i )
+		{
+			if( i == largest )
+			{
+				continue;
+			}
+			float normalized = sign * pRotation[i] * cSqrt2 * 0.5f + 0.5f;
+			normalized = normalized < 0.0f ? 0.0f : ( normalized > 1.0f ? 1.0f : normalized );
+			value |= (unsigned long long)( normalized * cRotationMax + 0.5f ) << shift;
+			shift += 15;
+		}
+		Append( data, value, cRotationBytes );
+	}
+
+	void DecodeRotation( const unsigned char* pData, float* pRotation )
+	{
+		unsigned long long value = Read( pData, cRotationBytes );
+		unsigned int largest = (unsigned int)( value & 3 );
+		unsigned int shift = 2;
+		float sumSq = 0.0f;
+		for( unsigned int i = 0; i < 4; ++i )
+		{
+			if( i == largest )
+			{
+				continue;
+			}
+			float component = (float)( ( value >> shift ) & cRotationMax ) * ( cSqrt2 / cRotationMax ) - 0.5f * cSqrt2;
+			pRotation[i] = component;
+			sumSq += component * component;
+			shift += 15;
+		}
+		if( sumSq < 1.0f )
+		{
+			pRotation[ largest ] = sqrtf( 1.0f - sumSq );
+		}
+		else
+		{
+			// only from quantization of a largest component near zero
+			pRotation[ largest ] = 0.0f;
+			NormalizeRotation( pRotation );
+		}
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Ctor
+//--------------------------------------------------------------------------------------
+CompressedAnimation::CompressedAnimation()
+	: m_pKeyData( NULL )
+{
+}
+
+//--------------------------------------------------------------------------------------
+// Compress keys. Parts which are exactly the same in every key are stored once.
+//--------------------------------------------------------------------------------------
+void CompressedAnimation::Compress( unsigned int numTracks, unsigned int numKeys, unsigned int fps, unsigned int frameTransformType,
+								    const char* const* ppNames, const AnimationKey* pKeys, float maxError )
+{
+	Clear();
+	if( 0 == numKeys )
+	{
+		return;
+	}
+
+	std::vector<CompressedAnimationTrack> tracks( numTracks );
+	std::vector<AnimationKey> trackKeys( numKeys );
+	std::vector<unsigned char> keyData;
+	for( unsigned int track = 0; track < numTracks; ++track )
+	{
+		for( unsigned int key = 0; key < numKeys; ++key )
+		{
+			trackKeys[ key ] = pKeys[ track * numKeys + key ];
+			NormalizeRotation( trackKeys[ key ].rotation );
+		}
+
+		CompressedAnimationTrack& rTrack = tracks[ track ];
+		memset( &rTrack, 0, sizeof( rTrack ) );
+		strncpy( rTrack.name, ppNames[ track ], cCompressedAnimationNameLength - 1 );
+
+		float translationError = GetRange( &trackKeys[0], numKeys, cTranslationOffset, rTrack.translationMin, rTrack.translationExtent );
+		float scaleError = GetRange( &trackKeys[0], numKeys, cScaleOffset, rTrack.scaleMin, rTrack.scaleExtent );
+		memcpy( rTrack.rotation, trackKeys[0].rotation, sizeof( rTrack.rotation ) );
+
+		if( !IsConstant( &trackKeys[0], numKeys, cTranslationOffset, 3 ) )
+		{
+			rTrack.flags |= COMPRESSED_TRACK_KEYED_TRANSLATION;
+			rTrack.flags |= translationError > maxError ? COMPRESSED_TRACK_WIDE_TRANSLATION : 0;
+			rTrack.keySize += translationError > maxError ? 12 : 6;
+		}
+		if( !IsConstant( &trackKeys[0], numKeys, cRotationOffset, 4 ) )
+		{
+			rTrack.flags |= COMPRESSED_TRACK_KEYED_ROTATION;
+			rTrack.keySize += cRotationBytes;
+		}
+		if( !IsConstant( &trackKeys[0], numKeys, cScaleOffset, 3 ) )
+		{
+			rTrack.flags |= COMPRESSED_TRACK_KEYED_SCALE;
+			rTrack.flags |= scaleError > maxError ? COMPRESSED_TRACK_WIDE_SCALE : 0;
+			rTrack.keySize += scaleError > maxError ? 12 : 6;
+		}
+
+		rTrack.keyOffset = (unsigned int)keyData.size();
+		if( 0 == rTrack.keySize )
+		{
+			continue;
+		}
+		for( unsigned int key = 0; key < numKeys; ++key )
+		{
+			const AnimationKey& rKey = trackKeys[ key ];
+			if( rTrack.flags & COMPRESSED_TRACK_KEYED_TRANSLATION )
+			{
+				EncodeRange( keyData, rKey.translation, rTrack.translationMin, rTrack.translationExtent, 0 != ( rTrack.flags & COMPRESSED_TRACK_WIDE_TRANSLATION ) );
+			}
+			if( rTrack.flags & COMPRESSED_TRACK_KEYED_ROTATION )
+			{
+				EncodeRotation( keyData, rKey.rotation );
+			}
+			if( rTrack.flags & COMPRESSED_TRACK_KEYED_SCALE )
+			{
+				EncodeRange( keyData, rKey.scale, rTrack.scaleMin, rTrack.scaleExtent, 0 != ( rTrack.flags & COMPRESSED_TRACK_WIDE_SCALE ) );
+			}
+		}
+	}
+
+	CompressedAnimationFileHeader header;
+	header.magic				= cCompressedAnimationMagic;
+	header.version				= cCompressedAnimationVersion;
+	header.numTracks			= numTracks;
+	header.numKeys				= numKeys;
+	header.fps					= fps;
+	header.frameTransformType	= frameTransformType;
+	header.keyDataSize			= (unsigned int)keyData.size();
+
+	m_Data.resize( sizeof( header ) + numTracks * sizeof( CompressedAnimationTrack ) + keyData.size() );
+	memcpy( &m_Data[0], &header, sizeof( header ) );
+	if( numTracks )
+	{
+		memcpy( &m_Data[ sizeof( header ) ], &tracks[0], numTracks * sizeof( CompressedAnimationTrack ) );
+	}
+	if( !keyData.empty() )
+	{
+		memcpy( &m_Data[ m_Data.size() - keyData.size() ], &keyData[0], keyData.size() );
+	}
+	m_pKeyData = &m_Data[0] + sizeof( header ) + numTracks * sizeof( CompressedAnimationTrack );
+}
+
+//--------------------------------------------------------------------------------------
+// Copy in file data, checking every track's keys are within it
+//--------------------------------------------------------------------------------------
+bool CompressedAnimation::SetData( const unsigned char* pData, size_t size )
+{
+	Clear();
+
+	CompressedAnimationFileHeader header;
+	if( !pData || size < sizeof( header ) )
+	{
+		return false;
+	}
+	memcpy( &header, pData, sizeof( header ) );
+	size_t keyDataStart = sizeof( header ) + (size_t)header.numTracks * sizeof( CompressedAnimationTrack );
+	if( cCompressedAnimationMagic != header.magic || cCompressedAnimationVersion != header.version
+		|| 0 == header.numKeys || keyDataStart + header.keyDataSize > size )
+	{
+		return false;
+	}
+
+	const CompressedAnimationTrack* pTracks = (const CompressedAnimationTrack*)( pData + sizeof( header ) );
+	for( unsigned int track = 0; track < header.numTracks; ++track )
+	{
+		const CompressedAnimationTrack& rTrack = pTracks[ track ];
+		unsigned int flags = rTrack.flags;
+		unsigned int keySize = ( flags & COMPRESSED_TRACK_KEYED_TRANSLATION ? ( flags & COMPRESSED_TRACK_WIDE_TRANSLATION ? 12 : 6 ) : 0 )
+			+ ( flags & COMPRESSED_TRACK_KEYED_ROTATION ? cRotationBytes : 0 )
+			+ ( flags & COMPRESSED_TRACK_KEYED_SCALE ? ( flags & COMPRESSED_TRACK_WIDE_SCALE ? 12 : 6 ) : 0 );
+		if( keySize != rTrack.keySize || rTrack.keyOffset + (unsigned long long)keySize * header.numKeys > header.keyDataSize )
+		{
+			return false;
+		}
+	}
+
+	m_Data.assign( pData, pData + keyDataStart + header.keyDataSize );
+	m_pKeyData = &m_Data[0] + keyDataStart;
+	return true;
+}
+
+void CompressedAnimation::Clear()
+{
+	m_Data.clear();
+	m_pKeyData = NULL;
+}
+
+//--------------------------------------------------------------------------------------
+// Decode a key, reading only that key's bytes
+//--------------------------------------------------------------------------------------
+void CompressedAnimation::DecodeKey( unsigned int track, unsigned int key, AnimationKey* pKey ) const
+{
+	const CompressedAnimationTrack& rTrack = GetTrack( track );
+	const unsigned char* pData = m_pKeyData + rTrack.keyOffset + key * rTrack.keySize;
+
+	if( rTrack.flags & COMPRESSED_TRACK_KEYED_TRANSLATION )
+	{
+		pData = DecodeRange( pData, rTrack.translationMin, rTrack.translationExtent, 0 != ( rTrack.flags & COMPRESSED_TRACK_WIDE_TRANSLATION ), pKey->translation );
+	}
+	else
+	{
+		memcpy( pKey->translation, rTrack.translationMin, sizeof( pKey->translation ) );
+	}
+
+	if( rTrack.flags & COMPRESSED_TRACK_KEYED_ROTATION )
+	{
+		DecodeRotation( pData, pKey->rotation );
+		pData += cRotationBytes;
+	}
+	else
+	{
+		memcpy( pKey->rotation, rTrack.rotation, sizeof( pKey->rotation ) );
+	}
+
+	if( rTrack.flags & COMPRESSED_TRACK_KEYED_SCALE )
+	{
+		DecodeRange( pData, rTrack.scaleMin, rTrack.scaleExtent, 0 != ( rTrack.flags & COMPRESSED_TRACK_WIDE_SCALE ), pKey->scale );
+	}
+	else
+	{
+		memcpy( pKey->scale, rTrack.scaleMin, sizeof( pKey->scale ) );
+	}
+}
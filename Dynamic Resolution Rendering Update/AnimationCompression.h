@@ -0,0 +1,155 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Note: like ResolutionController.h this file has no D3D or DXUT dependencies, so
+// animations can be compressed offline on any platform.
+
+#include <stddef.h>
+#include <vector>
+
+//--------------------------------------------------------------------------------------
+// Compressed animation file format, little endian, written by the AnimationCompressor
+// tool from .sdkmesh_anim files:
+//   CompressedAnimationFileHeader, then numTracks CompressedAnimationTrack, then
+//   keyDataSize bytes of keys.
+//
+// A track's translation, rotation and scale are each either constant, stored once in
+// the track, or keyed. A keyed track stores its keys consecutively, each key holding
+// only its keyed parts, in the order translation, rotation, scale:
+// - rotations are smallest three quaternions, the index of the largest component in
+//   2 bits and the other three in 15 bits each, 6 bytes
+// - translations and scales are quantized across the track's range, 16 bits a
+//   component, or 32 where 16 would exceed the error the tool was given
+//--------------------------------------------------------------------------------------
+const unsigned int	cCompressedAnimationMagic		= 0x4d4e4143;	// 'CANM'
+const unsigned int	cCompressedAnimationVersion		= 1;
+const unsigned int	cCompressedAnimationNameLength	= 100;			// SDKMesh's MAX_FRAME_NAME
+
+struct CompressedAnimationFileHeader
+{
+	unsigned int	magic;
+	unsigned int	version;
+	unsigned int	numTracks;
+	unsigned int	numKeys;
+	unsigned int	fps;
+	unsigned int	frameTransformType;
+	unsigned int	keyDataSize;
+};
+
+// CompressedAnimationTrack::flags
+enum COMPRESSED_TRACK_FLAGS
+{
+	COMPRESSED_TRACK_KEYED_TRANSLATION	= 0x01,
+	COMPRESSED_TRACK_KEYED_ROTATION		= 0x02,
+	COMPRESSED_TRACK_KEYED_SCALE		= 0x04,
+	COMPRESSED_TRACK_WIDE_TRANSLATION	= 0x08,	// 32 bits a component
+	COMPRESSED_TRACK_WIDE_SCALE			= 0x10,	// 32 bits a component
+};
+
+struct CompressedAnimationTrack
+{
+	char			name[ cCompressedAnimationNameLength ];
+	unsigned int	flags;					// COMPRESSED_TRACK_FLAGS
+	float			translationMin[3];		// the translation when constant
+	float			translationExtent[3];	// max - min
+	float			rotation[4];			// the rotation when constant, x, y, z, w
+	float			scaleMin[3];			// the scale when constant
+	float			scaleExtent[3];
+	unsigned int	keyOffset;				// of the first key in the key data
+	unsigned int	keySize;				// bytes a key, 0 when constant
+};
+
+//--------------------------------------------------------------------------------------
+// An uncompressed key, laid out as SDKANIMATION_DATA. All zero rotations, which SDKMesh
+// uses for no rotation, are compressed as the identity.
+//--------------------------------------------------------------------------------------
+struct AnimationKey
+{
+	float	translation[3];
+	float	rotation[4];
+	float	scale[3];
+};
+
+//--------------------------------------------------------------------------------------
+// Compressed animation in memory, in the file format, so it is held as loaded. Keys
+// are decoded individually, so sampling decodes only the two either side of the time.
+//--------------------------------------------------------------------------------------
+class CompressedAnimation
+{
+public:
+	CompressedAnimation();
+
+	// Compress numTracks tracks of numKeys keys, each track's keys consecutive in
+	// pKeys. maxError is the largest translation or scale error allowed before a track
+	// uses 32 bits a component.
+	void	Compress( unsigned int numTracks, unsigned int numKeys, unsigned int fps, unsigned int frameTransformType,
+					  const char* const* ppNames, const AnimationKey* pKeys, float maxError );
+
+	// Copy in file data, returning false if it is not a valid compressed animation
+	bool	SetData( const unsigned char* pData, size_t size );
+	void	Clear();
+
+	const unsigned char*	GetData() const
+	{
+		return m_Data.empty() ? NULL : &m_Data[0];
+	}
+	size_t					GetDataSize() const
+	{
+		return m_Data.size();
+	}
+
+	bool			IsValid() const
+	{
+		return !m_Data.empty();
+	}
+	unsigned int	GetNumTracks() const
+	{
+		return IsValid() ? GetHeader().numTracks : 0;
+	}
+	unsigned int	GetNumKeys() const
+	{
+		return IsValid() ? GetHeader().numKeys : 0;
+	}
+	unsigned int	GetFPS() const
+	{
+		return IsValid() ? GetHeader().fps : 0;
+	}
+	unsigned int	GetFrameTransformType() const
+	{
+		return IsValid() ? GetHeader().frameTransformType : 0;
+	}
+	const CompressedAnimationTrack& GetTrack( unsigned int track ) const
+	{
+		return ( (const CompressedAnimationTrack*)( &m_Data[0] + sizeof( CompressedAnimationFileHeader ) ) )[ track ];
+	}
+
+	// Decode one key of a track, the rotation normalized
+	void	DecodeKey( unsigned int track, unsigned int key, AnimationKey* pKey ) const;
+
+private:
+	const CompressedAnimationFileHeader& GetHeader() const
+	{
+		return *(const CompressedAnimationFileHeader*)&m_Data[0];
+	}
+
+	std::vector<unsigned char>	m_Data;
+	const unsigned char*		m_pKeyData;
+
+	//prevent assign and copy
+	CompressedAnimation( const CompressedAnimation& rhs );
+	CompressedAnimation& operator=( const CompressedAnimation& rhs );
+};
@@ -0,0 +1,321 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------
+// Animation compressor.
+//
+// Converts an .sdkmesh_anim file to the compressed format of AnimationCompression.h,
+// which CDXUTSDKMeshExt loads for animation files named .sdkmesh_canim. Reports the
+// compression ratio, the largest errors, and the rate keys are sampled from the raw
+// and compressed formats.
+//--------------------------------------------------------------------------------------
+
+#include "AnimationCompression.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+	// .sdkmesh_anim layout, see SDKANIMATION_FILE_HEADER and SDKANIMATION_FRAME_DATA in
+	// SDKmesh.h. Read by offset, as the tool is built without D3D and the structures
+	// have padding.
+	const size_t cRawHeaderSize				= 40;
+	const size_t cRawHeaderNumFrames		= 12;
+	const size_t cRawHeaderNumKeys			= 16;
+	const size_t cRawHeaderFPS				= 20;
+	const size_t cRawHeaderTransformType	= 8;
+	const size_t cRawHeaderDataOffset		= 32;
+	const size_t cRawFrameDataSize			= 112;
+	const size_t cRawFrameDataOffset		= 104;
+
+	const unsigned int cBenchmarkSamples	= 20000;
+
+	struct RawAnimation
+	{
+		size_t						fileSize;
+		unsigned int				numTracks;
+		unsigned int				numKeys;
+		unsigned int				fps;
+		unsigned int				frameTransformType;
+		std::vector<std::string>	names;
+		std::vector<AnimationKey>	keys;		// by track, then key
+	};
+
+	unsigned int ReadUInt( const std::vector<unsigned char>& data, size_t offset )
+	{
+		unsigned int value;
+		memcpy( &value, &data[ offset ], sizeof( value ) );
+		return value;
+	}
+
+	unsigned long long ReadUInt64( const std::vector<unsigned char>& data, size_t offset )
+	{
+		unsigned long long value;
+		memcpy( &value, &data[ offset ], sizeof( value ) );
+		return value;
+	}
+
+	bool LoadRawAnimation( const char* pFilename, RawAnimation& animation )
+	{
+		FILE* pFile = fopen( pFilename, "rb" );
+		if( !pFile )
+		{
+			return false;
+		}
+		std::vector<unsigned char> data;
+		unsigned char buffer[ 4096 ];
+		size_t bytesRead;
+		while( 0 != ( bytesRead = fread( buffer, 1, sizeof( buffer ), pFile ) ) )
+		{
+			data.insert( data.end(), buffer, buffer + bytesRead );
+		}
+		fclose( pFile );
+
+		if( data.size() < cRawHeaderSize )
+		{
+			return false;
+		}
+		animation.fileSize				= data.size();
+		animation.numTracks				= ReadUInt( data, cRawHeaderNumFrames );
+		animation.numKeys				= ReadUInt( data, cRawHeaderNumKeys );
+		animation.fps					= ReadUInt( data, cRawHeaderFPS );
+		animation.frameTransformType	= ReadUInt( data, cRawHeaderTransformType );
+		unsigned long long frameDataOffset = ReadUInt64( data, cRawHeaderDataOffset );
+		if( 0 == animation.numKeys || frameDataOffset + (unsigned long long)animation.numTracks * cRawFrameDataSize > data.size() )
+		{
+			return false;
+		}
+
+		animation.names.resize( animation.numTracks );
+		animation.keys.resize( (size_t)animation.numTracks * animation.numKeys );
+		for( unsigned int track = 0; track < animation.numTracks; ++track )
+		{
+			size_t frameData = (size_t)frameDataOffset + track * cRawFrameDataSize;
+			char name[ cCompressedAnimationNameLength + 1 ] = { 0 };
+			memcpy( name, &data[ frameData ], cCompressedAnimationNameLength );
+			animation.names[ track ] = name;
+
+			// key offsets are from the end of the header
+			unsigned long long keyOffset = cRawHeaderSize + ReadUInt64( data, frameData + cRawFrameDataOffset );
+			if( keyOffset + (unsigned long long)animation.numKeys * sizeof( AnimationKey ) > data.size() )
+			{
+				return false;
+			}
+			memcpy( &animation.keys[ (size_t)track * animation.numKeys ], &data[ (size_t)keyOffset ], animation.numKeys * sizeof( AnimationKey ) );
+		}
+		return true;
+	}
+
+	// Largest translation and scale differences, and rotation angle in degrees, between
+	// the raw keys and the decoded compressed keys
+	void PrintErrors( const RawAnimation& raw, const CompressedAnimation& compressed )
+	{
+		float maxTranslationError = 0.0f;
+		float maxRotationError = 0.0f;
+		float maxScaleError = 0.0f;
+		for( unsigned int track = 0; track < raw.numTracks; ++track )
+		{
+			for( unsigned int key = 0; key < raw.numKeys; ++key )
+			{
+				const AnimationKey& rRaw = raw.keys[ (size_t)track * raw.numKeys + key ];
+				AnimationKey decoded;
+				compressed.DecodeKey( track, key, &decoded );
+
+				// from the distance between the unit quaternions rather than their dot
+				// product, as acos near 1 loses the small angles being measured
+				double rawRotation[4] = { rRaw.rotation[0], rRaw.rotation[1], rRaw.rotation[2], rRaw.rotation[3] };
+				double decodedRotation[4] = { decoded.rotation[0], decoded.rotation[1], decoded.rotation[2], decoded.rotation[3] };
+				double rawLengthSq = 0.0;
+				double decodedLengthSq = 0.0;
+				for( unsigned int i = 0; i < 4; ++i )
+				{
+					rawLengthSq += rawRotation[i] * rawRotation[i];
+					decodedLengthSq += decodedRotation[i] * decodedRotation[i];
+				}
+				if( 0.0 == rawLengthSq )
+				{
+					rawRotation[3] = rawLengthSq = 1.0;
+				}
+				double differenceSq = 0.0;
+				double sumSq = 0.0;
+				for( unsigned int i = 0; i < 4; ++i )
+				{
+					double a = rawRotation[i] / sqrt( rawLengthSq );
+					double b = decodedRotation[i] / sqrt( decodedLengthSq );
+					differenceSq += ( a - b ) * ( a - b );
+					sumSq += ( a + b ) * ( a + b );
+				}
+				double distance = sqrt( differenceSq < sumSq ? differenceSq : sumSq );
+				float angle = (float)( 4.0 * asin( 0.5 * distance ) * 57.29577951 );
+				maxRotationError = angle > maxRotationError ? angle : maxRotationError;
+
+				for( unsigned int i = 0; i < 3; ++i )
+				{
+					float translationError = fabsf( decoded.translation[i] - rRaw.translation[i] );
+					float scaleError = fabsf( decoded.scale[i] - rRaw.scale[i] );
+					maxTranslationError = translationError > maxTranslationError ? translationError : maxTranslationError;
+					maxScaleError = scaleError > maxScaleError ? scaleError : maxScaleError;
+				}
+			}
+		}
+		printf( "Max error: translation %g, rotation %g degrees, scale %g\n", maxTranslationError, maxRotationError, maxScaleError );
+	}
+
+	// Sample every track at evenly spaced times, fetching the two keys either side
+	// as the mesh does, and print the keys fetched per microsecond
+	void PrintSamplingRates( const RawAnimation& raw, const CompressedAnimation& compressed )
+	{
+		float checksum = 0.0f;
+		double rawSeconds = 0.0;
+		double compressedSeconds = 0.0;
+		for( int pass = 0; pass < 2; ++pass )
+		{
+			clock_t start = clock();
+			for( unsigned int sample = 0; sample < cBenchmarkSamples; ++sample )
+			{
+				unsigned int keyPrev = ( sample * 7 ) % raw.numKeys;
+				unsigned int keyNext = ( keyPrev + 1 ) % raw.numKeys;
+				for( unsigned int track = 0; track < raw.numTracks; ++track )
+				{
+					AnimationKey prev, next;
+					if( 0 == pass )
+					{
+						prev = raw.keys[ (size_t)track * raw.numKeys + keyPrev ];
+						next = raw.keys[ (size_t)track * raw.numKeys + keyNext ];
+					}
+					else
+					{
+						compressed.DecodeKey( track, keyPrev, &prev );
+						compressed.DecodeKey( track, keyNext, &next );
+					}
+					checksum += prev.translation[0] + next.rotation[3];
+				}
+			}
+			double seconds = (double)( clock() - start ) / CLOCKS_PER_SEC;
+			( 0 == pass ? rawSeconds : compressedSeconds ) = seconds;
+		}
+
+		double keys = 2.0 * cBenchmarkSamples * raw.numTracks;
+		printf( "Sampling (keys/us): raw %.1f, compressed %.1f (checksum %g)\n",
+				rawSeconds > 0.0 ? keys / rawSeconds * 1.0e-6 : 0.0,
+				compressedSeconds > 0.0 ? keys / compressedSeconds * 1.0e-6 : 0.0, checksum );
+	}
+
+	void PrintUsage()
+	{
+		printf( "Usage: AnimationCompressor [options] input.sdkmesh_anim [output.sdkmesh_canim]\n"
+				"Options:\n"
+				"  -e <error>                                        largest translation or scale error\n"
+				"                                                    before 32 bit quantization, default 0.01\n"
+				"Without an output file the compression is only reported.\n" );
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Main function
+//--------------------------------------------------------------------------------------
+int main( int argc, char* argv[] )
+{
+	const char* pInputName = NULL;
+	const char* pOutputName = NULL;
+	float maxError = 0.01f;
+
+	for( int arg = 1; arg < argc; ++arg )
+	{
+		if( 0 == strcmp( argv[arg], "-e" ) && arg + 1 < argc )
+		{
+			maxError = (float)atof( argv[ ++arg ] );
+		}
+		else if( '-' == argv[arg][0] )
+		{
+			PrintUsage();
+			return 1;
+		}
+		else if( !pInputName )
+		{
+			pInputName = argv[arg];
+		}
+		else if( !pOutputName )
+		{
+			pOutputName = argv[arg];
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	if( !pInputName )
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	RawAnimation raw;
+	if( !LoadRawAnimation( pInputName, raw ) )
+	{
+		printf( "Failed to load animation %s\n", pInputName );
+		return 1;
+	}
+
+	std::vector<const char*> names( raw.numTracks );
+	for( unsigned int track = 0; track < raw.numTracks; ++track )
+	{
+		names[ track ] = raw.names[ track ].c_str();
+	}
+	CompressedAnimation compressed;
+	compressed.Compress( raw.numTracks, raw.numKeys, raw.fps, raw.frameTransformType,
+						 raw.numTracks ? &names[0] : NULL, raw.keys.empty() ? NULL : &raw.keys[0], maxError );
+
+	printf( "%s: %u tracks of %u keys\n", pInputName, raw.numTracks, raw.numKeys );
+	for( unsigned int track = 0; track < raw.numTracks; ++track )
+	{
+		const CompressedAnimationTrack& rTrack = compressed.GetTrack( track );
+		printf( "  %-32s translation %-8s rotation %-8s scale %-8s %u bytes a key\n", rTrack.name,
+				rTrack.flags & COMPRESSED_TRACK_KEYED_TRANSLATION ? ( rTrack.flags & COMPRESSED_TRACK_WIDE_TRANSLATION ? "32 bit" : "16 bit" ) : "constant",
+				rTrack.flags & COMPRESSED_TRACK_KEYED_ROTATION ? "48 bit" : "constant",
+				rTrack.flags & COMPRESSED_TRACK_KEYED_SCALE ? ( rTrack.flags & COMPRESSED_TRACK_WIDE_SCALE ? "32 bit" : "16 bit" ) : "constant",
+				rTrack.keySize );
+	}
+	printf( "Size: raw %u bytes, compressed %u bytes, ratio %.1f:1\n", (unsigned int)raw.fileSize,
+			(unsigned int)compressed.GetDataSize(), (double)raw.fileSize / compressed.GetDataSize() );
+	PrintErrors( raw, compressed );
+	PrintSamplingRates( raw, compressed );
+
+	if( pOutputName )
+	{
+		FILE* pOutput = fopen( pOutputName, "wb" );
+		if( !pOutput || 1 != fwrite( compressed.GetData(), compressed.GetDataSize(), 1, pOutput ) )
+		{
+			printf( "Failed to write %s\n", pOutputName );
+			if( pOutput )
+			{
+				fclose( pOutput );
+			}
+			return 1;
+		}
+		fclose( pOutput );
+		printf( "Written to %s\n", pOutputName );
+	}
+	return 0;
+}
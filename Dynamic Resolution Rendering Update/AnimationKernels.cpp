@@ -0,0 +1,399 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "AnimationKernels.h"
+
+#include <math.h>
+#if ANIMATION_KERNELS_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+	// Above this cosine of the angle between quaternions slerp falls back to nlerp, which
+	// differs from it by less than 1e-6 there, and the slerp weights lose precision
+	const float cSlerpNlerpThreshold = 0.9995f;
+
+	// acos( x ) for x in [0, 1], Abramowitz and Stegun 4.4.46, error below 2e-8
+	const float cAcos0 = 1.5707963050f;
+	const float cAcos1 = -0.2145988016f;
+	const float cAcos2 = 0.0889789874f;
+	const float cAcos3 = -0.0501743046f;
+	const float cAcos4 = 0.0308918810f;
+	const float cAcos5 = -0.0170881256f;
+	const float cAcos6 = 0.0066700901f;
+	const float cAcos7 = -0.0012624911f;
+
+	// sin( x ) for x in [0, pi/2], Taylor series to x^11, error below 6e-8
+	const float cSin3 = -1.0f / 6.0f;
+	const float cSin5 = 1.0f / 120.0f;
+	const float cSin7 = -1.0f / 5040.0f;
+	const float cSin9 = 1.0f / 362880.0f;
+	const float cSin11 = -1.0f / 39916800.0f;
+
+	float AcosUnit( float x )
+	{
+		float p = cAcos7;
+		p = p * x + cAcos6;
+		p = p * x + cAcos5;
+		p = p * x + cAcos4;
+		p = p * x + cAcos3;
+		p = p * x + cAcos2;
+		p = p * x + cAcos1;
+		p = p * x + cAcos0;
+		return sqrtf( 1.0f - x ) * p;
+	}
+
+	float SinHalfPi( float x )
+	{
+		float x2 = x * x;
+		float p = cSin11;
+		p = p * x2 + cSin9;
+		p = p * x2 + cSin7;
+		p = p * x2 + cSin5;
+		p = p * x2 + cSin3;
+		return x + x * x2 * p;
+	}
+
+	Vector3Streams Offset( const Vector3Streams& v, unsigned int offset )
+	{
+		Vector3Streams result = { v.x + offset, v.y + offset, v.z + offset };
+		return result;
+	}
+
+	QuaternionStreams Offset( const QuaternionStreams& q, unsigned int offset )
+	{
+		QuaternionStreams result = { q.x + offset, q.y + offset, q.z + offset, q.w + offset };
+		return result;
+	}
+
+	// Weights of a and b for interpolating between unit quaternions with the given cosine
+	void SlerpWeights( float cosAngle, float t, float* pWeightA, float* pWeightB )
+	{
+		float sign = 1.0f;
+		if( cosAngle < 0.0f )
+		{
+			// take the shorter arc by interpolating to -b
+			cosAngle = -cosAngle;
+			sign = -1.0f;
+		}
+		if( cosAngle > cSlerpNlerpThreshold )
+		{
+			*pWeightA = 1.0f - t;
+			*pWeightB = sign * t;
+			return;
+		}
+		float angle = AcosUnit( cosAngle );
+		float invSin = 1.0f / sqrtf( 1.0f - cosAngle * cosAngle );
+		*pWeightA = SinHalfPi( ( 1.0f - t ) * angle ) * invSin;
+		*pWeightB = sign * SinHalfPi( t * angle ) * invSin;
+	}
+
+	void BlendQuaternionsScalar( unsigned int count, float t, const QuaternionStreams& a, const QuaternionStreams& b, const QuaternionStreams& out, bool bSlerp )
+	{
+		for( unsigned int i = 0; i < count; ++i )
+		{
+			float cosAngle = a.x[i] * b.x[i] + a.y[i] * b.y[i] + a.z[i] * b.z[i] + a.w[i] * b.w[i];
+			float weightA, weightB;
+			if( bSlerp )
+			{
+				SlerpWeights( cosAngle, t, &weightA, &weightB );
+			}
+			else
+			{
+				weightA = 1.0f - t;
+				weightB = cosAngle < 0.0f ? -t : t;
+			}
+			out.x[i] = weightA * a.x[i] + weightB * b.x[i];
+			out.y[i] = weightA * a.y[i] + weightB * b.y[i];
+			out.z[i] = weightA * a.z[i] + weightB * b.z[i];
+			out.w[i] = weightA * a.w[i] + weightB * b.w[i];
+		}
+		NormalizeQuaternionsScalar( count, out );
+	}
+
+#if ANIMATION_KERNELS_SSE
+	__m128 Select( __m128 mask, __m128 ifTrue, __m128 ifFalse )
+	{
+		return _mm_or_ps( _mm_and_ps( mask, ifTrue ), _mm_andnot_ps( mask, ifFalse ) );
+	}
+
+	__m128 AcosUnit( __m128 x )
+	{
+		__m128 p = _mm_set1_ps( cAcos7 );
+		p = _mm_add_ps( _mm_mul_ps( p, x ), _mm_set1_ps( cAcos6 ) );
+		p = _mm_add_ps( _mm_mul_ps( p, x ), _mm_set1_ps( cAcos5 ) );
+		p = _mm_add_ps( _mm_mul_ps( p, x ), _mm_set1_ps( cAcos4 ) );
+		p = _mm_add_ps( _mm_mul_ps( p, x ), _mm_set1_ps( cAcos3 ) );
+		p = _mm_add_ps( _mm_mul_ps( p, x ), _mm_set1_ps( cAcos2 ) );
+		p = _mm_add_ps( _mm_mul_ps( p, x ), _mm_set1_ps( cAcos1 ) );
+		p = _mm_add_ps( _mm_mul_ps( p, x ), _mm_set1_ps( cAcos0 ) );
+		return _mm_mul_ps( _mm_sqrt_ps( _mm_sub_ps( _mm_set1_ps( 1.0f ), x ) ), p );
+	}
+
+	__m128 SinHalfPi( __m128 x )
+	{
+		__m128 x2 = _mm_mul_ps( x, x );
+		__m128 p = _mm_set1_ps( cSin11 );
+		p = _mm_add_ps( _mm_mul_ps( p, x2 ), _mm_set1_ps( cSin9 ) );
+		p = _mm_add_ps( _mm_mul_ps( p, x2 ), _mm_set1_ps( cSin7 ) );
+		p = _mm_add_ps( _mm_mul_ps( p, x2 ), _mm_set1_ps( cSin5 ) );
+		p = _mm_add_ps( _mm_mul_ps( p, x2 ), _mm_set1_ps( cSin3 ) );
+		return _mm_add_ps( x, _mm_mul_ps( _mm_mul_ps( x, x2 ), p ) );
+	}
+
+	// Normalizes four quaternions, all zero quaternions becoming the identity
+	void Normalize( __m128& x, __m128& y, __m128& z, __m128& w )
+	{
+		__m128 lengthSq = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, x ), _mm_mul_ps( y, y ) ),
+			_mm_add_ps( _mm_mul_ps( z, z ), _mm_mul_ps( w, w ) ) );
+		__m128 zero = _mm_setzero_ps();
+		__m128 isZero = _mm_cmpeq_ps( lengthSq, zero );
+		__m128 invLength = _mm_div_ps( _mm_set1_ps( 1.0f ), _mm_sqrt_ps( lengthSq ) );
+		x = _mm_andnot_ps( isZero, _mm_mul_ps( x, invLength ) );
+		y = _mm_andnot_ps( isZero, _mm_mul_ps( y, invLength ) );
+		z = _mm_andnot_ps( isZero, _mm_mul_ps( z, invLength ) );
+		w = Select( isZero, _mm_set1_ps( 1.0f ), _mm_mul_ps( w, invLength ) );
+	}
+
+	void BlendQuaternions( unsigned int count, float t, const QuaternionStreams& a, const QuaternionStreams& b, const QuaternionStreams& out, bool bSlerp )
+	{
+		const __m128 signBit = _mm_set1_ps( -0.0f );
+		const __m128 one = _mm_set1_ps( 1.0f );
+		const __m128 vt = _mm_set1_ps( t );
+		const __m128 vOneMinusT = _mm_set1_ps( 1.0f - t );
+		unsigned int i = 0;
+		for( ; i + 4 <= count; i += 4 )
+		{
+			__m128 ax = _mm_loadu_ps( a.x + i ), ay = _mm_loadu_ps( a.y + i ), az = _mm_loadu_ps( a.z + i ), aw = _mm_loadu_ps( a.w + i );
+			__m128 bx = _mm_loadu_ps( b.x + i ), by = _mm_loadu_ps( b.y + i ), bz = _mm_loadu_ps( b.z + i ), bw = _mm_loadu_ps( b.w + i );
+			__m128 cosAngle = _mm_add_ps( _mm_add_ps( _mm_mul_ps( ax, bx ), _mm_mul_ps( ay, by ) ),
+				_mm_add_ps( _mm_mul_ps( az, bz ), _mm_mul_ps( aw, bw ) ) );
+
+			// take the shorter arc by interpolating to -b
+			__m128 sign = _mm_and_ps( cosAngle, signBit );
+			cosAngle = _mm_xor_ps( cosAngle, sign );
+
+			__m128 weightA = vOneMinusT;
+			__m128 weightB = vt;
+			if( bSlerp )
+			{
+				// lanes near enough for nlerp may produce NaN here, but are not selected
+				__m128 angle = AcosUnit( cosAngle );
+				__m128 invSin = _mm_div_ps( one, _mm_sqrt_ps( _mm_sub_ps( one, _mm_mul_ps( cosAngle, cosAngle ) ) ) );
+				__m128 useNlerp = _mm_cmpgt_ps( cosAngle, _mm_set1_ps( cSlerpNlerpThreshold ) );
+				weightA = Select( useNlerp, weightA, _mm_mul_ps( SinHalfPi( _mm_mul_ps( vOneMinusT, angle ) ), invSin ) );
+				weightB = Select( useNlerp, weightB, _mm_mul_ps( SinHalfPi( _mm_mul_ps( vt, angle ) ), invSin ) );
+			}
+			weightB = _mm_xor_ps( weightB, sign );
+
+			__m128 x = _mm_add_ps( _mm_mul_ps( weightA, ax ), _mm_mul_ps( weightB, bx ) );
+			__m128 y = _mm_add_ps( _mm_mul_ps( weightA, ay ), _mm_mul_ps( weightB, by ) );
+			__m128 z = _mm_add_ps( _mm_mul_ps( weightA, az ), _mm_mul_ps( weightB, bz ) );
+			__m128 w = _mm_add_ps( _mm_mul_ps( weightA, aw ), _mm_mul_ps( weightB, bw ) );
+			Normalize( x, y, z, w );
+			_mm_storeu_ps( out.x + i, x );
+			_mm_storeu_ps( out.y + i, y );
+			_mm_storeu_ps( out.z + i, z );
+			_mm_storeu_ps( out.w + i, w );
+		}
+		BlendQuaternionsScalar( count - i, t, Offset( a, i ), Offset( b, i ), Offset( out, i ), bSlerp );
+	}
+#endif
+}
+
+//--------------------------------------------------------------------------------------
+// Scalar kernels
+//--------------------------------------------------------------------------------------
+void NormalizeQuaternionsScalar( unsigned int count, const QuaternionStreams& q )
+{
+	for( unsigned int i = 0; i < count; ++i )
+	{
+		float lengthSq = q.x[i] * q.x[i] + q.y[i] * q.y[i] + q.z[i] * q.z[i] + q.w[i] * q.w[i];
+		if( 0.0f == lengthSq )
+		{
+			q.w[i] = 1.0f;
+			continue;
+		}
+		float invLength = 1.0f / sqrtf( lengthSq );
+		q.x[i] *= invLength;
+		q.y[i] *= invLength;
+		q.z[i] *= invLength;
+		q.w[i] *= invLength;
+	}
+}
+
+void LerpVector3sScalar( unsigned int count, float t, const Vector3Streams& a, const Vector3Streams& b, const Vector3Streams& out )
+{
+	float oneMinusT = 1.0f - t;
+	for( unsigned int i = 0; i < count; ++i )
+	{
+		out.x[i] = oneMinusT * a.x[i] + t * b.x[i];
+		out.y[i] = oneMinusT * a.y[i] + t * b.y[i];
+		out.z[i] = oneMinusT * a.z[i] + t * b.z[i];
+	}
+}
+
+void NlerpQuaternionsScalar( unsigned int count, float t, const QuaternionStreams& a, const QuaternionStreams& b, const QuaternionStreams& out )
+{
+	BlendQuaternionsScalar( count, t, a, b, out, false );
+}
+
+void SlerpQuaternionsScalar( unsigned int count, float t, const QuaternionStreams& a, const QuaternionStreams& b, const QuaternionStreams& out )
+{
+	BlendQuaternionsScalar( count, t, a, b, out, true );
+}
+
+void ComposeAffineTransformsScalar( unsigned int count, const Vector3Streams& scale, const QuaternionStreams& rotation, const Vector3Streams& translation, float* pOut )
+{
+	for( unsigned int i = 0; i < count; ++i, pOut += cAffineTransformFloats )
+	{
+		float x = rotation.x[i], y = rotation.y[i], z = rotation.z[i], w = rotation.w[i];
+		float xx = x * x, yy = y * y, zz = z * z;
+		float xy = x * y, xz = x * z, yz = y * z;
+		float xw = x * w, yw = y * w, zw = z * w;
+
+		pOut[0]		= scale.x[i] * ( 1.0f - 2.0f * ( yy + zz ) );
+		pOut[1]		= scale.x[i] * 2.0f * ( xy + zw );
+		pOut[2]		= scale.x[i] * 2.0f * ( xz - yw );
+		pOut[3]		= scale.y[i] * 2.0f * ( xy - zw );
+		pOut[4]		= scale.y[i] * ( 1.0f - 2.0f * ( xx + zz ) );
+		pOut[5]		= scale.y[i] * 2.0f * ( yz + xw );
+		pOut[6]		= scale.z[i] * 2.0f * ( xz + yw );
+		pOut[7]		= scale.z[i] * 2.0f * ( yz - xw );
+		pOut[8]		= scale.z[i] * ( 1.0f - 2.0f * ( xx + yy ) );
+		pOut[9]		= translation.x[i];
+		pOut[10]	= translation.y[i];
+		pOut[11]	= translation.z[i];
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// SSE kernels, four tracks at a time with the remainder done by the scalar kernels
+//--------------------------------------------------------------------------------------
+#if ANIMATION_KERNELS_SSE
+void NormalizeQuaternions( unsigned int count, const QuaternionStreams& q )
+{
+	unsigned int i = 0;
+	for( ; i + 4 <= count; i += 4 )
+	{
+		__m128 x = _mm_loadu_ps( q.x + i ), y = _mm_loadu_ps( q.y + i ), z = _mm_loadu_ps( q.z + i ), w = _mm_loadu_ps( q.w + i );
+		Normalize( x, y, z, w );
+		_mm_storeu_ps( q.x + i, x );
+		_mm_storeu_ps( q.y + i, y );
+		_mm_storeu_ps( q.z + i, z );
+		_mm_storeu_ps( q.w + i, w );
+	}
+	NormalizeQuaternionsScalar( count - i, Offset( q, i ) );
+}
+
+void LerpVector3s( unsigned int count, float t, const Vector3Streams& a, const Vector3Streams& b, const Vector3Streams& out )
+{
+	const __m128 vt = _mm_set1_ps( t );
+	const __m128 vOneMinusT = _mm_set1_ps( 1.0f - t );
+	unsigned int i = 0;
+	for( ; i + 4 <= count; i += 4 )
+	{
+		_mm_storeu_ps( out.x + i, _mm_add_ps( _mm_mul_ps( vOneMinusT, _mm_loadu_ps( a.x + i ) ), _mm_mul_ps( vt, _mm_loadu_ps( b.x + i ) ) ) );
+		_mm_storeu_ps( out.y + i, _mm_add_ps( _mm_mul_ps( vOneMinusT, _mm_loadu_ps( a.y + i ) ), _mm_mul_ps( vt, _mm_loadu_ps( b.y + i ) ) ) );
+		_mm_storeu_ps( out.z + i, _mm_add_ps( _mm_mul_ps( vOneMinusT, _mm_loadu_ps( a.z + i ) ), _mm_mul_ps( vt, _mm_loadu_ps( b.z + i ) ) ) );
+	}
+	LerpVector3sScalar( count - i, t, Offset( a, i ), Offset( b, i ), Offset( out, i ) );
+}
+
+void NlerpQuaternions( unsigned int count, float t, const QuaternionStreams& a, const QuaternionStreams& b, const QuaternionStreams& out )
+{
+	BlendQuaternions( count, t, a, b, out, false );
+}
+
+void SlerpQuaternions( unsigned int count, float t, const QuaternionStreams& a, const QuaternionStreams& b, const QuaternionStreams& out )
+{
+	BlendQuaternions( count, t, a, b, out, true );
+}
+
+void ComposeAffineTransforms( unsigned int count, const Vector3Streams& scale, const QuaternionStreams& rotation, const Vector3Streams& translation, float* pOut )
+{
+	const __m128 one = _mm_set1_ps( 1.0f );
+	const __m128 two = _mm_set1_ps( 2.0f );
+	unsigned int i = 0;
+	for( ; i + 4 <= count; i += 4, pOut += 4 * cAffineTransformFloats )
+	{
+		__m128 x = _mm_loadu_ps( rotation.x + i ), y = _mm_loadu_ps( rotation.y + i ), z = _mm_loadu_ps( rotation.z + i ), w = _mm_loadu_ps( rotation.w + i );
+		__m128 sx = _mm_loadu_ps( scale.x + i ), sy = _mm_loadu_ps( scale.y + i ), sz = _mm_loadu_ps( scale.z + i );
+		__m128 xx = _mm_mul_ps( x, x ), yy = _mm_mul_ps( y, y ), zz = _mm_mul_ps( z, z );
+		__m128 xy = _mm_mul_ps( x, y ), xz = _mm_mul_ps( x, z ), yz = _mm_mul_ps( y, z );
+		__m128 xw = _mm_mul_ps( x, w ), yw = _mm_mul_ps( y, w ), zw = _mm_mul_ps( z, w );
+
+		// one register per matrix element, each holding four tracks
+		__m128 m0 = _mm_mul_ps( sx, _mm_sub_ps( one, _mm_mul_ps( two, _mm_add_ps( yy, zz ) ) ) );
+		__m128 m1 = _mm_mul_ps( sx, _mm_mul_ps( two, _mm_add_ps( xy, zw ) ) );
+		__m128 m2 = _mm_mul_ps( sx, _mm_mul_ps( two, _mm_sub_ps( xz, yw ) ) );
+		__m128 m3 = _mm_mul_ps( sy, _mm_mul_ps( two, _mm_sub_ps( xy, zw ) ) );
+		__m128 m4 = _mm_mul_ps( sy, _mm_sub_ps( one, _mm_mul_ps( two, _mm_add_ps( xx, zz ) ) ) );
+		__m128 m5 = _mm_mul_ps( sy, _mm_mul_ps( two, _mm_add_ps( yz, xw ) ) );
+		__m128 m6 = _mm_mul_ps( sz, _mm_mul_ps( two, _mm_add_ps( xz, yw ) ) );
+		__m128 m7 = _mm_mul_ps( sz, _mm_mul_ps( two, _mm_sub_ps( yz, xw ) ) );
+		__m128 m8 = _mm_mul_ps( sz, _mm_sub_ps( one, _mm_mul_ps( two, _mm_add_ps( xx, yy ) ) ) );
+		__m128 m9 = _mm_loadu_ps( translation.x + i );
+		__m128 m10 = _mm_loadu_ps( translation.y + i );
+		__m128 m11 = _mm_loadu_ps( translation.z + i );
+
+		// transpose each group of four elements into the four tracks' transforms
+		_MM_TRANSPOSE4_PS( m0, m1, m2, m3 );
+		_MM_TRANSPOSE4_PS( m4, m5, m6, m7 );
+		_MM_TRANSPOSE4_PS( m8, m9, m10, m11 );
+		_mm_storeu_ps( pOut + 0, m0 );
+		_mm_storeu_ps( pOut + 4, m4 );
+		_mm_storeu_ps( pOut + 8, m8 );
+		_mm_storeu_ps( pOut + 12, m1 );
+		_mm_storeu_ps( pOut + 16, m5 );
+		_mm_storeu_ps( pOut + 20, m9 );
+		_mm_storeu_ps( pOut + 24, m2 );
+		_mm_storeu_ps( pOut + 28, m6 );
+		_mm_storeu_ps( pOut + 32, m10 );
+		_mm_storeu_ps( pOut + 36, m3 );
+		_mm_storeu_ps( pOut + 40, m7 );
+		_mm_storeu_ps( pOut + 44, m11 );
+	}
+	ComposeAffineTransformsScalar( count - i, Offset( scale, i ), Offset( rotation, i ), Offset( translation, i ), pOut );
+}
+
+#else
+
+void NormalizeQuaternions( unsigned int count, const QuaternionStreams& q )
+{
+	NormalizeQuaternionsScalar( count, q );
+}
+
+void LerpVector3s( unsigned int count, float t, const Vector3Streams& a, const Vector3Streams& b, const Vector3Streams& out )
+{
+	LerpVector3sScalar( count, t, a, b, out );
+}
+
+void NlerpQuaternions( unsigned int count, float t, const QuaternionStreams& a, const QuaternionStreams& b, const QuaternionStreams& out )
+{
+	NlerpQuaternionsScalar( count, t, a, b, out );
+}
+
+void SlerpQuaternions( unsigned int count, float t, const QuaternionStreams& a, const QuaternionStreams& b, const QuaternionStreams& out )
+{
+	SlerpQuaternionsScalar( count, t, a, b, out );
+}
+
+void ComposeAffineTransforms( unsigned int count, const Vector3Streams& scale, const QuaternionStreams& rotation, const Vector3Streams& translation, float* pOut )
+{
+	ComposeAffineTransformsScalar( count, scale, rotation, translation, pOut );
+}
+#endif
@@ -0,0 +1,77 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Note: like ResolutionController.h this file has no D3D or DXUT dependencies.
+
+//--------------------------------------------------------------------------------------
+// Batch kernels for sampling animation keyframes. Tracks are stored as structure of
+// arrays, one float stream per component, so the kernels process four tracks at a time
+// with SSE. The scalar versions are the fallback where SSE is not available, and the
+// reference the SSE versions are checked against. Streams need no alignment and
+// count need not be a multiple of four.
+//
+// Conventions follow D3DX: quaternions are x, y, z, w, and matrices transform row
+// vectors, so a composed transform is scale * rotation * translation.
+//--------------------------------------------------------------------------------------
+#if defined( _M_IX86 ) || defined( _M_X64 ) || defined( __SSE2__ )
+#define ANIMATION_KERNELS_SSE 1
+#else
+#define ANIMATION_KERNELS_SSE 0
+#endif
+
+struct Vector3Streams
+{
+	float*	x;
+	float*	y;
+	float*	z;
+};
+
+struct QuaternionStreams
+{
+	float*	x;
+	float*	y;
+	float*	z;
+	float*	w;
+};
+
+// Floats written per transform by ComposeAffineTransforms(), four rows of three columns:
+// the scaled x, y and z axes, then the translation. The fourth column is 0, 0, 0, 1.
+const unsigned int cAffineTransformFloats = 12;
+
+// Normalize quaternions in place. All zero quaternions, which SDKMesh animation uses for
+// no rotation, become the identity.
+void NormalizeQuaternions( unsigned int count, const QuaternionStreams& q );
+void NormalizeQuaternionsScalar( unsigned int count, const QuaternionStreams& q );
+
+// out = ( 1 - t ) * a + t * b, out may be a or b
+void LerpVector3s( unsigned int count, float t, const Vector3Streams& a, const Vector3Streams& b, const Vector3Streams& out );
+void LerpVector3sScalar( unsigned int count, float t, const Vector3Streams& a, const Vector3Streams& b, const Vector3Streams& out );
+
+// Normalized linear interpolation along the shorter arc, for unit a and b, out may be a or b
+void NlerpQuaternions( unsigned int count, float t, const QuaternionStreams& a, const QuaternionStreams& b, const QuaternionStreams& out );
+void NlerpQuaternionsScalar( unsigned int count, float t, const QuaternionStreams& a, const QuaternionStreams& b, const QuaternionStreams& out );
+
+// Spherical linear interpolation along the shorter arc, for unit a and b, matching
+// D3DXQuaternionSlerp() to within about 1e-6. The angle uses polynomial acos and sin,
+// and nearly equal quaternions fall back to nlerp. Results are normalized, out may be a or b.
+void SlerpQuaternions( unsigned int count, float t, const QuaternionStreams& a, const QuaternionStreams& b, const QuaternionStreams& out );
+void SlerpQuaternionsScalar( unsigned int count, float t, const QuaternionStreams& a, const QuaternionStreams& b, const QuaternionStreams& out );
+
+// Compose scale * rotation * translation for unit rotations, writing count transforms
+// of cAffineTransformFloats each to pOut
+void ComposeAffineTransforms( unsigned int count, const Vector3Streams& scale, const QuaternionStreams& rotation, const Vector3Streams& translation, float* pOut );
+void ComposeAffineTransformsScalar( unsigned int count, const Vector3Streams& scale, const QuaternionStreams& rotation, const Vector3Streams& translation, float* pOut );
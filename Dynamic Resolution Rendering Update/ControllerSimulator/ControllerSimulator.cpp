@@ -0,0 +1,572 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------
+// Offline resolution controller simulator.
+//
+// Replays recorded frame time traces through the same controllers and DynamicResolution
+// logic as the sample, modelling GPU cost as a function of the simulated viewport pixel
+// count, and reports deadline miss rate, scale oscillation, settle time and average
+// pixel count. No GPU is required.
+//
+// Trace formats:
+//   CSV:    one frame per line: gpuFrameInnerWorkTime,cpuFrameTime[,viewportWidth,viewportHeight]
+//           times in seconds, lines which do not start with a number are ignored.
+//   Binary: TraceFileHeader followed by TraceFileHeader::numRecords TraceRecords.
+//           If the viewport size is 0 the frame is assumed to be at back buffer size.
+//--------------------------------------------------------------------------------------
+
+#include "ResolutionController.h"
+#include "DynamicResolution.h"
+#include "FrameCostModel.h"
+#include "StreamingStats.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <vector>
+
+namespace
+{
+	const unsigned int	cTraceMagic		= 0x52544644;	// 'DFTR'
+	const unsigned int	cTraceVersion	= 1;
+
+	struct TraceFileHeader
+	{
+		unsigned int	magic;
+		unsigned int	version;
+		unsigned int	numRecords;
+		unsigned int	reserved;
+	};
+
+	struct TraceRecord
+	{
+		float			gpuFrameInnerWorkTime;
+		float			cpuFrameTime;
+		unsigned int	viewportWidth;
+		unsigned int	viewportHeight;
+	};
+
+	//--------------------------------------------------------------------------------------
+	// Simulation settings, set from the command line
+	//--------------------------------------------------------------------------------------
+	struct SimulationSettings
+	{
+		SimulationSettings()
+			: backBufferWidth( 1280 )
+			, backBufferHeight( 720 )
+			, targetFrameRate( 60.0f )
+			, scaleMin( 0.3f )
+			, scaleMax( 1 )
+			, fixedCostFraction( 0.2f )
+			, gpuAverageCount( 10 )
+			, settleFrames( 30 )
+			, tileSize( 0 )
+			, cpuPercentile( -1.0f )
+		{
+		}
+
+		unsigned int	backBufferWidth;
+		unsigned int	backBufferHeight;
+		float			targetFrameRate;
+		float			scaleMin;
+		unsigned int	scaleMax;
+		float			fixedCostFraction;	// fraction of GPU time at back buffer size which does not scale with pixels
+		unsigned int	gpuAverageCount;	// frames averaged by the GPU timer, as GPUProfiler
+		unsigned int	settleFrames;		// frames without a miss before the controller counts as settled
+		unsigned int	tileSize;			// resolution ladder tile size, 0 for none
+		float			cpuPercentile;		// CPU frame time percentile to control on, < 0 for the 1 second average
+	};
+
+	//--------------------------------------------------------------------------------------
+	// Results of one controller run over a trace
+	//--------------------------------------------------------------------------------------
+	struct SimulationResults
+	{
+		unsigned int	numFrames;
+		unsigned int	numMisses;
+		double			meanAbsScaleChange;
+		unsigned int	numDirectionReversals;
+		unsigned int	numSettleEvents;
+		double			meanSettleFrames;
+		unsigned int	maxSettleFrames;
+		unsigned int	numUnsettledEvents;
+		double			averagePixelCount;
+	};
+
+	//--------------------------------------------------------------------------------------
+	// Trace loading
+	//--------------------------------------------------------------------------------------
+	bool LoadCSVTrace( const char* pFilename, std::vector<TraceRecord>& trace )
+	{
+		FILE* pFile = fopen( pFilename, "r" );
+		if( !pFile )
+		{
+			return false;
+		}
+
+		char line[512];
+		while( fgets( line, sizeof( line ), pFile ) )
+		{
+			const char* pStart = line;
+			while( ' ' == *pStart || '\t' == *pStart )
+			{
+				++pStart;
+			}
+			if( !( ( *pStart >= '0' && *pStart <= '9' ) || '.' == *pStart ) )
+			{
+				// header, comment or empty line
+				continue;
+			}
+
+			float values[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+			int numValues = 0;
+			char* pCurr = (char*)pStart;
+			while( numValues < 4 )
+			{
+				char* pEnd = NULL;
+				values[ numValues ] = (float)strtod( pCurr, &pEnd );
+				if( pEnd == pCurr )
+				{
+					break;
+				}
+				++numValues;
+				pCurr = pEnd;
+				while( ',' == *pCurr || ' ' == *pCurr || '\t' == *pCurr )
+				{
+					++pCurr;
+				}
+			}
+			if( numValues < 2 )
+			{
+				continue;
+			}
+
+			TraceRecord record;
+			record.gpuFrameInnerWorkTime	= values[0];
+			record.cpuFrameTime				= values[1];
+			record.viewportWidth			= numValues >= 4 ? (unsigned int)values[2] : 0;
+			record.viewportHeight			= numValues >= 4 ? (unsigned int)values[3] : 0;
+			trace.push_back( record );
+		}
+
+		fclose( pFile );
+		return true;
+	}
+
+	bool LoadBinaryTrace( const char* pFilename, std::vector<TraceRecord>& trace )
+	{
+		FILE* pFile = fopen( pFilename, "rb" );
+		if( !pFile )
+		{
+			return false;
+		}
+
+		TraceFileHeader header;
+		bool bValid = 1 == fread( &header, sizeof( header ), 1, pFile ) &&
+					  cTraceMagic == header.magic &&
+					  cTraceVersion == header.version;
+
+		// the record count comes from the file, so check it against the bytes actually
+		// present before sizing the trace from it
+		if( bValid )
+		{
+			long recordsStart = ftell( pFile );
+			bValid = 0 <= recordsStart && 0 == fseek( pFile, 0, SEEK_END );
+			long fileLength = bValid ? ftell( pFile ) : -1;
+			bValid = bValid && recordsStart <= fileLength &&
+					 header.numRecords <= ( size_t )( fileLength - recordsStart ) / sizeof( TraceRecord ) &&
+					 0 == fseek( pFile, recordsStart, SEEK_SET );
+			if( !bValid )
+			{
+				fprintf( stderr, "%s: record count %u does not match the file length\n", pFilename, header.numRecords );
+			}
+		}
+
+		if( bValid && header.numRecords )
+		{
+			size_t offset = trace.size();
+			trace.resize( offset + header.numRecords );
+			size_t numRead = fread( &trace[ offset ], sizeof( TraceRecord ), header.numRecords, pFile );
+			trace.resize( offset + numRead );
+		}
+
+		fclose( pFile );
+		return bValid;
+	}
+
+	bool HasExtension( const char* pFilename, const char* pExtension )
+	{
+		size_t length = strlen( pFilename );
+		size_t extensionLength = strlen( pExtension );
+		if( length <= extensionLength )
+		{
+			return false;
+		}
+		const char* pEnd = pFilename + length - extensionLength;
+		for( size_t i = 0; i < extensionLength; ++i )
+		{
+			if( tolower( ( unsigned char )pEnd[ i ] ) != tolower( ( unsigned char )pExtension[ i ] ) )
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool LoadTrace( const char* pFilename, std::vector<TraceRecord>& trace )
+	{
+		if( HasExtension( pFilename, ".csv" ) )
+		{
+			return LoadCSVTrace( pFilename, trace );
+		}
+		return LoadBinaryTrace( pFilename, trace );
+	}
+
+	//--------------------------------------------------------------------------------------
+	// GPU cost model: t = work * ( fixed + ( 1 - fixed ) * pixels / backBufferPixels ).
+	// The recorded time and pixel count give the per frame work, which is then used to
+	// predict the time at the simulated pixel count.
+	//--------------------------------------------------------------------------------------
+	float SimulateGPUTime( const TraceRecord& record, float simulatedPixels, const SimulationSettings& settings )
+	{
+		float backBufferPixels = (float)settings.backBufferWidth * (float)settings.backBufferHeight;
+		float recordedPixels = backBufferPixels;
+		if( record.viewportWidth && record.viewportHeight )
+		{
+			recordedPixels = (float)record.viewportWidth * (float)record.viewportHeight;
+		}
+
+		float fixed = settings.fixedCostFraction;
+		float recordedCost = fixed + ( 1.0f - fixed ) * recordedPixels / backBufferPixels;
+		float simulatedCost = fixed + ( 1.0f - fixed ) * simulatedPixels / backBufferPixels;
+		return record.gpuFrameInnerWorkTime * simulatedCost / recordedCost;
+	}
+
+	//--------------------------------------------------------------------------------------
+	// Run a single controller over the trace, mirroring ControlResolution().
+	// pCostModel, if not NULL, is fed each time the averaged GPU time updates.
+	//--------------------------------------------------------------------------------------
+	SimulationResults Simulate( IResolutionController* pController, FrameCostModel* pCostModel, const std::vector<TraceRecord>& trace, const SimulationSettings& settings )
+	{
+		SimulationResults results;
+		memset( &results, 0, sizeof( results ) );
+
+		DynamicResolution dynamicResolution;
+		dynamicResolution.SetTileSize( settings.tileSize );
+		dynamicResolution.InitializeResolutionParameters( settings.backBufferWidth, settings.backBufferHeight, 8192, 8192, settings.scaleMax );
+		dynamicResolution.SetScale( 1.0f, 1.0f );
+
+		float controlledScale = 1.0f;
+		pController->Reset( controlledScale );
+		if( pCostModel )
+		{
+			pCostModel->Reset();
+		}
+
+		const float targetTime = 1.0f / settings.targetFrameRate;
+
+		// GPU timer state, block averaged as GPUProfiler::GetAveragedTime()
+		float gpuAveragedTime = 0.0f;
+		float gpuAccumulatingTime = 0.0f;
+		double gpuAccumulatingPixels = 0.0;
+		unsigned int gpuNumAccumulations = 0;
+
+		// CPU frame time state, updated about once a second as DXUTGetFPS(), or per frame statistics
+		float cpuFrameTime = targetTime;
+		float fpsAccumulatedTime = 0.0f;
+		unsigned int fpsNumFrames = 0;
+		StreamingStats frameTimeStats( 120 );
+
+		double sumAbsScaleChange = 0.0;
+		double sumPixels = 0.0;
+		float prevScaleDelta = 0.0f;
+		bool bInEvent = false;
+		unsigned int eventStart = 0;
+		unsigned int framesSinceMiss = 0;
+		double sumSettleFrames = 0.0;
+
+		for( size_t frame = 0; frame < trace.size(); ++frame )
+		{
+			const TraceRecord& record = trace[ frame ];
+
+			D3D11_VIEWPORT viewport;
+			dynamicResolution.GetViewport( &viewport );
+			float pixels = viewport.Width * viewport.Height;
+			sumPixels += pixels;
+
+			float gpuTime = SimulateGPUTime( record, pixels, settings );
+			float frameTime = gpuTime > record.cpuFrameTime ? gpuTime : record.cpuFrameTime;
+
+			// deadline and settle tracking
+			bool bMiss = frameTime > targetTime;
+			if( bMiss )
+			{
+				++results.numMisses;
+				framesSinceMiss = 0;
+				if( !bInEvent )
+				{
+					bInEvent = true;
+					eventStart = (unsigned int)frame;
+				}
+			}
+			else
+			{
+				++framesSinceMiss;
+				if( bInEvent && framesSinceMiss >= settings.settleFrames )
+				{
+					unsigned int settle = (unsigned int)frame + 1 - settings.settleFrames - eventStart;
+					sumSettleFrames += settle;
+					if( settle > results.maxSettleFrames )
+					{
+						results.maxSettleFrames = settle;
+					}
+					++results.numSettleEvents;
+					bInEvent = false;
+				}
+			}
+
+			// measurement, with the same latency characteristics as the sample
+			gpuAccumulatingTime += gpuTime;
+			gpuAccumulatingPixels += pixels;
+			if( ++gpuNumAccumulations >= settings.gpuAverageCount )
+			{
+				gpuAveragedTime = gpuAccumulatingTime / (float)gpuNumAccumulations;
+				if( pCostModel )
+				{
+					pCostModel->AddSample( (float)( gpuAccumulatingPixels / gpuNumAccumulations ), &gpuAveragedTime );
+				}
+				gpuAccumulatingTime = 0.0f;
+				gpuAccumulatingPixels = 0.0;
+				gpuNumAccumulations = 0;
+			}
+			if( settings.cpuPercentile < 0.0f )
+			{
+				fpsAccumulatedTime += frameTime;
+				++fpsNumFrames;
+				if( fpsAccumulatedTime > 1.0f )
+				{
+					cpuFrameTime = fpsAccumulatedTime / (float)fpsNumFrames;
+					fpsAccumulatedTime = 0.0f;
+					fpsNumFrames = 0;
+				}
+			}
+			else
+			{
+				frameTimeStats.AddSample( frameTime );
+				cpuFrameTime = frameTimeStats.GetPercentile( settings.cpuPercentile );
+			}
+
+			// control, as ControlResolution()
+			ResolutionControlInput input;
+			input.controlTime	= CalculateControlTime( gpuAveragedTime, cpuFrameTime );
+			input.targetTime	= targetTime;
+			input.currentScale	= controlledScale;
+			input.scaleMin		= settings.scaleMin;
+			input.scaleMax		= (float)settings.scaleMax;
+			input.scalePixelCount	= (float)settings.backBufferWidth * (float)settings.backBufferHeight;
+			input.shadedPixelCost	= 0.0f;	// traces have no pipeline statistics
+			input.overdraw			= 0.0f;
+			float newScale = pController->Update( input );
+
+			float scaleDelta = newScale - controlledScale;
+			sumAbsScaleChange += fabs( scaleDelta );
+			if( scaleDelta * prevScaleDelta < 0.0f )
+			{
+				++results.numDirectionReversals;
+			}
+			if( 0.0f != scaleDelta )
+			{
+				prevScaleDelta = scaleDelta;
+			}
+
+			controlledScale = newScale;
+			dynamicResolution.SetScale( controlledScale, controlledScale );
+		}
+
+		if( bInEvent )
+		{
+			++results.numUnsettledEvents;
+		}
+
+		results.numFrames = (unsigned int)trace.size();
+		if( results.numFrames )
+		{
+			results.meanAbsScaleChange	= sumAbsScaleChange / results.numFrames;
+			results.averagePixelCount	= sumPixels / results.numFrames;
+		}
+		if( results.numSettleEvents )
+		{
+			results.meanSettleFrames = sumSettleFrames / results.numSettleEvents;
+		}
+		return results;
+	}
+
+	void PrintResults( const wchar_t* pName, const SimulationResults& results, const SimulationSettings& settings )
+	{
+		float frameTimeMs = 1000.0f / settings.targetFrameRate;
+		float backBufferPixels = (float)settings.backBufferWidth * (float)settings.backBufferHeight;
+		printf( "%-14ls %9.3f%% %12.5f %10u %10.1f %10.1f %10u %12.0f (%5.1f%%)\n",
+				pName,
+				results.numFrames ? 100.0 * results.numMisses / results.numFrames : 0.0,
+				results.meanAbsScaleChange,
+				results.numDirectionReversals,
+				results.meanSettleFrames * frameTimeMs,
+				results.maxSettleFrames * frameTimeMs,
+				results.numUnsettledEvents,
+				results.averagePixelCount,
+				100.0 * results.averagePixelCount / backBufferPixels );
+	}
+
+	void PrintUsage()
+	{
+		printf( "Usage: ControllerSimulator [options] trace.csv|trace.bin [more traces]\n"
+				"Options:\n"
+				"  -controller <proportional|pid|deadband|slew|predictive|all>  (default all)\n"
+				"  -fps <target frame rate>                          (default 60)\n"
+				"  -size <width> <height>                            back buffer size (default 1280 720)\n"
+				"  -scalemin <min scale>                             (default 0.3)\n"
+				"  -scalemax <1..2>                                  (default 1)\n"
+				"  -fixed <fraction>                                 GPU time not scaling with pixels (default 0.2)\n"
+				"  -average <frames>                                 GPU timer averaging (default 10)\n"
+				"  -settle <frames>                                  frames without a miss to settle (default 30)\n"
+				"  -tile <pixels>                                    resolution ladder tile size (default 0, off)\n"
+				"  -cpupercentile <0..100>                           control on a percentile of the last 120 frame times\n"
+				"                                                    instead of the 1 second average FPS\n" );
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Main function
+//--------------------------------------------------------------------------------------
+int main( int argc, char* argv[] )
+{
+	SimulationSettings settings;
+	const char* pControllerName = "all";
+	std::vector<TraceRecord> trace;
+
+	for( int arg = 1; arg < argc; ++arg )
+	{
+		bool bHasValue = arg + 1 < argc;
+		if( 0 == strcmp( argv[arg], "-controller" ) && bHasValue )
+		{
+			pControllerName = argv[++arg];
+		}
+		else if( 0 == strcmp( argv[arg], "-fps" ) && bHasValue )
+		{
+			settings.targetFrameRate = (float)atof( argv[++arg] );
+		}
+		else if( 0 == strcmp( argv[arg], "-size" ) && arg + 2 < argc )
+		{
+			settings.backBufferWidth = (unsigned int)atoi( argv[++arg] );
+			settings.backBufferHeight = (unsigned int)atoi( argv[++arg] );
+		}
+		else if( 0 == strcmp( argv[arg], "-scalemin" ) && bHasValue )
+		{
+			settings.scaleMin = (float)atof( argv[++arg] );
+		}
+		else if( 0 == strcmp( argv[arg], "-scalemax" ) && bHasValue )
+		{
+			settings.scaleMax = (unsigned int)atoi( argv[++arg] );
+		}
+		else if( 0 == strcmp( argv[arg], "-fixed" ) && bHasValue )
+		{
+			settings.fixedCostFraction = (float)atof( argv[++arg] );
+		}
+		else if( 0 == strcmp( argv[arg], "-average" ) && bHasValue )
+		{
+			settings.gpuAverageCount = (unsigned int)atoi( argv[++arg] );
+		}
+		else if( 0 == strcmp( argv[arg], "-settle" ) && bHasValue )
+		{
+			settings.settleFrames = (unsigned int)atoi( argv[++arg] );
+		}
+		else if( 0 == strcmp( argv[arg], "-tile" ) && bHasValue )
+		{
+			settings.tileSize = (unsigned int)atoi( argv[++arg] );
+		}
+		else if( 0 == strcmp( argv[arg], "-cpupercentile" ) && bHasValue )
+		{
+			settings.cpuPercentile = (float)atof( argv[++arg] );
+		}
+		else if( '-' == argv[arg][0] )
+		{
+			PrintUsage();
+			return 1;
+		}
+		else if( !LoadTrace( argv[arg], trace ) )
+		{
+			printf( "Failed to load trace %s\n", argv[arg] );
+			return 1;
+		}
+	}
+
+	if( trace.empty() || settings.targetFrameRate <= 0.0f || 0 == settings.backBufferWidth || 0 == settings.backBufferHeight )
+	{
+		PrintUsage();
+		return 1;
+	}
+	if( 0 == settings.gpuAverageCount )
+	{
+		settings.gpuAverageCount = 1;
+	}
+
+	ProportionalResolutionController	proportional;
+	PIDResolutionController				pid;
+	DeadbandResolutionController		deadband;
+	SlewLimitedResolutionController		slewLimited;
+	FrameCostModel						costModel( 1 );	// only the total GPU time is recorded
+	PredictiveResolutionController		predictive( &costModel );
+
+	struct ControllerEntry
+	{
+		const char*				pOption;
+		IResolutionController*	pController;
+		FrameCostModel*			pCostModel;
+	};
+	ControllerEntry controllers[] =
+	{
+		{ "proportional",	&proportional,	NULL },
+		{ "pid",			&pid,			NULL },
+		{ "deadband",		&deadband,		NULL },
+		{ "slew",			&slewLimited,	NULL },
+		{ "predictive",		&predictive,	&costModel },
+	};
+
+	printf( "%u frames, target %.2f FPS, back buffer %ux%u\n\n", (unsigned int)trace.size(), settings.targetFrameRate, settings.backBufferWidth, settings.backBufferHeight );
+	printf( "%-14s %10s %12s %10s %10s %10s %10s %20s\n",
+			"Controller", "Miss rate", "Mean |dS|", "Reversals", "Settle ms", "Max ms", "Unsettled", "Average pixels" );
+
+	bool bFound = false;
+	for( size_t controller = 0; controller < sizeof( controllers ) / sizeof( controllers[0] ); ++controller )
+	{
+		if( 0 == strcmp( pControllerName, "all" ) || 0 == strcmp( pControllerName, controllers[ controller ].pOption ) )
+		{
+			SimulationResults results = Simulate( controllers[ controller ].pController, controllers[ controller ].pCostModel, trace, settings );
+			PrintResults( controllers[ controller ].pController->GetName(), results, settings );
+			bFound = true;
+		}
+	}
+
+	if( !bFound )
+	{
+		PrintUsage();
+		return 1;
+	}
+	return 0;
+}
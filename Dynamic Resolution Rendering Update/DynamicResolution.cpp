@@ -14,6 +14,9 @@
 // limitations under the License.
 /////////////////////////////////////////////////////////////////////////////////////////////
 #include "DynamicResolution.h"
+#include "RenderTargetBudget.h"
+
+#include <math.h>
 
 //--------------------------------------------------------------------------------------
 // Set up default values
@@ -23,14 +26,33 @@ DynamicResolution::DynamicResolution()
 	, m_BackBufferHeight( 720 )
 	, m_MaxWidth( 2048 )
 	, m_MaxHeight( 2048 )
+	, m_ScaleX( 1.0f )
+	, m_ScaleY( 1.0f )
 	, m_MaxScalingX( 1.0f )
 	, m_MaxScalingY( 1.0f )
 	, m_DynamicRTWidth( 1280 )
 	, m_DynamicRTHeight( 720 )
+	, m_DynamicRTBytes( 0 )
+	, m_bWithinBudget( true )
+	, m_NumDownsampleLevels( 0 )
+	, m_NumDownsampleSteps( 0 )
 	, m_CurrDynamicRTWidth( 1280 )
 	, m_CurrDynamicRTHeight( 720 )
+	, m_TileSize( 0 )
+	, m_pRungsX( NULL )
+	, m_pRungsY( NULL )
+	, m_NumRungsX( 0 )
+	, m_NumRungsY( 0 )
+	, m_RungIndexX( 0 )
+	, m_RungIndexY( 0 )
+
+{
+}
 
+DynamicResolution::~DynamicResolution()
 {
+	delete[] m_pRungsX;
+	delete[] m_pRungsY;
 }
 
 
@@ -38,8 +60,20 @@ DynamicResolution::DynamicResolution()
 // Initializes parameters - seperate from constructor so the application can call
 // this to reset on backbuffer changes (e.g. in OnD3D11ResizedSwapChain() ).
 //--------------------------------------------------------------------------------------
-void DynamicResolution::InitializeResolutionParameters( UINT backBufferWidth, UINT backBufferHeight, UINT maxWidth, UINT maxHeight, UINT maxScaling ) 
+void DynamicResolution::InitializeResolutionParameters( UINT backBufferWidth, UINT backBufferHeight, UINT maxWidth, UINT maxHeight, UINT maxScaling,
+														 const RenderTargetBudget* pBudget ) 
 {
+	m_DynamicRTBytes	= 0;
+	m_bWithinBudget		= true;
+	if( pBudget )
+	{
+		RenderTargetBudgetResult budgetResult;
+		pBudget->Calculate( backBufferWidth, backBufferHeight, maxWidth, maxHeight, maxScaling, &budgetResult );
+		maxScaling			= budgetResult.maxScaling;
+		m_DynamicRTBytes	= budgetResult.totalBytes;
+		m_bWithinBudget		= budgetResult.bWithinBudget;
+	}
+
 	m_BackBufferWidth	= backBufferWidth;
 	m_BackBufferHeight	= backBufferHeight;
 	m_MaxWidth			= maxWidth;
@@ -76,6 +110,10 @@ void DynamicResolution::InitializeResolutionParameters( UINT backBufferWidth, UI
 	}
 	m_MaxScalingY = m_DynamicRTHeight / (float)backBufferHeight;
 
+	m_NumDownsampleLevels = RenderTargetBudget::CalculateDownsampleSteps( m_DynamicRTWidth, m_DynamicRTHeight, backBufferWidth, backBufferHeight );
+
+	BuildLadder();
+
 	// Call setscale to initialize scale driven params
 	SetScale( m_ScaleX, m_ScaleY );
 
@@ -108,10 +146,59 @@ void DynamicResolution::SetScale( float scaleX, float scaleY )
 	m_CurrDynamicRTHeight	= floor( (float)m_DynamicRTHeight * m_ScaleY / m_MaxScalingY );
 	m_CurrDynamicRTWidth	= floor( (float)m_DynamicRTWidth *  m_ScaleX / m_MaxScalingX );
 
+	if( m_TileSize )
+	{
+		// Snap down to the ladder
+		m_RungIndexX = FindResolutionRung( m_pRungsX, m_NumRungsX, m_CurrDynamicRTWidth );
+		m_RungIndexY = FindResolutionRung( m_pRungsY, m_NumRungsY, m_CurrDynamicRTHeight );
+		m_CurrDynamicRTWidth	= (float)m_pRungsX[ m_RungIndexX ].size;
+		m_CurrDynamicRTHeight	= (float)m_pRungsY[ m_RungIndexY ].size;
+	}
+
 	// Recreate scale values from actual viewport values
 	m_ScaleY = m_CurrDynamicRTHeight * m_MaxScalingY / (float)m_DynamicRTHeight;
 	m_ScaleX = m_CurrDynamicRTWidth *  m_MaxScalingX / (float)m_DynamicRTWidth;
 
+	m_NumDownsampleSteps = RenderTargetBudget::CalculateDownsampleSteps( (UINT)m_CurrDynamicRTWidth, (UINT)m_CurrDynamicRTHeight, m_BackBufferWidth, m_BackBufferHeight );
+	if( m_NumDownsampleSteps > m_NumDownsampleLevels )
+	{
+		m_NumDownsampleSteps = m_NumDownsampleLevels;
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Set the tile size used for the resolution ladder, 0 to disable
+//--------------------------------------------------------------------------------------
+void DynamicResolution::SetTileSize( UINT tileSize )
+{
+	m_TileSize = tileSize;
+	BuildLadder();
+	SetScale( m_ScaleX, m_ScaleY );
+}
+
+//--------------------------------------------------------------------------------------
+// Build the ladder for both axes. Called when the buffer sizes or tile size change.
+//--------------------------------------------------------------------------------------
+void DynamicResolution::BuildLadder()
+{
+	delete[] m_pRungsX;
+	delete[] m_pRungsY;
+	m_pRungsX = NULL;
+	m_pRungsY = NULL;
+	m_NumRungsX = 0;
+	m_NumRungsY = 0;
+	m_RungIndexX = 0;
+	m_RungIndexY = 0;
+
+	if( 0 == m_TileSize )
+	{
+		return;
+	}
+
+	m_pRungsX = new ResolutionRung[ GetMaxResolutionRungs( m_DynamicRTWidth, m_TileSize ) ];
+	m_pRungsY = new ResolutionRung[ GetMaxResolutionRungs( m_DynamicRTHeight, m_TileSize ) ];
+	m_NumRungsX = BuildResolutionLadder( m_pRungsX, m_BackBufferWidth, m_DynamicRTWidth, m_MaxScalingX, m_TileSize );
+	m_NumRungsY = BuildResolutionLadder( m_pRungsY, m_BackBufferHeight, m_DynamicRTHeight, m_MaxScalingY, m_TileSize );
 }
 
 //--------------------------------------------------------------------------------------
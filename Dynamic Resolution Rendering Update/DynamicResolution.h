@@ -15,19 +15,72 @@
 /////////////////////////////////////////////////////////////////////////////////////////////
 #pragma once
 
-#include "dxut.h"
+// Only D3D11_VIEWPORT is needed, so DXUT is not included. This allows the class to be
+// used by offline tools such as the controller simulator.
+#include <d3d11.h>
+
+#include "ResolutionLadder.h"
+
+class RenderTargetBudget;
 
 //--------------------------------------------------------------------------------------
 // This class is used to hold dynamic resolution information.
+//
+// By default any integer viewport size can be used. If a tile size is set, a ladder
+// of sizes which are multiples of the tile size is built for each axis (see
+// ResolutionLadder.h), and SetScale() snaps down to a rung. This avoids partially covered raster tiles at the viewport
+// edge and means the viewport only changes when a rung boundary is crossed.
+//
+// When super sampling by more than 2x the final resolve would skip source texels, so
+// the image is first reduced by 2:1 steps through a downsample pyramid. The class gives
+// the number of pyramid levels for the dynamic buffer and the steps for the current
+// viewport; the application owns the level render targets.
 //--------------------------------------------------------------------------------------
 class DynamicResolution
 {
 public:
 	DynamicResolution();
+	~DynamicResolution();
 
-	void InitializeResolutionParameters( UINT backBufferWidth, UINT backBufferHeight, UINT maxWidth, UINT maxHeight, UINT maxScaling );
+	// If pBudget is not NULL maxScaling is reduced until the dynamic targets fit its budget
+	void InitializeResolutionParameters( UINT backBufferWidth, UINT backBufferHeight, UINT maxWidth, UINT maxHeight, UINT maxScaling,
+										 const RenderTargetBudget* pBudget = NULL );
 	void SetScale( float scaleX, float scaleY );
 
+	// 0 disables the ladder, otherwise typically 8, 16, 32 or 64
+	void SetTileSize( UINT tileSize );
+	UINT GetTileSize() const
+	{
+		return m_TileSize;
+	}
+
+	// Ladder information, the rung index can be used to cache per rung constants.
+	// Only valid when the tile size is not 0.
+	UINT GetNumRungsX() const
+	{
+		return m_NumRungsX;
+	}
+	UINT GetNumRungsY() const
+	{
+		return m_NumRungsY;
+	}
+	UINT GetRungIndexX() const
+	{
+		return m_RungIndexX;
+	}
+	UINT GetRungIndexY() const
+	{
+		return m_RungIndexY;
+	}
+	const ResolutionRung& GetRungX( UINT rung ) const
+	{
+		return m_pRungsX[ rung ];
+	}
+	const ResolutionRung& GetRungY( UINT rung ) const
+	{
+		return m_pRungsY[ rung ];
+	}
+
 	// Accessors
 	float GetScaleX() const
 	{
@@ -54,9 +107,33 @@ public:
 		return m_DynamicRTHeight;
 	}
 
+	// Downsample pyramid levels needed at the maximum scale, level n is the dynamic
+	// buffer size >> n for n from 1
+	UINT GetNumDownsampleLevels() const
+	{
+		return m_NumDownsampleLevels;
+	}
+	// 2:1 steps to take for the current viewport before the final resolve
+	UINT GetNumDownsampleSteps() const
+	{
+		return m_NumDownsampleSteps;
+	}
+
+	// Memory used by the budgeted targets, 0 if no budget was given
+	UINT64 GetDynamicBufferBytes() const
+	{
+		return m_DynamicRTBytes;
+	}
+	bool IsWithinBudget() const
+	{
+		return m_bWithinBudget;
+	}
+
 	void GetViewport( D3D11_VIEWPORT* pViewPort ) const;
 
 private:
+	void BuildLadder();
+
 	UINT m_BackBufferWidth;
 	UINT m_BackBufferHeight;
 	UINT m_MaxWidth;
@@ -64,6 +141,10 @@ private:
 
 	UINT m_DynamicRTWidth;
 	UINT m_DynamicRTHeight;
+	UINT64 m_DynamicRTBytes;
+	bool m_bWithinBudget;
+	UINT m_NumDownsampleLevels;
+	UINT m_NumDownsampleSteps;
 
 	float m_CurrDynamicRTWidth;
 	float m_CurrDynamicRTHeight;
@@ -72,5 +153,17 @@ private:
 	float m_ScaleY;
 	float m_MaxScalingX;
 	float m_MaxScalingY;
+
+	UINT m_TileSize;
+	ResolutionRung* m_pRungsX;
+	ResolutionRung* m_pRungsY;
+	UINT m_NumRungsX;
+	UINT m_NumRungsY;
+	UINT m_RungIndexX;
+	UINT m_RungIndexY;
+
+	//prevent assign and copy
+	DynamicResolution( const DynamicResolution& rhs );
+	DynamicResolution& operator=( const DynamicResolution& rhs );
 };
 
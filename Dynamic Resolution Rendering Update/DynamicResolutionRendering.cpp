@@ -20,7 +20,20 @@
 #include "Utility.h"
 #include "TexGenUtils.h"
 #include "DynamicResolution.h"
-#include "GPUTimer.h"
+#include "RenderTargetBudget.h"
+#include "ResolutionController.h"
+#include "FrameCostModel.h"
+#include "FrameBoundClassifier.h"
+#include "StreamingStats.h"
+#include "FixedTimestep.h"
+#include "VelocityStats.h"
+#include "GPUProfiler.h"
+#include "GPUPipelineStats.h"
+#include "GPUQueryBackendD3D11.h"
+#include "GPUClockCalibration.h"
+#include "TraceRecorder.h"
+#include "TelemetryLogger.h"
+#include "TaskPool.h"
 #include "ZoomBox.h"
 
 // Globals: GUI related
@@ -45,9 +58,14 @@ bool                        g_ShowZoomBox           = false;
 
 // Globals: Sample Component related
 
-// Constant parameters to constrain dynamic render targets. Should be made device dependant, using memory limits.
+// Constant parameters to constrain dynamic render targets. These are the feature level 10 texture
+// size limits, the memory budget below further limits the size on devices with less memory.
 const unsigned int			g_MaxRTWidth			= 8192; // max width of dynamic RT
 const unsigned int			g_MaxRTHeight			= 8192; // max height of dynamic RT
+const unsigned int			g_MaxDownsampleLevels	= 2;	// 2:1 downsample levels, enough for the UI's largest, 4x, super sampling
+const float					g_DynamicRTBudgetFraction = 0.25f;	// fraction of video memory for dynamic RTs
+UINT64						g_DynamicRTBudgetBytes	= 256 * 1024 * 1024;	// updated from the adapter on device creation
+RenderTargetBudget			g_DynamicRTBudget;
 const float					g_VelocityToAlphaScale	= 16.0f;
 
 unsigned int                g_ResolutionScaleX = 100; // % value, updated during init
@@ -57,9 +75,11 @@ RESOLVE_MODE				g_ResolveMode = RESOLVE_MODE_TEMPORALAA;
 bool						g_bPaused = false;
 bool						g_bMotionBlur = true;
 bool						g_bShowCameras = false;
+bool						g_bFrustumCulling = true;
 bool						g_bAspectRatioLock = true;
 bool						g_bClearWithPixelShader = true;
-unsigned int				g_ResolutionScaleMax	= 1;	// 1==back buffer size, > 1 means larger. Only 2 useful for super sampling without multi-downsample.
+unsigned int				g_ResolutionScaleMax	= 1;	// 1==back buffer size, > 1 means larger. Above 2 the downsample pyramid is used.
+const unsigned int			g_SuperSamplingFactors[] = { 1, 2, 4 };	// g_ResolutionScaleMax options, order must match the UI
 bool						g_bResetDynamicRes = false;
 unsigned int				g_CameraIndex = 1;
 unsigned int				g_SymmetricTAA = 0;				// 0==Asymmetric Temporal AA using offsets [0,0],[0.5,0.5], 1==symmetric TAA with [-0.25,-0.25],[+0.25,+0.25]
@@ -67,6 +87,10 @@ unsigned int				g_SymmetricTAA = 0;				// 0==Asymmetric Temporal AA using offset
 // Globals: Scene
 Scene						g_Scene;
 
+// Globals: Worker threads for the scene's per model animation and matrix updates
+TaskPool					g_TaskPool;
+const UINT					g_ThreadBenchmarkIterations = 50;
+
 // Globals: Post Process
 Utility::RenderTarget		g_Color;
 Utility::RenderTarget		g_ColorDynamic;
@@ -74,6 +98,9 @@ Utility::RenderTarget		g_Velocity;
 Utility::RenderTarget		g_VelocityDynamic[2];
 Utility::RenderTarget		g_FinalRTDynamic[2];
 unsigned int				g_CurrentRT = 0;
+Utility::RenderTarget		g_DownsampleDynamic[2][g_MaxDownsampleLevels];	// level n is 1/2^(n+1) of g_FinalRTDynamic
+unsigned int				g_NumDownsampleLevels = 0;
+unsigned int				g_DownsampleLevelUsed[2] = { 0, 0 };	// level holding the final image for each g_FinalRTDynamic
 Utility::RenderTarget		g_DepthBufferDynamic;
 
 ID3D11Buffer*				g_pFullScreenQuadBuffer = NULL;
@@ -94,6 +121,7 @@ ID3D11PixelShader*			g_pResolveTemporalAAFastPixelShader = NULL;
 ID3D11PixelShader*			g_pResolveTemporalAANOPixelShader = NULL;
 ID3D11PixelShader*			g_pResolveTemporalAANOFastPixelShader = NULL;
 ID3D11PixelShader*			g_pResolveTemporalAABasicPixelShader = NULL;
+ID3D11PixelShader*			g_pReduceVelocityPixelShader = NULL;
 
 ID3D11PixelShader*			g_pClearPixelShader = NULL;
 ID3D11VertexShader*			g_pClearVertexShader = NULL;
@@ -108,87 +136,84 @@ ID3D11ShaderResourceView*	g_pNoiseTextureSRV;
 
 const unsigned int			g_NoiseTextureSize = 128;
 
-// Globals: Timing
-AveragedGPUTimer			g_GPUFrameInnerWorkTimer( 10 );
-AveragedGPUTimer			g_GPUFrameClearTimer( 10 );
-AveragedGPUTimer			g_GPUFrameSceneTimer( 10 );
-AveragedGPUTimer			g_GPUFramePostProcTimer( 10 );
-AveragedGPUTimer			g_GPUFrameScaleTimer( 10 );
-
-//--------------------------------------------------------------------------------------
-// Helper class used to smooth per frame timing so as to reduce hitch instabilities
-//--------------------------------------------------------------------------------------
-class SmoothedTimer
+// Globals: Timing. Times of the named scopes are averaged over 10 frames for the HUD
+// and the cost model.
+GPUQueryBackendD3D11		g_GPUQueryBackend;
+GPUProfiler					g_GPUProfiler( 32, 4, 10 );
+const char* const			g_GPUScopeFrame			= "Inner Frame";
+const char* const			g_GPUScopeClear			= "Clear";
+const char* const			g_GPUScopeScene			= "Scene";
+const char* const			g_GPUScopePostProc		= "Post Process";
+const char* const			g_GPUScopeScale			= "Frame Scale";
+
+// Globals: CPU / GPU clock calibration, so GPU timestamps can be placed on the CPU timeline.
+// Each sample waits for the GPU to go idle, so they are taken only every few seconds and
+// only while a trace capture or the latency measurement needs them.
+GPUClockCalibration			g_GPUClockCalibration( 16, 1.0 );
+const double				g_ClockSamplePeriod		= 2.0;
+double						g_LastClockSampleTime	= 0.0;
+bool						g_bClockSampleStall		= false;	// this frame waited for a clock sample
+bool						g_bMeasureGPULatency	= false;
+const unsigned int			g_SubmitEndTimeCount	= 8;	// must exceed the GPU profiler frame latency
+double						g_SubmitEndTimes[ g_SubmitEndTimeCount ] = { 0.0 };	// by g_GPUFrameCount
+unsigned int				g_GPUFrameCount			= 0;	// GPU profiler frames begun
+StreamingStats				g_GPULatencyStats( 120 );	// end of submission to the GPU completing the frame
+
+// Globals: Trace capture of CPU scopes and GPU intervals to Chrome trace event JSON
+class DXUTTraceClock : public ITraceClock
 {
 public:
-	SmoothedTimer( unsigned int smoothInterval )
-		: m_SmoothInterval( smoothInterval )
-		, m_Time( 0.0 )
-		, m_Elapsed( 0.0f )
-		, m_Curr( 0 )
-		, m_pDeltaTs( NULL )
-		, m_fSmoothInterval( (float)smoothInterval )
-	{
-		m_pDeltaTs = new float[m_SmoothInterval];
-
-		//init with 60FPS in ms
-		for( unsigned int i=0; i < m_SmoothInterval; ++i )
-		{
-			m_pDeltaTs[i] = 1.0f/(60.0f*1000.0f);
-		}
-
-	}
-
-	~SmoothedTimer()
+	virtual double GetTime()
 	{
-		delete[] m_pDeltaTs;
+		return DXUTGetGlobalTimer()->GetAbsoluteTime();
 	}
-
-	void Update( float deltaT )
+	virtual unsigned int GetThreadId()
 	{
-		m_pDeltaTs[ m_Curr ] = deltaT;
-		++m_Curr;
-		if( m_Curr >= m_SmoothInterval )
-		{
-			m_Curr = 0;
-		}
-
-		//to avoid potentially accumulating rounding errors we calculate all every frame
-		m_Elapsed = 0.0f;
-		for( unsigned int i=0; i < m_SmoothInterval; ++i )
-		{
-			m_Elapsed += m_pDeltaTs[i];
-		}
-		m_Elapsed /= m_fSmoothInterval;
-		m_Time += m_Elapsed;
-
+		return (unsigned int)GetCurrentThreadId();
 	}
-	double GetTime() const
-	{
-		return m_Time;
-	}
-	float GetElapsedTime() const
-	{
-		return m_Elapsed;
-	}
-
-
-private:
-	float*			m_pDeltaTs;
-	unsigned int	m_SmoothInterval;
-	float			m_fSmoothInterval;
-	double			m_Time;
-	float			m_Elapsed;
-	unsigned int	m_Curr;
-
-	//prevent assign and copy
-	SmoothedTimer( const SmoothedTimer& rhs );
-	SmoothedTimer& operator=( const SmoothedTimer& rhs );
-
-
 };
+DXUTTraceClock				g_TraceClock;
+TraceRecorder				g_TraceRecorder( &g_TraceClock, 65536 );
+const unsigned int			g_TraceFrames			= 300;
+const wchar_t* const		g_TraceFileName			= L"DynamicResolutionTrace.json";
+
+// Globals: Per frame telemetry log, written on a background thread and converted to CSV
+// or a ControllerSimulator trace with TelemetryDecoder
+TelemetryLogger				g_TelemetryLogger;
+const char* const			g_TelemetryFileName		= "DynamicResolutionTelemetry.bin";
+unsigned int				g_TelemetryFrame		= 0;
+float						g_LastControlTime		= 0.0f;	// controller input of the last ControlResolution()
+float						g_LastTargetTime		= 0.0f;
+
+// Globals: Fixed timestep simulation. The scene is simulated in fixed steps, so its animation
+// does not depend on frame times and benchmark runs are reproducible, and each frame renders
+// an interpolation of the last two steps.
+const float			g_SimulationRates[]		= { 30.0f, 60.0f, 120.0f, 240.0f };	// step rates in Hz, order must match the UI
+UINT				g_SimulationRateIndex	= 1;
+const unsigned int	g_SimulationMaxSteps	= 4;	// steps per frame, longer frames slow the simulation down
+FixedTimestep		g_SimulationClock( g_SimulationRates[ 1 ], g_SimulationMaxSteps );
+
+// Globals: Per frame CPU frame time statistics, used as the CPU input to resolution control
+StreamingStats		g_FrameTimeStats( 120 );
+FRAME_TIME_INPUT	g_FrameTimeInput		= FRAME_TIME_INPUT_P50;
 
-SmoothedTimer g_SmoothedTimer(10);
+//--------------------------------------------------------------------------------------
+// Frame time statistic selected by a FRAME_TIME_INPUT other than FRAME_TIME_INPUT_FPS
+//--------------------------------------------------------------------------------------
+float GetFrameTimeInput( const StreamingStats& stats, FRAME_TIME_INPUT input )
+{
+	switch( input )
+	{
+	case FRAME_TIME_INPUT_P95:
+		return stats.GetP95();
+	case FRAME_TIME_INPUT_P99:
+		return stats.GetP99();
+	case FRAME_TIME_INPUT_MAX:
+		return stats.GetMax();
+	default:
+		return stats.GetMedian();
+	}
+}
 
 // Globals: Dynamic resolution control
 float				g_ControlledScaleMin	= 0.3f;
@@ -196,6 +221,71 @@ float				g_ControlledScale		= 1.0f;
 CONTROL_MODE		g_ControlMode			= CONTROL_MODE_VSYNC;
 float				g_VSyncFrameRate		= 60.0f;
 DynamicResolution	g_DynamicResolution;
+const UINT			g_TileSizes[]			= { 0, 8, 16, 32, 64 };	// resolution ladder tile sizes, 0 is off
+UINT				g_TileSizeIndex			= 0;
+
+// Globals: Per pass GPU cost model, sampled each time the averaged GPU timers update
+FrameCostModel		g_FrameCostModel( COST_PASS_COUNT );
+double				g_CostModelPixelSum		= 0.0;	// viewport pixels summed over the timer averaging interval
+unsigned int		g_CostModelNumFrames	= 0;
+
+// Globals: Per pass pipeline statistics, indexed by COST_PASS up to COST_PASS_OTHER which
+// has no queries of its own. Pixel shader invocations against the time of the resolution
+// dependent passes give the cost of a shaded pixel, and against the viewport the overdraw.
+AveragedGPUPipelineStats	g_PassPipelineStats[ COST_PASS_OTHER ];
+GPUQueryBackendD3D11		g_PassPipelineStatsBackends[ COST_PASS_OTHER ];	// each owns one pass's query pool
+PipelineStatistics			g_PassPipelineStatsAverages[ COST_PASS_OTHER ];
+double						g_PipelineStatsPixelSum		= 0.0;	// viewport pixels summed over the statistics averaging interval
+unsigned int				g_PipelineStatsNumFrames	= 0;
+float						g_PipelineStatsPixels		= 0.0f;	// average viewport pixels of the last interval
+float						g_ShadedPixelCost			= 0.0f;	// GPU seconds per pixel shader invocation, 0 until known
+float						g_Overdraw					= 0.0f;	// pixel shader invocations per viewport pixel, 0 until known
+
+// Globals: Resolution controllers, indexed by CONTROLLER_TYPE
+ProportionalResolutionController	g_ProportionalController;
+PIDResolutionController				g_PIDController;
+DeadbandResolutionController		g_DeadbandController;
+SlewLimitedResolutionController		g_SlewLimitedController;
+PredictiveResolutionController		g_PredictiveController( &g_FrameCostModel );
+IResolutionController*				g_pResolutionControllers[ CONTROLLER_TYPE_COUNT ] =
+{
+	&g_ProportionalController,
+	&g_PIDController,
+	&g_DeadbandController,
+	&g_SlewLimitedController,
+	&g_PredictiveController
+};
+CONTROLLER_TYPE						g_ControllerType = CONTROLLER_TYPE_PROPORTIONAL;
+
+// Globals: Per axis automatic control, used when the aspect ratio is not locked.
+// The max values are also limited by g_ResolutionScaleMax.
+AxisScaleSelector	g_AxisScaleSelector;
+float				g_ControlledScaleMinX	= 0.3f;
+float				g_ControlledScaleMaxX	= 4.0f;
+float				g_ControlledScaleMinY	= 0.3f;
+float				g_ControlledScaleMaxY	= 4.0f;
+
+// Globals: Motion adaptive control. The dynamic velocity buffer is reduced to a small
+// texture on the GPU, which is read back through a ring of staging textures so the CPU
+// never waits for the GPU.
+bool					g_bMotionAdaptive			= false;
+MotionAdaptivePolicy	g_MotionAdaptivePolicy;
+Utility::RenderTarget	g_VelocityReduced;
+const unsigned int		g_VelocityReadbackDepth		= 4;
+ID3D11Texture2D*		g_pVelocityReadback[ g_VelocityReadbackDepth ] = { NULL };
+unsigned int			g_VelocityReadbackNext		= 0;	// next staging texture to copy to
+unsigned int			g_VelocityReadbackPending	= 0;	// copies issued but not yet read back
+VelocityStatistics		g_VelocityStatistics;
+bool					g_bHaveVelocityStatistics	= false;
+
+// Globals: CPU / GPU bound classification. CPU times come from the DXUT timer, and
+// the Present wait is the time from the end of OnD3D11FrameRender to the next OnFrameMove.
+FrameBoundClassifier	g_FrameBoundClassifier;
+bool					g_bBoundGating			= false;	// only lower the scale when GPU bound
+double					g_CPURenderEndTime		= 0.0;
+float					g_CPUUpdateTime			= 0.0f;
+float					g_CPUSubmitTime			= 0.0f;
+float					g_CPUPresentTime		= 0.0f;
 
 
 // Constant Buffers
@@ -227,6 +317,12 @@ struct CB_PS_RESOLVENOISE
 };
 ID3D11Buffer*				m_pCBPSResolveNoise = NULL;
 
+struct CB_PS_REDUCEVELOCITY
+{
+	D3DXVECTOR4	g_ReduceCellSize;	// float4( ratio_x/reduced width, ratio_y/reduced height, back buffer width, back buffer height )
+};
+ID3D11Buffer*				m_pCBPSReduceVelocity = NULL;
+
 struct CB_VS_POSTPROCESS_TEMPORAL_AA
 {
 	D3DXVECTOR2	g_VSRTCurrRatio0;
@@ -259,6 +355,29 @@ HRESULT CALLBACK OnD3D11CreateDevice( ID3D11Device* pD3DDevice,
     V_RETURN( g_D3DSettingsDlg.OnD3D11CreateDevice( pD3DDevice ) );
     g_pTextHelper = new CDXUTTextHelper( pD3DDevice, pImmediateContext, &g_DialogResourceManager, 15 );
 
+	// Budget the dynamic render targets from the adapter's memory
+	IDXGIDevice* pDXGIDevice = NULL;
+	if( SUCCEEDED( pD3DDevice->QueryInterface( __uuidof( IDXGIDevice ), (void**)&pDXGIDevice ) ) )
+	{
+		IDXGIAdapter* pDXGIAdapter = NULL;
+		if( SUCCEEDED( pDXGIDevice->GetAdapter( &pDXGIAdapter ) ) )
+		{
+			DXGI_ADAPTER_DESC adapterDesc;
+			if( SUCCEEDED( pDXGIAdapter->GetDesc( &adapterDesc ) ) )
+			{
+				// integrated graphics have little or no dedicated memory and render from shared memory
+				UINT64 videoMemory = adapterDesc.DedicatedVideoMemory;
+				if( videoMemory < 512 * 1024 * 1024 )
+				{
+					videoMemory += adapterDesc.SharedSystemMemory;
+				}
+				g_DynamicRTBudgetBytes = (UINT64)( g_DynamicRTBudgetFraction * videoMemory );
+			}
+			pDXGIAdapter->Release();
+		}
+		pDXGIDevice->Release();
+	}
+
 	// init post process...
 
 
@@ -339,6 +458,10 @@ HRESULT CALLBACK OnD3D11CreateDevice( ID3D11Device* pD3DDevice,
     BufferDesc.ByteWidth = sizeof( CB_PS_RESOLVENOISE );
 	V_RETURN( pD3DDevice->CreateBuffer( &BufferDesc, NULL, &m_pCBPSResolveNoise ) );
 
+	// Reduce Velocity CB for PS
+    BufferDesc.ByteWidth = sizeof( CB_PS_REDUCEVELOCITY );
+	V_RETURN( pD3DDevice->CreateBuffer( &BufferDesc, NULL, &m_pCBPSReduceVelocity ) );
+
 	// Resolve Temporal AA for VS
     BufferDesc.ByteWidth = sizeof( CB_VS_POSTPROCESS_TEMPORAL_AA );
 	V_RETURN( pD3DDevice->CreateBuffer( &BufferDesc, NULL, &m_pCBVSPostProcessTemporalAA ) );
@@ -404,12 +527,39 @@ HRESULT CALLBACK OnD3D11CreateDevice( ID3D11Device* pD3DDevice,
 	V_RETURN( pD3DDevice->CreateShaderResourceView( pNoiseTex, &SRVNoiseTexDesc, &g_pNoiseTextureSRV ) );
 	pNoiseTex->Release();	//no longer needed.
 
+	//Reduced velocity texture and staging textures to read it back
+	V_RETURN( g_VelocityReduced.Create( pD3DDevice, DXGI_FORMAT_R32G32B32A32_FLOAT,
+										VelocityReduceConsts::cReducedSize, VelocityReduceConsts::cReducedSize, "Reduced Velocity" ) );
+	D3D11_TEXTURE2D_DESC descVelocityReadback;
+	g_VelocityReduced.GetTexture2D()->GetDesc( &descVelocityReadback );
+	descVelocityReadback.BindFlags = 0;
+	descVelocityReadback.CPUAccessFlags = D3D11_CPU_ACCESS_READ;
+	descVelocityReadback.MiscFlags = 0;
+	descVelocityReadback.Usage = D3D11_USAGE_STAGING;
+	for( unsigned int i = 0; i < g_VelocityReadbackDepth; ++i )
+	{
+		V_RETURN( pD3DDevice->CreateTexture2D( &descVelocityReadback, NULL, &g_pVelocityReadback[i] ) );
+	}
+	g_VelocityReadbackNext = 0;
+	g_VelocityReadbackPending = 0;
+	g_bHaveVelocityStatistics = false;
+
 	//init timers
-	g_GPUFrameInnerWorkTimer.OnD3D11CreateDevice(  pD3DDevice, pImmediateContext );
-	g_GPUFrameClearTimer.OnD3D11CreateDevice(  pD3DDevice, pImmediateContext );
-	g_GPUFrameSceneTimer.OnD3D11CreateDevice(  pD3DDevice, pImmediateContext );
-	g_GPUFramePostProcTimer.OnD3D11CreateDevice(  pD3DDevice, pImmediateContext );
-	g_GPUFrameScaleTimer.OnD3D11CreateDevice(  pD3DDevice, pImmediateContext );
+	g_GPUQueryBackend.OnD3D11CreateDevice( pD3DDevice, pImmediateContext );
+	if( !g_GPUProfiler.Create( &g_GPUQueryBackend ) )
+	{
+		return E_FAIL;
+	}
+	GPUProfiler::SetActive( &g_GPUProfiler );
+	TraceRecorder::SetActive( &g_TraceRecorder );
+	for( UINT pass = 0; pass < COST_PASS_OTHER; ++pass )
+	{
+		g_PassPipelineStatsBackends[ pass ].OnD3D11CreateDevice( pD3DDevice, pImmediateContext );
+		if( !g_PassPipelineStats[ pass ].Create( &g_PassPipelineStatsBackends[ pass ] ) )
+		{
+			return E_FAIL;
+		}
+	}
 	//init scenes
 	g_Scene.OnD3D11CreateDevice( pD3DDevice, pImmediateContext );
 
@@ -490,6 +640,9 @@ void CreateShaders( ID3D11Device* pD3DDevice )
 	Utility::CreatePixelShaderFromFile( L"PostProcessDynamic.hlsl","PSResolveTemporalAABasic", "ps_4_0",
 										pD3DDevice, &g_pResolveTemporalAABasicPixelShader );
 
+	Utility::CreatePixelShaderFromFile( L"PostProcessDynamic.hlsl","PSReduceVelocity", "ps_4_0",
+										pD3DDevice, &g_pReduceVelocityPixelShader );
+
 }
 
 //--------------------------------------------------------------------------------------
@@ -517,6 +670,7 @@ void ReleaseShaders()
 	SAFE_RELEASE( g_pResolveTemporalAANOPixelShader );
 	SAFE_RELEASE( g_pResolveTemporalAANOFastPixelShader );
 	SAFE_RELEASE( g_pResolveTemporalAABasicPixelShader );
+	SAFE_RELEASE( g_pReduceVelocityPixelShader );
 }
 
 //--------------------------------------------------------------------------------------
@@ -601,9 +755,9 @@ HRESULT CALLBACK OnD3D11ResizedSwapChain( ID3D11Device* pD3DDevice,
 
     // UI elements placement
     g_HUD.SetLocation( pBackBufferSurfaceDesc->Width - 200, 30 );
-    g_HUD.SetSize( 100, 60 );
+    g_HUD.SetSize( 100, 86 );
 
-    g_SampleUI.SetLocation( pBackBufferSurfaceDesc->Width - g_uGUIWidth, 100 );
+    g_SampleUI.SetLocation( pBackBufferSurfaceDesc->Width - g_uGUIWidth, 126 );
     g_SampleUI.SetSize( 100, 40 );
 
     g_HelpUI.SetLocation( pBackBufferSurfaceDesc->Width - g_uGUIWidth, pBackBufferSurfaceDesc->Height - 50 );
@@ -668,14 +822,57 @@ HRESULT CALLBACK OnD3D11ResizedSwapChain( ID3D11Device* pD3DDevice,
 //--------------------------------------------------------------------------------------
 void InitDynamicResolution( ID3D11Device* pD3DDevice )
 {
+	// Dynamic render targets, all are budgeted and created at the dynamic buffer size
+	struct DynamicRTDesc
+	{
+		Utility::RenderTarget*	pRT;
+		DXGI_FORMAT				format;
+		UINT					bytesPerPixel;
+		const CHAR*				pName;
+	};
+	const DynamicRTDesc dynamicRTs[] =
+	{
+		{ &g_DepthBufferDynamic,	DXGI_FORMAT_D32_FLOAT,		4,	"Dynamic Depth" },
+		{ &g_ColorDynamic,			DXGI_FORMAT_R8G8B8A8_UNORM,	4,	"Dynamic Color" },
+		{ &g_VelocityDynamic[0],	DXGI_FORMAT_R16G16_FLOAT,	4,	"Dynamic Velocity 0" },
+		{ &g_VelocityDynamic[1],	DXGI_FORMAT_R16G16_FLOAT,	4,	"Dynamic Velocity 1" },
+		{ &g_FinalRTDynamic[0],		DXGI_FORMAT_R8G8B8A8_UNORM,	4,	"Final Color 0" },
+		{ &g_FinalRTDynamic[1],		DXGI_FORMAT_R8G8B8A8_UNORM,	4,	"Final Color 1" },
+	};
+	g_DynamicRTBudget.Reset( g_DynamicRTBudgetBytes );
+	for( UINT rt = 0; rt < ARRAYSIZE( dynamicRTs ); ++rt )
+	{
+		g_DynamicRTBudget.AddTarget( dynamicRTs[ rt ].pName, dynamicRTs[ rt ].bytesPerPixel );
+	}
+	// the downsample pyramid levels are DXGI_FORMAT_R8G8B8A8_UNORM
+	g_DynamicRTBudget.SetDownsampleChains( 4, ARRAYSIZE( g_FinalRTDynamic ) );
+
 	//Dynamic Rendering
-	g_DynamicResolution.InitializeResolutionParameters( (UINT)g_ViewPort.Width, (UINT)g_ViewPort.Height, g_MaxRTWidth, g_MaxRTHeight, g_ResolutionScaleMax );
-	g_DepthBufferDynamic.Create( pD3DDevice, DXGI_FORMAT_D32_FLOAT, g_DynamicResolution.GetDynamicBufferWidth(), g_DynamicResolution.GetDynamicBufferHeight(), "Dynamic Depth" );
-	g_ColorDynamic.Create( pD3DDevice, DXGI_FORMAT_R8G8B8A8_UNORM, g_DynamicResolution.GetDynamicBufferWidth(), g_DynamicResolution.GetDynamicBufferHeight(), "Dynamic Color" );
-	g_VelocityDynamic[0].Create( pD3DDevice, DXGI_FORMAT_R16G16_FLOAT, g_DynamicResolution.GetDynamicBufferWidth(), g_DynamicResolution.GetDynamicBufferHeight(), "Dynamic Velocity 0" );
-	g_VelocityDynamic[1].Create( pD3DDevice, DXGI_FORMAT_R16G16_FLOAT, g_DynamicResolution.GetDynamicBufferWidth(), g_DynamicResolution.GetDynamicBufferHeight(), "Dynamic Velocity 1" );
-	g_FinalRTDynamic[0].Create( pD3DDevice, DXGI_FORMAT_R8G8B8A8_UNORM, g_DynamicResolution.GetDynamicBufferWidth(), g_DynamicResolution.GetDynamicBufferHeight(), "Final Color 0" );
-	g_FinalRTDynamic[1].Create( pD3DDevice, DXGI_FORMAT_R8G8B8A8_UNORM, g_DynamicResolution.GetDynamicBufferWidth(), g_DynamicResolution.GetDynamicBufferHeight(), "Final Color 1" );
+	g_DynamicResolution.InitializeResolutionParameters( (UINT)g_ViewPort.Width, (UINT)g_ViewPort.Height, g_MaxRTWidth, g_MaxRTHeight, g_ResolutionScaleMax, &g_DynamicRTBudget );
+	g_FrameCostModel.Reset();
+	g_CostModelPixelSum = 0.0;
+	g_CostModelNumFrames = 0;
+	g_PipelineStatsPixelSum = 0.0;
+	g_PipelineStatsNumFrames = 0;
+	g_ShadedPixelCost = 0.0f;
+	g_Overdraw = 0.0f;
+	for( UINT rt = 0; rt < ARRAYSIZE( dynamicRTs ); ++rt )
+	{
+		dynamicRTs[ rt ].pRT->Create( pD3DDevice, dynamicRTs[ rt ].format, g_DynamicResolution.GetDynamicBufferWidth(), g_DynamicResolution.GetDynamicBufferHeight(), dynamicRTs[ rt ].pName );
+	}
+
+	// Downsample pyramid for each final color target, used when super sampling above 2x
+	g_NumDownsampleLevels = min( g_DynamicResolution.GetNumDownsampleLevels(), g_MaxDownsampleLevels );
+	for( UINT rt = 0; rt < ARRAYSIZE( g_FinalRTDynamic ); ++rt )
+	{
+		for( UINT level = 0; level < g_NumDownsampleLevels; ++level )
+		{
+			g_DownsampleDynamic[ rt ][ level ].Create( pD3DDevice, DXGI_FORMAT_R8G8B8A8_UNORM,
+				g_DynamicResolution.GetDynamicBufferWidth() >> ( level + 1 ), g_DynamicResolution.GetDynamicBufferHeight() >> ( level + 1 ), "Downsample" );
+		}
+		g_DownsampleLevelUsed[ rt ] = 0;
+	}
+	ReportDynamicRTMemory();
 
 	g_TemporalAAVSConstants.g_VSRTCurrRatio0.x = g_DynamicResolution.GetRTScaleX();
 	g_TemporalAAVSConstants.g_VSRTCurrRatio0.y = g_DynamicResolution.GetRTScaleY();
@@ -685,6 +882,38 @@ void InitDynamicResolution( ID3D11Device* pD3DDevice )
 
 }
 
+//--------------------------------------------------------------------------------------
+// Report the dynamic render target memory breakdown to the debug output and the GUI
+//--------------------------------------------------------------------------------------
+void ReportDynamicRTMemory()
+{
+	const float bytesToMB = 1.0f / ( 1024.0f * 1024.0f );
+	UINT width = g_DynamicResolution.GetDynamicBufferWidth();
+	UINT height = g_DynamicResolution.GetDynamicBufferHeight();
+
+	CHAR szDebug[256];
+	sprintf_s( szDebug, "Dynamic RTs %ux%u: %.1f MB of %.1f MB budget%s\n", width, height,
+		g_DynamicResolution.GetDynamicBufferBytes() * bytesToMB, g_DynamicRTBudget.GetBudget() * bytesToMB,
+		g_DynamicResolution.IsWithinBudget() ? "" : " (over budget at back buffer size)" );
+	OutputDebugStringA( szDebug );
+	for( UINT rt = 0; rt < g_DynamicRTBudget.GetNumTargets(); ++rt )
+	{
+		sprintf_s( szDebug, "  %s: %.1f MB\n", g_DynamicRTBudget.GetTargetName( rt ),
+			g_DynamicRTBudget.GetTargetBytes( rt, width, height ) * bytesToMB );
+		OutputDebugStringA( szDebug );
+	}
+	if( g_NumDownsampleLevels )
+	{
+		sprintf_s( szDebug, "  Downsample (%u levels): %.1f MB\n", g_NumDownsampleLevels,
+			g_DynamicRTBudget.GetDownsampleBytes( width, height, (UINT)g_ViewPort.Width, (UINT)g_ViewPort.Height ) * bytesToMB );
+		OutputDebugStringA( szDebug );
+	}
+
+	WCHAR sz[100];
+	swprintf_s( sz, L"RT Memory (MB): %.0f/%.0f", g_DynamicResolution.GetDynamicBufferBytes() * bytesToMB, g_DynamicRTBudget.GetBudget() * bytesToMB );
+	g_SampleUI.GetStatic( IDC_RTMEMORYSTATIC )->SetText( sz );
+}
+
 //--------------------------------------------------------------------------------------
 // Update the scene
 //--------------------------------------------------------------------------------------
@@ -692,6 +921,15 @@ void CALLBACK OnFrameMove( double fTime,
                            float fElapsedTime,
                            void* pUserContext )
 {
+	double cpuUpdateStartTime = DXUTGetGlobalTimer()->GetAbsoluteTime();
+	if( g_CPURenderEndTime > 0.0 )
+	{
+		g_CPUPresentTime = (float)( cpuUpdateStartTime - g_CPURenderEndTime );
+		g_TraceRecorder.AddCPUEvent( "Present", g_CPURenderEndTime, cpuUpdateStartTime );
+	}
+	g_TraceRecorder.BeginFrame( cpuUpdateStartTime );
+	TRACE_CPU_SCOPE( "OnFrameMove" );
+
 	if(  g_bDynamicResolutionEnabled &&
 		( RESOLVE_MODE_TEMPORALAA		== g_ResolveMode )  || 
 		( RESOLVE_MODE_TEMPORALAA_NO	== g_ResolveMode )  ||
@@ -704,15 +942,43 @@ void CALLBACK OnFrameMove( double fTime,
 		g_CurrentRT = 0;
 	}
 
+	// DXUT's elapsed time is the time between frame starts, so in steady state the present to present delta.
+	// A frame which waited for a clock sample is not a measure of the frame rate, so is left out.
+	if( !g_bClockSampleStall )
+	{
+		g_FrameTimeStats.AddSample( fElapsedTime );
+	}
+	g_bClockSampleStall = false;
+
 	if( !g_bPaused )
 	{
-		g_SmoothedTimer.Update( fElapsedTime );
-		g_Scene.OnFrameMove( g_SmoothedTimer.GetTime(), g_SmoothedTimer.GetElapsedTime(), g_CurrentRT );
+		unsigned int numSteps = g_SimulationClock.Advance( fElapsedTime );
+		for( unsigned int step = 0; step < numSteps; ++step )
+		{
+			g_Scene.Simulate( g_SimulationClock.GetStepEndTime( step ), g_SimulationClock.GetStepTime() );
+		}
+		g_Scene.OnFrameMove( g_SimulationClock.GetInterpolation(), g_CurrentRT );
+
+		float motionX, motionY;
+		if( g_bMotionAdaptive && g_bHaveVelocityStatistics )
+		{
+			// measured motion, which unlike the camera estimate includes moving objects
+			motionX = g_VelocityStatistics.meanAbsX;
+			motionY = g_VelocityStatistics.meanAbsY;
+		}
+		else
+		{
+			g_Scene.GetCameraScreenMotion( &motionX, &motionY );
+		}
+		g_AxisScaleSelector.UpdateMotion( motionX, motionY );
 	}
 	else
 	{
 		g_Scene.OnFramePaused(  g_CurrentRT );
+		g_AxisScaleSelector.UpdateMotion( 0.0f, 0.0f );
 	}
+
+	g_CPUUpdateTime = (float)( DXUTGetGlobalTimer()->GetAbsoluteTime() - cpuUpdateStartTime );
 }
 
 //--------------------------------------------------------------------------------------
@@ -734,19 +1000,76 @@ void CALLBACK OnD3D11FrameRender( ID3D11Device* pD3DDevice,
         return;
     }
 
-	float gpuFrameInnerWorkTime, gpuFrameClearTime, gpuFrameSceneTime, gpuFramePostProcTime, gpuFrameScaleTime;
-	g_GPUFrameInnerWorkTimer.HaveUpdatedAveragedIntervalTime( pD3DImmediateContext, &gpuFrameInnerWorkTime );
-	g_GPUFrameClearTimer.HaveUpdatedAveragedIntervalTime( pD3DImmediateContext, &gpuFrameClearTime );
-	// only check if one of the timers is updated, update the GUI from this
-	bool bUpdateStats = g_GPUFrameSceneTimer.HaveUpdatedAveragedIntervalTime( pD3DImmediateContext, &gpuFrameSceneTime );
-	g_GPUFramePostProcTimer.HaveUpdatedAveragedIntervalTime( pD3DImmediateContext, &gpuFramePostProcTime );
-	g_GPUFrameScaleTimer.HaveUpdatedAveragedIntervalTime( pD3DImmediateContext, &gpuFrameScaleTime );
+	// before the frame starts, so the wait for the GPU is not counted as submission
+	double clockSampleTime = DXUTGetGlobalTimer()->GetAbsoluteTime();
+	if( ( g_bMeasureGPULatency || g_TraceRecorder.IsCapturing() ) && clockSampleTime - g_LastClockSampleTime >= g_ClockSamplePeriod )
+	{
+		g_GPUQueryBackend.SampleClocks( &g_GPUClockCalibration );
+		g_LastClockSampleTime = clockSampleTime;
+		g_bClockSampleStall = true;
+	}
+
+	double cpuSubmitStartTime = DXUTGetGlobalTimer()->GetAbsoluteTime();
+	TRACE_CPU_SCOPE( "OnD3D11FrameRender" );
+
+	// resolves the results of completed frames, then starts profiling this one
+	g_GPUProfiler.BeginFrame();
+	++g_GPUFrameCount;
+	g_TraceRecorder.MarkGPUFrameStart();
+	if( g_GPUProfiler.HaveNewResults() )
+	{
+		UpdateGPULatency();
+	}
 
+	float gpuFrameInnerWorkTime, gpuFrameClearTime, gpuFrameSceneTime, gpuFramePostProcTime, gpuFrameScaleTime;
+	bool bHaveGPUTime = g_GPUProfiler.GetAveragedTime( g_GPUScopeFrame, &gpuFrameInnerWorkTime );
+	g_GPUProfiler.GetAveragedTime( g_GPUScopeClear, &gpuFrameClearTime );
+	g_GPUProfiler.GetAveragedTime( g_GPUScopeScene, &gpuFrameSceneTime );
+	g_GPUProfiler.GetAveragedTime( g_GPUScopePostProc, &gpuFramePostProcTime );
+	g_GPUProfiler.GetAveragedTime( g_GPUScopeScale, &gpuFrameScaleTime );
+	// update the GUI only when the averages are updated
+	bool bUpdateStats = g_GPUProfiler.HaveUpdatedAverages();
+
+	// feed the cost model with the new averages against the average pixel count of the same interval
+	if( bUpdateStats && g_CostModelNumFrames )
+	{
+		float passTimes[ COST_PASS_COUNT ];
+		passTimes[ COST_PASS_CLEAR ]	= gpuFrameClearTime;
+		passTimes[ COST_PASS_SCENE ]	= gpuFrameSceneTime;
+		passTimes[ COST_PASS_POSTPROC ]	= gpuFramePostProcTime;
+		passTimes[ COST_PASS_SCALE ]	= gpuFrameScaleTime;
+		passTimes[ COST_PASS_OTHER ]	= gpuFrameInnerWorkTime - gpuFrameClearTime - gpuFrameSceneTime - gpuFramePostProcTime - gpuFrameScaleTime;
+		if( passTimes[ COST_PASS_OTHER ] < 0.0f )
+		{
+			passTimes[ COST_PASS_OTHER ] = 0.0f;
+		}
+		g_FrameCostModel.AddSample( (float)( g_CostModelPixelSum / g_CostModelNumFrames ), passTimes );
+		g_CostModelPixelSum = 0.0;
+		g_CostModelNumFrames = 0;
+	}
+	UpdatePipelineStatistics( gpuFrameClearTime, gpuFrameSceneTime, gpuFramePostProcTime );
+
+	// submit time is from the previous frame, as this frame's is not known yet
+	FrameBoundInput boundInput;
+	boundInput.frameTime		= fElapsedTime;
+	boundInput.gpuTime			= gpuFrameInnerWorkTime;
+	boundInput.cpuUpdateTime	= g_CPUUpdateTime;
+	boundInput.cpuSubmitTime	= g_CPUSubmitTime;
+	boundInput.cpuPresentTime	= g_CPUPresentTime;
+	boundInput.targetTime		= ( CONTROL_MODE_HALFVSYNC == g_ControlMode ? 2.0f : 1.0f ) / g_VSyncFrameRate;
+	if( bHaveGPUTime )
+	{
+		g_FrameBoundClassifier.Update( boundInput );
+	}
 
 	// control resolution if dynamic resolution enabled
 	if( g_bDynamicResolutionEnabled )
 	{
-		ControlResolution( gpuFrameInnerWorkTime );
+		if( g_bMotionAdaptive )
+		{
+			ReadBackVelocityStatistics( pD3DImmediateContext );
+		}
+		ControlResolution( gpuFrameInnerWorkTime, bHaveGPUTime );
 	}
 
 	if( bUpdateStats )
@@ -834,6 +1157,11 @@ void CALLBACK OnD3D11FrameRender( ID3D11Device* pD3DDevice,
 		srViewsPostProcess[1] = g_VelocityDynamic[g_CurrentRT].GetShaderResourceView();
 	}
 
+	g_CostModelPixelSum += viewPortSceneAndPostProcess.Width * viewPortSceneAndPostProcess.Height;
+	++g_CostModelNumFrames;
+	g_PipelineStatsPixelSum += viewPortSceneAndPostProcess.Width * viewPortSceneAndPostProcess.Height;
+	++g_PipelineStatsNumFrames;
+
 	if(!g_bMotionBlur)
 	{
 		//initial render draws straight to post process RT
@@ -845,10 +1173,11 @@ void CALLBACK OnD3D11FrameRender( ID3D11Device* pD3DDevice,
 	// OnD3D11FrameRender Section: start of scene render code
 
 	DXUT_BeginPerfEvent( DXUT_PERFEVENTCOLOR, L"Inner Frame" );
-	g_GPUFrameInnerWorkTimer.Begin( pD3DImmediateContext );
+	g_GPUProfiler.BeginScope( g_GPUScopeFrame );
 
 	DXUT_BeginPerfEvent( DXUT_PERFEVENTCOLOR, L"Clear" );
-	g_GPUFrameClearTimer.Begin( pD3DImmediateContext );;
+	g_GPUProfiler.BeginScope( g_GPUScopeClear );
+	g_PassPipelineStats[ COST_PASS_CLEAR ].Begin();
 
 
 	pD3DImmediateContext->RSSetViewports( 1, &viewPortSceneAndPostProcess );
@@ -888,26 +1217,41 @@ void CALLBACK OnD3D11FrameRender( ID3D11Device* pD3DDevice,
 		pD3DImmediateContext->OMSetDepthStencilState( NULL, 0 );	//reset state to default
 	}
 
-	g_GPUFrameClearTimer.End( pD3DImmediateContext );
+	g_PassPipelineStats[ COST_PASS_CLEAR ].End();
+	g_GPUProfiler.EndScope();
 	DXUT_Dynamic_D3DPERF_EndEvent();
 
 	//--------------------------------------------------------------------------------------
 	// OnD3D11FrameRender Section: render scene
 
 	DXUT_BeginPerfEvent( DXUT_PERFEVENTCOLOR, L"Scene Forwards Render" );
-	g_GPUFrameSceneTimer.Begin( pD3DImmediateContext );
+	{
+		PROFILE_GPU_SCOPE( g_GPUScopeScene );
+		TRACE_CPU_SCOPE( "RenderScene" );
+		g_PassPipelineStats[ COST_PASS_SCENE ].Begin();
+		g_Scene.RenderScene( pD3DDevice, pD3DImmediateContext, pJitter );
+		g_PassPipelineStats[ COST_PASS_SCENE ].End();
+	}
+	DXUT_Dynamic_D3DPERF_EndEvent();
 
-	g_Scene.RenderScene( pD3DDevice, pD3DImmediateContext, pJitter );
+	//--------------------------------------------------------------------------------------
+	// OnD3D11FrameRender Section: reduce velocity for motion adaptive control
 
-	g_GPUFrameSceneTimer.End( pD3DImmediateContext );
-	DXUT_Dynamic_D3DPERF_EndEvent();
+	if( g_bDynamicResolutionEnabled && g_bMotionAdaptive )
+	{
+		DXUT_BeginPerfEvent( DXUT_PERFEVENTCOLOR, L"Reduce Velocity" );
+		PROFILE_GPU_SCOPE( "Reduce Velocity" );
+		ReduceVelocityBuffer( pD3DImmediateContext, g_VelocityDynamic[g_CurrentRT].GetShaderResourceView() );
+		DXUT_Dynamic_D3DPERF_EndEvent();
+	}
 
 
 	//--------------------------------------------------------------------------------------
 	// OnD3D11FrameRender Section: render post process
 
 	DXUT_BeginPerfEvent( DXUT_PERFEVENTCOLOR, L"Post Process Motion Blur" );
-	g_GPUFramePostProcTimer.Begin( pD3DImmediateContext );
+	g_GPUProfiler.BeginScope( g_GPUScopePostProc );
+	g_PassPipelineStats[ COST_PASS_POSTPROC ].Begin();
 
    // Set render resources
 	pD3DImmediateContext->OMSetRenderTargets( 2, rtvPostProcess, NULL );
@@ -970,7 +1314,8 @@ void CALLBACK OnD3D11FrameRender( ID3D11Device* pD3DDevice,
 		pD3DImmediateContext->Draw( 4, 0 );
 	}
 
-	g_GPUFramePostProcTimer.End( pD3DImmediateContext );
+	g_PassPipelineStats[ COST_PASS_POSTPROC ].End();
+	g_GPUProfiler.EndScope();
 	DXUT_Dynamic_D3DPERF_EndEvent();
 
 	//--------------------------------------------------------------------------------------
@@ -978,15 +1323,19 @@ void CALLBACK OnD3D11FrameRender( ID3D11Device* pD3DDevice,
 	// (if required)
 
 	DXUT_BeginPerfEvent( DXUT_PERFEVENTCOLOR, L"Frame Scale" );
-	g_GPUFrameScaleTimer.Begin( pD3DImmediateContext );
+	g_GPUProfiler.BeginScope( g_GPUScopeScale );
+	g_PassPipelineStats[ COST_PASS_SCALE ].Begin();
 
 	if( g_bDynamicResolutionEnabled )
 	{
+		// reduce super sampled images to no more than 2x the back buffer before the resolve
+		DownsampleFinalRT( pD3DImmediateContext, g_CurrentRT );
+
 		//render resolve
 		if( g_bPaused  && g_CurrentRT )
-			srViewsPostProcess[0] = g_FinalRTDynamic[1-g_CurrentRT].GetShaderResourceView();
+			srViewsPostProcess[0] = GetFinalSRV( 1-g_CurrentRT );
 		else
-			srViewsPostProcess[0] = g_FinalRTDynamic[g_CurrentRT].GetShaderResourceView();
+			srViewsPostProcess[0] = GetFinalSRV( g_CurrentRT );
 
 		srViewsPostProcess[1] = NULL;	// may require 2nd SRV
 		srViewsPostProcess[2] = NULL;	// may require 3rd SRV
@@ -1035,8 +1384,8 @@ void CALLBACK OnD3D11FrameRender( ID3D11Device* pD3DDevice,
 				D3D11_MAPPED_SUBRESOURCE MappedResource;
 				pD3DImmediateContext->Map( m_pCBPSResolveCubic, 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedResource );
 				CB_PS_RESOLVECUBIC* pResolve = ( CB_PS_RESOLVECUBIC* )MappedResource.pData;
-				pResolve->g_SizeSource.x = (float)g_DynamicResolution.GetDynamicBufferWidth();
-				pResolve->g_SizeSource.y = (float)g_DynamicResolution.GetDynamicBufferHeight();
+				pResolve->g_SizeSource.x = (float)GetFinalWidth( g_CurrentRT );
+				pResolve->g_SizeSource.y = (float)GetFinalHeight( g_CurrentRT );
 				pResolve->g_texsize_x.x = 1.0f/pResolve->g_SizeSource.x;
 				pResolve->g_texsize_x.y = 0.0f;
 				pResolve->g_texsize_y.x = 0.0f;
@@ -1079,8 +1428,8 @@ void CALLBACK OnD3D11FrameRender( ID3D11Device* pD3DDevice,
 				CB_PS_RESOLVENOISE* pResolve = ( CB_PS_RESOLVENOISE* )MappedResource.pData;
 				pResolve->g_NoiseTexScale.x = g_NoiseTextureSize;
 				pResolve->g_NoiseTexScale.y = g_NoiseTextureSize;
-				pResolve->g_NoiseScale.x = 0.5f / (float)g_DynamicResolution.GetDynamicBufferWidth();
-				pResolve->g_NoiseScale.y = 0.5f / (float)g_DynamicResolution.GetDynamicBufferHeight();
+				pResolve->g_NoiseScale.x = 0.5f / (float)GetFinalWidth( g_CurrentRT );
+				pResolve->g_NoiseScale.y = 0.5f / (float)GetFinalHeight( g_CurrentRT );
 				pD3DImmediateContext->Unmap( m_pCBPSResolveNoise, 0 );
 				pD3DImmediateContext->PSSetConstantBuffers( 0, 1, &m_pCBPSResolveNoise );
 				srViewsPostProcess[1] = g_pNoiseTextureSRV;
@@ -1122,16 +1471,16 @@ void CALLBACK OnD3D11FrameRender( ID3D11Device* pD3DDevice,
 
 			//choose for scale factor to reduce effect of previous pixel by 1/2 when velocity shows colour data comes from 1 pixel away
 			//this requires a scale factor of 1 after we scale the velocity to be in units of pixels
-			pTemporalAAPSConstant->g_VelocityScale.x = static_cast<float>( g_DynamicResolution.GetDynamicBufferWidth() );
-			pTemporalAAPSConstant->g_VelocityScale.y = static_cast<float>( g_DynamicResolution.GetDynamicBufferHeight() );
+			pTemporalAAPSConstant->g_VelocityScale.x = static_cast<float>( GetFinalWidth( currRT ) );
+			pTemporalAAPSConstant->g_VelocityScale.y = static_cast<float>( GetFinalHeight( currRT ) );
 			pTemporalAAPSConstant->g_VelocityAlphaScale.x = g_VelocityToAlphaScale * g_VelocityToAlphaScale;
 			pD3DImmediateContext->Unmap( m_pCBPSPostProcessTemporalAA, 0 );
 			pD3DImmediateContext->PSSetConstantBuffers( 1, 1, &m_pCBPSPostProcessTemporalAA );	//use buffer slot b1
 
 
 			// Set up srvs.
-			srViewsPostProcess[0] = g_FinalRTDynamic[currRT].GetShaderResourceView();
-			srViewsPostProcess[1] = g_FinalRTDynamic[1 - currRT].GetShaderResourceView();
+			srViewsPostProcess[0] = GetFinalSRV( currRT );
+			srViewsPostProcess[1] = GetFinalSRV( 1 - currRT );
 			srViewsPostProcess[2] = g_VelocityDynamic[currRT].GetShaderResourceView();
 			srViewsPostProcess[3] = g_VelocityDynamic[1 - currRT].GetShaderResourceView();
 
@@ -1173,8 +1522,8 @@ void CALLBACK OnD3D11FrameRender( ID3D11Device* pD3DDevice,
 				// constant scale gives noise pixels scaling with 1/dynamic_resolution
 				pResolve->g_NoiseTexScale.x = g_NoiseTextureSize;
 				pResolve->g_NoiseTexScale.y = g_NoiseTextureSize;
-				pResolve->g_NoiseScale.x = 0.5f / (float)g_DynamicResolution.GetDynamicBufferWidth();
-				pResolve->g_NoiseScale.y = 0.5f / (float)g_DynamicResolution.GetDynamicBufferHeight();
+				pResolve->g_NoiseScale.x = 0.5f / (float)GetFinalWidth( currRT );
+				pResolve->g_NoiseScale.y = 0.5f / (float)GetFinalHeight( currRT );
 				pD3DImmediateContext->Unmap( m_pCBPSResolveNoise, 0 );
 				pD3DImmediateContext->PSSetConstantBuffers( 0, 1, &m_pCBPSResolveNoise );
 				srViewsPostProcess[4] = g_pNoiseTextureSRV;
@@ -1194,7 +1543,8 @@ void CALLBACK OnD3D11FrameRender( ID3D11Device* pD3DDevice,
 	//ensure resources no longer bound
 	memset( srViewsPostProcess, 0, sizeof( srViewsPostProcess ) );
 	pD3DImmediateContext->PSSetShaderResources( 0, sizeof( srViewsPostProcess ) / sizeof( ID3D11ShaderResourceView* ), srViewsPostProcess );
-	g_GPUFrameScaleTimer.End( pD3DImmediateContext );
+	g_PassPipelineStats[ COST_PASS_SCALE ].End();
+	g_GPUProfiler.EndScope();
 	DXUT_Dynamic_D3DPERF_EndEvent();
 
     ID3D11RenderTargetView* pRTV = DXUTGetD3D11RenderTargetView();
@@ -1210,6 +1560,7 @@ void CALLBACK OnD3D11FrameRender( ID3D11Device* pD3DDevice,
     // Display GUI if enabled 
     if( g_bDisplayGUI )
     {
+		TRACE_CPU_SCOPE( "UI" );
 		g_HUD.OnRender( fElapsedTime );
 		g_SampleUI.OnRender( fElapsedTime );
 		g_HelpUI.OnRender( fElapsedTime );
@@ -1218,26 +1569,37 @@ void CALLBACK OnD3D11FrameRender( ID3D11Device* pD3DDevice,
     // Display the demo text if enabled
     if( g_bDisplayDemoText )
     {
+		TRACE_CPU_SCOPE( "Demo Text" );
         RenderText();
     }
 
-	g_GPUFrameInnerWorkTimer.End( pD3DImmediateContext );
+	g_GPUProfiler.EndScope();
+	g_GPUProfiler.EndFrame();
 
+	// includes Scene::RenderScene submission, Present follows once this returns
+	g_CPURenderEndTime = DXUTGetGlobalTimer()->GetAbsoluteTime();
+	g_SubmitEndTimes[ g_GPUFrameCount % g_SubmitEndTimeCount ] = g_CPURenderEndTime;
+	g_CPUSubmitTime = (float)( g_CPURenderEndTime - cpuSubmitStartTime );
+
+	if( g_TelemetryLogger.IsOpen() )
+	{
+		LogTelemetry( fElapsedTime );
+	}
 }
 
 //--------------------------------------------------------------------------------------
 // Resolution Control Code
 //
-// The control method here is a simple proportional method, as we are dealing with a 
-// continuously varying quantity which is directly related to the measured input (frame time)
-// and which has no momentum.
-//
-// No hysteris is used since it's a continuous quantity, but the algorithm could be easily
-// improved to reduce or even remove resolution changes when the camera is stationary as
-// this causes the a slight visible swimming effect.
+// The control mode selects the target frame time and the selected IResolutionController
+// (see ResolutionController.h) moves the scale towards it; the default is the original
+// simple proportional method. The axis selector, motion adaptive policy and bound gating
+// then adjust the result when enabled.
 //--------------------------------------------------------------------------------------
-void ControlResolution( float gpuFrameInnerWorkTime )
+void ControlResolution( float gpuFrameInnerWorkTime, bool bHaveGPUTime )
 {
+	TRACE_CPU_SCOPE( "ControlResolution" );
+	g_LastControlTime = 0.0f;
+	g_LastTargetTime = 0.0f;
 	float optimalElapsedTime = 1.0f/g_VSyncFrameRate;
 	switch( g_ControlMode )
 	{
@@ -1250,30 +1612,65 @@ void ControlResolution( float gpuFrameInnerWorkTime )
 
 	case CONTROL_MODE_VSYNC:		//Vsync, so 60FPS if this is the monitor frequency
 		{
-			// use average of measured inner loop time and FPS
-			// to account for both CPU and GPU activities to some extent
 			float frameTime = 1.0f/DXUTGetFPS();
-			float controlTime =  (gpuFrameInnerWorkTime + frameTime)/2.0f;
-			if( frameTime > 2.0f * gpuFrameInnerWorkTime )
+			if( FRAME_TIME_INPUT_FPS != g_FrameTimeInput && g_FrameTimeStats.GetNumSamples() )
+			{
+				// recent per frame statistics react to load changes and hitches much sooner
+				frameTime = GetFrameTimeInput( g_FrameTimeStats, g_FrameTimeInput );
+			}
+
+			bool bMotionAdaptive = g_bMotionAdaptive && g_bHaveVelocityStatistics;
+			float scaleMin = g_ControlledScaleMin;
+			if( bMotionAdaptive )
 			{
-				// Some activities can cause frame rate spikes in overall time not
-				// due to GPU activity, so we ignore these. For example changing resolution & going fullscreen.
-				// additionally we may be completely CPU bound so should not throttle GPU too much
-				controlTime = gpuFrameInnerWorkTime;
+				g_MotionAdaptivePolicy.UpdateMotion( g_VelocityStatistics.meanSpeed );
+				scaleMin = g_MotionAdaptivePolicy.GetScaleMin( g_ControlledScaleMin );
 			}
-			float timeRatio = controlTime / optimalElapsedTime;
-			const float rateOfChange = 0.01f;
-			float scaleRatio =  rateOfChange * (1.0f-timeRatio) + 1.0f;
-			g_ControlledScale = scaleRatio * g_ControlledScale;
-			if( g_ControlledScale < g_ControlledScaleMin )
+
+			ResolutionControlInput input;
+			// until the first GPU timings arrive control on the CPU frame time alone,
+			// rather than treating the missing GPU time as a very fast frame
+			input.controlTime	= bHaveGPUTime ? CalculateControlTime( gpuFrameInnerWorkTime, frameTime ) : frameTime;
+			input.targetTime	= optimalElapsedTime;
+			input.currentScale	= g_ControlledScale;
+			input.scaleMin		= scaleMin;
+			input.scaleMax		= (float)g_ResolutionScaleMax;
+			input.scalePixelCount	= g_ViewPort.Width * g_ViewPort.Height;
+			input.shadedPixelCost	= g_ShadedPixelCost;
+			input.overdraw			= g_Overdraw;
+			g_LastControlTime		= input.controlTime;
+			g_LastTargetTime		= input.targetTime;
+			float newScale = g_pResolutionControllers[ g_ControllerType ]->Update( input );
+			if( bMotionAdaptive )
+			{
+				newScale = g_MotionAdaptivePolicy.Apply( input, newScale );
+			}
+			if( g_bBoundGating && !g_FrameBoundClassifier.IsDecreaseAllowed( bHaveGPUTime ? gpuFrameInnerWorkTime : 0.0f, optimalElapsedTime ) )
 			{
-				g_ControlledScale = g_ControlledScaleMin;
+				// lowering the resolution only helps when the GPU is the bottleneck
+				float holdScale = min( g_ControlledScale, input.scaleMax );
+				if( newScale < holdScale )
+				{
+					newScale = holdScale;
+				}
 			}
-			if( g_ControlledScale > (float)g_ResolutionScaleMax )
+			g_ControlledScale = newScale;
+			if( g_bAspectRatioLock )
 			{
-				g_ControlledScale = (float)g_ResolutionScaleMax;
+				g_DynamicResolution.SetScale( g_ControlledScale, g_ControlledScale );
+			}
+			else
+			{
+				// same pixel count, but split between the axes based on screen motion
+				AxisScaleLimits limits;
+				limits.minX = min( g_ControlledScaleMinX, scaleMin );
+				limits.maxX = min( g_ControlledScaleMaxX, (float)g_ResolutionScaleMax );
+				limits.minY = min( g_ControlledScaleMinY, scaleMin );
+				limits.maxY = min( g_ControlledScaleMaxY, (float)g_ResolutionScaleMax );
+				float scaleX, scaleY;
+				g_AxisScaleSelector.Select( g_ControlledScale, limits, &scaleX, &scaleY );
+				g_DynamicResolution.SetScale( scaleX, scaleY );
 			}
-			g_DynamicResolution.SetScale( g_ControlledScale, g_ControlledScale );
 
 			//update individual counters
 			g_ResolutionScaleX = (UINT)(100.0f*g_DynamicResolution.GetScaleX());
@@ -1283,6 +1680,240 @@ void ControlResolution( float gpuFrameInnerWorkTime )
 }
 
 
+//--------------------------------------------------------------------------------------
+// Push one telemetry record for this frame. GPU times are those of the frame resolved by
+// the profiler this frame, if any, so are GetLastLatency() frames behind the CPU time.
+//--------------------------------------------------------------------------------------
+void LogTelemetry( float cpuFrameTime )
+{
+	TelemetryRecord record;
+	memset( &record, 0, sizeof( record ) );
+	record.frame			= g_TelemetryFrame++;
+	record.cpuFrameTime		= cpuFrameTime;
+
+	if( g_GPUProfiler.HaveNewResults() )
+	{
+		const char* const pScopes[] = { g_GPUScopeFrame, g_GPUScopeClear, g_GPUScopeScene, g_GPUScopePostProc, g_GPUScopeScale };
+		float* const pTimes[] = { &record.gpuFrameTime, &record.clearTime, &record.sceneTime, &record.postProcTime, &record.scaleTime };
+		for( unsigned int i = 0; i < sizeof( pScopes ) / sizeof( pScopes[0] ); ++i )
+		{
+			unsigned int result = g_GPUProfiler.FindResult( pScopes[i] );
+			if( GPUProfiler::INVALID_SCOPE != result )
+			{
+				*pTimes[i] = g_GPUProfiler.GetResult( result ).time;
+			}
+		}
+		record.flags |= TELEMETRY_FLAG_GPU_TIMES;
+	}
+
+	D3D11_VIEWPORT viewport( g_ViewPort );
+	if( g_bDynamicResolutionEnabled )
+	{
+		g_DynamicResolution.GetViewport( &viewport );
+		record.scaleX		= g_DynamicResolution.GetScaleX();
+		record.scaleY		= g_DynamicResolution.GetScaleY();
+		record.flags		|= TELEMETRY_FLAG_DYNAMIC_RESOLUTION;
+	}
+	else
+	{
+		record.scaleX		= 1.0f;
+		record.scaleY		= 1.0f;
+	}
+	record.viewportWidth	= (unsigned short)viewport.Width;
+	record.viewportHeight	= (unsigned short)viewport.Height;
+	record.controlTime		= g_LastControlTime;
+	record.targetTime		= g_LastTargetTime;
+	record.resolveMode		= (unsigned char)g_ResolveMode;
+	record.controlMode		= (unsigned char)g_ControlMode;
+	record.controllerType	= (unsigned char)g_ControllerType;
+	record.frameBound		= (unsigned char)g_FrameBoundClassifier.GetBound();
+	if( g_bMotionAdaptive && g_MotionAdaptivePolicy.IsLocked() )
+	{
+		record.flags |= TELEMETRY_FLAG_MOTION_LOCKED;
+	}
+	if( g_bBoundGating )
+	{
+		record.flags |= TELEMETRY_FLAG_BOUND_GATING;
+	}
+	g_TelemetryLogger.Push( record );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Reduce g_FinalRTDynamic[rt] by 2:1 steps through its downsample pyramid until it is
+// no more than 2x the back buffer. Each step is a bilinear sample at the corner of four
+// source texels, i.e. a 2x2 box filter. The viewport at each level keeps the RT scale
+// ratio of the dynamic buffer, so the resolve texture coordinates are unchanged. Odd
+// viewport sizes round up so the resolve never samples an unwritten texel.
+//--------------------------------------------------------------------------------------
+void DownsampleFinalRT( ID3D11DeviceContext* pD3DImmediateContext, unsigned int rt )
+{
+	g_DownsampleLevelUsed[ rt ] = min( g_DynamicResolution.GetNumDownsampleSteps(), g_NumDownsampleLevels );
+	if( 0 == g_DownsampleLevelUsed[ rt ] )
+	{
+		return;
+	}
+
+	DXUT_BeginPerfEvent( DXUT_PERFEVENTCOLOR, L"Downsample" );
+	PROFILE_GPU_SCOPE( "Downsample" );
+
+	static const UINT stride = sizeof( D3DXVECTOR3 );
+	static const UINT offset = 0;
+	pD3DImmediateContext->IASetVertexBuffers( 0, 1, &g_pFullScreenQuadBuffer, &stride, &offset );
+	pD3DImmediateContext->IASetIndexBuffer( NULL, DXGI_FORMAT_R16_UINT, 0 );
+	pD3DImmediateContext->IASetPrimitiveTopology( D3D10_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP );
+	pD3DImmediateContext->IASetInputLayout( g_pPostProcessDynamicInputLayout );
+	pD3DImmediateContext->VSSetShader( g_pPostProcessDynamicVertexShader, NULL, 0 );
+	pD3DImmediateContext->PSSetShader( g_pResolveDynamicPixelShader, NULL, 0 );
+	pD3DImmediateContext->PSSetSamplers( 0, 1, &g_pSamLinear );
+
+	D3D11_MAPPED_SUBRESOURCE MappedResource;
+	pD3DImmediateContext->Map( m_pCBPostProcess, 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedResource );
+	CB_VS_POSTPROCESS* pPostProcess = ( CB_VS_POSTPROCESS* )MappedResource.pData;
+	pPostProcess->g_SubSampleRTCurrRatio.x = g_DynamicResolution.GetRTScaleX();
+	pPostProcess->g_SubSampleRTCurrRatio.y = g_DynamicResolution.GetRTScaleY();
+	pD3DImmediateContext->Unmap( m_pCBPostProcess, 0 );
+	pD3DImmediateContext->VSSetConstantBuffers( 0, 1, &m_pCBPostProcess );
+
+	ID3D11ShaderResourceView* pSourceSRV = g_FinalRTDynamic[ rt ].GetShaderResourceView();
+	for( UINT level = 0; level < g_DownsampleLevelUsed[ rt ]; ++level )
+	{
+		Utility::RenderTarget& dest = g_DownsampleDynamic[ rt ][ level ];
+		ID3D11RenderTargetView* pRTV = dest.GetRenderTargetView();
+		pD3DImmediateContext->OMSetRenderTargets( 1, &pRTV, NULL );
+
+		D3D11_VIEWPORT viewPortLevel;
+		viewPortLevel.TopLeftX = 0.0f;
+		viewPortLevel.TopLeftY = 0.0f;
+		viewPortLevel.Width = ceil( g_DynamicResolution.GetRTScaleX() * ( g_DynamicResolution.GetDynamicBufferWidth() >> ( level + 1 ) ) );
+		viewPortLevel.Height = ceil( g_DynamicResolution.GetRTScaleY() * ( g_DynamicResolution.GetDynamicBufferHeight() >> ( level + 1 ) ) );
+		viewPortLevel.MinDepth = 0.0f;
+		viewPortLevel.MaxDepth = 1.0f;
+		pD3DImmediateContext->RSSetViewports( 1, &viewPortLevel );
+		pD3DImmediateContext->PSSetShaderResources( 0, 1, &pSourceSRV );
+
+		pD3DImmediateContext->Draw( 4, 0 );
+
+		// unbind the source before it may be bound as a render target
+		ID3D11ShaderResourceView* pNullSRV = NULL;
+		pD3DImmediateContext->PSSetShaderResources( 0, 1, &pNullSRV );
+		pSourceSRV = dest.GetShaderResourceView();
+	}
+
+	DXUT_Dynamic_D3DPERF_EndEvent();
+}
+
+//--------------------------------------------------------------------------------------
+// Final image of g_FinalRTDynamic[rt] after any downsampling, and its texture size
+//--------------------------------------------------------------------------------------
+ID3D11ShaderResourceView* GetFinalSRV( unsigned int rt )
+{
+	if( g_DownsampleLevelUsed[ rt ] )
+	{
+		return g_DownsampleDynamic[ rt ][ g_DownsampleLevelUsed[ rt ] - 1 ].GetShaderResourceView();
+	}
+	return g_FinalRTDynamic[ rt ].GetShaderResourceView();
+}
+
+UINT GetFinalWidth( unsigned int rt )
+{
+	return g_DynamicResolution.GetDynamicBufferWidth() >> g_DownsampleLevelUsed[ rt ];
+}
+
+UINT GetFinalHeight( unsigned int rt )
+{
+	return g_DynamicResolution.GetDynamicBufferHeight() >> g_DownsampleLevelUsed[ rt ];
+}
+
+//--------------------------------------------------------------------------------------
+// Reduce the dynamic velocity buffer to VelocityReduceConsts::cReducedSize squared
+// texels with PSReduceVelocity, and queue a copy of the result for readback.
+//--------------------------------------------------------------------------------------
+void ReduceVelocityBuffer( ID3D11DeviceContext* pD3DImmediateContext, ID3D11ShaderResourceView* pVelocitySRV )
+{
+	ID3D11RenderTargetView* pRTV = g_VelocityReduced.GetRenderTargetView();
+	pD3DImmediateContext->OMSetRenderTargets( 1, &pRTV, NULL );
+	D3D11_VIEWPORT viewPortReduced;
+	viewPortReduced.TopLeftX = 0.0f;
+	viewPortReduced.TopLeftY = 0.0f;
+	viewPortReduced.Width = (float)VelocityReduceConsts::cReducedSize;
+	viewPortReduced.Height = (float)VelocityReduceConsts::cReducedSize;
+	viewPortReduced.MinDepth = 0.0f;
+	viewPortReduced.MaxDepth = 1.0f;
+	pD3DImmediateContext->RSSetViewports( 1, &viewPortReduced );
+	pD3DImmediateContext->PSSetShaderResources( 1, 1, &pVelocitySRV );
+
+	static const UINT stride = sizeof( D3DXVECTOR3 );
+	static const UINT offset = 0;
+	pD3DImmediateContext->IASetVertexBuffers( 0, 1, &g_pFullScreenQuadBuffer, &stride, &offset );
+	pD3DImmediateContext->IASetIndexBuffer( NULL, DXGI_FORMAT_R16_UINT, 0 );
+	pD3DImmediateContext->IASetPrimitiveTopology( D3D10_PRIMITIVE_TOPOLOGY_TRIANGLESTRIP );
+	pD3DImmediateContext->IASetInputLayout( g_pPostProcessDynamicInputLayout );
+	pD3DImmediateContext->VSSetShader( g_pPostProcessDynamicVertexShader, NULL, 0 );
+	pD3DImmediateContext->PSSetShader( g_pReduceVelocityPixelShader, NULL, 0 );
+
+	// Set Constant Buffers, the whole of the reduced texture is written
+	D3D11_MAPPED_SUBRESOURCE MappedResource;
+	pD3DImmediateContext->Map( m_pCBPostProcess, 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedResource );
+	CB_VS_POSTPROCESS* pPostProcess = ( CB_VS_POSTPROCESS* )MappedResource.pData;
+	pPostProcess->g_SubSampleRTCurrRatio.x = 1.0f;
+	pPostProcess->g_SubSampleRTCurrRatio.y = 1.0f;
+	pD3DImmediateContext->Unmap( m_pCBPostProcess, 0 );
+	pD3DImmediateContext->VSSetConstantBuffers( 0, 1, &m_pCBPostProcess );
+
+	pD3DImmediateContext->Map( m_pCBPSReduceVelocity, 0, D3D11_MAP_WRITE_DISCARD, 0, &MappedResource );
+	CB_PS_REDUCEVELOCITY* pReduceVelocity = ( CB_PS_REDUCEVELOCITY* )MappedResource.pData;
+	pReduceVelocity->g_ReduceCellSize.x = g_DynamicResolution.GetRTScaleX() / VelocityReduceConsts::cReducedSize;
+	pReduceVelocity->g_ReduceCellSize.y = g_DynamicResolution.GetRTScaleY() / VelocityReduceConsts::cReducedSize;
+	pReduceVelocity->g_ReduceCellSize.z = g_ViewPort.Width;		// velocity is relative to the viewport,
+	pReduceVelocity->g_ReduceCellSize.w = g_ViewPort.Height;	// so this gives back buffer pixels
+	pD3DImmediateContext->Unmap( m_pCBPSReduceVelocity, 0 );
+	pD3DImmediateContext->PSSetConstantBuffers( 0, 1, &m_pCBPSReduceVelocity );
+
+	pD3DImmediateContext->Draw( 4, 0 );
+
+	// unbind the velocity buffer as it is a render target again next frame
+	ID3D11ShaderResourceView* pNullSRV = NULL;
+	pD3DImmediateContext->PSSetShaderResources( 1, 1, &pNullSRV );
+
+	pD3DImmediateContext->CopyResource( g_pVelocityReadback[ g_VelocityReadbackNext ], g_VelocityReduced.GetTexture2D() );
+	g_VelocityReadbackNext = ( g_VelocityReadbackNext + 1 ) % g_VelocityReadbackDepth;
+	if( g_VelocityReadbackPending < g_VelocityReadbackDepth )
+	{
+		++g_VelocityReadbackPending;
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Read back any reduced velocity copies the GPU has finished, oldest first, without
+// waiting. g_VelocityStatistics is left holding the most recent.
+//--------------------------------------------------------------------------------------
+void ReadBackVelocityStatistics( ID3D11DeviceContext* pD3DImmediateContext )
+{
+	const unsigned int reducedSize = VelocityReduceConsts::cReducedSize;
+	float reduced[ reducedSize * reducedSize * 4 ];
+
+	while( g_VelocityReadbackPending )
+	{
+		unsigned int oldest = ( g_VelocityReadbackNext + g_VelocityReadbackDepth - g_VelocityReadbackPending ) % g_VelocityReadbackDepth;
+		D3D11_MAPPED_SUBRESOURCE MappedResource;
+		if( FAILED( pD3DImmediateContext->Map( g_pVelocityReadback[ oldest ], 0, D3D11_MAP_READ, D3D11_MAP_FLAG_DO_NOT_WAIT, &MappedResource ) ) )
+		{
+			break;	// DXGI_ERROR_WAS_STILL_DRAWING, try again next frame
+		}
+		for( unsigned int row = 0; row < reducedSize; ++row )
+		{
+			memcpy( reduced + row * reducedSize * 4, (BYTE*)MappedResource.pData + row * MappedResource.RowPitch, reducedSize * 4 * sizeof( float ) );
+		}
+		pD3DImmediateContext->Unmap( g_pVelocityReadback[ oldest ], 0 );
+		--g_VelocityReadbackPending;
+
+		CalculateVelocityStatistics( reduced, reducedSize * reducedSize, &g_VelocityStatistics );
+		g_bHaveVelocityStatistics = true;
+	}
+}
+
+
 //--------------------------------------------------------------------------------------
 // Remove resources created in OnD3D11ResizedSwapChain
 //--------------------------------------------------------------------------------------
@@ -1311,6 +1942,16 @@ void ReleaseDynamicResolution()
 	g_DepthBufferDynamic.SafeReleaseAll();
 	g_FinalRTDynamic[0].SafeReleaseAll();
 	g_FinalRTDynamic[1].SafeReleaseAll();
+
+	for( UINT rt = 0; rt < ARRAYSIZE( g_FinalRTDynamic ); ++rt )
+	{
+		for( UINT level = 0; level < g_MaxDownsampleLevels; ++level )
+		{
+			g_DownsampleDynamic[ rt ][ level ].SafeReleaseAll();
+		}
+		g_DownsampleLevelUsed[ rt ] = 0;
+	}
+	g_NumDownsampleLevels = 0;
 }
 
 //--------------------------------------------------------------------------------------
@@ -1336,18 +1977,29 @@ void CALLBACK OnD3D11DestroyDevice( void* pUserContext )
 	SAFE_RELEASE( m_pCBMotionBlur );
 	SAFE_RELEASE( m_pCBPSResolveCubic );
 	SAFE_RELEASE( m_pCBPSResolveNoise );
+	SAFE_RELEASE( m_pCBPSReduceVelocity );
 	SAFE_RELEASE( g_pCubicLookupFilterTex );
 	SAFE_RELEASE( g_pCubicLookupFilterSRV );
 	SAFE_RELEASE( g_pNoiseTextureSRV );
 
+	g_VelocityReduced.SafeReleaseAll();
+	for( unsigned int i = 0; i < g_VelocityReadbackDepth; ++i )
+	{
+		SAFE_RELEASE( g_pVelocityReadback[i] );
+	}
+
 	SAFE_RELEASE( m_pCBVSPostProcessTemporalAA );
 	SAFE_RELEASE( m_pCBPSPostProcessTemporalAA );
 
-	g_GPUFrameInnerWorkTimer.OnD3D11DestroyDevice();
-	g_GPUFrameClearTimer.OnD3D11DestroyDevice();
-	g_GPUFrameSceneTimer.OnD3D11DestroyDevice();
-	g_GPUFramePostProcTimer.OnD3D11DestroyDevice();
-	g_GPUFrameScaleTimer.OnD3D11DestroyDevice();
+	GPUProfiler::SetActive( NULL );
+	g_GPUProfiler.Release();
+	// a new device may not share the old GPU clock
+	g_GPUClockCalibration.Reset();
+	g_LastClockSampleTime = 0.0;
+	for( UINT pass = 0; pass < COST_PASS_OTHER; ++pass )
+	{
+		g_PassPipelineStats[ pass ].Release();
+	}
     g_ZoomBox.OnD3D11DestroyDevice();
 
 	g_Scene.OnD3D11DestroyDevice();
@@ -1468,9 +2120,14 @@ void CALLBACK OnGUIEvent( UINT uEvent,
 		g_SampleUI.GetComboBox( IDC_RESOLVEMODE )->SetEnabled( g_bDynamicResolutionEnabled );
 		g_SampleUI.GetSlider( IDC_RESOLUTIONSCALE_SLIDERX )->SetEnabled( g_bDynamicResolutionEnabled );
 		g_SampleUI.GetSlider( IDC_RESOLUTIONSCALE_SLIDERY )->SetEnabled( g_bDynamicResolutionEnabled );
-		g_SampleUI.GetCheckBox( IDC_SUPERSAMPLING )->SetEnabled( g_bDynamicResolutionEnabled );
+		g_SampleUI.GetComboBox( IDC_SUPERSAMPLING )->SetEnabled( g_bDynamicResolutionEnabled );
 		g_SampleUI.GetCheckBox( IDC_ASPECTRATIOLOCK )->SetEnabled( g_bDynamicResolutionEnabled );
 		g_SampleUI.GetComboBox( IDC_CONTROLMODE )->SetEnabled( g_bDynamicResolutionEnabled );
+		g_SampleUI.GetComboBox( IDC_CONTROLLERTYPE )->SetEnabled( g_bDynamicResolutionEnabled && ( g_ControlMode != CONTROL_MODE_MANUAL ) );
+		g_SampleUI.GetComboBox( IDC_FRAMETIMEINPUT )->SetEnabled( g_bDynamicResolutionEnabled && ( g_ControlMode != CONTROL_MODE_MANUAL ) );
+		g_SampleUI.GetComboBox( IDC_TILESIZE )->SetEnabled( g_bDynamicResolutionEnabled );
+		g_SampleUI.GetCheckBox( IDC_MOTIONADAPTIVE )->SetEnabled( g_bDynamicResolutionEnabled && ( g_ControlMode != CONTROL_MODE_MANUAL ) );
+		g_SampleUI.GetCheckBox( IDC_BOUNDGATING )->SetEnabled( g_bDynamicResolutionEnabled && ( g_ControlMode != CONTROL_MODE_MANUAL ) );
 		break;
     case IDC_RESOLVEMODE:
 		g_ResolveMode = (RESOLVE_MODE)g_SampleUI.GetComboBox( IDC_RESOLVEMODE )->GetSelectedIndex();
@@ -1489,6 +2146,10 @@ void CALLBACK OnGUIEvent( UINT uEvent,
 		g_CameraIndex = g_SampleUI.GetComboBox( IDC_CAMERASELECT )->GetSelectedIndex();
 		g_Scene.SetCamera( g_CameraIndex );
 		break;
+	case IDC_SIMULATIONRATE:
+		g_SimulationRateIndex = g_SampleUI.GetComboBox( IDC_SIMULATIONRATE )->GetSelectedIndex();
+		g_SimulationClock.SetStepRate( g_SimulationRates[ g_SimulationRateIndex ] );
+		break;
         // Display the contact message box
     case GUI_CONTACT:
         RenderContactBox();
@@ -1509,13 +2170,20 @@ void CALLBACK OnGUIEvent( UINT uEvent,
 		ReleaseShaders();
 		CreateShaders( DXUTGetD3D11Device() );
 		break;
+	case IDC_CAPTURETRACE:
+		if( g_TraceRecorder.Start( g_TraceFileName, g_TraceFrames ) && !g_bMeasureGPULatency )
+		{
+			RestartClockCalibration();
+		}
+		break;
+	case IDC_BENCHMARKTHREADS:
+		BenchmarkThreadScaling();
+		break;
 	case IDC_CLEARWITHPIXELSHADER:
 		g_bClearWithPixelShader = !g_bClearWithPixelShader;
 		break;
 	case IDC_SUPERSAMPLING:
-		g_ResolutionScaleMax = 3 - g_ResolutionScaleMax;	// 3 - 1 = 2; 3 - 2 = 1;
-		assert( g_ResolutionScaleMax >= 1 );	//not supported
-		assert( g_ResolutionScaleMax <= 2 );	//not supported
+		g_ResolutionScaleMax = g_SuperSamplingFactors[ g_SampleUI.GetComboBox( IDC_SUPERSAMPLING )->GetSelectedIndex() ];
 		g_bResetDynamicRes = true;
 		g_SampleUI.GetSlider( IDC_RESOLUTIONSCALE_SLIDERX )->SetRange( 1, g_ResolutionScaleMax*100 );
 		g_SampleUI.GetSlider( IDC_RESOLUTIONSCALE_SLIDERX )->SetValue( 1 );	//error in setvalue causes slider to not update unless value passed in does not equal current value, so set to 1 first
@@ -1528,6 +2196,10 @@ void CALLBACK OnGUIEvent( UINT uEvent,
 		g_bShowCameras = !g_bShowCameras;
 		g_Scene.SetShowCameras( g_bShowCameras );
 		break;
+	case IDC_FRUSTUMCULLING:
+		g_bFrustumCulling = !g_bFrustumCulling;
+		g_Scene.SetFrustumCulling( g_bFrustumCulling );
+		break;
 	case IDC_ASPECTRATIOLOCK:
 		g_bAspectRatioLock = !g_bAspectRatioLock;
 		break;
@@ -1536,6 +2208,53 @@ void CALLBACK OnGUIEvent( UINT uEvent,
 		// only enable sliders if both dynamic resolution is on and the control mode is manual.
 		g_SampleUI.GetSlider( IDC_RESOLUTIONSCALE_SLIDERX )->SetEnabled( g_bDynamicResolutionEnabled && ( g_ControlMode == CONTROL_MODE_MANUAL ) );
 		g_SampleUI.GetSlider( IDC_RESOLUTIONSCALE_SLIDERY )->SetEnabled( g_bDynamicResolutionEnabled && ( g_ControlMode == CONTROL_MODE_MANUAL ) );
+		g_SampleUI.GetComboBox( IDC_CONTROLLERTYPE )->SetEnabled( g_bDynamicResolutionEnabled && ( g_ControlMode != CONTROL_MODE_MANUAL ) );
+		g_SampleUI.GetComboBox( IDC_FRAMETIMEINPUT )->SetEnabled( g_bDynamicResolutionEnabled && ( g_ControlMode != CONTROL_MODE_MANUAL ) );
+		g_SampleUI.GetCheckBox( IDC_MOTIONADAPTIVE )->SetEnabled( g_bDynamicResolutionEnabled && ( g_ControlMode != CONTROL_MODE_MANUAL ) );
+		g_SampleUI.GetCheckBox( IDC_BOUNDGATING )->SetEnabled( g_bDynamicResolutionEnabled && ( g_ControlMode != CONTROL_MODE_MANUAL ) );
+		g_pResolutionControllers[ g_ControllerType ]->Reset( g_ControlledScale );
+		break;
+	case IDC_CONTROLLERTYPE:
+		g_ControllerType = (CONTROLLER_TYPE)g_SampleUI.GetComboBox( IDC_CONTROLLERTYPE )->GetSelectedIndex();
+		g_pResolutionControllers[ g_ControllerType ]->Reset( g_ControlledScale );
+		break;
+	case IDC_FRAMETIMEINPUT:
+		g_FrameTimeInput = (FRAME_TIME_INPUT)g_SampleUI.GetComboBox( IDC_FRAMETIMEINPUT )->GetSelectedIndex();
+		g_pResolutionControllers[ g_ControllerType ]->Reset( g_ControlledScale );
+		break;
+	case IDC_TILESIZE:
+		g_TileSizeIndex = g_SampleUI.GetComboBox( IDC_TILESIZE )->GetSelectedIndex();
+		g_DynamicResolution.SetTileSize( g_TileSizes[ g_TileSizeIndex ] );
+		break;
+	case IDC_MOTIONADAPTIVE:
+		g_bMotionAdaptive = !g_bMotionAdaptive;
+		// statistics are only gathered while enabled, so start again from no motion data
+		g_MotionAdaptivePolicy.Reset();
+		g_bHaveVelocityStatistics = false;
+		g_VelocityReadbackPending = 0;
+		g_SampleUI.GetStatic( IDC_MOTIONSTATIC )->SetText( L"Motion (px): NA" );
+		break;
+	case IDC_BOUNDGATING:
+		g_bBoundGating = !g_bBoundGating;
+		break;
+	case IDC_TELEMETRY:
+		if( g_TelemetryLogger.IsOpen() )
+		{
+			g_TelemetryLogger.Close();
+		}
+		else if( g_TelemetryLogger.Open( g_TelemetryFileName ) )
+		{
+			g_TelemetryFrame = 0;
+		}
+		g_SampleUI.GetCheckBox( IDC_TELEMETRY )->SetChecked( g_TelemetryLogger.IsOpen() );
+		break;
+	case IDC_MEASURELATENCY:
+		g_bMeasureGPULatency = !g_bMeasureGPULatency;
+		if( g_bMeasureGPULatency )
+		{
+			RestartClockCalibration();
+			g_GPULatencyStats.Reset();
+		}
 		break;
     }
 }
@@ -1599,18 +2318,64 @@ void UpdateStats( float gpuFrameInnerWorkTime, float gpuFrameClearTime, float gp
 	// Update text occasionally
 	WCHAR sz[100];
 	// Update timing information
-	swprintf_s( sz, L"Frame Time (ms): %.2f", gpuFrameInnerWorkTime*1000.0f );
+	const StreamingStats* pFrameStats = g_GPUProfiler.GetStats( g_GPUScopeFrame );
+	swprintf_s( sz, L"Frame Time avg/95 (ms): %.2f/%.2f", gpuFrameInnerWorkTime*1000.0f, pFrameStats ? pFrameStats->GetP95()*1000.0f : 0.0f );
 	g_SampleUI.GetStatic( IDC_FRAMETIMESTATIC )->SetText( sz );
-	swprintf_s( sz, L"Clear Time (ms): %.2f", gpuFrameClearTime*1000.0f );
-	g_SampleUI.GetStatic( IDC_CLEARTIMESTATIC )->SetText( sz );
-	swprintf_s( sz, L"Scene Time (ms): %.2f", gpuFrameSceneTime*1000.0f );
-	g_SampleUI.GetStatic( IDC_SCENETIMESTATIC )->SetText( sz );
-	swprintf_s( sz, L"PostP Time (ms): %.2f", gpuFramePostProcTime*1000.0f );
-	g_SampleUI.GetStatic( IDC_POSTPROCTIMESTATIC )->SetText( sz );
-	swprintf_s( sz, L"Scale Time (ms): %.2f", gpuFrameScaleTime*1000.0f );
-	g_SampleUI.GetStatic( IDC_SCALETIMESTATIC )->SetText( sz );
+	SetPassTimeText( IDC_CLEARTIMESTATIC, L"Clear", gpuFrameClearTime, COST_PASS_CLEAR, g_PipelineStatsPixels );
+	SetPassTimeText( IDC_SCENETIMESTATIC, L"Scene", gpuFrameSceneTime, COST_PASS_SCENE, g_PipelineStatsPixels );
+	SetPassTimeText( IDC_POSTPROCTIMESTATIC, L"PostP", gpuFramePostProcTime, COST_PASS_POSTPROC, g_PipelineStatsPixels );
+	// the resolve always writes the whole back buffer
+	SetPassTimeText( IDC_SCALETIMESTATIC, L"Scale", gpuFrameScaleTime, COST_PASS_SCALE, g_ViewPort.Width * g_ViewPort.Height );
+	if( g_PassPipelineStats[ COST_PASS_SCENE ].HaveAveragedStatistics() )
+	{
+		const PipelineStatistics& scene = g_PassPipelineStatsAverages[ COST_PASS_SCENE ];
+		swprintf_s( sz, L"Scene VS/Prim/PS (K): %.0f/%.0f/%.0f", scene.vsInvocations/1000.0f, scene.primitives/1000.0f, scene.psInvocations/1000.0f );
+		g_SampleUI.GetStatic( IDC_PIPELINESTATSSTATIC )->SetText( sz );
+	}
 	swprintf_s( sz, L"VSync Time (ms): %.2f", (1.0f/g_VSyncFrameRate)*1000.0f );
 	g_SampleUI.GetStatic( IDC_VSYNCFRAMERATESTATIC )->SetText( sz );
+	swprintf_s( sz, L"CPU 50/95/99/Max (ms): %.1f/%.1f/%.1f/%.1f",
+		g_FrameTimeStats.GetMedian()*1000.0f, g_FrameTimeStats.GetP95()*1000.0f, g_FrameTimeStats.GetP99()*1000.0f, g_FrameTimeStats.GetMax()*1000.0f );
+	g_SampleUI.GetStatic( IDC_FRAMETIMESTATSSTATIC )->SetText( sz );
+	if( g_FrameCostModel.IsValid() )
+	{
+		swprintf_s( sz, L"Cost (ms): %.2f + %.2f/MPix", g_FrameCostModel.GetFixedCost()*1000.0f, g_FrameCostModel.GetPerPixelCost()*1.0e9f );
+		g_SampleUI.GetStatic( IDC_COSTMODELSTATIC )->SetText( sz );
+	}
+	if( g_bMotionAdaptive && g_bHaveVelocityStatistics )
+	{
+		swprintf_s( sz, L"Motion (px): %.1f/%.1f%s", g_VelocityStatistics.meanSpeed, g_VelocityStatistics.maxSpeed,
+			g_MotionAdaptivePolicy.IsLocked() ? L" Locked" : L"" );
+		g_SampleUI.GetStatic( IDC_MOTIONSTATIC )->SetText( sz );
+	}
+	const FrameBoundInput& bound = g_FrameBoundClassifier.GetSmoothedInput();
+	swprintf_s( sz, L"%s Bound CPU/GPU/Pres (ms): %.1f/%.1f/%.1f", FrameBoundClassifier::GetBoundName( g_FrameBoundClassifier.GetBound() ),
+		( bound.cpuUpdateTime + bound.cpuSubmitTime )*1000.0f, bound.gpuTime*1000.0f, bound.cpuPresentTime*1000.0f );
+	g_SampleUI.GetStatic( IDC_FRAMEBOUNDSTATIC )->SetText( sz );
+	swprintf_s( sz, L"GPU Lag/Max/Depth/Drop/Disj: %u/%u/%u/%u/%u", g_GPUProfiler.GetLastLatency(), g_GPUProfiler.GetMaxLatency(),
+		g_GPUProfiler.GetFrameLatency(), g_GPUProfiler.GetNumDroppedFrames(), g_GPUProfiler.GetNumDisjointFrames() );
+	g_SampleUI.GetStatic( IDC_GPUTIMINGSTATIC )->SetText( sz );
+	swprintf_s( sz, L"Matrices/Frame: %u", g_Scene.GetNumMatricesRecomputed() );
+	g_SampleUI.GetStatic( IDC_MATRIXUPDATESSTATIC )->SetText( sz );
+	if( g_bFrustumCulling )
+	{
+		swprintf_s( sz, L"Culled Draws: %u/%u %.3fms", g_Scene.GetNumCulledDraws(), g_Scene.GetNumDraws(), g_Scene.GetCullTime()*1000.0 );
+	}
+	else
+	{
+		swprintf_s( sz, L"Culled Draws: Off" );
+	}
+	g_SampleUI.GetStatic( IDC_CULLINGSTATIC )->SetText( sz );
+	if( !g_bMeasureGPULatency )
+	{
+		g_SampleUI.GetStatic( IDC_GPULATENCYSTATIC )->SetText( L"GPU Latency avg/95 (ms): Off" );
+	}
+	else if( g_GPULatencyStats.GetNumSamples() )
+	{
+		swprintf_s( sz, L"GPU Latency avg/95 (ms): %.1f/%.1f", g_GPULatencyStats.GetMean()*1000.0f, g_GPULatencyStats.GetP95()*1000.0f );
+		g_SampleUI.GetStatic( IDC_GPULATENCYSTATIC )->SetText( sz );
+	}
+	g_HUD.GetButton( IDC_CAPTURETRACE )->SetText( g_TraceRecorder.IsCapturing() ? L"Capturing Trace..." : L"Capture Trace (F5)" );
 
 	// Update scale text and sliders. We get the scale text always from actual scale,
 	// but slide value from the control variables to prevent the internal changes in scale x and y
@@ -1624,12 +2389,144 @@ void UpdateStats( float gpuFrameInnerWorkTime, float gpuFrameClearTime, float gp
 
 }
 
+//--------------------------------------------------------------------------------------
+// Called when the GPU profiler resolves a frame. With the clock calibration the frame's
+// GPU timestamps are CPU times, giving the latency from the end of its submission to
+// the GPU completing it, and placing its intervals in a trace where the GPU ran them.
+//--------------------------------------------------------------------------------------
+void UpdateGPULatency()
+{
+	unsigned int latency = g_GPUProfiler.GetLastLatency();
+	bool bCalibrated = g_GPUClockCalibration.IsValid() &&
+		g_GPUClockCalibration.GetFrequency() == g_GPUProfiler.GetResultFrequency();
+	if( g_bMeasureGPULatency && bCalibrated && latency < g_SubmitEndTimeCount && latency < g_GPUFrameCount )
+	{
+		double gpuEndTime = g_GPUClockCalibration.GPUToCPUTime( g_GPUProfiler.GetResultEndTicks() );
+		g_GPULatencyStats.AddSample( (float)( gpuEndTime - g_SubmitEndTimes[ ( g_GPUFrameCount - latency ) % g_SubmitEndTimeCount ] ) );
+	}
+
+	if( g_TraceRecorder.IsCapturing() )
+	{
+		if( bCalibrated )
+		{
+			double gpuStartTime = g_GPUClockCalibration.GPUToCPUTime( g_GPUProfiler.GetResultStartTicks() );
+			g_TraceRecorder.AddGPUFrame( latency, gpuStartTime, &g_GPUProfiler.GetResult( 0 ), g_GPUProfiler.GetNumResults() );
+		}
+		else
+		{
+			g_TraceRecorder.AddGPUFrame( latency, &g_GPUProfiler.GetResult( 0 ), g_GPUProfiler.GetNumResults() );
+		}
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Called when clock samples are needed again after a break. The last fit may have drifted
+// since, so it is dropped and the first sample taken at the next frame.
+//--------------------------------------------------------------------------------------
+void RestartClockCalibration()
+{
+	g_GPUClockCalibration.Reset();
+	g_LastClockSampleTime = 0.0;
+}
+
+//--------------------------------------------------------------------------------------
+// Times the scene's per model updates with 1 to all of the task pool's threads. The
+// table goes to the debug output, and the single thread and all thread times to the UI.
+//--------------------------------------------------------------------------------------
+void BenchmarkThreadScaling()
+{
+	UINT numThreads = g_TaskPool.GetNumThreads();
+	double singleThreadTime = 0.0;
+	double allThreadTime = 0.0;
+	WCHAR sz[100];
+	OutputDebugStringW( L"Model update thread scaling:\n" );
+	for( UINT threads = 1; threads <= numThreads; ++threads )
+	{
+		g_TaskPool.SetActiveThreads( threads );
+		double time = g_Scene.BenchmarkModelUpdate( g_ThreadBenchmarkIterations );
+		if( 1 == threads )
+		{
+			singleThreadTime = time;
+		}
+		allThreadTime = time;
+		swprintf_s( sz, L"  %u threads: %.3fms %.2fx\n", threads, time*1000.0, time > 0.0 ? singleThreadTime/time : 0.0 );
+		OutputDebugStringW( sz );
+	}
+	g_TaskPool.SetActiveThreads( numThreads );
+
+	swprintf_s( sz, L"Update 1/%uT (ms): %.2f/%.2f", numThreads, singleThreadTime*1000.0, allThreadTime*1000.0 );
+	g_SampleUI.GetStatic( IDC_THREADSCALINGSTATIC )->SetText( sz );
+}
+
+//--------------------------------------------------------------------------------------
+// Pass time text, with the cost per shaded pixel and the overdraw against pixels when
+// the pass has pipeline statistics which shade any
+//--------------------------------------------------------------------------------------
+void SetPassTimeText( int id, const WCHAR* pName, float passTime, COST_PASS pass, float pixels )
+{
+	WCHAR sz[100];
+	const PipelineStatistics& stats = g_PassPipelineStatsAverages[ pass ];
+	if( g_PassPipelineStats[ pass ].HaveAveragedStatistics() && stats.psInvocations > 0.0f && pixels > 0.0f )
+	{
+		swprintf_s( sz, L"%s (ms): %.2f %.2fns/px %.2fx", pName, passTime*1000.0f,
+			passTime*1.0e9f/stats.psInvocations, stats.psInvocations/pixels );
+	}
+	else
+	{
+		swprintf_s( sz, L"%s Time (ms): %.2f", pName, passTime*1000.0f );
+	}
+	g_SampleUI.GetStatic( id )->SetText( sz );
+}
+
+//--------------------------------------------------------------------------------------
+// Reads back every ready result of the per pass pipeline statistics without waiting on
+// the GPU. When a new average of the scene pass arrives, the averaged times of the
+// passes rendered at the dynamic resolution are divided between the pixels they shaded
+// to give the cost of a shaded pixel, and those pixels against the viewport give the
+// overdraw. Together they are a per pixel cost for the resolution controller which does
+// not need a spread of resolutions to fit, unlike the FrameCostModel.
+//--------------------------------------------------------------------------------------
+void UpdatePipelineStatistics( float gpuFrameClearTime, float gpuFrameSceneTime, float gpuFramePostProcTime )
+{
+	bool bUpdated = false;
+	for( UINT pass = 0; pass < COST_PASS_OTHER; ++pass )
+	{
+		if( g_PassPipelineStats[ pass ].HaveUpdatedAveragedStatistics( &g_PassPipelineStatsAverages[ pass ] ) &&
+			COST_PASS_SCENE == pass )
+		{
+			bUpdated = true;
+		}
+	}
+	if( !bUpdated || !g_PipelineStatsNumFrames )
+	{
+		return;
+	}
+	g_PipelineStatsPixels = (float)( g_PipelineStatsPixelSum / g_PipelineStatsNumFrames );
+	g_PipelineStatsPixelSum = 0.0;
+	g_PipelineStatsNumFrames = 0;
+
+	// the resolve is at the back buffer resolution, so is left in the fixed cost
+	float time = gpuFrameClearTime + gpuFrameSceneTime + gpuFramePostProcTime;
+	float shadedPixels = g_PassPipelineStatsAverages[ COST_PASS_CLEAR ].psInvocations +
+		g_PassPipelineStatsAverages[ COST_PASS_SCENE ].psInvocations +
+		g_PassPipelineStatsAverages[ COST_PASS_POSTPROC ].psInvocations;
+	if( time > 0.0f && shadedPixels > 0.0f && g_PipelineStatsPixels > 0.0f )
+	{
+		g_ShadedPixelCost	= time / shadedPixels;
+		g_Overdraw			= shadedPixels / g_PipelineStatsPixels;
+	}
+}
+
 
 //--------------------------------------------------------------------------------------
 // Pre-init phase 
 //--------------------------------------------------------------------------------------
 void InitApp()
 {
+	// Worker threads for the scene, one per logical processor
+	g_TaskPool.Init();
+	g_Scene.SetTaskPool( &g_TaskPool );
+
     // Dialogs init
     g_D3DSettingsDlg.Init( &g_DialogResourceManager );
     g_HUD.Init( &g_DialogResourceManager );
@@ -1645,6 +2542,12 @@ void InitApp()
 	// Add Shader Reoload Button for runtime recompile of shaders
     g_HUD.AddButton( IDC_RELOADSHADERS, L"Reload Shaders (F4)", 0, iY += 26, g_uGUIWidth, g_uGUIHeight, VK_F4 );
 
+	// Capture a trace of the next g_TraceFrames frames to g_TraceFileName
+    g_HUD.AddButton( IDC_CAPTURETRACE, L"Capture Trace (F5)", 0, iY += 26, g_uGUIWidth, g_uGUIHeight, VK_F5 );
+
+	// Time the scene's model updates with increasing numbers of worker threads
+    g_HUD.AddButton( IDC_BENCHMARKTHREADS, L"Benchmark Threads (F6)", 0, iY += 26, g_uGUIWidth, g_uGUIHeight, VK_F6 );
+
 	// Add Sample UI
     g_SampleUI.SetCallback( OnGUIEvent );
     iY = 0;
@@ -1652,6 +2555,8 @@ void InitApp()
 	g_SampleUI.AddCheckBox( IDC_PAUSED, L"Paused (P)", 0, iY += 26, 170, g_uGUIHeight, g_bPaused, 'P' );
 	// Add Show Cameras
 	g_SampleUI.AddCheckBox( IDC_SHOWCAMERAS, L"Show Cameras", 0, iY += 26, 170, g_uGUIHeight, g_bShowCameras );
+	// Add Frustum Culling
+	g_SampleUI.AddCheckBox( IDC_FRUSTUMCULLING, L"Frustum Culling", 0, iY += 26, 170, g_uGUIHeight, g_bFrustumCulling );
 	
 	// Add Toggle for Motion Blur
 	g_SampleUI.AddCheckBox( IDC_MOTIONBLUR, L"MotionBlur", 0, iY += 26, 170, g_uGUIHeight, g_bMotionBlur );
@@ -1664,6 +2569,16 @@ void InitApp()
 	CDXUTComboBox*	pCameraSelect;
     g_SampleUI.AddComboBox( IDC_CAMERASELECT, 0, iY += 18, 170, g_uGUIHeight, 0, false, &pCameraSelect );
 
+	// Add simulation step rate, order must match g_SimulationRates
+    g_SampleUI.AddStatic( IDC_SIMULATIONRATESTATIC, L"Simulation Rate:", 0, iY += 26, 120, g_uGUIHeight );
+	CDXUTComboBox*	pSimulationRateSelect;
+    g_SampleUI.AddComboBox( IDC_SIMULATIONRATE, 0, iY += 18, 170, g_uGUIHeight, 0, false, &pSimulationRateSelect );
+	pSimulationRateSelect->AddItem( L"30 Hz", NULL );
+	pSimulationRateSelect->AddItem( L"60 Hz", NULL );
+	pSimulationRateSelect->AddItem( L"120 Hz", NULL );
+	pSimulationRateSelect->AddItem( L"240 Hz", NULL );
+	pSimulationRateSelect->SetSelectedByIndex( g_SimulationRateIndex );
+
 	// Add Clear with Pixel Shader
 	g_SampleUI.AddCheckBox( IDC_CLEARWITHPIXELSHADER, L"Clear with Pixel Shader", 0, iY += 26, 170, g_uGUIHeight, g_bClearWithPixelShader );
 
@@ -1671,9 +2586,21 @@ void InitApp()
 	//Add checkbox for dynamic resolution being enabled
 	g_SampleUI.AddCheckBox( IDC_DYNAMICRESOLUTION, L"Dynamic Resolution", 0, iY += 26, 170, g_uGUIHeight, g_bDynamicResolutionEnabled );
 
-	//Add checkbox for supersampling being enabled
-	g_SampleUI.AddCheckBox( IDC_SUPERSAMPLING, L"Allow Super Sampling", 0, iY += 26, 170, g_uGUIHeight, g_ResolutionScaleMax != 1 );
-	g_SampleUI.GetCheckBox( IDC_SUPERSAMPLING )->SetEnabled( g_bDynamicResolutionEnabled );
+	//Add super sampling factor, order must match g_SuperSamplingFactors
+    g_SampleUI.AddStatic( IDC_SUPERSAMPLINGSTATIC, L"Super Sampling:", 0, iY += 26, 120, g_uGUIHeight );
+	CDXUTComboBox*	pSuperSamplingSelect;
+    g_SampleUI.AddComboBox( IDC_SUPERSAMPLING, 0, iY += 18, 170, g_uGUIHeight, 0, false, &pSuperSamplingSelect );
+	pSuperSamplingSelect->AddItem( L"Off", NULL );
+	pSuperSamplingSelect->AddItem( L"Up to 2x", NULL );
+	pSuperSamplingSelect->AddItem( L"Up to 4x", NULL );
+	for( UINT factor = 0; factor < ARRAYSIZE( g_SuperSamplingFactors ); ++factor )
+	{
+		if( g_SuperSamplingFactors[ factor ] == g_ResolutionScaleMax )
+		{
+			pSuperSamplingSelect->SetSelectedByIndex( factor );
+		}
+	}
+	pSuperSamplingSelect->SetEnabled( g_bDynamicResolutionEnabled );
 
 
 	//Add checkbox for supersampling being enabled
@@ -1741,14 +2668,74 @@ void InitApp()
 	g_SampleUI.GetSlider( IDC_RESOLUTIONSCALE_SLIDERX )->SetEnabled( g_bDynamicResolutionEnabled && ( g_ControlMode == CONTROL_MODE_MANUAL ) );
 	g_SampleUI.GetSlider( IDC_RESOLUTIONSCALE_SLIDERY )->SetEnabled( g_bDynamicResolutionEnabled && ( g_ControlMode == CONTROL_MODE_MANUAL ) );
 
+	// Add controller selection, order must match CONTROLLER_TYPE
+    g_SampleUI.AddStatic( IDC_CONTROLLERTYPESTATIC, L"Controller:", 0, iY += 26, 120, g_uGUIHeight );
+	CDXUTComboBox*	pControllerSelect;
+    g_SampleUI.AddComboBox( IDC_CONTROLLERTYPE, 0, iY += 18, 170, g_uGUIHeight, 0, false, &pControllerSelect );
+	for( int controller = 0; controller < CONTROLLER_TYPE_COUNT; ++controller )
+	{
+		pControllerSelect->AddItem( g_pResolutionControllers[ controller ]->GetName(), NULL );
+	}
+	pControllerSelect->SetEnabled( g_bDynamicResolutionEnabled && ( g_ControlMode != CONTROL_MODE_MANUAL ) );
+	pControllerSelect->SetSelectedByIndex( g_ControllerType );
+
+	// Add CPU frame time input selection, order must match FRAME_TIME_INPUT
+    g_SampleUI.AddStatic( IDC_FRAMETIMEINPUTSTATIC, L"CPU Frame Time Input:", 0, iY += 26, 120, g_uGUIHeight );
+	CDXUTComboBox*	pFrameTimeInputSelect;
+    g_SampleUI.AddComboBox( IDC_FRAMETIMEINPUT, 0, iY += 18, 170, g_uGUIHeight, 0, false, &pFrameTimeInputSelect );
+	pFrameTimeInputSelect->AddItem( L"Average FPS", NULL );
+	pFrameTimeInputSelect->AddItem( L"Median", NULL );
+	pFrameTimeInputSelect->AddItem( L"95th Percentile", NULL );
+	pFrameTimeInputSelect->AddItem( L"99th Percentile", NULL );
+	pFrameTimeInputSelect->AddItem( L"Max", NULL );
+	pFrameTimeInputSelect->SetEnabled( g_bDynamicResolutionEnabled && ( g_ControlMode != CONTROL_MODE_MANUAL ) );
+	pFrameTimeInputSelect->SetSelectedByIndex( g_FrameTimeInput );
+
+	// Add resolution ladder tile size, order must match g_TileSizes
+    g_SampleUI.AddStatic( IDC_TILESIZESTATIC, L"Resolution Ladder:", 0, iY += 26, 120, g_uGUIHeight );
+	CDXUTComboBox*	pTileSizeSelect;
+    g_SampleUI.AddComboBox( IDC_TILESIZE, 0, iY += 18, 170, g_uGUIHeight, 0, false, &pTileSizeSelect );
+	pTileSizeSelect->AddItem( L"Off", NULL );
+	pTileSizeSelect->AddItem( L"8 Pixel Tiles", NULL );
+	pTileSizeSelect->AddItem( L"16 Pixel Tiles", NULL );
+	pTileSizeSelect->AddItem( L"32 Pixel Tiles", NULL );
+	pTileSizeSelect->AddItem( L"64 Pixel Tiles", NULL );
+	pTileSizeSelect->SetEnabled( g_bDynamicResolutionEnabled );
+	pTileSizeSelect->SetSelectedByIndex( g_TileSizeIndex );
+	g_DynamicResolution.SetTileSize( g_TileSizes[ g_TileSizeIndex ] );
+
+	// Motion adaptive control from velocity buffer statistics
+	g_SampleUI.AddCheckBox( IDC_MOTIONADAPTIVE, L"Motion Adaptive", 0, iY += 26, 170, g_uGUIHeight, g_bMotionAdaptive );
+	g_SampleUI.GetCheckBox( IDC_MOTIONADAPTIVE )->SetEnabled( g_bDynamicResolutionEnabled && ( g_ControlMode != CONTROL_MODE_MANUAL ) );
+
+	// Only lower resolution when GPU bound
+	g_SampleUI.AddCheckBox( IDC_BOUNDGATING, L"Lower Only When GPU Bound", 0, iY += 26, 170, g_uGUIHeight, g_bBoundGating );
+	g_SampleUI.GetCheckBox( IDC_BOUNDGATING )->SetEnabled( g_bDynamicResolutionEnabled && ( g_ControlMode != CONTROL_MODE_MANUAL ) );
+
+	// Per frame telemetry log
+	g_SampleUI.AddCheckBox( IDC_TELEMETRY, L"Log Telemetry", 0, iY += 26, 170, g_uGUIHeight, false );
+
+	// GPU latency, which takes clock calibration samples that stall every few seconds
+	g_SampleUI.AddCheckBox( IDC_MEASURELATENCY, L"Measure GPU Latency", 0, iY += 26, 170, g_uGUIHeight, g_bMeasureGPULatency );
 
 	// Add Performance counters
-	g_SampleUI.AddStatic( IDC_FRAMETIMESTATIC, L"Frame Time (ms): NA", 0, iY += 26, 120, g_uGUIHeight );
-	g_SampleUI.AddStatic( IDC_CLEARTIMESTATIC, L"Clear Time (ms): NA", 0, iY += 12, 120, g_uGUIHeight );
-	g_SampleUI.AddStatic( IDC_SCENETIMESTATIC, L"Scene Time (ms): NA", 0, iY += 12, 120, g_uGUIHeight );
-	g_SampleUI.AddStatic( IDC_POSTPROCTIMESTATIC, L"PostP Time (ms): NA", 0, iY += 12, 120, g_uGUIHeight );
-	g_SampleUI.AddStatic( IDC_SCALETIMESTATIC, L"Scale Time (ms): NA", 0, iY += 12, 120, g_uGUIHeight );
+	g_SampleUI.AddStatic( IDC_FRAMETIMESTATIC, L"Frame Time avg/95 (ms): NA", 0, iY += 26, 170, g_uGUIHeight );
+	g_SampleUI.AddStatic( IDC_CLEARTIMESTATIC, L"Clear Time (ms): NA", 0, iY += 12, 170, g_uGUIHeight );
+	g_SampleUI.AddStatic( IDC_SCENETIMESTATIC, L"Scene Time (ms): NA", 0, iY += 12, 170, g_uGUIHeight );
+	g_SampleUI.AddStatic( IDC_POSTPROCTIMESTATIC, L"PostP Time (ms): NA", 0, iY += 12, 170, g_uGUIHeight );
+	g_SampleUI.AddStatic( IDC_SCALETIMESTATIC, L"Scale Time (ms): NA", 0, iY += 12, 170, g_uGUIHeight );
+	g_SampleUI.AddStatic( IDC_PIPELINESTATSSTATIC, L"Scene VS/Prim/PS (K): NA", 0, iY += 12, 170, g_uGUIHeight );
 	g_SampleUI.AddStatic( IDC_VSYNCFRAMERATESTATIC, L"Vsync Time (ms): NA", 0, iY += 12, 120, g_uGUIHeight );
+	g_SampleUI.AddStatic( IDC_FRAMETIMESTATSSTATIC, L"CPU 50/95/99/Max (ms): NA", 0, iY += 12, 170, g_uGUIHeight );
+	g_SampleUI.AddStatic( IDC_COSTMODELSTATIC, L"Cost (ms): NA", 0, iY += 12, 170, g_uGUIHeight );
+	g_SampleUI.AddStatic( IDC_MOTIONSTATIC, L"Motion (px): NA", 0, iY += 12, 170, g_uGUIHeight );
+	g_SampleUI.AddStatic( IDC_RTMEMORYSTATIC, L"RT Memory (MB): NA", 0, iY += 12, 170, g_uGUIHeight );
+	g_SampleUI.AddStatic( IDC_FRAMEBOUNDSTATIC, L"Bound: NA", 0, iY += 12, 170, g_uGUIHeight );
+	g_SampleUI.AddStatic( IDC_GPUTIMINGSTATIC, L"GPU Lag/Max/Depth/Drop/Disj: NA", 0, iY += 12, 170, g_uGUIHeight );
+	g_SampleUI.AddStatic( IDC_GPULATENCYSTATIC, L"GPU Latency avg/95 (ms): Off", 0, iY += 12, 170, g_uGUIHeight );
+	g_SampleUI.AddStatic( IDC_THREADSCALINGSTATIC, L"Update 1/NT (ms): F6", 0, iY += 12, 170, g_uGUIHeight );
+	g_SampleUI.AddStatic( IDC_MATRIXUPDATESSTATIC, L"Matrices/Frame: NA", 0, iY += 12, 170, g_uGUIHeight );
+	g_SampleUI.AddStatic( IDC_CULLINGSTATIC, L"Culled Draws: NA", 0, iY += 12, 170, g_uGUIHeight );
 
 
     // Contact button and handling callback
@@ -1780,6 +2767,16 @@ void RenderText()
     {
         g_pTextHelper->SetInsertionPos( iX, iY += 20 );
         g_pTextHelper->DrawTextLine( L"Press F1 For Help" );
+
+		// GPU profile of the last resolved frame, nested scopes are indented under their parent
+		for( UINT resultIndex = 0; resultIndex < g_GPUProfiler.GetNumResults(); ++resultIndex )
+		{
+			const GPUProfileResult& result = g_GPUProfiler.GetResult( resultIndex );
+			WCHAR sz[100];
+			swprintf_s( sz, L"%*s%hs: %.2f ms", result.depth * 4, L"", result.pName, result.time * 1000.0f );
+			g_pTextHelper->SetInsertionPos( iX, iY += 16 );
+			g_pTextHelper->DrawTextLine( sz );
+		}
     }
     else // Help screen enabled 
     {
@@ -1846,6 +2843,12 @@ int WINAPI wWinMain( HINSTANCE hInstance,
     DXUTCreateDevice( D3D_FEATURE_LEVEL_10_0, true, 1280, 720 );
     DXUTMainLoop();
 
+	// writes the record count, so the log is complete
+	g_TelemetryLogger.Close();
+
+	g_Scene.SetTaskPool( NULL );
+	g_TaskPool.Shutdown();
+
     return DXUTGetExitCode();
 }
 
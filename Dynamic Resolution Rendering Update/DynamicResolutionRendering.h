@@ -61,6 +61,33 @@
 #define IDC_RELOADSHADERS				31
 #define IDC_TOGGLEZOOM                  32
 #define IDC_SYMMETRIC_TAA               33
+#define IDC_CONTROLLERTYPE				34
+#define IDC_CONTROLLERTYPESTATIC		35
+#define IDC_COSTMODELSTATIC				36
+#define IDC_TILESIZE					37
+#define IDC_TILESIZESTATIC				38
+#define IDC_FRAMETIMEINPUT				39
+#define IDC_FRAMETIMEINPUTSTATIC		40
+#define IDC_FRAMETIMESTATSSTATIC		41
+#define IDC_MOTIONADAPTIVE				42
+#define IDC_MOTIONSTATIC				43
+#define IDC_RTMEMORYSTATIC				44
+#define IDC_SUPERSAMPLINGSTATIC			45
+#define IDC_BOUNDGATING					46
+#define IDC_FRAMEBOUNDSTATIC			47
+#define IDC_GPUTIMINGSTATIC				48
+#define IDC_CAPTURETRACE				49
+#define IDC_TELEMETRY					50
+#define IDC_SIMULATIONRATE				51
+#define IDC_SIMULATIONRATESTATIC		52
+#define IDC_PIPELINESTATSSTATIC			53
+#define IDC_GPULATENCYSTATIC			54
+#define IDC_BENCHMARKTHREADS			55
+#define IDC_THREADSCALINGSTATIC			56
+#define IDC_MATRIXUPDATESSTATIC			57
+#define IDC_FRUSTUMCULLING				58
+#define IDC_CULLINGSTATIC				60
+#define IDC_MEASURELATENCY				62
 
 
 
@@ -85,6 +112,39 @@ enum CONTROL_MODE
 	CONTROL_MODE_VSYNC			= 2
 };
 
+enum CONTROLLER_TYPE
+{
+	CONTROLLER_TYPE_PROPORTIONAL	= 0,
+	CONTROLLER_TYPE_PID				= 1,
+	CONTROLLER_TYPE_DEADBAND		= 2,
+	CONTROLLER_TYPE_SLEWLIMITED		= 3,
+	CONTROLLER_TYPE_PREDICTIVE		= 4,
+	CONTROLLER_TYPE_COUNT
+};
+
+// Source of the CPU frame time used by resolution control
+enum FRAME_TIME_INPUT
+{
+	FRAME_TIME_INPUT_FPS			= 0,	// 1/DXUTGetFPS(), which only updates about once a second
+	FRAME_TIME_INPUT_P50			= 1,	// streaming percentiles over the last 120 frames, see StreamingStats
+	FRAME_TIME_INPUT_P95			= 2,
+	FRAME_TIME_INPUT_P99			= 3,
+	FRAME_TIME_INPUT_MAX			= 4,
+	FRAME_TIME_INPUT_COUNT
+};
+
+// GPU passes fitted by the frame cost model. COST_PASS_OTHER is the part of the
+// inner frame time not covered by the individual pass timers.
+enum COST_PASS
+{
+	COST_PASS_CLEAR			= 0,
+	COST_PASS_SCENE			= 1,
+	COST_PASS_POSTPROC		= 2,
+	COST_PASS_SCALE			= 3,
+	COST_PASS_OTHER			= 4,
+	COST_PASS_COUNT
+};
+
 // D3D device callback
 HRESULT CALLBACK    OnD3D11CreateDevice( ID3D11Device*,
                                          const DXGI_SURFACE_DESC*,
@@ -168,7 +228,31 @@ void RenderText();
 void UpdateStats( float gpuFrameInnerWorkTime, float gpuFrameClearTime, float gpuFrameSceneTime, float gpuFramePostProcTime, float gpuFrameScaleTime );
 
 // Resolution Control Code
-void ControlResolution( float gpuFrameInnerWorkTime );
+void ControlResolution( float gpuFrameInnerWorkTime, bool bHaveGPUTime );
+
+// Per frame telemetry
+void LogTelemetry( float cpuFrameTime );
+
+// GPU latency from the CPU / GPU clock calibration
+void UpdateGPULatency();
+void RestartClockCalibration();
+
+// Scaling of the scene's per model updates with worker threads
+void BenchmarkThreadScaling();
+
+// Per pass pipeline statistics
+void UpdatePipelineStatistics( float gpuFrameClearTime, float gpuFrameSceneTime, float gpuFramePostProcTime );
+void SetPassTimeText( int id, const WCHAR* pName, float passTime, COST_PASS pass, float pixels );
+
+// Velocity buffer reduction for motion adaptive resolution control
+void ReduceVelocityBuffer( ID3D11DeviceContext* pD3DImmediateContext, ID3D11ShaderResourceView* pVelocitySRV );
+void ReadBackVelocityStatistics( ID3D11DeviceContext* pD3DImmediateContext );
+
+// Downsample pyramid for super sampling above 2x
+void DownsampleFinalRT( ID3D11DeviceContext* pD3DImmediateContext, unsigned int rt );
+ID3D11ShaderResourceView* GetFinalSRV( unsigned int rt );
+UINT GetFinalWidth( unsigned int rt );
+UINT GetFinalHeight( unsigned int rt );
 
 // Main function
 int WINAPI          wWinMain( HINSTANCE,
@@ -179,6 +263,7 @@ int WINAPI          wWinMain( HINSTANCE,
 void ReleaseDynamicResolution();
 
 void InitDynamicResolution( ID3D11Device* pD3DDevice );
+void ReportDynamicRTMemory();
 
 void CreateShaders( ID3D11Device* pD3DDevice );
 void ReleaseShaders();
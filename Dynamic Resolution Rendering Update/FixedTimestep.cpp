@@ -0,0 +1,93 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "FixedTimestep.h"
+
+//--------------------------------------------------------------------------------------
+// Fixed timestep simulation clock
+//--------------------------------------------------------------------------------------
+FixedTimestep::FixedTimestep( float stepRate, unsigned int maxStepsPerFrame )
+	: m_StepRate( 60.0f )
+	, m_StepTime( 1.0f / 60.0f )
+	, m_MaxStepsPerFrame( 1 )
+	, m_BaseTime( 0.0 )
+	, m_Accumulator( 0.0 )
+	, m_NumSteps( 0 )
+	, m_NumFrameSteps( 0 )
+	, m_NumDroppedSteps( 0 )
+{
+	SetStepRate( stepRate );
+	SetMaxStepsPerFrame( maxStepsPerFrame );
+}
+
+void FixedTimestep::Reset( double time )
+{
+	m_BaseTime		= time;
+	m_Accumulator	= 0.0;
+	m_NumSteps		= 0;
+	m_NumFrameSteps	= 0;
+}
+
+void FixedTimestep::SetStepRate( float stepRate )
+{
+	if( stepRate <= 0.0f )
+	{
+		return;
+	}
+	// rebase so the time so far is unaffected, and keep the accumulated fraction of a step
+	float interpolation = GetInterpolation();
+	m_BaseTime		= GetTime();
+	m_NumSteps		= 0;
+	m_NumFrameSteps	= 0;
+	m_StepRate		= stepRate;
+	m_StepTime		= 1.0f / stepRate;
+	m_Accumulator	= interpolation * (double)m_StepTime;
+}
+
+unsigned int FixedTimestep::Advance( float elapsedTime )
+{
+	if( elapsedTime > 0.0f )
+	{
+		m_Accumulator += elapsedTime;
+	}
+
+	unsigned int numSteps = 0;
+	while( m_Accumulator >= m_StepTime )
+	{
+		if( numSteps == m_MaxStepsPerFrame )
+		{
+			// drop whole steps but keep the fraction, so interpolation stays continuous
+			while( m_Accumulator >= m_StepTime )
+			{
+				m_Accumulator -= m_StepTime;
+				++m_NumDroppedSteps;
+			}
+			break;
+		}
+		m_Accumulator -= m_StepTime;
+		++numSteps;
+	}
+
+	m_NumSteps += numSteps;
+	m_NumFrameSteps = numSteps;
+	return numSteps;
+}
+
+double FixedTimestep::GetStepEndTime( unsigned int step ) const
+{
+	// from the step count rather than accumulated, so identical for every run
+	unsigned long long stepNumber = m_NumSteps - m_NumFrameSteps + step + 1;
+	return m_BaseTime + stepNumber * (double)m_StepTime;
+}
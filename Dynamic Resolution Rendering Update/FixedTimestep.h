@@ -0,0 +1,94 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Note: like ResolutionController.h this file has no D3D or DXUT dependencies.
+
+//--------------------------------------------------------------------------------------
+// Fixed timestep simulation clock. Real frame time is accumulated and consumed in whole
+// steps of 1 / step rate seconds, so the simulation only ever sees the same step and
+// its state after N steps does not depend on the frame times which produced them. The
+// time left over is returned as a fraction of a step for interpolating between the last
+// two simulated states when rendering.
+//
+// At most maxStepsPerFrame steps are taken per frame. Any further time is dropped, so a
+// long hitch slows the simulation down rather than making the next frames longer still.
+//--------------------------------------------------------------------------------------
+class FixedTimestep
+{
+public:
+	FixedTimestep( float stepRate = 60.0f, unsigned int maxStepsPerFrame = 4 );
+
+	// Restart at simulation time 'time' with no time accumulated
+	void Reset( double time = 0.0 );
+
+	// Changing the rate keeps the current simulation time
+	void SetStepRate( float stepRate );
+	float GetStepRate() const
+	{
+		return m_StepRate;
+	}
+	float GetStepTime() const
+	{
+		return m_StepTime;
+	}
+	void SetMaxStepsPerFrame( unsigned int maxStepsPerFrame )
+	{
+		m_MaxStepsPerFrame = maxStepsPerFrame ? maxStepsPerFrame : 1;
+	}
+	unsigned int GetMaxStepsPerFrame() const
+	{
+		return m_MaxStepsPerFrame;
+	}
+
+	// Accumulate a frame's elapsed time, returns the number of steps to simulate
+	unsigned int Advance( float elapsedTime );
+
+	// Simulation time at the end of step 'step' of those returned by the last Advance()
+	double GetStepEndTime( unsigned int step ) const;
+
+	// Simulation time of the latest step
+	double GetTime() const
+	{
+		return m_BaseTime + m_NumSteps * (double)m_StepTime;
+	}
+
+	// Fraction of a step accumulated after the latest step, in [0, 1)
+	float GetInterpolation() const
+	{
+		return (float)( m_Accumulator / m_StepTime );
+	}
+
+	unsigned long long GetNumSteps() const
+	{
+		return m_NumSteps;
+	}
+	// Steps not simulated due to the per frame limit
+	unsigned long long GetNumDroppedSteps() const
+	{
+		return m_NumDroppedSteps;
+	}
+
+private:
+	float				m_StepRate;
+	float				m_StepTime;
+	unsigned int		m_MaxStepsPerFrame;
+	double				m_BaseTime;			// time of step 0, the step rate may have changed since
+	double				m_Accumulator;		// time not yet simulated, less than one step after Advance()
+	unsigned long long	m_NumSteps;			// since m_BaseTime
+	unsigned int		m_NumFrameSteps;	// returned by the last Advance()
+	unsigned long long	m_NumDroppedSteps;
+};
@@ -0,0 +1,130 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "FrameBoundClassifier.h"
+
+namespace
+{
+	void Smooth( float* pValue, float newValue, float smoothing )
+	{
+		*pValue += smoothing * ( newValue - *pValue );
+	}
+}
+
+FrameBoundClassifier::FrameBoundClassifier( float boundFraction, unsigned int minFrames, float smoothing )
+	: m_BoundFraction( boundFraction )
+	, m_MinFrames( minFrames )
+	, m_Smoothing( smoothing )
+{
+	Reset();
+}
+
+void FrameBoundClassifier::Reset()
+{
+	m_Smoothed.frameTime		= 0.0f;
+	m_Smoothed.gpuTime			= 0.0f;
+	m_Smoothed.cpuUpdateTime	= 0.0f;
+	m_Smoothed.cpuSubmitTime	= 0.0f;
+	m_Smoothed.cpuPresentTime	= 0.0f;
+	m_Smoothed.targetTime		= 0.0f;
+	m_bHaveInput		= false;
+	m_Bound				= FRAME_BOUND_UNKNOWN;
+	m_Candidate			= FRAME_BOUND_UNKNOWN;
+	m_CandidateFrames	= 0;
+}
+
+void FrameBoundClassifier::Update( const FrameBoundInput& input )
+{
+	if( input.frameTime <= 0.0f )
+	{
+		return;
+	}
+
+	if( !m_bHaveInput )
+	{
+		m_Smoothed = input;
+		m_bHaveInput = true;
+	}
+	else
+	{
+		Smooth( &m_Smoothed.frameTime,		input.frameTime,		m_Smoothing );
+		Smooth( &m_Smoothed.gpuTime,		input.gpuTime,			m_Smoothing );
+		Smooth( &m_Smoothed.cpuUpdateTime,	input.cpuUpdateTime,	m_Smoothing );
+		Smooth( &m_Smoothed.cpuSubmitTime,	input.cpuSubmitTime,	m_Smoothing );
+		Smooth( &m_Smoothed.cpuPresentTime,	input.cpuPresentTime,	m_Smoothing );
+		m_Smoothed.targetTime = input.targetTime;
+	}
+
+	FRAME_BOUND bound = Classify( m_Smoothed );
+	if( bound != m_Candidate )
+	{
+		m_Candidate = bound;
+		m_CandidateFrames = 0;
+	}
+	++m_CandidateFrames;
+
+	// the first label is reported straight away, later changes must persist
+	if( FRAME_BOUND_UNKNOWN == m_Bound || m_CandidateFrames >= m_MinFrames )
+	{
+		m_Bound = m_Candidate;
+	}
+}
+
+FRAME_BOUND FrameBoundClassifier::Classify( const FrameBoundInput& input ) const
+{
+	float referenceTime = input.frameTime;
+	if( input.targetTime > 0.0f && input.targetTime < referenceTime )
+	{
+		referenceTime = input.targetTime;
+	}
+	float busyTime = m_BoundFraction * referenceTime;
+	float cpuTime = input.cpuUpdateTime + input.cpuSubmitTime;
+
+	// when the GPU is bound the CPU also ends up waiting in Present for the GPU to
+	// catch up, so check the GPU first
+	if( input.gpuTime >= busyTime && input.gpuTime >= cpuTime )
+	{
+		return FRAME_BOUND_GPU;
+	}
+	if( cpuTime >= busyTime )
+	{
+		return FRAME_BOUND_CPU;
+	}
+	return FRAME_BOUND_PRESENT;
+}
+
+bool FrameBoundClassifier::IsDecreaseAllowed( float gpuTime, float targetTime ) const
+{
+	if( FRAME_BOUND_GPU == m_Bound || FRAME_BOUND_UNKNOWN == m_Bound )
+	{
+		return true;
+	}
+	return targetTime > 0.0f && gpuTime > targetTime;
+}
+
+const wchar_t* FrameBoundClassifier::GetBoundName( FRAME_BOUND bound )
+{
+	switch( bound )
+	{
+	case FRAME_BOUND_GPU:
+		return L"GPU";
+	case FRAME_BOUND_CPU:
+		return L"CPU";
+	case FRAME_BOUND_PRESENT:
+		return L"Present";
+	default:
+		return L"NA";
+	}
+}
@@ -0,0 +1,93 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Note: like ResolutionController.h this file has no D3D or DXUT dependencies.
+
+//--------------------------------------------------------------------------------------
+// Which part of the system limits the frame rate
+//--------------------------------------------------------------------------------------
+enum FRAME_BOUND
+{
+	FRAME_BOUND_UNKNOWN,	// no timings yet
+	FRAME_BOUND_GPU,		// GPU busy for most of the frame
+	FRAME_BOUND_CPU,		// CPU update and submission take most of the frame
+	FRAME_BOUND_PRESENT,	// neither is busy, the frame waits in Present for vsync
+	FRAME_BOUND_COUNT
+};
+
+//--------------------------------------------------------------------------------------
+// Per frame timings for FrameBoundClassifier. All times are in seconds.
+//--------------------------------------------------------------------------------------
+struct FrameBoundInput
+{
+	float	frameTime;			// present to present time
+	float	gpuTime;			// GPU time of the frame's work
+	float	cpuUpdateTime;		// CPU time of the scene update, e.g. OnFrameMove
+	float	cpuSubmitTime;		// CPU time of building and submitting the frame's rendering
+	float	cpuPresentTime;		// CPU time blocked in Present
+	float	targetTime;			// frame time aimed for, e.g. the vsync interval, 0 if none
+};
+
+//--------------------------------------------------------------------------------------
+// Labels each frame CPU, GPU or present bound from the CPU and GPU timings. Lowering the
+// resolution only helps when the GPU is the bottleneck; when CPU bound it costs quality
+// for no gain. The GPU is bound when its time is close to the frame time, and the CPU
+// when its update and submission are. Otherwise the frame is waiting in Present, e.g.
+// on vsync. With a target the times are compared to the shorter of the frame and target
+// times, as a missed vsync deadline doubles the frame time and a GPU just over budget
+// would otherwise look idle. Timings are smoothed, and a new label must hold for
+// m_MinFrames frames before it is reported so single hitches do not flip the result.
+//--------------------------------------------------------------------------------------
+class FrameBoundClassifier
+{
+public:
+	FrameBoundClassifier( float boundFraction = 0.8f, unsigned int minFrames = 5, float smoothing = 0.1f );
+
+	void Reset();
+
+	void Update( const FrameBoundInput& input );
+
+	FRAME_BOUND GetBound() const
+	{
+		return m_Bound;
+	}
+
+	// Whether the scale may be lowered: always when GPU bound or not yet known, and
+	// otherwise only when the GPU alone is over the target frame time
+	bool IsDecreaseAllowed( float gpuTime, float targetTime ) const;
+
+	// Smoothed timings used for the last classification
+	const FrameBoundInput& GetSmoothedInput() const
+	{
+		return m_Smoothed;
+	}
+
+	static const wchar_t* GetBoundName( FRAME_BOUND bound );
+
+	float			m_BoundFraction;	// fraction of the frame time a processor must be busy to be the bottleneck
+	unsigned int	m_MinFrames;		// frames a new label must hold before it is reported
+	float			m_Smoothing;		// weight of the new timings each frame
+
+private:
+	FRAME_BOUND Classify( const FrameBoundInput& input ) const;
+
+	FrameBoundInput	m_Smoothed;
+	bool			m_bHaveInput;
+	FRAME_BOUND		m_Bound;
+	FRAME_BOUND		m_Candidate;
+	unsigned int	m_CandidateFrames;
+};
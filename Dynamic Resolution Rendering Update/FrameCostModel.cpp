@@ -0,0 +1,178 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "FrameCostModel.h"
+
+#include <assert.h>
+
+namespace
+{
+	// Relative variance of pixel count (variance / mean^2) required to fit the slope.
+	// 1e-4 is roughly a 1% spread in pixel count, or 0.5% in scale.
+	const double cMinRelativeVariance = 1e-4;
+}
+
+//--------------------------------------------------------------------------------------
+// Linear cost model for a single pass
+//--------------------------------------------------------------------------------------
+LinearCostModel::LinearCostModel( float forgetFactor )
+	: m_ForgetFactor( forgetFactor )
+{
+	Reset();
+}
+
+void LinearCostModel::Reset()
+{
+	m_SumWeight		= 0.0;
+	m_SumX			= 0.0;
+	m_SumY			= 0.0;
+	m_SumXX			= 0.0;
+	m_SumXY			= 0.0;
+	m_FixedCost		= 0.0f;
+	m_PerPixelCost	= 0.0f;
+	m_bHasSlope		= false;
+	m_NumSamples	= 0;
+}
+
+void LinearCostModel::AddSample( float pixelCount, float time )
+{
+	if( pixelCount <= 0.0f || time < 0.0f )
+	{
+		return;
+	}
+
+	double x = pixelCount;
+	double y = time;
+	m_SumWeight	= m_SumWeight	* m_ForgetFactor + 1.0;
+	m_SumX		= m_SumX		* m_ForgetFactor + x;
+	m_SumY		= m_SumY		* m_ForgetFactor + y;
+	m_SumXX		= m_SumXX		* m_ForgetFactor + x * x;
+	m_SumXY		= m_SumXY		* m_ForgetFactor + x * y;
+	++m_NumSamples;
+
+	Fit();
+}
+
+void LinearCostModel::Fit()
+{
+	double meanX = m_SumX / m_SumWeight;
+	double meanY = m_SumY / m_SumWeight;
+	double varX  = m_SumXX / m_SumWeight - meanX * meanX;
+	double covXY = m_SumXY / m_SumWeight - meanX * meanY;
+
+	double perPixel = m_PerPixelCost;
+	if( varX > cMinRelativeVariance * meanX * meanX )
+	{
+		perPixel = covXY / varX;
+		m_bHasSlope = true;
+	}
+	else if( !m_bHasSlope )
+	{
+		// no slope information yet, so assume the pass is entirely pixel bound
+		perPixel = meanY / meanX;
+	}
+
+	// noise can give a negative slope or intercept, neither of which are physical
+	if( perPixel < 0.0 )
+	{
+		perPixel = 0.0;
+	}
+	double fixed = meanY - perPixel * meanX;
+	if( fixed < 0.0 )
+	{
+		fixed = 0.0;
+		perPixel = meanY / meanX;
+	}
+
+	m_FixedCost		= (float)fixed;
+	m_PerPixelCost	= (float)perPixel;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Frame cost model
+//--------------------------------------------------------------------------------------
+FrameCostModel::FrameCostModel( unsigned int numPasses, float forgetFactor )
+	: m_MinSamples( 3 )
+	, m_NumPasses( numPasses )
+{
+	assert( numPasses <= MAX_PASSES );
+	if( m_NumPasses > MAX_PASSES )
+	{
+		m_NumPasses = MAX_PASSES;
+	}
+	for( unsigned int pass = 0; pass < MAX_PASSES; ++pass )
+	{
+		m_PassModels[ pass ].m_ForgetFactor = forgetFactor;
+	}
+}
+
+void FrameCostModel::Reset()
+{
+	for( unsigned int pass = 0; pass < m_NumPasses; ++pass )
+	{
+		m_PassModels[ pass ].Reset();
+	}
+}
+
+void FrameCostModel::AddSample( float pixelCount, const float* pPassTimes )
+{
+	for( unsigned int pass = 0; pass < m_NumPasses; ++pass )
+	{
+		m_PassModels[ pass ].AddSample( pixelCount, pPassTimes[ pass ] );
+	}
+}
+
+float FrameCostModel::PredictFrameTime( float pixelCount ) const
+{
+	return GetFixedCost() + GetPerPixelCost() * pixelCount;
+}
+
+bool FrameCostModel::GetPixelCountForTime( float frameTime, float* pPixelCount ) const
+{
+	float perPixel = GetPerPixelCost();
+	if( !IsValid() || perPixel <= 0.0f )
+	{
+		return false;
+	}
+	float pixelCount = ( frameTime - GetFixedCost() ) / perPixel;
+	*pPixelCount = pixelCount > 0.0f ? pixelCount : 0.0f;
+	return true;
+}
+
+float FrameCostModel::GetFixedCost() const
+{
+	float fixed = 0.0f;
+	for( unsigned int pass = 0; pass < m_NumPasses; ++pass )
+	{
+		fixed += m_PassModels[ pass ].GetFixedCost();
+	}
+	return fixed;
+}
+
+float FrameCostModel::GetPerPixelCost() const
+{
+	float perPixel = 0.0f;
+	for( unsigned int pass = 0; pass < m_NumPasses; ++pass )
+	{
+		perPixel += m_PassModels[ pass ].GetPerPixelCost();
+	}
+	return perPixel;
+}
+
+bool FrameCostModel::IsValid() const
+{
+	return m_NumPasses > 0 && m_PassModels[0].GetNumSamples() >= m_MinSamples;
+}
@@ -0,0 +1,116 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Note: like ResolutionController.h this file has no D3D or DXUT dependencies.
+
+//--------------------------------------------------------------------------------------
+// Online linear fit of the GPU time of a single pass against the dynamic viewport
+// pixel count: time = fixedCost + perPixelCost * pixelCount.
+//
+// Uses exponentially weighted least squares so the fit follows changes in scene
+// content. When the pixel count has not varied enough to separate the two terms
+// (e.g. the scale is stationary) the previous per pixel cost is kept and only the
+// fixed cost is refitted to the mean.
+//--------------------------------------------------------------------------------------
+class LinearCostModel
+{
+public:
+	LinearCostModel( float forgetFactor = 0.9f );
+
+	void Reset();
+	void AddSample( float pixelCount, float time );
+
+	float Predict( float pixelCount ) const
+	{
+		return m_FixedCost + m_PerPixelCost * pixelCount;
+	}
+
+	float GetFixedCost() const
+	{
+		return m_FixedCost;
+	}
+	float GetPerPixelCost() const
+	{
+		return m_PerPixelCost;
+	}
+	unsigned int GetNumSamples() const
+	{
+		return m_NumSamples;
+	}
+
+	float	m_ForgetFactor;		// weight applied to old samples each update, in (0,1]
+
+private:
+	void Fit();
+
+	// weighted sums, double as pixel counts squared exceed float precision
+	double	m_SumWeight;
+	double	m_SumX;
+	double	m_SumY;
+	double	m_SumXX;
+	double	m_SumXY;
+
+	float	m_FixedCost;
+	float	m_PerPixelCost;
+	bool	m_bHasSlope;
+	unsigned int m_NumSamples;
+};
+
+//--------------------------------------------------------------------------------------
+// Per pass cost model for the whole frame. Each pass is fitted separately so passes
+// which do not scale with the dynamic viewport (e.g. the final resolve) end up in the
+// fixed cost, and the frame prediction is the sum of the pass predictions.
+//--------------------------------------------------------------------------------------
+class FrameCostModel
+{
+public:
+	enum { MAX_PASSES = 8 };
+
+	FrameCostModel( unsigned int numPasses, float forgetFactor = 0.9f );
+
+	void Reset();
+
+	// pPassTimes must hold GetNumPasses() times in seconds
+	void AddSample( float pixelCount, const float* pPassTimes );
+
+	float PredictFrameTime( float pixelCount ) const;
+
+	// Pixel count at which the predicted frame time equals frameTime.
+	// Returns false if the model has no usable per pixel cost yet.
+	bool GetPixelCountForTime( float frameTime, float* pPixelCount ) const;
+
+	// Coefficients summed over all passes, for telemetry
+	float GetFixedCost() const;
+	float GetPerPixelCost() const;
+
+	bool IsValid() const;
+
+	unsigned int GetNumPasses() const
+	{
+		return m_NumPasses;
+	}
+	const LinearCostModel& GetPassModel( unsigned int pass ) const
+	{
+		return m_PassModels[ pass ];
+	}
+
+	unsigned int	m_MinSamples;	// samples required before the model is used
+
+private:
+	LinearCostModel	m_PassModels[ MAX_PASSES ];
+	unsigned int	m_NumPasses;
+};
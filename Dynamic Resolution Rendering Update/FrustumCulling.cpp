@@ -0,0 +1,394 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "FrustumCulling.h"
+
+#include <math.h>
+#include <float.h>
+#include <string.h>
+#include <algorithm>
+#if FRUSTUM_CULLING_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace
+{
+	// Items per leaf, few enough that a leaf is rarely mostly culled
+	const unsigned int cMaxLeafItems = 4;
+
+	// Deeper than any median split tree of 32 bit item counts, with a second child pending per level
+	const unsigned int cMaxTraversalDepth = 64;
+
+	// Node bounds are grown slightly so rounding never leaves an item's box outside its
+	// node's, and a culled node's items would all have been culled
+	const float cNodeBoundsScale = 1.0f + 1.0e-5f;
+
+	const unsigned int cAllPlanes = ( 1u << cNumFrustumPlanes ) - 1;
+
+	// Frustum planes as structure of arrays, padded to eight with planes everything is inside
+	struct PlaneSet
+	{
+		float	x[8];
+		float	y[8];
+		float	z[8];
+		float	w[8];
+		float	absX[8];
+		float	absY[8];
+		float	absZ[8];
+	};
+
+	void SetPlanes( const Frustum& frustum, PlaneSet* pPlanes )
+	{
+		for( unsigned int plane = 0; plane < 8; ++plane )
+		{
+			bool bPadding = plane >= cNumFrustumPlanes;
+			pPlanes->x[ plane ] = bPadding ? 0.0f : frustum.planes[ plane ][ 0 ];
+			pPlanes->y[ plane ] = bPadding ? 0.0f : frustum.planes[ plane ][ 1 ];
+			pPlanes->z[ plane ] = bPadding ? 0.0f : frustum.planes[ plane ][ 2 ];
+			pPlanes->w[ plane ] = bPadding ? 1.0f : frustum.planes[ plane ][ 3 ];
+			pPlanes->absX[ plane ] = fabsf( pPlanes->x[ plane ] );
+			pPlanes->absY[ plane ] = fabsf( pPlanes->y[ plane ] );
+			pPlanes->absZ[ plane ] = fabsf( pPlanes->z[ plane ] );
+		}
+	}
+
+	//--------------------------------------------------------------------------------------
+	// Test a box against the planes in *pMask. Returns false if it is outside any of them,
+	// otherwise removes the planes it is wholly inside from *pMask.
+	//--------------------------------------------------------------------------------------
+	bool TestBoundsScalar( const PlaneSet& planes, const float* pBounds, unsigned int* pMask )
+	{
+		unsigned int mask = *pMask;
+		for( unsigned int plane = 0; plane < cNumFrustumPlanes; ++plane )
+		{
+			if( mask & ( 1u << plane ) )
+			{
+				float distance = planes.x[ plane ] * pBounds[0] + planes.y[ plane ] * pBounds[1] + planes.z[ plane ] * pBounds[2] + planes.w[ plane ];
+				float radius = planes.absX[ plane ] * pBounds[3] + planes.absY[ plane ] * pBounds[4] + planes.absZ[ plane ] * pBounds[5];
+				if( distance + radius < 0.0f )
+				{
+					return false;
+				}
+				if( distance - radius >= 0.0f )
+				{
+					mask &= ~( 1u << plane );
+				}
+			}
+		}
+		*pMask = mask;
+		return true;
+	}
+
+#if FRUSTUM_CULLING_SSE
+	bool TestBoundsSSE( const PlaneSet& planes, const float* pBounds, unsigned int* pMask )
+	{
+		__m128 centerX = _mm_set1_ps( pBounds[0] );
+		__m128 centerY = _mm_set1_ps( pBounds[1] );
+		__m128 centerZ = _mm_set1_ps( pBounds[2] );
+		__m128 extentX = _mm_set1_ps( pBounds[3] );
+		__m128 extentY = _mm_set1_ps( pBounds[4] );
+		__m128 extentZ = _mm_set1_ps( pBounds[5] );
+		__m128 zero = _mm_setzero_ps();
+
+		unsigned int outside = 0;
+		unsigned int inside = 0;
+		for( unsigned int first = 0; first < 8; first += 4 )
+		{
+			__m128 distance = _mm_mul_ps( _mm_loadu_ps( &planes.x[ first ] ), centerX );
+			distance = _mm_add_ps( distance, _mm_mul_ps( _mm_loadu_ps( &planes.y[ first ] ), centerY ) );
+			distance = _mm_add_ps( distance, _mm_mul_ps( _mm_loadu_ps( &planes.z[ first ] ), centerZ ) );
+			distance = _mm_add_ps( distance, _mm_loadu_ps( &planes.w[ first ] ) );
+			__m128 radius = _mm_mul_ps( _mm_loadu_ps( &planes.absX[ first ] ), extentX );
+			radius = _mm_add_ps( radius, _mm_mul_ps( _mm_loadu_ps( &planes.absY[ first ] ), extentY ) );
+			radius = _mm_add_ps( radius, _mm_mul_ps( _mm_loadu_ps( &planes.absZ[ first ] ), extentZ ) );
+			outside |= (unsigned int)_mm_movemask_ps( _mm_cmplt_ps( _mm_add_ps( distance, radius ), zero ) ) << first;
+			inside |= (unsigned int)_mm_movemask_ps( _mm_cmpge_ps( _mm_sub_ps( distance, radius ), zero ) ) << first;
+		}
+
+		if( outside & *pMask )
+		{
+			return false;
+		}
+		*pMask &= ~inside;
+		return true;
+	}
+#endif
+
+	bool TestBounds( const PlaneSet& planes, const float* pBounds, unsigned int* pMask, bool bSSE )
+	{
+#if FRUSTUM_CULLING_SSE
+		if( bSSE )
+		{
+			return TestBoundsSSE( planes, pBounds, pMask );
+		}
+#endif
+		return TestBoundsScalar( planes, pBounds, pMask );
+	}
+
+	void GrowBounds( const float* pBounds, float* pMin, float* pMax )
+	{
+		for( int axis = 0; axis < 3; ++axis )
+		{
+			float low = pBounds[ axis ] - pBounds[ axis + 3 ];
+			float high = pBounds[ axis ] + pBounds[ axis + 3 ];
+			pMin[ axis ] = low < pMin[ axis ] ? low : pMin[ axis ];
+			pMax[ axis ] = high > pMax[ axis ] ? high : pMax[ axis ];
+		}
+	}
+
+	// Orders items by the center of their box on one axis
+	struct CenterLess
+	{
+		const float*	pBounds;
+		int				axis;
+
+		bool operator()( unsigned int a, unsigned int b ) const
+		{
+			return pBounds[ a * cBoundsFloats + axis ] < pBounds[ b * cBoundsFloats + axis ];
+		}
+	};
+}
+
+//--------------------------------------------------------------------------------------
+// Planes from the columns of the matrix, as clip space -w <= x <= w, -w <= y <= w and
+// 0 <= z <= w. The planes are not normalized, which the tests do not need.
+//--------------------------------------------------------------------------------------
+void ExtractFrustum( const float* pViewProj, Frustum* pFrustum )
+{
+	for( int i = 0; i < 4; ++i )
+	{
+		const float* pRow = pViewProj + i * 4;
+		pFrustum->planes[0][i] = pRow[3] + pRow[0];	// left
+		pFrustum->planes[1][i] = pRow[3] - pRow[0];	// right
+		pFrustum->planes[2][i] = pRow[3] + pRow[1];	// bottom
+		pFrustum->planes[3][i] = pRow[3] - pRow[1];	// top
+		pFrustum->planes[4][i] = pRow[2];			// near
+		pFrustum->planes[5][i] = pRow[3] - pRow[2];	// far
+	}
+}
+
+void TransformBounds( const float* pBounds, const float* pMatrix, float* pOut )
+{
+	float center[3];
+	float extent[3];
+	for( int axis = 0; axis < 3; ++axis )
+	{
+		center[ axis ] = pBounds[0] * pMatrix[ axis ] + pBounds[1] * pMatrix[ 4 + axis ] + pBounds[2] * pMatrix[ 8 + axis ] + pMatrix[ 12 + axis ];
+		extent[ axis ] = pBounds[3] * fabsf( pMatrix[ axis ] ) + pBounds[4] * fabsf( pMatrix[ 4 + axis ] ) + pBounds[5] * fabsf( pMatrix[ 8 + axis ] );
+	}
+	for( int axis = 0; axis < 3; ++axis )
+	{
+		pOut[ axis ] = center[ axis ];
+		pOut[ axis + 3 ] = extent[ axis ];
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// BoundingVolumeHierarchy
+//--------------------------------------------------------------------------------------
+BoundingVolumeHierarchy::BoundingVolumeHierarchy()
+{
+}
+
+void BoundingVolumeHierarchy::Build( unsigned int numItems, const float* pBounds )
+{
+	m_Items.resize( numItems );
+	for( unsigned int item = 0; item < numItems; ++item )
+	{
+		m_Items[ item ] = item;
+	}
+	m_ItemBounds.resize( numItems * cBoundsFloats );
+	m_Nodes.clear();
+	m_Nodes.reserve( numItems ? 2 * numItems - 1 : 0 );
+	if( numItems )
+	{
+		BuildNode( 0, numItems, pBounds );
+	}
+	Refit( pBounds );
+}
+
+unsigned int BoundingVolumeHierarchy::BuildNode( unsigned int firstItem, unsigned int numItems, const float* pBounds )
+{
+	unsigned int node = (unsigned int)m_Nodes.size();
+	Node newNode;
+	memset( &newNode, 0, sizeof( newNode ) );
+	newNode.firstItem = firstItem;
+	newNode.numItems = numItems;
+	m_Nodes.push_back( newNode );
+	if( numItems <= cMaxLeafItems )
+	{
+		return node;
+	}
+
+	// split on the axis the item centers are most spread along
+	float minCenter[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float maxCenter[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for( unsigned int i = firstItem; i < firstItem + numItems; ++i )
+	{
+		const float* pCenter = pBounds + m_Items[ i ] * cBoundsFloats;
+		for( int axis = 0; axis < 3; ++axis )
+		{
+			minCenter[ axis ] = pCenter[ axis ] < minCenter[ axis ] ? pCenter[ axis ] : minCenter[ axis ];
+			maxCenter[ axis ] = pCenter[ axis ] > maxCenter[ axis ] ? pCenter[ axis ] : maxCenter[ axis ];
+		}
+	}
+	CenterLess less;
+	less.pBounds = pBounds;
+	less.axis = 0;
+	for( int axis = 1; axis < 3; ++axis )
+	{
+		if( maxCenter[ axis ] - minCenter[ axis ] > maxCenter[ less.axis ] - minCenter[ less.axis ] )
+		{
+			less.axis = axis;
+		}
+	}
+
+	unsigned int numFirst = numItems / 2;
+	std::vector<unsigned int>::iterator first = m_Items.begin() + firstItem;
+	std::nth_element( first, first + numFirst, first + numItems, less );
+	BuildNode( firstItem, numFirst, pBounds );
+	unsigned int secondChild = BuildNode( firstItem + numFirst, numItems - numFirst, pBounds );
+	m_Nodes[ node ].secondChild = secondChild;
+	return node;
+}
+
+void BoundingVolumeHierarchy::Refit( const float* pBounds )
+{
+	for( unsigned int i = 0; i < m_Items.size(); ++i )
+	{
+		memcpy( &m_ItemBounds[ i * cBoundsFloats ], pBounds + m_Items[ i ] * cBoundsFloats, cBoundsFloats * sizeof( float ) );
+	}
+	RefitNodes();
+}
+
+//--------------------------------------------------------------------------------------
+// Children follow their parent, so going backwards each node's children are done first
+//--------------------------------------------------------------------------------------
+void BoundingVolumeHierarchy::RefitNodes()
+{
+	for( unsigned int node = (unsigned int)m_Nodes.size(); node-- > 0; )
+	{
+		Node& rNode = m_Nodes[ node ];
+		float minBounds[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float maxBounds[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+		if( rNode.secondChild )
+		{
+			GrowBounds( m_Nodes[ node + 1 ].bounds, minBounds, maxBounds );
+			GrowBounds( m_Nodes[ rNode.secondChild ].bounds, minBounds, maxBounds );
+		}
+		else
+		{
+			for( unsigned int i = rNode.firstItem; i < rNode.firstItem + rNode.numItems; ++i )
+			{
+				GrowBounds( &m_ItemBounds[ i * cBoundsFloats ], minBounds, maxBounds );
+			}
+		}
+		for( int axis = 0; axis < 3; ++axis )
+		{
+			rNode.bounds[ axis ] = 0.5f * ( minBounds[ axis ] + maxBounds[ axis ] );
+			rNode.bounds[ axis + 3 ] = 0.5f * ( maxBounds[ axis ] - minBounds[ axis ] ) * cNodeBoundsScale;
+		}
+	}
+}
+
+unsigned int BoundingVolumeHierarchy::Cull( const Frustum& frustum, unsigned char* pVisible ) const
+{
+	return CullNodes( frustum, pVisible, FRUSTUM_CULLING_SSE != 0 );
+}
+
+unsigned int BoundingVolumeHierarchy::CullScalar( const Frustum& frustum, unsigned char* pVisible ) const
+{
+	return CullNodes( frustum, pVisible, false );
+}
+
+//--------------------------------------------------------------------------------------
+// Depth first walk, carrying the planes each node still straddles. A node inside all
+// planes has all its items visible without testing them.
+//--------------------------------------------------------------------------------------
+unsigned int BoundingVolumeHierarchy::CullNodes( const Frustum& frustum, unsigned char* pVisible, bool bSSE ) const
+{
+	if( m_Items.empty() )
+	{
+		return 0;
+	}
+	memset( pVisible, 0, m_Items.size() );
+
+	PlaneSet planes;
+	SetPlanes( frustum, &planes );
+
+	unsigned int stackNodes[ cMaxTraversalDepth ];
+	unsigned int stackMasks[ cMaxTraversalDepth ];
+	unsigned int stackSize = 1;
+	stackNodes[0] = 0;
+	stackMasks[0] = cAllPlanes;
+
+	unsigned int numVisible = 0;
+	while( stackSize )
+	{
+		--stackSize;
+		unsigned int node = stackNodes[ stackSize ];
+		const Node& rNode = m_Nodes[ node ];
+		unsigned int mask = stackMasks[ stackSize ];
+		if( !TestBounds( planes, rNode.bounds, &mask, bSSE ) )
+		{
+			continue;
+		}
+
+		if( 0 == mask )
+		{
+			for( unsigned int i = rNode.firstItem; i < rNode.firstItem + rNode.numItems; ++i )
+			{
+				pVisible[ m_Items[ i ] ] = 1;
+			}
+			numVisible += rNode.numItems;
+		}
+		else if( rNode.secondChild )
+		{
+			stackNodes[ stackSize ] = rNode.secondChild;
+			stackMasks[ stackSize ] = mask;
+			stackNodes[ stackSize + 1 ] = node + 1;
+			stackMasks[ stackSize + 1 ] = mask;
+			stackSize += 2;
+		}
+		else
+		{
+			for( unsigned int i = rNode.firstItem; i < rNode.firstItem + rNode.numItems; ++i )
+			{
+				unsigned int itemMask = mask;
+				if( TestBounds( planes, &m_ItemBounds[ i * cBoundsFloats ], &itemMask, bSSE ) )
+				{
+					pVisible[ m_Items[ i ] ] = 1;
+					++numVisible;
+				}
+			}
+		}
+	}
+	return numVisible;
+}
+
+unsigned int BoundingVolumeHierarchy::CullItems( unsigned int numItems, const float* pBounds, const Frustum& frustum, unsigned char* pVisible )
+{
+	PlaneSet planes;
+	SetPlanes( frustum, &planes );
+
+	unsigned int numVisible = 0;
+	for( unsigned int item = 0; item < numItems; ++item )
+	{
+		unsigned int mask = cAllPlanes;
+		pVisible[ item ] = TestBounds( planes, pBounds + item * cBoundsFloats, &mask, FRUSTUM_CULLING_SSE != 0 ) ? 1 : 0;
+		numVisible += pVisible[ item ];
+	}
+	return numVisible;
+}
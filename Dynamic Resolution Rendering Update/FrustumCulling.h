@@ -0,0 +1,101 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Note: like ResolutionController.h this file has no D3D or DXUT dependencies.
+
+#include <vector>
+
+//--------------------------------------------------------------------------------------
+// View frustum culling of axis aligned boxes with a bounding volume hierarchy. Boxes
+// are cBoundsFloats floats, the center then the half extents. A box is tested against
+// all six planes at once with SSE, and the planes a node is inside of are not tested
+// again for its children. The scalar versions are the fallback where SSE is not
+// available, and the reference the SSE versions are checked against.
+//
+// Matrices follow D3DX: 16 floats, row major, transforming row vectors.
+//--------------------------------------------------------------------------------------
+#if defined( _M_IX86 ) || defined( _M_X64 ) || defined( __SSE2__ )
+#define FRUSTUM_CULLING_SSE 1
+#else
+#define FRUSTUM_CULLING_SSE 0
+#endif
+
+const unsigned int cBoundsFloats = 6;
+const unsigned int cNumFrustumPlanes = 6;
+
+// Planes a, b, c, d with points inside where a*x + b*y + c*z + d >= 0
+struct Frustum
+{
+	float	planes[ cNumFrustumPlanes ][ 4 ];
+};
+
+// Frustum of a view projection matrix with D3D clip space, z from 0 to w
+void ExtractFrustum( const float* pViewProj, Frustum* pFrustum );
+
+// Axis aligned box enclosing a box transformed by an affine matrix, pOut may be pBounds
+void TransformBounds( const float* pBounds, const float* pMatrix, float* pOut );
+
+class BoundingVolumeHierarchy
+{
+public:
+	BoundingVolumeHierarchy();
+
+	// Build over numItems boxes, splitting each node's items at the median center on the
+	// longest axis of their centers. Builds again from scratch, so allocates.
+	void			Build( unsigned int numItems, const float* pBounds );
+
+	// Update the node bounds for moved items, keeping the tree. pBounds is indexed by
+	// item as for Build().
+	void			Refit( const float* pBounds );
+
+	// Writes 1 to pVisible[ item ] for items intersecting the frustum, 0 otherwise, and
+	// returns the number visible. Boxes straddling a plane outside the frustum, near a
+	// corner, are kept as visible.
+	unsigned int	Cull( const Frustum& frustum, unsigned char* pVisible ) const;
+	unsigned int	CullScalar( const Frustum& frustum, unsigned char* pVisible ) const;
+
+	// Tests every box without a hierarchy, giving the same results as Cull()
+	static unsigned int CullItems( unsigned int numItems, const float* pBounds, const Frustum& frustum, unsigned char* pVisible );
+
+	unsigned int	GetNumItems() const
+	{
+		return (unsigned int)m_Items.size();
+	}
+	unsigned int	GetNumNodes() const
+	{
+		return (unsigned int)m_Nodes.size();
+	}
+
+private:
+	// Nodes are depth first, so a node's first child follows it and its items are the
+	// contiguous range of m_Items from firstItem. Leaves have no second child.
+	struct Node
+	{
+		float			bounds[ cBoundsFloats ];
+		unsigned int	firstItem;
+		unsigned int	numItems;
+		unsigned int	secondChild;
+	};
+
+	unsigned int	BuildNode( unsigned int firstItem, unsigned int numItems, const float* pBounds );
+	void			RefitNodes();
+	unsigned int	CullNodes( const Frustum& frustum, unsigned char* pVisible, bool bSSE ) const;
+
+	std::vector<Node>			m_Nodes;
+	std::vector<unsigned int>	m_Items;		// items in node order
+	std::vector<float>			m_ItemBounds;	// their bounds, in the same order
+};
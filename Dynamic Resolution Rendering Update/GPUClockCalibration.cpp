@@ -0,0 +1,168 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "GPUClockCalibration.h"
+
+#include <math.h>
+
+namespace
+{
+	// Floor on the uncertainty of a sample, so a sample with CPU times closer than the
+	// timer resolution does not take all the weight
+	const double cMinSampleUncertainty = 1.0e-6;
+
+	// Drift beyond this is not a clock difference, rather samples which do not fit
+	const double cMaxDrift = 1.0e-3;
+}
+
+//--------------------------------------------------------------------------------------
+// Ctor
+//--------------------------------------------------------------------------------------
+GPUClockCalibration::GPUClockCalibration( unsigned int maxSamples, double minDriftSpan )
+	: m_MaxSamples( maxSamples ? maxSamples : 1 )
+	, m_MinDriftSpan( minDriftSpan )
+{
+	m_pSamples = new Sample[ m_MaxSamples ];
+	Reset();
+}
+
+//--------------------------------------------------------------------------------------
+// Dtor
+//--------------------------------------------------------------------------------------
+GPUClockCalibration::~GPUClockCalibration()
+{
+	delete[] m_pSamples;
+}
+
+void GPUClockCalibration::Reset()
+{
+	m_NumSamples	= 0;
+	m_NextSample	= 0;
+	m_Frequency		= 0;
+	m_RefCPUTime	= 0.0;
+	m_RefOffset		= 0.0;
+	m_Drift			= 0.0;
+	m_Residual		= 0.0;
+}
+
+double GPUClockCalibration::TicksToSeconds( unsigned long long ticks, unsigned long long frequency )
+{
+	return (double)( ticks / frequency ) + (double)( ticks % frequency ) / (double)frequency;
+}
+
+//--------------------------------------------------------------------------------------
+// Add a sample and refit
+//--------------------------------------------------------------------------------------
+void GPUClockCalibration::AddSample( double cpuBefore, double cpuAfter, unsigned long long gpuTicks, unsigned long long frequency )
+{
+	if( 0 == frequency || cpuAfter < cpuBefore )
+	{
+		return;
+	}
+	if( frequency != m_Frequency )
+	{
+		Reset();
+		m_Frequency = frequency;
+	}
+
+	double uncertainty = 0.5 * ( cpuAfter - cpuBefore );
+	if( uncertainty < cMinSampleUncertainty )
+	{
+		uncertainty = cMinSampleUncertainty;
+	}
+	Sample& sample = m_pSamples[ m_NextSample ];
+	sample.cpuTime	= 0.5 * ( cpuBefore + cpuAfter );
+	sample.offset	= TicksToSeconds( gpuTicks, frequency ) - sample.cpuTime;
+	sample.weight	= 1.0 / ( uncertainty * uncertainty );
+
+	m_NextSample = ( m_NextSample + 1 ) % m_MaxSamples;
+	if( m_NumSamples < m_MaxSamples )
+	{
+		++m_NumSamples;
+	}
+	Fit();
+}
+
+//--------------------------------------------------------------------------------------
+// Weighted least squares fit of offset against CPU time. Times are taken relative to
+// the weighted mean time, so the sums do not lose precision to large absolute times.
+//--------------------------------------------------------------------------------------
+void GPUClockCalibration::Fit()
+{
+	double sumWeight = 0.0;
+	double sumTime = 0.0;
+	double sumOffset = 0.0;
+	double minTime = m_pSamples[0].cpuTime;
+	double maxTime = m_pSamples[0].cpuTime;
+	for( unsigned int i = 0; i < m_NumSamples; ++i )
+	{
+		const Sample& sample = m_pSamples[i];
+		sumWeight	+= sample.weight;
+		sumTime		+= sample.weight * ( sample.cpuTime - m_pSamples[0].cpuTime );
+		sumOffset	+= sample.weight * sample.offset;
+		minTime = sample.cpuTime < minTime ? sample.cpuTime : minTime;
+		maxTime = sample.cpuTime > maxTime ? sample.cpuTime : maxTime;
+	}
+	m_RefCPUTime	= m_pSamples[0].cpuTime + sumTime / sumWeight;
+	m_RefOffset		= sumOffset / sumWeight;
+	m_Drift			= 0.0;
+
+	if( maxTime - minTime >= m_MinDriftSpan )
+	{
+		double sumTT = 0.0;
+		double sumTO = 0.0;
+		for( unsigned int i = 0; i < m_NumSamples; ++i )
+		{
+			const Sample& sample = m_pSamples[i];
+			double t = sample.cpuTime - m_RefCPUTime;
+			sumTT += sample.weight * t * t;
+			sumTO += sample.weight * t * ( sample.offset - m_RefOffset );
+		}
+		if( sumTT > 0.0 )
+		{
+			m_Drift = sumTO / sumTT;
+			m_Drift = m_Drift > cMaxDrift ? cMaxDrift : ( m_Drift < -cMaxDrift ? -cMaxDrift : m_Drift );
+		}
+	}
+
+	double sumSquares = 0.0;
+	for( unsigned int i = 0; i < m_NumSamples; ++i )
+	{
+		const Sample& sample = m_pSamples[i];
+		double error = sample.offset - GetOffset( sample.cpuTime );
+		sumSquares += sample.weight * error * error;
+	}
+	m_Residual = sqrt( sumSquares / sumWeight );
+}
+
+//--------------------------------------------------------------------------------------
+// Conversions
+//--------------------------------------------------------------------------------------
+double GPUClockCalibration::GetOffset( double cpuTime ) const
+{
+	return m_RefOffset + m_Drift * ( cpuTime - m_RefCPUTime );
+}
+
+double GPUClockCalibration::GPUToCPUTime( unsigned long long gpuTicks ) const
+{
+	if( !m_Frequency )
+	{
+		return 0.0;
+	}
+	// gpu = cpu + offset( cpu ), solved for cpu about the reference time
+	double gpuTime = TicksToSeconds( gpuTicks, m_Frequency );
+	double refGPUTime = m_RefCPUTime + m_RefOffset;
+	return m_RefCPUTime + ( gpuTime - refGPUTime ) / ( 1.0 + m_Drift );
+}
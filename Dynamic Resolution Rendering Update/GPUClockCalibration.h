@@ -0,0 +1,104 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Note: like ResolutionController.h this file has no D3D or DXUT dependencies. The
+// samples are taken with GPUQueryBackendD3D11::SampleClocks().
+
+//--------------------------------------------------------------------------------------
+// Correlates the GPU timestamp clock with the CPU clock, so GPU timestamps can be placed
+// on the CPU timeline. Each sample is a GPU timestamp known to have been taken between
+// two CPU times, and gives the GPU minus CPU time offset to within half that interval.
+// The offset is fitted as a line against CPU time over the last maxSamples samples,
+// weighting each by its precision, so the slope tracks the drift between the clocks.
+//
+// Until samples span minDriftSpan seconds the drift is taken as zero. A change of
+// timestamp frequency restarts the calibration, as the GPU clock may have been reset.
+//--------------------------------------------------------------------------------------
+class GPUClockCalibration
+{
+public:
+	GPUClockCalibration( unsigned int maxSamples = 16, double minDriftSpan = 1.0 );
+	~GPUClockCalibration();
+
+	void Reset();
+
+	// A GPU timestamp of gpuTicks at frequency ticks per second, taken between the CPU
+	// times cpuBefore and cpuAfter in seconds
+	void AddSample( double cpuBefore, double cpuAfter, unsigned long long gpuTicks, unsigned long long frequency );
+
+	bool IsValid() const
+	{
+		return m_NumSamples > 0;
+	}
+	unsigned int GetNumSamples() const
+	{
+		return m_NumSamples;
+	}
+
+	// CPU time in seconds of a GPU timestamp, which must use the calibrated frequency
+	double GPUToCPUTime( unsigned long long gpuTicks ) const;
+
+	// GPU minus CPU time in seconds at CPU time cpuTime
+	double GetOffset( double cpuTime ) const;
+
+	// Relative rate of the GPU clock less one, so 1.0e-6 is the GPU gaining 1us a second
+	double GetDrift() const
+	{
+		return m_Drift;
+	}
+
+	// Weighted RMS distance of the samples from the fitted offset, in seconds
+	double GetResidual() const
+	{
+		return m_Residual;
+	}
+
+	unsigned long long GetFrequency() const
+	{
+		return m_Frequency;
+	}
+
+	// GPU ticks as seconds, split so large tick counts keep their precision
+	static double TicksToSeconds( unsigned long long ticks, unsigned long long frequency );
+
+private:
+	struct Sample
+	{
+		double	cpuTime;	// middle of the CPU interval
+		double	offset;		// GPU minus CPU time at cpuTime
+		double	weight;
+	};
+
+	void Fit();
+
+	Sample*				m_pSamples;		// ring buffer of the last m_MaxSamples
+	unsigned int		m_MaxSamples;
+	unsigned int		m_NumSamples;
+	unsigned int		m_NextSample;
+	double				m_MinDriftSpan;
+	unsigned long long	m_Frequency;
+
+	// fitted offset = m_RefOffset + m_Drift * ( cpuTime - m_RefCPUTime )
+	double				m_RefCPUTime;
+	double				m_RefOffset;
+	double				m_Drift;
+	double				m_Residual;
+
+	//prevent assign and copy
+	GPUClockCalibration( const GPUClockCalibration& rhs );
+	GPUClockCalibration& operator=( const GPUClockCalibration& rhs );
+};
@@ -0,0 +1,236 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "GPUPipelineStats.h"
+
+#include <algorithm>
+#include <string.h>
+
+//--------------------------------------------------------------------------------------
+// Ctor, all per slot storage is allocated here
+//--------------------------------------------------------------------------------------
+GPUPipelineStats::GPUPipelineStats( unsigned int pipelineDepth, unsigned int maxPipelineDepth )
+	: m_pBackend( NULL )
+	, m_PipelineDepth( pipelineDepth ? pipelineDepth : 1 )
+	, m_MaxPipelineDepth( std::max( maxPipelineDepth, m_PipelineDepth ) )
+	, m_NumBegins( 0 )
+	, m_Current( 0 )
+	, m_OldestPending( 0 )
+	, m_bOpenInterval( false )
+	, m_NumDroppedBegins( 0 )
+	, m_LastLatency( 0 )
+	, m_MaxLatency( 0 )
+{
+	m_pQueries		= new unsigned int[ m_MaxPipelineDepth ];
+	m_pbPending		= new bool[ m_MaxPipelineDepth ];
+	m_pBeginNumbers	= new unsigned int[ m_MaxPipelineDepth ];
+	for( unsigned int slot = 0; slot < m_MaxPipelineDepth; ++slot )
+	{
+		m_pQueries[ slot ] = slot;
+		m_pbPending[ slot ] = false;
+		m_pBeginNumbers[ slot ] = 0;
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Dtor
+//--------------------------------------------------------------------------------------
+GPUPipelineStats::~GPUPipelineStats()
+{
+	Release();
+	delete[] m_pQueries;
+	delete[] m_pbPending;
+	delete[] m_pBeginNumbers;
+}
+
+//--------------------------------------------------------------------------------------
+// Query pool creation, one query per interval in flight. A pool which has grown is
+// recreated at the grown size.
+//--------------------------------------------------------------------------------------
+bool GPUPipelineStats::Create( IGPUQueryBackend* pBackend )
+{
+	Release();
+	if( !pBackend->CreatePipelineStats( m_PipelineDepth ) )
+	{
+		pBackend->ReleasePipelineStats();
+		return false;
+	}
+	m_pBackend = pBackend;
+	return true;
+}
+
+void GPUPipelineStats::Release()
+{
+	if( m_pBackend )
+	{
+		m_pBackend->ReleasePipelineStats();
+		m_pBackend = NULL;
+	}
+	for( unsigned int slot = 0; slot < m_PipelineDepth; ++slot )
+	{
+		m_pQueries[ slot ] = slot;
+		m_pbPending[ slot ] = false;
+	}
+	m_Current		= 0;
+	m_OldestPending	= 0;
+	m_bOpenInterval	= false;
+}
+
+//--------------------------------------------------------------------------------------
+// Doubles the pipeline depth, up to m_MaxPipelineDepth, when every slot is pending.
+// The slots are rotated so the oldest pending interval is first and the new slots
+// follow the newest, keeping the pending intervals in the order they were issued.
+//--------------------------------------------------------------------------------------
+bool GPUPipelineStats::Grow()
+{
+	if( m_PipelineDepth >= m_MaxPipelineDepth )
+	{
+		return false;
+	}
+	unsigned int newDepth = std::min( 2 * m_PipelineDepth, m_MaxPipelineDepth );
+	if( !m_pBackend->GrowPipelineStats( newDepth ) )
+	{
+		return false;
+	}
+
+	std::rotate( m_pQueries, m_pQueries + m_OldestPending, m_pQueries + m_PipelineDepth );
+	std::rotate( m_pbPending, m_pbPending + m_OldestPending, m_pbPending + m_PipelineDepth );
+	std::rotate( m_pBeginNumbers, m_pBeginNumbers + m_OldestPending, m_pBeginNumbers + m_PipelineDepth );
+	for( unsigned int slot = m_PipelineDepth; slot < newDepth; ++slot )
+	{
+		m_pQueries[ slot ] = slot;
+		m_pbPending[ slot ] = false;
+	}
+	m_OldestPending = 0;
+	m_Current = m_PipelineDepth;
+	m_PipelineDepth = newDepth;
+	return true;
+}
+
+//--------------------------------------------------------------------------------------
+// Begin statistics, call this at the start of the block of GPU work to count.
+// Use only one begin/end pair per frame per instance.
+//--------------------------------------------------------------------------------------
+bool GPUPipelineStats::Begin()
+{
+	if( !m_pBackend || m_bOpenInterval )
+	{
+		return false;
+	}
+	++m_NumBegins;
+	if( m_pbPending[ m_Current ] && !Grow() )
+	{
+		// the GPU is more than m_MaxPipelineDepth intervals behind, so skip this one
+		++m_NumDroppedBegins;
+		return false;
+	}
+	m_pBeginNumbers[ m_Current ] = m_NumBegins;
+	m_pBackend->BeginPipelineStats( m_pQueries[ m_Current ] );
+	m_bOpenInterval = true;
+	return true;
+}
+
+//--------------------------------------------------------------------------------------
+// End statistics, call this at the end of the block of GPU work to count
+//--------------------------------------------------------------------------------------
+bool GPUPipelineStats::End()
+{
+	if( !m_bOpenInterval )
+	{
+		return false;
+	}
+	m_pBackend->EndPipelineStats( m_pQueries[ m_Current ] );
+	m_pbPending[ m_Current ] = true;
+	m_Current = ( m_Current + 1 ) % m_PipelineDepth;
+	m_bOpenInterval = false;
+	return true;
+}
+
+//--------------------------------------------------------------------------------------
+// Returns true if there is a valid result, storing the counts of the oldest interval in
+// pCounts and removing it from the pool. Never waits for the GPU, a false return with
+// IsPending() true means the result is not ready.
+//--------------------------------------------------------------------------------------
+bool GPUPipelineStats::GetStatistics( GPUPipelineCounts* pCounts )
+{
+	memset( pCounts, 0, sizeof( GPUPipelineCounts ) );
+	if( !m_pbPending[ m_OldestPending ] || !m_pBackend->GetPipelineStats( m_pQueries[ m_OldestPending ], pCounts ) )
+	{
+		return false;
+	}
+
+	m_LastLatency = m_NumBegins - m_pBeginNumbers[ m_OldestPending ];
+	m_MaxLatency = std::max( m_MaxLatency, m_LastLatency );
+	m_pbPending[ m_OldestPending ] = false;
+	m_OldestPending = ( m_OldestPending + 1 ) % m_PipelineDepth;
+	return true;
+}
+
+
+
+//--------------------------------------------------------------------------------------
+// Ctor
+//--------------------------------------------------------------------------------------
+AveragedGPUPipelineStats::AveragedGPUPipelineStats( unsigned int updateCount, unsigned int pipelineDepth )
+	: GPUPipelineStats( pipelineDepth )
+	, m_UpdateCount( updateCount ? updateCount : 1 )
+	, m_AccumulatingVSInvocations( 0.0 )
+	, m_AccumulatingPrimitives( 0.0 )
+	, m_AccumulatingPSInvocations( 0.0 )
+	, m_NumAccumulations( 0 )
+	, m_bHaveAverage( false )
+{
+	memset( &m_AveragedStatistics, 0, sizeof( m_AveragedStatistics ) );
+}
+
+//--------------------------------------------------------------------------------------
+// Dtor
+//--------------------------------------------------------------------------------------
+AveragedGPUPipelineStats::~AveragedGPUPipelineStats()
+{
+}
+
+//--------------------------------------------------------------------------------------
+// Accumulates every ready result, so the pool does not fill when the GPU delivers
+// several at once, and updates averaged per interval statistics to pAveragedStatistics
+//--------------------------------------------------------------------------------------
+bool AveragedGPUPipelineStats::HaveUpdatedAveragedStatistics( PipelineStatistics* pAveragedStatistics )
+{
+	bool bUpdate = false;
+	GPUPipelineCounts counts;
+	while( GetStatistics( &counts ) )
+	{
+		// accumulated as doubles, the counts can be large and floats would lose them
+		m_AccumulatingVSInvocations	+= (double)counts.vsInvocations;
+		m_AccumulatingPrimitives	+= (double)counts.primitives;
+		m_AccumulatingPSInvocations	+= (double)counts.psInvocations;
+		++m_NumAccumulations;
+		if( m_NumAccumulations >= m_UpdateCount )
+		{
+			m_AveragedStatistics.vsInvocations	= (float)( m_AccumulatingVSInvocations / (double)m_NumAccumulations );
+			m_AveragedStatistics.primitives		= (float)( m_AccumulatingPrimitives / (double)m_NumAccumulations );
+			m_AveragedStatistics.psInvocations	= (float)( m_AccumulatingPSInvocations / (double)m_NumAccumulations );
+			m_AccumulatingVSInvocations	= 0.0;
+			m_AccumulatingPrimitives	= 0.0;
+			m_AccumulatingPSInvocations	= 0.0;
+			m_NumAccumulations = 0;
+			m_bHaveAverage = true;
+			bUpdate = true;
+		}
+	}
+	*pAveragedStatistics = m_AveragedStatistics;
+
+	return bUpdate;
+}
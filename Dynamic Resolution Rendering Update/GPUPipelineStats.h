@@ -0,0 +1,145 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Note: like GPUProfiler.h this file has no D3D or DXUT dependencies. The queries are
+// issued through IGPUQueryBackend, see GPUQueryBackendD3D11.h.
+
+#include "GPUProfiler.h"
+
+//--------------------------------------------------------------------------------------
+// Pipeline statistics counted over a begin / end pair, as floats so they can be
+// averaged. The D3D11 query gives more counters, these are the ones used for costing.
+//--------------------------------------------------------------------------------------
+struct PipelineStatistics
+{
+	float	vsInvocations;	// vertex shader invocations
+	float	primitives;		// primitives read by the input assembler
+	float	psInvocations;	// pixel shader invocations, i.e. pixels shaded
+};
+
+//--------------------------------------------------------------------------------------
+// Pipeline statistics begin / end intervals using the pipeline statistics queries of an
+// IGPUQueryBackend, with pipelineDepth intervals in flight. Results are read in the
+// order the intervals were issued without waiting for the GPU. If every interval is
+// still in flight when a new one begins the pool doubles, as GPUProfiler's does, up to
+// maxPipelineDepth intervals, and once it can grow no further that interval is dropped.
+//--------------------------------------------------------------------------------------
+class GPUPipelineStats
+{
+public:
+	GPUPipelineStats( unsigned int pipelineDepth = 4, unsigned int maxPipelineDepth = 16 );
+	~GPUPipelineStats();
+
+	// Create the query pool through pBackend, which must outlive the use of it
+	bool Create( IGPUQueryBackend* pBackend );
+	void Release();
+
+	// Issue a statistics begin, if possible. Returns false if every interval is in
+	// flight and the pool could not grow, which is counted in GetNumDroppedBegins().
+	// Must be issued in non interleaved pairs per instance
+	bool Begin();
+
+	// Issue a statistics end to complete the interval
+	bool End();
+
+	// Reads the oldest interval which has been issued and removes it from the pool.
+	// Returns false if there is none or its result is not ready, so call this until it
+	// returns false to drain every ready result.
+	bool GetStatistics( GPUPipelineCounts* pCounts );
+
+	// True if intervals have been issued whose results have not been read
+	bool IsPending() const
+	{
+		return m_pbPending[ m_OldestPending ];
+	}
+
+	// Intervals in flight the query pool currently holds
+	unsigned int GetPipelineDepth() const
+	{
+		return m_PipelineDepth;
+	}
+	// Begin calls which failed as every interval was in flight
+	unsigned int GetNumDroppedBegins() const
+	{
+		return m_NumDroppedBegins;
+	}
+	// Begin calls between issuing an interval and reading its result, for the last
+	// result read and the worst so far
+	unsigned int GetLastLatency() const
+	{
+		return m_LastLatency;
+	}
+	unsigned int GetMaxLatency() const
+	{
+		return m_MaxLatency;
+	}
+
+private:
+	bool Grow();
+
+	IGPUQueryBackend*	m_pBackend;
+	unsigned int		m_PipelineDepth;
+	unsigned int		m_MaxPipelineDepth;
+
+	// per interval slot, sized for m_MaxPipelineDepth with the first m_PipelineDepth in
+	// use. Slot n uses backend query m_pQueries[n], so slots can be reordered when the
+	// pool grows.
+	unsigned int*		m_pQueries;
+	bool*				m_pbPending;
+	unsigned int*		m_pBeginNumbers;	// m_NumBegins when each slot was begun
+	unsigned int		m_NumBegins;		// begin calls, including dropped ones
+	unsigned int		m_Current;			// slot to issue next
+	unsigned int		m_OldestPending;	// oldest slot awaiting its result
+	bool				m_bOpenInterval;
+
+	unsigned int		m_NumDroppedBegins;
+	unsigned int		m_LastLatency;
+	unsigned int		m_MaxLatency;
+
+	//prevent assign and copy
+	GPUPipelineStats( const GPUPipelineStats& rhs );
+	GPUPipelineStats& operator=( const GPUPipelineStats& rhs );
+};
+
+//--------------------------------------------------------------------------------------
+// Average pipeline statistics based on GPUPipelineStats used over multiple frames
+//--------------------------------------------------------------------------------------
+class AveragedGPUPipelineStats : public GPUPipelineStats
+{
+public:
+	AveragedGPUPipelineStats( unsigned int updateCount = 10, unsigned int pipelineDepth = 4 );
+	~AveragedGPUPipelineStats();
+
+	// Reads every ready result. Normal usuage is to call this once a frame and update
+	// the GUI etc. when it returns true, meaning a new average was completed.
+	bool HaveUpdatedAveragedStatistics( PipelineStatistics* pAveragedStatistics );
+
+	// False until the first average is available
+	bool HaveAveragedStatistics() const
+	{
+		return m_bHaveAverage;
+	}
+private:
+
+	unsigned int		m_UpdateCount;
+	PipelineStatistics	m_AveragedStatistics;
+	double				m_AccumulatingVSInvocations;
+	double				m_AccumulatingPrimitives;
+	double				m_AccumulatingPSInvocations;
+	unsigned int		m_NumAccumulations;
+	bool				m_bHaveAverage;
+};
@@ -0,0 +1,445 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "GPUProfiler.h"
+
+#include <algorithm>
+#include <assert.h>
+#include <string.h>
+
+GPUProfiler* GPUProfiler::s_pActive = NULL;
+
+//--------------------------------------------------------------------------------------
+// Ctor, all per frame storage is allocated here
+//--------------------------------------------------------------------------------------
+GPUProfiler::GPUProfiler( unsigned int maxScopes, unsigned int frameLatency, unsigned int averageCount, unsigned int maxFrameLatency )
+	: m_pBackend( NULL )
+	, m_MaxScopes( maxScopes ? maxScopes : 1 )
+	, m_FrameLatency( frameLatency ? frameLatency : 1 )
+	, m_MaxFrameLatency( std::max( maxFrameLatency, m_FrameLatency ) )
+	, m_AverageCount( averageCount ? averageCount : 1 )
+	, m_FrameNumber( 0 )
+	, m_CurrentFrame( 0 )
+	, m_OldestPending( 0 )
+	, m_bFrameOpen( false )
+	, m_StackDepth( 0 )
+	, m_NumResults( 0 )
+	, m_bNewResults( false )
+	, m_ResultStartTicks( 0 )
+	, m_ResultEndTicks( 0 )
+	, m_ResultFrequency( 0 )
+	, m_NumAverages( 0 )
+	, m_NumAveragedFrames( 0 )
+	, m_bUpdatedAverages( false )
+	, m_NumDroppedFrames( 0 )
+	, m_NumDisjointFrames( 0 )
+	, m_LastLatency( 0 )
+	, m_MaxLatency( 0 )
+{
+	m_pScopes			= new Scope[ m_MaxScopes * m_MaxFrameLatency ];
+	m_pFrameQueries		= new unsigned int[ m_MaxFrameLatency ];
+	m_pNumScopes		= new unsigned int[ m_MaxFrameLatency ];
+	m_pbFramePending	= new bool[ m_MaxFrameLatency ];
+	m_pFrameNumbers		= new unsigned int[ m_MaxFrameLatency ];
+	m_pScopeStack		= new unsigned int[ m_MaxScopes ];
+	m_pResults			= new GPUProfileResult[ m_MaxScopes ];
+	m_pResolveResults	= new GPUProfileResult[ m_MaxScopes ];
+	m_pAverageNames		= new const char*[ m_MaxScopes ];
+	m_pAverageSums		= new float[ m_MaxScopes ];
+	m_pAverageTimes		= new float[ m_MaxScopes ];
+	m_pbAverageValid	= new bool[ m_MaxScopes ];
+	m_pFrameSums		= new float[ m_MaxScopes ];
+	m_pStats			= new StreamingStats[ m_MaxScopes ];
+	for( unsigned int frame = 0; frame < m_MaxFrameLatency; ++frame )
+	{
+		m_pFrameQueries[ frame ] = frame;
+		m_pNumScopes[ frame ] = 0;
+		m_pbFramePending[ frame ] = false;
+		m_pFrameNumbers[ frame ] = 0;
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Dtor
+//--------------------------------------------------------------------------------------
+GPUProfiler::~GPUProfiler()
+{
+	if( s_pActive == this )
+	{
+		s_pActive = NULL;
+	}
+	Release();
+	delete[] m_pScopes;
+	delete[] m_pFrameQueries;
+	delete[] m_pNumScopes;
+	delete[] m_pbFramePending;
+	delete[] m_pFrameNumbers;
+	delete[] m_pScopeStack;
+	delete[] m_pResults;
+	delete[] m_pResolveResults;
+	delete[] m_pAverageNames;
+	delete[] m_pAverageSums;
+	delete[] m_pAverageTimes;
+	delete[] m_pbAverageValid;
+	delete[] m_pFrameSums;
+	delete[] m_pStats;
+}
+
+//--------------------------------------------------------------------------------------
+// Query pool creation, two timestamps per scope for each frame in flight. A pool which
+// has grown is recreated at the grown size.
+//--------------------------------------------------------------------------------------
+bool GPUProfiler::Create( IGPUQueryBackend* pBackend )
+{
+	Release();
+	if( !pBackend->Create( 2 * m_MaxScopes * m_FrameLatency, m_FrameLatency ) )
+	{
+		pBackend->Release();
+		return false;
+	}
+	m_pBackend = pBackend;
+	return true;
+}
+
+void GPUProfiler::Release()
+{
+	if( m_pBackend )
+	{
+		m_pBackend->Release();
+		m_pBackend = NULL;
+	}
+	for( unsigned int frame = 0; frame < m_FrameLatency; ++frame )
+	{
+		m_pFrameQueries[ frame ] = frame;
+		m_pNumScopes[ frame ] = 0;
+		m_pbFramePending[ frame ] = false;
+	}
+	m_CurrentFrame		= 0;
+	m_OldestPending		= 0;
+	m_bFrameOpen		= false;
+	m_StackDepth		= 0;
+	m_NumResults		= 0;
+	m_bNewResults		= false;
+	m_NumAverages		= 0;
+	m_NumAveragedFrames	= 0;
+	m_bUpdatedAverages	= false;
+}
+
+//--------------------------------------------------------------------------------------
+// Frame begin and end
+//--------------------------------------------------------------------------------------
+void GPUProfiler::BeginFrame()
+{
+	assert( !m_bFrameOpen );
+	m_bUpdatedAverages = false;
+	m_bNewResults = false;
+	if( !m_pBackend )
+	{
+		return;
+	}
+
+	++m_FrameNumber;
+	ResolveFrames();
+
+	if( m_pbFramePending[ m_CurrentFrame ] && !Grow() )
+	{
+		// the GPU is more than m_MaxFrameLatency frames behind, so skip this frame
+		++m_NumDroppedFrames;
+		return;
+	}
+	m_pNumScopes[ m_CurrentFrame ] = 0;
+	m_StackDepth = 0;
+	m_bFrameOpen = true;
+	m_pBackend->BeginFrame( m_pFrameQueries[ m_CurrentFrame ] );
+}
+
+void GPUProfiler::EndFrame()
+{
+	if( !m_bFrameOpen )
+	{
+		return;
+	}
+	assert( 0 == m_StackDepth );	// scopes must be closed within the frame
+
+	m_pBackend->EndFrame( m_pFrameQueries[ m_CurrentFrame ] );
+	m_pbFramePending[ m_CurrentFrame ] = true;
+	m_pFrameNumbers[ m_CurrentFrame ] = m_FrameNumber;
+	m_CurrentFrame = ( m_CurrentFrame + 1 ) % m_FrameLatency;
+	m_bFrameOpen = false;
+}
+
+//--------------------------------------------------------------------------------------
+// Scope begin and end, scopes beyond m_MaxScopes in a frame are not timed
+//--------------------------------------------------------------------------------------
+void GPUProfiler::BeginScope( const char* pName )
+{
+	if( !m_bFrameOpen )
+	{
+		return;
+	}
+
+	unsigned int& numScopes = m_pNumScopes[ m_CurrentFrame ];
+	unsigned int scopeIndex = INVALID_SCOPE;
+	if( numScopes < m_MaxScopes && m_StackDepth < m_MaxScopes )
+	{
+		scopeIndex = numScopes++;
+		unsigned int firstScope = m_pFrameQueries[ m_CurrentFrame ] * m_MaxScopes;
+		Scope& scope = m_pScopes[ firstScope + scopeIndex ];
+		scope.pName		= pName;
+		scope.parent	= m_StackDepth ? m_pScopeStack[ m_StackDepth - 1 ] : INVALID_SCOPE;
+		scope.depth		= m_StackDepth;
+		m_pBackend->IssueTimestamp( 2 * ( firstScope + scopeIndex ) );
+	}
+	if( m_StackDepth < m_MaxScopes )
+	{
+		m_pScopeStack[ m_StackDepth++ ] = scopeIndex;
+	}
+}
+
+void GPUProfiler::EndScope()
+{
+	if( !m_bFrameOpen || 0 == m_StackDepth )
+	{
+		return;
+	}
+
+	unsigned int scopeIndex = m_pScopeStack[ --m_StackDepth ];
+	if( INVALID_SCOPE != scopeIndex )
+	{
+		m_pBackend->IssueTimestamp( 2 * ( m_pFrameQueries[ m_CurrentFrame ] * m_MaxScopes + scopeIndex ) + 1 );
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Doubles the frames in flight, up to m_MaxFrameLatency, when every slot is pending.
+// The slots are rotated so the oldest pending frame is first and the new slots follow
+// the newest, keeping the pending frames in the order they were issued.
+//--------------------------------------------------------------------------------------
+bool GPUProfiler::Grow()
+{
+	if( m_FrameLatency >= m_MaxFrameLatency )
+	{
+		return false;
+	}
+	unsigned int newLatency = std::min( 2 * m_FrameLatency, m_MaxFrameLatency );
+	if( !m_pBackend->Grow( 2 * m_MaxScopes * newLatency, newLatency ) )
+	{
+		return false;
+	}
+
+	assert( m_CurrentFrame == m_OldestPending );
+	std::rotate( m_pFrameQueries, m_pFrameQueries + m_OldestPending, m_pFrameQueries + m_FrameLatency );
+	std::rotate( m_pNumScopes, m_pNumScopes + m_OldestPending, m_pNumScopes + m_FrameLatency );
+	std::rotate( m_pbFramePending, m_pbFramePending + m_OldestPending, m_pbFramePending + m_FrameLatency );
+	std::rotate( m_pFrameNumbers, m_pFrameNumbers + m_OldestPending, m_pFrameNumbers + m_FrameLatency );
+	for( unsigned int frame = m_FrameLatency; frame < newLatency; ++frame )
+	{
+		m_pFrameQueries[ frame ] = frame;
+		m_pNumScopes[ frame ] = 0;
+		m_pbFramePending[ frame ] = false;
+	}
+	m_OldestPending = 0;
+	m_CurrentFrame = m_FrameLatency;
+	m_FrameLatency = newLatency;
+	return true;
+}
+
+//--------------------------------------------------------------------------------------
+// Resolve completed frames in the order they were issued, stopping at the first frame
+// which the GPU has not completed
+//--------------------------------------------------------------------------------------
+void GPUProfiler::ResolveFrames()
+{
+	while( m_pbFramePending[ m_OldestPending ] )
+	{
+		if( !ResolveFrame( m_OldestPending ) )
+		{
+			break;
+		}
+		m_pbFramePending[ m_OldestPending ] = false;
+		m_OldestPending = ( m_OldestPending + 1 ) % m_FrameLatency;
+	}
+}
+
+bool GPUProfiler::ResolveFrame( unsigned int frame )
+{
+	unsigned int firstScope = m_pFrameQueries[ frame ] * m_MaxScopes;
+	unsigned long long frequency;
+	bool bDisjoint;
+	if( !m_pBackend->GetFrameData( m_pFrameQueries[ frame ], &frequency, &bDisjoint ) )
+	{
+		return false;
+	}
+
+	// all timestamps should be complete once the frame query is, but if any are not the
+	// frame is left pending and the previous results are kept intact
+	unsigned int numScopes = m_pNumScopes[ frame ];
+	bool bValid = !bDisjoint && frequency > 0;
+	unsigned long long frameStart = 0;
+	unsigned long long frameEnd = 0;
+	for( unsigned int scopeIndex = 0; scopeIndex < numScopes; ++scopeIndex )
+	{
+		unsigned int timestamp = 2 * ( firstScope + scopeIndex );
+		unsigned long long start, end;
+		if( !m_pBackend->GetTimestamp( timestamp, &start ) || !m_pBackend->GetTimestamp( timestamp + 1, &end ) )
+		{
+			return false;
+		}
+		if( !bValid )
+		{
+			continue;
+		}
+		if( 0 == scopeIndex )
+		{
+			frameStart = start;
+		}
+		if( end > frameEnd )
+		{
+			frameEnd = end;
+		}
+
+		const Scope& scope = m_pScopes[ firstScope + scopeIndex ];
+		GPUProfileResult& result = m_pResolveResults[ scopeIndex ];
+		result.pName	= scope.pName;
+		result.parent	= scope.parent;
+		result.depth	= scope.depth;
+		result.time		= end > start ? (float)( (double)( end - start ) / (double)frequency ) : 0.0f;
+		result.start	= start > frameStart ? (float)( (double)( start - frameStart ) / (double)frequency ) : 0.0f;
+	}
+
+	m_LastLatency = m_FrameNumber - m_pFrameNumbers[ frame ];
+	if( m_LastLatency > m_MaxLatency )
+	{
+		m_MaxLatency = m_LastLatency;
+	}
+
+	if( !bValid )
+	{
+		++m_NumDisjointFrames;
+		return true;
+	}
+	memcpy( m_pResults, m_pResolveResults, numScopes * sizeof( GPUProfileResult ) );
+	m_NumResults = numScopes;
+	m_bNewResults = true;
+	m_ResultStartTicks = frameStart;
+	m_ResultEndTicks = frameEnd;
+	m_ResultFrequency = frequency;
+	AccumulateAverages();
+	return true;
+}
+
+//--------------------------------------------------------------------------------------
+// Averages by name
+//--------------------------------------------------------------------------------------
+void GPUProfiler::AccumulateAverages()
+{
+	for( unsigned int average = 0; average < m_NumAverages; ++average )
+	{
+		m_pFrameSums[ average ] = 0.0f;
+	}
+	for( unsigned int resultIndex = 0; resultIndex < m_NumResults; ++resultIndex )
+	{
+		const GPUProfileResult& result = m_pResults[ resultIndex ];
+		unsigned int average = FindAverage( result.pName );
+		if( INVALID_SCOPE == average )
+		{
+			if( m_NumAverages >= m_MaxScopes )
+			{
+				continue;
+			}
+			average = m_NumAverages++;
+			m_pAverageNames[ average ] = result.pName;
+			m_pAverageSums[ average ] = 0.0f;
+			m_pAverageTimes[ average ] = 0.0f;
+			m_pbAverageValid[ average ] = false;
+			m_pFrameSums[ average ] = 0.0f;
+			m_pStats[ average ].Reset();
+		}
+		m_pFrameSums[ average ] += result.time;
+	}
+
+	for( unsigned int average = 0; average < m_NumAverages; ++average )
+	{
+		m_pAverageSums[ average ] += m_pFrameSums[ average ];
+		m_pStats[ average ].AddSample( m_pFrameSums[ average ] );
+	}
+
+	if( ++m_NumAveragedFrames >= m_AverageCount )
+	{
+		for( unsigned int average = 0; average < m_NumAverages; ++average )
+		{
+			m_pAverageTimes[ average ] = m_pAverageSums[ average ] / (float)m_NumAveragedFrames;
+			m_pbAverageValid[ average ] = true;
+			m_pAverageSums[ average ] = 0.0f;
+		}
+		m_NumAveragedFrames = 0;
+		m_bUpdatedAverages = true;
+	}
+}
+
+unsigned int GPUProfiler::FindAverage( const char* pName ) const
+{
+	for( unsigned int average = 0; average < m_NumAverages; ++average )
+	{
+		if( m_pAverageNames[ average ] == pName || 0 == strcmp( m_pAverageNames[ average ], pName ) )
+		{
+			return average;
+		}
+	}
+	return INVALID_SCOPE;
+}
+
+bool GPUProfiler::GetAveragedTime( const char* pName, float* pTime ) const
+{
+	unsigned int average = FindAverage( pName );
+	if( INVALID_SCOPE == average || !m_pbAverageValid[ average ] )
+	{
+		*pTime = 0.0f;
+		return false;
+	}
+	*pTime = m_pAverageTimes[ average ];
+	return true;
+}
+
+const StreamingStats* GPUProfiler::GetStats( const char* pName ) const
+{
+	unsigned int average = FindAverage( pName );
+	return INVALID_SCOPE == average ? NULL : &m_pStats[ average ];
+}
+
+unsigned int GPUProfiler::FindResult( const char* pName ) const
+{
+	for( unsigned int resultIndex = 0; resultIndex < m_NumResults; ++resultIndex )
+	{
+		if( 0 == strcmp( m_pResults[ resultIndex ].pName, pName ) )
+		{
+			return resultIndex;
+		}
+	}
+	return INVALID_SCOPE;
+}
+
+//--------------------------------------------------------------------------------------
+// Active profiler for PROFILE_GPU_SCOPE
+//--------------------------------------------------------------------------------------
+void GPUProfiler::SetActive( GPUProfiler* pProfiler )
+{
+	s_pActive = pProfiler;
+}
+
+GPUProfiler* GPUProfiler::GetActive()
+{
+	return s_pActive;
+}
@@ -0,0 +1,293 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Note: like ResolutionController.h this file has no D3D or DXUT dependencies. The
+// queries are issued through IGPUQueryBackend, see GPUQueryBackendD3D11.h.
+
+#include "StreamingStats.h"
+
+//--------------------------------------------------------------------------------------
+// Counts from a pipeline statistics query, those of D3D11_QUERY_DATA_PIPELINE_STATISTICS
+// used for costing
+//--------------------------------------------------------------------------------------
+struct GPUPipelineCounts
+{
+	unsigned long long	vsInvocations;
+	unsigned long long	primitives;		// read by the input assembler
+	unsigned long long	psInvocations;
+};
+
+//--------------------------------------------------------------------------------------
+// Query interface used by GPUProfiler and GPUPipelineStats. Queries are identified by
+// index into pools created up front; each frame in flight also has a disjoint query
+// giving the timestamp frequency and whether the timestamps of that frame can be used.
+// Pipeline statistics queries are a separate pool with its own create and release.
+//--------------------------------------------------------------------------------------
+class IGPUQueryBackend
+{
+public:
+	virtual ~IGPUQueryBackend() {}
+
+	// Create numTimestamps timestamp queries and numFrames frame (disjoint) queries
+	virtual bool Create( unsigned int numTimestamps, unsigned int numFrames ) = 0;
+	virtual void Release() = 0;
+	// Add queries so the pool holds numTimestamps and numFrames, keeping the existing
+	// queries and any results they have in flight. On failure the pool is unchanged.
+	virtual bool Grow( unsigned int numTimestamps, unsigned int numFrames ) = 0;
+
+	virtual void BeginFrame( unsigned int frame ) = 0;
+	virtual void EndFrame( unsigned int frame ) = 0;
+	virtual void IssueTimestamp( unsigned int timestamp ) = 0;
+
+	// Results of an ended frame or timestamp, return false if not available yet
+	virtual bool GetFrameData( unsigned int frame, unsigned long long* pFrequency, bool* pbDisjoint ) = 0;
+	virtual bool GetTimestamp( unsigned int timestamp, unsigned long long* pTicks ) = 0;
+
+	// Pipeline statistics pool, grown like the timestamp pool. Queries are begun and
+	// ended around the work to count and return false until their result is available.
+	virtual bool CreatePipelineStats( unsigned int numQueries ) = 0;
+	virtual void ReleasePipelineStats() = 0;
+	virtual bool GrowPipelineStats( unsigned int numQueries ) = 0;
+	virtual void BeginPipelineStats( unsigned int query ) = 0;
+	virtual void EndPipelineStats( unsigned int query ) = 0;
+	virtual bool GetPipelineStats( unsigned int query, GPUPipelineCounts* pCounts ) = 0;
+};
+
+//--------------------------------------------------------------------------------------
+// Result of one scope in a resolved frame
+//--------------------------------------------------------------------------------------
+struct GPUProfileResult
+{
+	const char*		pName;
+	unsigned int	parent;		// index of the enclosing scope, GPUProfiler::INVALID_SCOPE for a root
+	unsigned int	depth;		// 0 for a root
+	float			time;		// seconds
+	float			start;		// seconds from the start of the frame's first scope
+};
+
+//--------------------------------------------------------------------------------------
+// Hierarchical GPU profiler. Scopes are opened and closed within BeginFrame() / EndFrame()
+// and may nest. Each scope takes two timestamps from one shared query pool, which holds
+// maxScopes scopes for each of frameLatency frames in flight. Completed frames are
+// resolved at the next BeginFrame() without waiting for the GPU, and the latest resolved
+// frame is available as a tree of results in the order the scopes were opened, so a
+// scope's children follow it. If every frame is still in flight when a new one begins
+// the pool doubles, up to maxFrameLatency frames, and once it can grow no further that
+// frame is not profiled.
+//
+// Times are also averaged by scope name over averageCount resolved frames, for
+// displaying and for inputs which should not change every frame. Scope names must
+// remain valid for the lifetime of the profiler, e.g. string literals.
+//--------------------------------------------------------------------------------------
+class GPUProfiler
+{
+public:
+	enum { INVALID_SCOPE = 0xffffffff };
+
+	GPUProfiler( unsigned int maxScopes = 32, unsigned int frameLatency = 4, unsigned int averageCount = 10, unsigned int maxFrameLatency = 16 );
+	~GPUProfiler();
+
+	// Create the query pool through pBackend, which must outlive the profiler's use of it
+	bool Create( IGPUQueryBackend* pBackend );
+	void Release();
+
+	// Resolves any completed frames, then starts a new one
+	void BeginFrame();
+	void EndFrame();
+
+	void BeginScope( const char* pName );
+	void EndScope();
+
+	// Latest resolved frame
+	bool HaveResults() const
+	{
+		return m_NumResults > 0;
+	}
+	// True if the last BeginFrame() resolved a frame, which GetLastLatency() frames ago
+	bool HaveNewResults() const
+	{
+		return m_bNewResults;
+	}
+	unsigned int GetNumResults() const
+	{
+		return m_NumResults;
+	}
+	const GPUProfileResult& GetResult( unsigned int index ) const
+	{
+		return m_pResults[ index ];
+	}
+	// Index of the first result with the given name, INVALID_SCOPE if there is none
+	unsigned int FindResult( const char* pName ) const;
+	// Raw GPU timestamps of the first scope's start and the latest scope end of the latest
+	// resolved frame, for placing it on the CPU timeline with GPUClockCalibration
+	unsigned long long GetResultStartTicks() const
+	{
+		return m_ResultStartTicks;
+	}
+	unsigned long long GetResultEndTicks() const
+	{
+		return m_ResultEndTicks;
+	}
+	unsigned long long GetResultFrequency() const
+	{
+		return m_ResultFrequency;
+	}
+
+	// True if the averages were updated by the last BeginFrame()
+	bool HaveUpdatedAverages() const
+	{
+		return m_bUpdatedAverages;
+	}
+	// Average time per frame of the named scopes, summed if a name is used more than once
+	// a frame. Returns false, and a time of 0, until an average including the name has
+	// been published, so no data can be told apart from a fast scope.
+	bool GetAveragedTime( const char* pName, float* pTime ) const;
+
+	// Streaming statistics of the per frame time of the named scopes, updated every
+	// resolved frame. NULL if the name has not been seen.
+	const StreamingStats* GetStats( const char* pName ) const;
+
+	// Frames in flight the query pool currently holds
+	unsigned int GetFrameLatency() const
+	{
+		return m_FrameLatency;
+	}
+	// Frames not profiled as every slot was still in flight, or discarded as disjoint
+	unsigned int GetNumDroppedFrames() const
+	{
+		return m_NumDroppedFrames;
+	}
+	unsigned int GetNumDisjointFrames() const
+	{
+		return m_NumDisjointFrames;
+	}
+	// Frames between a frame ending and its results being resolved, for the last
+	// resolved frame and the worst so far
+	unsigned int GetLastLatency() const
+	{
+		return m_LastLatency;
+	}
+	unsigned int GetMaxLatency() const
+	{
+		return m_MaxLatency;
+	}
+
+	// Profiler used by PROFILE_GPU_SCOPE, may be NULL
+	static void SetActive( GPUProfiler* pProfiler );
+	static GPUProfiler* GetActive();
+
+private:
+	struct Scope
+	{
+		const char*		pName;
+		unsigned int	parent;
+		unsigned int	depth;
+	};
+
+	void ResolveFrames();
+	bool ResolveFrame( unsigned int frame );
+	bool Grow();
+	void AccumulateAverages();
+	unsigned int FindAverage( const char* pName ) const;
+
+	IGPUQueryBackend*	m_pBackend;
+	unsigned int		m_MaxScopes;
+	unsigned int		m_FrameLatency;
+	unsigned int		m_MaxFrameLatency;
+	unsigned int		m_AverageCount;
+
+	// per frame slot, sized for m_MaxFrameLatency with the first m_FrameLatency in use.
+	// Slot n uses backend frame m_pFrameQueries[n], whose scopes and timestamps start at
+	// m_pFrameQueries[n] * m_MaxScopes, so slots can be reordered when the pool grows.
+	Scope*				m_pScopes;
+	unsigned int*		m_pFrameQueries;
+	unsigned int*		m_pNumScopes;
+	bool*				m_pbFramePending;
+	unsigned int*		m_pFrameNumbers;	// m_FrameNumber when each frame slot ended
+	unsigned int		m_FrameNumber;		// frames begun, including dropped frames
+	unsigned int		m_CurrentFrame;		// frame slot being recorded
+	unsigned int		m_OldestPending;	// oldest frame slot awaiting resolve
+	bool				m_bFrameOpen;
+
+	// scopes opened but not closed, INVALID_SCOPE for scopes which did not fit
+	unsigned int*		m_pScopeStack;
+	unsigned int		m_StackDepth;
+
+	GPUProfileResult*	m_pResults;
+	GPUProfileResult*	m_pResolveResults;	// frame being resolved, copied to m_pResults once complete
+	unsigned int		m_NumResults;
+	bool				m_bNewResults;
+	unsigned long long	m_ResultStartTicks;
+	unsigned long long	m_ResultEndTicks;
+	unsigned long long	m_ResultFrequency;
+
+	// averages by name
+	const char**		m_pAverageNames;
+	float*				m_pAverageSums;
+	float*				m_pAverageTimes;
+	bool*				m_pbAverageValid;
+	float*				m_pFrameSums;
+	StreamingStats*		m_pStats;
+	unsigned int		m_NumAverages;
+	unsigned int		m_NumAveragedFrames;
+	bool				m_bUpdatedAverages;
+
+	unsigned int		m_NumDroppedFrames;
+	unsigned int		m_NumDisjointFrames;
+	unsigned int		m_LastLatency;
+	unsigned int		m_MaxLatency;
+
+	static GPUProfiler*	s_pActive;
+
+	//prevent assign and copy
+	GPUProfiler( const GPUProfiler& rhs );
+	GPUProfiler& operator=( const GPUProfiler& rhs );
+};
+
+//--------------------------------------------------------------------------------------
+// Scope marker for the active profiler, closes the scope when it goes out of scope
+//--------------------------------------------------------------------------------------
+class GPUProfileScope
+{
+public:
+	GPUProfileScope( GPUProfiler* pProfiler, const char* pName )
+		: m_pProfiler( pProfiler )
+	{
+		if( m_pProfiler )
+		{
+			m_pProfiler->BeginScope( pName );
+		}
+	}
+	~GPUProfileScope()
+	{
+		if( m_pProfiler )
+		{
+			m_pProfiler->EndScope();
+		}
+	}
+
+private:
+	GPUProfiler*	m_pProfiler;
+
+	//prevent assign and copy
+	GPUProfileScope( const GPUProfileScope& rhs );
+	GPUProfileScope& operator=( const GPUProfileScope& rhs );
+};
+
+#define PROFILE_GPU_SCOPE_JOIN2( a, b )	a##b
+#define PROFILE_GPU_SCOPE_JOIN( a, b )	PROFILE_GPU_SCOPE_JOIN2( a, b )
+#define PROFILE_GPU_SCOPE( name )		GPUProfileScope PROFILE_GPU_SCOPE_JOIN( gpuProfileScope, __LINE__ )( GPUProfiler::GetActive(), name )
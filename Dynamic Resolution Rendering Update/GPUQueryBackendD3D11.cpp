@@ -0,0 +1,384 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "GPUQueryBackendD3D11.h"
+#include "GPUClockCalibration.h"
+
+namespace
+{
+	// Longest SampleClocks() waits on the GPU before giving up, in seconds
+	const double cMaxClockSampleWait = 0.1;
+}
+
+//--------------------------------------------------------------------------------------
+// Ctor
+//--------------------------------------------------------------------------------------
+GPUQueryBackendD3D11::GPUQueryBackendD3D11()
+	: m_pD3DDevice( NULL )
+	, m_pImmediateContext( NULL )
+	, m_pTimestampQueries( NULL )
+	, m_pFrameQueries( NULL )
+	, m_pClockIdleQuery( NULL )
+	, m_pClockTimestampQuery( NULL )
+	, m_pClockDisjointQuery( NULL )
+	, m_pPipelineStatsQueries( NULL )
+	, m_NumTimestamps( 0 )
+	, m_NumFrames( 0 )
+	, m_NumPipelineStats( 0 )
+{
+}
+
+//--------------------------------------------------------------------------------------
+// Dtor
+//--------------------------------------------------------------------------------------
+GPUQueryBackendD3D11::~GPUQueryBackendD3D11()
+{
+	Release();
+	ReleasePipelineStats();
+}
+
+void GPUQueryBackendD3D11::OnD3D11CreateDevice( ID3D11Device* pD3DDevice, ID3D11DeviceContext* pImmediateContext )
+{
+	m_pD3DDevice = pD3DDevice;
+	m_pImmediateContext = pImmediateContext;
+}
+
+//--------------------------------------------------------------------------------------
+// Query pool creation and deletion
+//--------------------------------------------------------------------------------------
+bool GPUQueryBackendD3D11::Create( unsigned int numTimestamps, unsigned int numFrames )
+{
+	Release();
+	if( !m_pD3DDevice )
+	{
+		return false;
+	}
+
+	m_NumTimestamps = numTimestamps;
+	m_NumFrames = numFrames;
+	m_pTimestampQueries = new ID3D11Query*[ m_NumTimestamps ];
+	m_pFrameQueries = new ID3D11Query*[ m_NumFrames ];
+	memset( m_pTimestampQueries, 0, m_NumTimestamps * sizeof( ID3D11Query* ) );
+	memset( m_pFrameQueries, 0, m_NumFrames * sizeof( ID3D11Query* ) );
+
+	D3D11_QUERY_DESC timerQueryDesc;
+	timerQueryDesc.Query = D3D11_QUERY_TIMESTAMP;
+	timerQueryDesc.MiscFlags = 0;
+	D3D11_QUERY_DESC freqQueryDesc;
+	freqQueryDesc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+	freqQueryDesc.MiscFlags = 0;
+
+	HRESULT hr = S_OK;
+	for( unsigned int i = 0; i < m_NumTimestamps && SUCCEEDED( hr ); ++i )
+	{
+		V( m_pD3DDevice->CreateQuery( &timerQueryDesc, &m_pTimestampQueries[i] ) );
+	}
+	for( unsigned int i = 0; i < m_NumFrames && SUCCEEDED( hr ); ++i )
+	{
+		V( m_pD3DDevice->CreateQuery( &freqQueryDesc, &m_pFrameQueries[i] ) );
+	}
+
+	D3D11_QUERY_DESC eventQueryDesc;
+	eventQueryDesc.Query = D3D11_QUERY_EVENT;
+	eventQueryDesc.MiscFlags = 0;
+	if( SUCCEEDED( hr ) )
+	{
+		V( m_pD3DDevice->CreateQuery( &eventQueryDesc, &m_pClockIdleQuery ) );
+	}
+	if( SUCCEEDED( hr ) )
+	{
+		V( m_pD3DDevice->CreateQuery( &timerQueryDesc, &m_pClockTimestampQuery ) );
+	}
+	if( SUCCEEDED( hr ) )
+	{
+		V( m_pD3DDevice->CreateQuery( &freqQueryDesc, &m_pClockDisjointQuery ) );
+	}
+	return SUCCEEDED( hr );
+}
+
+void GPUQueryBackendD3D11::Release()
+{
+	for( unsigned int i = 0; i < m_NumTimestamps; ++i )
+	{
+		SAFE_RELEASE( m_pTimestampQueries[i] );
+	}
+	for( unsigned int i = 0; i < m_NumFrames; ++i )
+	{
+		SAFE_RELEASE( m_pFrameQueries[i] );
+	}
+	SAFE_DELETE_ARRAY( m_pTimestampQueries );
+	SAFE_DELETE_ARRAY( m_pFrameQueries );
+	SAFE_RELEASE( m_pClockIdleQuery );
+	SAFE_RELEASE( m_pClockTimestampQuery );
+	SAFE_RELEASE( m_pClockDisjointQuery );
+	m_NumTimestamps = 0;
+	m_NumFrames = 0;
+}
+
+//--------------------------------------------------------------------------------------
+// Pool growth. The existing queries move to the new arrays unchanged, so results still
+// in flight are read as before, and the new queries are released again on failure.
+//--------------------------------------------------------------------------------------
+bool GPUQueryBackendD3D11::Grow( unsigned int numTimestamps, unsigned int numFrames )
+{
+	if( !m_pD3DDevice || numTimestamps < m_NumTimestamps || numFrames < m_NumFrames )
+	{
+		return false;
+	}
+
+	ID3D11Query** pTimestampQueries = new ID3D11Query*[ numTimestamps ];
+	ID3D11Query** pFrameQueries = new ID3D11Query*[ numFrames ];
+	memset( pTimestampQueries, 0, numTimestamps * sizeof( ID3D11Query* ) );
+	memset( pFrameQueries, 0, numFrames * sizeof( ID3D11Query* ) );
+
+	D3D11_QUERY_DESC timerQueryDesc;
+	timerQueryDesc.Query = D3D11_QUERY_TIMESTAMP;
+	timerQueryDesc.MiscFlags = 0;
+	D3D11_QUERY_DESC freqQueryDesc;
+	freqQueryDesc.Query = D3D11_QUERY_TIMESTAMP_DISJOINT;
+	freqQueryDesc.MiscFlags = 0;
+
+	HRESULT hr = S_OK;
+	for( unsigned int i = m_NumTimestamps; i < numTimestamps && SUCCEEDED( hr ); ++i )
+	{
+		V( m_pD3DDevice->CreateQuery( &timerQueryDesc, &pTimestampQueries[i] ) );
+	}
+	for( unsigned int i = m_NumFrames; i < numFrames && SUCCEEDED( hr ); ++i )
+	{
+		V( m_pD3DDevice->CreateQuery( &freqQueryDesc, &pFrameQueries[i] ) );
+	}
+	if( FAILED( hr ) )
+	{
+		for( unsigned int i = m_NumTimestamps; i < numTimestamps; ++i )
+		{
+			SAFE_RELEASE( pTimestampQueries[i] );
+		}
+		for( unsigned int i = m_NumFrames; i < numFrames; ++i )
+		{
+			SAFE_RELEASE( pFrameQueries[i] );
+		}
+		delete[] pTimestampQueries;
+		delete[] pFrameQueries;
+		return false;
+	}
+
+	if( m_NumTimestamps )
+	{
+		memcpy( pTimestampQueries, m_pTimestampQueries, m_NumTimestamps * sizeof( ID3D11Query* ) );
+	}
+	if( m_NumFrames )
+	{
+		memcpy( pFrameQueries, m_pFrameQueries, m_NumFrames * sizeof( ID3D11Query* ) );
+	}
+	SAFE_DELETE_ARRAY( m_pTimestampQueries );
+	SAFE_DELETE_ARRAY( m_pFrameQueries );
+	m_pTimestampQueries = pTimestampQueries;
+	m_pFrameQueries = pFrameQueries;
+	m_NumTimestamps = numTimestamps;
+	m_NumFrames = numFrames;
+	return true;
+}
+
+//--------------------------------------------------------------------------------------
+// Issue queries. The disjoint query brackets all the frame's timestamps, so they are
+// complete once it is.
+//--------------------------------------------------------------------------------------
+void GPUQueryBackendD3D11::BeginFrame( unsigned int frame )
+{
+	m_pImmediateContext->Begin( m_pFrameQueries[ frame ] );
+}
+
+void GPUQueryBackendD3D11::EndFrame( unsigned int frame )
+{
+	m_pImmediateContext->End( m_pFrameQueries[ frame ] );
+}
+
+void GPUQueryBackendD3D11::IssueTimestamp( unsigned int timestamp )
+{
+	// timestamp queries issued and ended immediatly
+	m_pImmediateContext->End( m_pTimestampQueries[ timestamp ] );
+}
+
+//--------------------------------------------------------------------------------------
+// Read results
+//--------------------------------------------------------------------------------------
+bool GPUQueryBackendD3D11::GetFrameData( unsigned int frame, unsigned long long* pFrequency, bool* pbDisjoint )
+{
+	D3D11_QUERY_DATA_TIMESTAMP_DISJOINT queryDataTSD;
+	HRESULT hr = m_pImmediateContext->GetData( m_pFrameQueries[ frame ], &queryDataTSD, sizeof( D3D11_QUERY_DATA_TIMESTAMP_DISJOINT ), D3D11_ASYNC_GETDATA_DONOTFLUSH );
+	if( hr != S_OK ) { return false; }
+
+	*pFrequency = queryDataTSD.Frequency;
+	*pbDisjoint = queryDataTSD.Disjoint ? true : false;
+	return true;
+}
+
+bool GPUQueryBackendD3D11::GetTimestamp( unsigned int timestamp, unsigned long long* pTicks )
+{
+	UINT64 queryData;
+	HRESULT hr = m_pImmediateContext->GetData( m_pTimestampQueries[ timestamp ], &queryData, sizeof( UINT64 ), D3D11_ASYNC_GETDATA_DONOTFLUSH );
+	if( hr != S_OK ) { return false; }
+
+	*pTicks = queryData;
+	return true;
+}
+
+//--------------------------------------------------------------------------------------
+// Pipeline statistics pool, created, grown and read as the timestamp pool is
+//--------------------------------------------------------------------------------------
+bool GPUQueryBackendD3D11::CreatePipelineStats( unsigned int numQueries )
+{
+	ReleasePipelineStats();
+	if( !m_pD3DDevice )
+	{
+		return false;
+	}
+	return GrowPipelineStats( numQueries );
+}
+
+void GPUQueryBackendD3D11::ReleasePipelineStats()
+{
+	for( unsigned int i = 0; i < m_NumPipelineStats; ++i )
+	{
+		SAFE_RELEASE( m_pPipelineStatsQueries[i] );
+	}
+	SAFE_DELETE_ARRAY( m_pPipelineStatsQueries );
+	m_NumPipelineStats = 0;
+}
+
+bool GPUQueryBackendD3D11::GrowPipelineStats( unsigned int numQueries )
+{
+	if( !m_pD3DDevice || numQueries < m_NumPipelineStats )
+	{
+		return false;
+	}
+
+	ID3D11Query** pQueries = new ID3D11Query*[ numQueries ];
+	memset( pQueries, 0, numQueries * sizeof( ID3D11Query* ) );
+
+	D3D11_QUERY_DESC statsQueryDesc;
+	statsQueryDesc.Query = D3D11_QUERY_PIPELINE_STATISTICS;
+	statsQueryDesc.MiscFlags = 0;
+
+	HRESULT hr = S_OK;
+	for( unsigned int i = m_NumPipelineStats; i < numQueries && SUCCEEDED( hr ); ++i )
+	{
+		V( m_pD3DDevice->CreateQuery( &statsQueryDesc, &pQueries[i] ) );
+	}
+	if( FAILED( hr ) )
+	{
+		for( unsigned int i = m_NumPipelineStats; i < numQueries; ++i )
+		{
+			SAFE_RELEASE( pQueries[i] );
+		}
+		delete[] pQueries;
+		return false;
+	}
+
+	if( m_NumPipelineStats )
+	{
+		memcpy( pQueries, m_pPipelineStatsQueries, m_NumPipelineStats * sizeof( ID3D11Query* ) );
+	}
+	SAFE_DELETE_ARRAY( m_pPipelineStatsQueries );
+	m_pPipelineStatsQueries = pQueries;
+	m_NumPipelineStats = numQueries;
+	return true;
+}
+
+void GPUQueryBackendD3D11::BeginPipelineStats( unsigned int query )
+{
+	m_pImmediateContext->Begin( m_pPipelineStatsQueries[ query ] );
+}
+
+void GPUQueryBackendD3D11::EndPipelineStats( unsigned int query )
+{
+	m_pImmediateContext->End( m_pPipelineStatsQueries[ query ] );
+}
+
+bool GPUQueryBackendD3D11::GetPipelineStats( unsigned int query, GPUPipelineCounts* pCounts )
+{
+	D3D11_QUERY_DATA_PIPELINE_STATISTICS queryData;
+	HRESULT hr = m_pImmediateContext->GetData( m_pPipelineStatsQueries[ query ], &queryData, sizeof( D3D11_QUERY_DATA_PIPELINE_STATISTICS ), D3D11_ASYNC_GETDATA_DONOTFLUSH );
+	if( hr != S_OK ) { return false; }
+
+	pCounts->vsInvocations	= queryData.VSInvocations;
+	pCounts->primitives		= queryData.IAPrimitives;
+	pCounts->psInvocations	= queryData.PSInvocations;
+	return true;
+}
+
+//--------------------------------------------------------------------------------------
+// Clock calibration sample. Once the GPU is idle, a timestamp submitted with a flush is
+// taken almost as soon as it is issued, so the CPU times either side bound it tightly.
+// The waits use GetData() without D3D11_ASYNC_GETDATA_DONOTFLUSH so the queries are
+// submitted, and give up after cMaxClockSampleWait rather than hang on a lost device.
+//--------------------------------------------------------------------------------------
+bool GPUQueryBackendD3D11::SampleClocks( GPUClockCalibration* pCalibration )
+{
+	if( !m_pClockIdleQuery || !m_pClockTimestampQuery || !m_pClockDisjointQuery )
+	{
+		return false;
+	}
+	CDXUTTimer* pTimer = DXUTGetGlobalTimer();
+
+	m_pImmediateContext->End( m_pClockIdleQuery );
+	double waitStart = pTimer->GetAbsoluteTime();
+	while( S_FALSE == m_pImmediateContext->GetData( m_pClockIdleQuery, NULL, 0, 0 ) )
+	{
+		if( pTimer->GetAbsoluteTime() - waitStart > cMaxClockSampleWait )
+		{
+			return false;
+		}
+	}
+
+	m_pImmediateContext->Begin( m_pClockDisjointQuery );
+	double cpuBefore = pTimer->GetAbsoluteTime();
+	m_pImmediateContext->End( m_pClockTimestampQuery );
+	m_pImmediateContext->Flush();
+	UINT64 gpuTicks;
+	HRESULT hr;
+	while( S_FALSE == ( hr = m_pImmediateContext->GetData( m_pClockTimestampQuery, &gpuTicks, sizeof( UINT64 ), 0 ) ) )
+	{
+		if( pTimer->GetAbsoluteTime() - cpuBefore > cMaxClockSampleWait )
+		{
+			break;
+		}
+	}
+	double cpuAfter = pTimer->GetAbsoluteTime();
+	m_pImmediateContext->End( m_pClockDisjointQuery );
+	if( S_OK != hr )
+	{
+		return false;
+	}
+
+	// the disjoint query completes straight after the timestamp
+	D3D11_QUERY_DATA_TIMESTAMP_DISJOINT queryDataTSD;
+	while( S_FALSE == ( hr = m_pImmediateContext->GetData( m_pClockDisjointQuery, &queryDataTSD, sizeof( D3D11_QUERY_DATA_TIMESTAMP_DISJOINT ), 0 ) ) )
+	{
+		if( pTimer->GetAbsoluteTime() - cpuAfter > cMaxClockSampleWait )
+		{
+			return false;
+		}
+	}
+	if( S_OK != hr || queryDataTSD.Disjoint )
+	{
+		// the GPU clock may have been reset, so earlier samples no longer apply
+		pCalibration->Reset();
+		return false;
+	}
+
+	pCalibration->AddSample( cpuBefore, cpuAfter, gpuTicks, queryDataTSD.Frequency );
+	return true;
+}
@@ -0,0 +1,78 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "DXUT.h"
+#include "GPUProfiler.h"
+
+class GPUClockCalibration;
+
+//--------------------------------------------------------------------------------------
+// D3D11 queries for GPUProfiler and GPUPipelineStats. Frame queries are
+// D3D11_QUERY_TIMESTAMP_DISJOINT and results are read with D3D11_ASYNC_GETDATA_DONOTFLUSH
+// so the CPU never waits. A GPUProfiler and a GPUPipelineStats can share one backend, but
+// each GPUPipelineStats needs its own as it owns the pipeline statistics pool.
+//--------------------------------------------------------------------------------------
+class GPUQueryBackendD3D11 : public IGPUQueryBackend
+{
+public:
+	GPUQueryBackendD3D11();
+	~GPUQueryBackendD3D11();
+
+	// Must be called before GPUProfiler::Create()
+	void OnD3D11CreateDevice( ID3D11Device* pD3DDevice, ID3D11DeviceContext* pImmediateContext );
+
+	virtual bool Create( unsigned int numTimestamps, unsigned int numFrames );
+	virtual void Release();
+	virtual bool Grow( unsigned int numTimestamps, unsigned int numFrames );
+
+	virtual void BeginFrame( unsigned int frame );
+	virtual void EndFrame( unsigned int frame );
+	virtual void IssueTimestamp( unsigned int timestamp );
+
+	virtual bool GetFrameData( unsigned int frame, unsigned long long* pFrequency, bool* pbDisjoint );
+	virtual bool GetTimestamp( unsigned int timestamp, unsigned long long* pTicks );
+
+	virtual bool CreatePipelineStats( unsigned int numQueries );
+	virtual void ReleasePipelineStats();
+	virtual bool GrowPipelineStats( unsigned int numQueries );
+	virtual void BeginPipelineStats( unsigned int query );
+	virtual void EndPipelineStats( unsigned int query );
+	virtual bool GetPipelineStats( unsigned int query, GPUPipelineCounts* pCounts );
+
+	// Pairs a GPU timestamp with the DXUT timer either side of it and adds it to
+	// pCalibration. The GPU is allowed to go idle first so the timestamp is taken as soon
+	// as it is submitted, which stalls for the frames queued, so call this occasionally
+	// and outside a GPUProfiler frame. Returns false if no sample was taken.
+	bool SampleClocks( GPUClockCalibration* pCalibration );
+
+private:
+	ID3D11Device*			m_pD3DDevice;
+	ID3D11DeviceContext*	m_pImmediateContext;
+	ID3D11Query**			m_pTimestampQueries;
+	ID3D11Query**			m_pFrameQueries;
+	ID3D11Query*			m_pClockIdleQuery;
+	ID3D11Query*			m_pClockTimestampQuery;
+	ID3D11Query*			m_pClockDisjointQuery;
+	ID3D11Query**			m_pPipelineStatsQueries;
+	unsigned int			m_NumTimestamps;
+	unsigned int			m_NumFrames;
+	unsigned int			m_NumPipelineStats;
+
+	//prevent assign and copy
+	GPUQueryBackendD3D11( const GPUQueryBackendD3D11& rhs );
+	GPUQueryBackendD3D11& operator=( const GPUQueryBackendD3D11& rhs );
+};
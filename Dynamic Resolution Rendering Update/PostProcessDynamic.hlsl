@@ -49,6 +49,14 @@ cbuffer cbPSResolveNoise : register( b0 )
 	float4	g_NoiseScale	: packoffset( c1 );		// float4( width, height, Not used, Not used )
 };
 
+cbuffer cbPSReduceVelocity : register( b0 )
+{
+	float4	g_ReduceCellSize	: packoffset( c0 );	// float4( ratio_x/reduced width, ratio_y/reduced height, back buffer width, back buffer height )
+};
+
+// must match VelocityReduceConsts::cSamplesPerAxis in VelocityStats.h
+#define REDUCE_VELOCITY_SAMPLES 4
+
 Texture2D    g_txColor				: register( t0 );
 Texture2D    g_txVelocity			: register( t1 );
 Texture1D    g_txCubicLookupFilter	: register( t1 );
@@ -129,6 +137,39 @@ float4 PSMotionBlur(PSPostProcessIn input) : SV_TARGET
 	
 }
 
+//-----------------------------------------------------------------------------------------
+// PixelShader for velocity reduction, see ReduceVelocity() in VelocityStats.cpp for the
+// CPU reference. Each output texel takes a regular grid of velocity samples over its
+// share of the dynamic viewport and outputs
+// float4( mean |x|, mean |y|, mean speed, max speed ) in back buffer pixels.
+// Load() is used so samples are exact texels whatever the viewport to output ratio.
+//-----------------------------------------------------------------------------------------
+float4 PSReduceVelocity(PSPostProcessIn input) : SV_TARGET
+{
+	float2 velocitySize;
+	g_txVelocity.GetDimensions( velocitySize.x, velocitySize.y );
+
+	float2 cellStart = floor( input.Pos.xy ) * g_ReduceCellSize.xy;
+	float2 sampleStep = g_ReduceCellSize.xy / REDUCE_VELOCITY_SAMPLES;
+
+	float4 result = float4( 0.0f, 0.0f, 0.0f, 0.0f );
+	[unroll] for( uint y = 0; y < REDUCE_VELOCITY_SAMPLES; ++y )
+	{
+		[unroll] for( uint x = 0; x < REDUCE_VELOCITY_SAMPLES; ++x )
+		{
+			float2 samplePos = cellStart + ( float2( x, y ) + 0.5f ) * sampleStep;
+			int2 texel = min( int2( samplePos * velocitySize ), int2( velocitySize ) - 1 );
+			float2 velocity = g_txVelocity.Load( int3( texel, 0 ) ).xy * g_ReduceCellSize.zw;
+			float speed = length( velocity );
+			result.xy += abs( velocity );
+			result.z += speed;
+			result.w = max( result.w, speed );
+		}
+	}
+	result.xyz /= REDUCE_VELOCITY_SAMPLES * REDUCE_VELOCITY_SAMPLES;
+	return result;
+}
+
 //-----------------------------------------------------------------------------------------
 // PixelShader for resolve (point and bilinear)
 //-----------------------------------------------------------------------------------------
@@ -0,0 +1,126 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "RenderTargetBudget.h"
+
+//--------------------------------------------------------------------------------------
+// Set up an empty budget
+//--------------------------------------------------------------------------------------
+RenderTargetBudget::RenderTargetBudget()
+	: m_BudgetBytes( 0 )
+	, m_NumTargets( 0 )
+	, m_DownsampleBytesPerPixel( 0 )
+	, m_NumDownsampleChains( 0 )
+{
+}
+
+void RenderTargetBudget::Reset( unsigned long long budgetBytes )
+{
+	m_BudgetBytes = budgetBytes;
+	m_NumTargets = 0;
+	m_NumDownsampleChains = 0;
+}
+
+void RenderTargetBudget::SetDownsampleChains( unsigned int bytesPerPixel, unsigned int numChains )
+{
+	m_DownsampleBytesPerPixel = bytesPerPixel;
+	m_NumDownsampleChains = numChains;
+}
+
+bool RenderTargetBudget::AddTarget( const char* pName, unsigned int bytesPerPixel )
+{
+	if( m_NumTargets >= MAX_TARGETS || !bytesPerPixel )
+	{
+		return false;
+	}
+	m_pTargetNames[ m_NumTargets ] = pName;
+	m_TargetBytesPerPixel[ m_NumTargets ] = bytesPerPixel;
+	++m_NumTargets;
+	return true;
+}
+
+//--------------------------------------------------------------------------------------
+// Try each scaling from the largest down, the first one which fits is the largest
+//--------------------------------------------------------------------------------------
+void RenderTargetBudget::Calculate( unsigned int backBufferWidth, unsigned int backBufferHeight, unsigned int maxWidth, unsigned int maxHeight,
+									unsigned int maxScaling, RenderTargetBudgetResult* pResult ) const
+{
+	// Largest multiple of the back buffer allowed on each axis, as in InitializeResolutionParameters
+	unsigned int maxScaleWidth = backBufferWidth ? maxWidth / backBufferWidth : 1;
+	unsigned int maxScaleHeight = backBufferHeight ? maxHeight / backBufferHeight : 1;
+	maxScaleWidth = maxScaleWidth > 1 ? maxScaleWidth : 1;
+	maxScaleHeight = maxScaleHeight > 1 ? maxScaleHeight : 1;
+
+	unsigned long long bytesPerPixel = GetBytesPerPixel();
+	unsigned int scaling = maxScaling > 1 ? maxScaling : 1;
+	for( ; ; --scaling )
+	{
+		unsigned int scaleWidth = scaling < maxScaleWidth ? scaling : maxScaleWidth;
+		unsigned int scaleHeight = scaling < maxScaleHeight ? scaling : maxScaleHeight;
+		pResult->width = scaleWidth * backBufferWidth;
+		pResult->height = scaleHeight * backBufferHeight;
+		pResult->maxScaling = scaling;
+		pResult->totalBytes = bytesPerPixel * pResult->width * pResult->height +
+							  GetDownsampleBytes( pResult->width, pResult->height, backBufferWidth, backBufferHeight );
+		pResult->bWithinBudget = pResult->totalBytes <= m_BudgetBytes;
+		if( pResult->bWithinBudget || scaling == 1 )
+		{
+			break;
+		}
+	}
+}
+
+unsigned int RenderTargetBudget::GetBytesPerPixel() const
+{
+	unsigned int bytesPerPixel = 0;
+	for( unsigned int target = 0; target < m_NumTargets; ++target )
+	{
+		bytesPerPixel += m_TargetBytesPerPixel[ target ];
+	}
+	return bytesPerPixel;
+}
+
+unsigned long long RenderTargetBudget::GetTargetBytes( unsigned int target, unsigned int width, unsigned int height ) const
+{
+	return (unsigned long long)m_TargetBytesPerPixel[ target ] * width * height;
+}
+
+unsigned long long RenderTargetBudget::GetDownsampleBytes( unsigned int width, unsigned int height, unsigned int backBufferWidth, unsigned int backBufferHeight ) const
+{
+	unsigned long long chainBytes = 0;
+	unsigned int numLevels = CalculateDownsampleSteps( width, height, backBufferWidth, backBufferHeight );
+	for( unsigned int level = 1; level <= numLevels; ++level )
+	{
+		chainBytes += (unsigned long long)m_DownsampleBytesPerPixel * ( width >> level ) * ( height >> level );
+	}
+	return chainBytes * m_NumDownsampleChains;
+}
+
+//--------------------------------------------------------------------------------------
+// Halve while the image is over 2x the back buffer on either axis. Both axes are halved
+// together, so stop if that would take either below the back buffer size.
+//--------------------------------------------------------------------------------------
+unsigned int RenderTargetBudget::CalculateDownsampleSteps( unsigned int width, unsigned int height, unsigned int backBufferWidth, unsigned int backBufferHeight )
+{
+	unsigned int steps = 0;
+	while( ( width > 2 * backBufferWidth || height > 2 * backBufferHeight ) &&
+		   width >= 2 * backBufferWidth && height >= 2 * backBufferHeight )
+	{
+		width /= 2;
+		height /= 2;
+		++steps;
+	}
+	return steps;
+}
@@ -0,0 +1,101 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Note: like ResolutionController.h this file has no D3D or DXUT dependencies, targets
+// are described by their size in bytes per pixel rather than their format.
+
+//--------------------------------------------------------------------------------------
+// Result of RenderTargetBudget::Calculate()
+//--------------------------------------------------------------------------------------
+struct RenderTargetBudgetResult
+{
+	unsigned int		width;			// largest dynamic buffer dimensions within the budget
+	unsigned int		height;
+	unsigned int		maxScaling;		// scaling which gives these dimensions
+	unsigned long long	totalBytes;		// memory used by all targets at width x height, including downsample chains
+	bool				bWithinBudget;	// false if even back buffer sized targets exceed the budget
+};
+
+//--------------------------------------------------------------------------------------
+// Memory budget for the dynamic render targets. The application adds each dynamic
+// target and its bytes per pixel, and Calculate() finds the largest dynamic buffer for which
+// all of them fit in the budget. Per target sizes are available for reporting.
+//--------------------------------------------------------------------------------------
+class RenderTargetBudget
+{
+public:
+	enum { MAX_TARGETS = 16 };
+
+	RenderTargetBudget();
+
+	// Remove all targets and set the budget in bytes
+	void Reset( unsigned long long budgetBytes );
+
+	// Returns false if there are already MAX_TARGETS or bytesPerPixel is 0. Drivers may
+	// pad or compress targets, so the size of the format is the minimum a target uses.
+	bool AddTarget( const char* pName, unsigned int bytesPerPixel );
+
+	// Budget numChains downsample pyramids with bytesPerPixel per level, with the levels
+	// given by CalculateDownsampleSteps(). 0 chains for none.
+	void SetDownsampleChains( unsigned int bytesPerPixel, unsigned int numChains );
+
+	// The dynamic buffer is an integer multiple of the back buffer on each axis, limited
+	// by maxWidth and maxHeight (see DynamicResolution::InitializeResolutionParameters),
+	// so this finds the largest scaling up to maxScaling whose buffer fits the budget.
+	// If none do the back buffer size is returned with bWithinBudget false.
+	void Calculate( unsigned int backBufferWidth, unsigned int backBufferHeight, unsigned int maxWidth, unsigned int maxHeight,
+					unsigned int maxScaling, RenderTargetBudgetResult* pResult ) const;
+
+	unsigned long long GetBudget() const
+	{
+		return m_BudgetBytes;
+	}
+	unsigned int GetNumTargets() const
+	{
+		return m_NumTargets;
+	}
+	const char* GetTargetName( unsigned int target ) const
+	{
+		return m_pTargetNames[ target ];
+	}
+	unsigned int GetTargetBytesPerPixel( unsigned int target ) const
+	{
+		return m_TargetBytesPerPixel[ target ];
+	}
+
+	// Bytes per pixel summed over all targets
+	unsigned int GetBytesPerPixel() const;
+
+	// Memory used by one target at the given size
+	unsigned long long GetTargetBytes( unsigned int target, unsigned int width, unsigned int height ) const;
+
+	// Memory used by all downsample chains for a dynamic buffer of the given size
+	unsigned long long GetDownsampleBytes( unsigned int width, unsigned int height, unsigned int backBufferWidth, unsigned int backBufferHeight ) const;
+
+	// Number of 2:1 steps which leave a width x height image no more than 2x the back
+	// buffer size, without going below the back buffer size on either axis. Also used
+	// by DynamicResolution for the pyramid it creates.
+	static unsigned int CalculateDownsampleSteps( unsigned int width, unsigned int height, unsigned int backBufferWidth, unsigned int backBufferHeight );
+
+private:
+	unsigned long long	m_BudgetBytes;
+	unsigned int		m_NumTargets;
+	const char*			m_pTargetNames[ MAX_TARGETS ];
+	unsigned int		m_TargetBytesPerPixel[ MAX_TARGETS ];
+	unsigned int		m_DownsampleBytesPerPixel;
+	unsigned int		m_NumDownsampleChains;
+};
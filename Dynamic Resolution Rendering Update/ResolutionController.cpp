@@ -0,0 +1,373 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "ResolutionController.h"
+#include "FrameCostModel.h"
+
+#include <math.h>
+
+namespace
+{
+	//--------------------------------------------------------------------------------------
+	// Clamp helpers
+	//--------------------------------------------------------------------------------------
+	float Clamp( float value, float minValue, float maxValue )
+	{
+		if( value < minValue )
+		{
+			return minValue;
+		}
+		if( value > maxValue )
+		{
+			return maxValue;
+		}
+		return value;
+	}
+
+	float ClampScale( float scale, const ResolutionControlInput& input )
+	{
+		return Clamp( scale, input.scaleMin, input.scaleMax );
+	}
+
+	//--------------------------------------------------------------------------------------
+	// Relative error, positive when there is headroom (frame faster than target)
+	//--------------------------------------------------------------------------------------
+	float RelativeError( const ResolutionControlInput& input )
+	{
+		return 1.0f - input.controlTime / input.targetTime;
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Use average of measured inner loop time and CPU frame time to account for both
+// CPU and GPU activities to some extent.
+//--------------------------------------------------------------------------------------
+float CalculateControlTime( float gpuFrameTime, float cpuFrameTime )
+{
+	float controlTime = ( gpuFrameTime + cpuFrameTime ) / 2.0f;
+	if( cpuFrameTime > 2.0f * gpuFrameTime )
+	{
+		// Some activities can cause frame rate spikes in overall time not
+		// due to GPU activity, so we ignore these. For example changing resolution & going fullscreen.
+		// additionally we may be completely CPU bound so should not throttle GPU too much
+		controlTime = gpuFrameTime;
+	}
+	return controlTime;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Proportional controller
+//--------------------------------------------------------------------------------------
+ProportionalResolutionController::ProportionalResolutionController( float rateOfChange )
+	: m_RateOfChange( rateOfChange )
+{
+}
+
+void ProportionalResolutionController::Reset( float /*currentScale*/ )
+{
+}
+
+float ProportionalResolutionController::Update( const ResolutionControlInput& input )
+{
+	if( input.targetTime <= 0.0f )
+	{
+		return ClampScale( input.currentScale, input );
+	}
+	float scaleRatio = m_RateOfChange * RelativeError( input ) + 1.0f;
+	return ClampScale( scaleRatio * input.currentScale, input );
+}
+
+
+//--------------------------------------------------------------------------------------
+// PID controller
+//--------------------------------------------------------------------------------------
+PIDResolutionController::PIDResolutionController( float kp, float ki, float kd )
+	: m_Kp( kp )
+	, m_Ki( ki )
+	, m_Kd( kd )
+	, m_MaxStep( 0.25f )
+	, m_PrevError( 0.0f )
+	, m_PrevPrevError( 0.0f )
+{
+}
+
+void PIDResolutionController::Reset( float /*currentScale*/ )
+{
+	m_PrevError = 0.0f;
+	m_PrevPrevError = 0.0f;
+}
+
+float PIDResolutionController::Update( const ResolutionControlInput& input )
+{
+	if( input.targetTime <= 0.0f )
+	{
+		return ClampScale( input.currentScale, input );
+	}
+
+	// error is clamped so a single huge hitch can't collapse the scale in one frame
+	float error = Clamp( RelativeError( input ), -1.0f, 1.0f );
+
+	// incremental form: du = Kp*(e - e1) + Ki*e + Kd*(e - 2*e1 + e2)
+	float delta =	m_Kp * ( error - m_PrevError ) +
+					m_Ki * error +
+					m_Kd * ( error - 2.0f * m_PrevError + m_PrevPrevError );
+	delta = Clamp( delta, -m_MaxStep, m_MaxStep );
+
+	m_PrevPrevError = m_PrevError;
+	m_PrevError = error;
+
+	return ClampScale( input.currentScale * ( 1.0f + delta ), input );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Deadband controller with hysteresis
+//--------------------------------------------------------------------------------------
+DeadbandResolutionController::DeadbandResolutionController( float outerBand, float innerBand, float rateOfChange )
+	: m_OuterBand( outerBand )
+	, m_InnerBand( innerBand )
+	, m_RateOfChange( rateOfChange )
+	, m_bEngaged( false )
+{
+}
+
+void DeadbandResolutionController::Reset( float /*currentScale*/ )
+{
+	m_bEngaged = false;
+}
+
+float DeadbandResolutionController::Update( const ResolutionControlInput& input )
+{
+	if( input.targetTime <= 0.0f )
+	{
+		return ClampScale( input.currentScale, input );
+	}
+
+	float error = RelativeError( input );
+	float absError = fabs( error );
+
+	if( m_bEngaged )
+	{
+		if( absError < m_InnerBand )
+		{
+			m_bEngaged = false;
+		}
+	}
+	else if( absError > m_OuterBand )
+	{
+		m_bEngaged = true;
+	}
+
+	if( !m_bEngaged )
+	{
+		return ClampScale( input.currentScale, input );
+	}
+
+	float scaleRatio = m_RateOfChange * Clamp( error, -1.0f, 1.0f ) + 1.0f;
+	return ClampScale( scaleRatio * input.currentScale, input );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Slew limited controller
+//--------------------------------------------------------------------------------------
+SlewLimitedResolutionController::SlewLimitedResolutionController( float maxStepDown, float maxStepUp )
+	: m_MaxStepDown( maxStepDown )
+	, m_MaxStepUp( maxStepUp )
+{
+}
+
+void SlewLimitedResolutionController::Reset( float /*currentScale*/ )
+{
+}
+
+float SlewLimitedResolutionController::Update( const ResolutionControlInput& input )
+{
+	if( input.targetTime <= 0.0f || input.controlTime <= 0.0f )
+	{
+		return ClampScale( input.currentScale, input );
+	}
+
+	// pixel count goes with scale squared, so the scale ratio is the square root of the time ratio
+	float scaleRatio = sqrt( input.targetTime / input.controlTime );
+	scaleRatio = Clamp( scaleRatio, 1.0f - m_MaxStepDown, 1.0f + m_MaxStepUp );
+	return ClampScale( scaleRatio * input.currentScale, input );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Predictive controller
+//--------------------------------------------------------------------------------------
+PredictiveResolutionController::PredictiveResolutionController( const FrameCostModel* pCostModel, float headroom, float maxStepUp )
+	: m_pCostModel( pCostModel )
+	, m_Headroom( headroom )
+	, m_MaxStepUp( maxStepUp )
+	, m_MaxStepDown( 0.15f )
+{
+}
+
+void PredictiveResolutionController::Reset( float /*currentScale*/ )
+{
+}
+
+float PredictiveResolutionController::Update( const ResolutionControlInput& input )
+{
+	if( input.targetTime <= 0.0f )
+	{
+		return ClampScale( input.currentScale, input );
+	}
+
+	float pixelCount = 0.0f;
+	bool bHavePixelCount = input.scalePixelCount > 0.0f && m_pCostModel &&
+		m_pCostModel->GetPixelCountForTime( m_Headroom * input.targetTime, &pixelCount );
+	if( !bHavePixelCount && input.scalePixelCount > 0.0f && input.controlTime > 0.0f &&
+		input.shadedPixelCost > 0.0f && input.overdraw > 0.0f )
+	{
+		// measured per pixel cost, with whatever the current pixels do not explain as fixed
+		float pixelCost = input.shadedPixelCost * input.overdraw;
+		float currentPixels = input.currentScale * input.currentScale * input.scalePixelCount;
+		float fixedTime = input.controlTime - pixelCost * currentPixels;
+		if( fixedTime < 0.0f )
+		{
+			fixedTime = 0.0f;
+		}
+		pixelCount = ( m_Headroom * input.targetTime - fixedTime ) / pixelCost;
+		bHavePixelCount = pixelCount > 0.0f;
+	}
+	if( !bHavePixelCount )
+	{
+		if( input.controlTime <= 0.0f )
+		{
+			return ClampScale( input.currentScale, input );
+		}
+		float scaleRatio = sqrt( input.targetTime / input.controlTime );
+		scaleRatio = Clamp( scaleRatio, 1.0f - m_MaxStepDown, 1.0f + m_MaxStepUp );
+		return ClampScale( scaleRatio * input.currentScale, input );
+	}
+
+	// pixel count goes with scale squared
+	float scale = sqrt( pixelCount / input.scalePixelCount );
+	float maxScale = input.currentScale * ( 1.0f + m_MaxStepUp );
+	if( scale > maxScale )
+	{
+		scale = maxScale;
+	}
+	return ClampScale( scale, input );
+}
+
+
+//--------------------------------------------------------------------------------------
+// Axis scale selector
+//--------------------------------------------------------------------------------------
+AxisScaleSelector::AxisScaleSelector( float maxAxisRatio, float motionThreshold, float smoothing )
+	: m_MaxAxisRatio( maxAxisRatio )
+	, m_MotionThreshold( motionThreshold )
+	, m_Smoothing( smoothing )
+	, m_AxisBias( 0.0f )
+{
+}
+
+void AxisScaleSelector::Reset()
+{
+	m_AxisBias = 0.0f;
+}
+
+void AxisScaleSelector::UpdateMotion( float motionX, float motionY )
+{
+	// the threshold keeps small, noisy motion from biasing a near static view
+	float bias = ( motionX - motionY ) / ( motionX + motionY + m_MotionThreshold );
+	m_AxisBias += m_Smoothing * ( Clamp( bias, -1.0f, 1.0f ) - m_AxisBias );
+}
+
+void AxisScaleSelector::Select( float scale, const AxisScaleLimits& limits, float* pScaleX, float* pScaleY ) const
+{
+	// ratio = scaleX / scaleY, below 1 when there is more motion in X
+	float ratio = pow( m_MaxAxisRatio, -m_AxisBias );
+	float area = scale * scale;
+	float scaleX = scale * sqrt( ratio );
+
+	// if one axis hits a limit, the other takes up the difference where it can
+	scaleX = Clamp( scaleX, limits.minX, limits.maxX );
+	float scaleY = Clamp( area / scaleX, limits.minY, limits.maxY );
+	scaleX = Clamp( area / scaleY, limits.minX, limits.maxX );
+
+	*pScaleX = scaleX;
+	*pScaleY = scaleY;
+}
+
+
+//--------------------------------------------------------------------------------------
+// Motion adaptive policy
+//--------------------------------------------------------------------------------------
+MotionAdaptivePolicy::MotionAdaptivePolicy( float lockSpeed, float unlockSpeed, float fastSpeed, float fastScaleMin )
+	: m_LockSpeed( lockSpeed )
+	, m_UnlockSpeed( unlockSpeed )
+	, m_FastSpeed( fastSpeed )
+	, m_FastScaleMin( fastScaleMin )
+	, m_LockOverBudget( 0.1f )
+	, m_Smoothing( 0.25f )
+	, m_Speed( 0.0f )
+	, m_bLocked( false )
+{
+}
+
+void MotionAdaptivePolicy::Reset()
+{
+	m_Speed = 0.0f;
+	m_bLocked = false;
+}
+
+void MotionAdaptivePolicy::UpdateMotion( float meanSpeed )
+{
+	m_Speed += m_Smoothing * ( meanSpeed - m_Speed );
+
+	if( m_bLocked )
+	{
+		if( m_Speed > m_UnlockSpeed )
+		{
+			m_bLocked = false;
+		}
+	}
+	else if( m_Speed < m_LockSpeed )
+	{
+		m_bLocked = true;
+	}
+}
+
+float MotionAdaptivePolicy::GetScaleMin( float scaleMin ) const
+{
+	if( m_FastScaleMin >= scaleMin || m_FastSpeed <= m_UnlockSpeed )
+	{
+		return scaleMin;
+	}
+	float t = Clamp( ( m_Speed - m_UnlockSpeed ) / ( m_FastSpeed - m_UnlockSpeed ), 0.0f, 1.0f );
+	return scaleMin + t * ( m_FastScaleMin - scaleMin );
+}
+
+float MotionAdaptivePolicy::Apply( const ResolutionControlInput& input, float newScale ) const
+{
+	if( !m_bLocked || input.targetTime <= 0.0f )
+	{
+		return newScale;
+	}
+
+	// while locked only allow decreases needed to stay near the target frame time
+	if( newScale < input.currentScale && RelativeError( input ) < -m_LockOverBudget )
+	{
+		return newScale;
+	}
+	return ClampScale( input.currentScale, input );
+}
@@ -0,0 +1,273 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Note: this file deliberately has no D3D or DXUT dependencies so the controllers
+// can be driven by synthetic frame time signals outside of the sample.
+
+class FrameCostModel;
+
+//--------------------------------------------------------------------------------------
+// Per frame input to a resolution controller. All times are in seconds.
+//--------------------------------------------------------------------------------------
+struct ResolutionControlInput
+{
+	float	controlTime;	// measured frame time to control against
+	float	targetTime;		// desired frame time, e.g. 1/VSync
+	float	currentScale;	// scale applied this frame
+	float	scaleMin;		// lower limit of output scale
+	float	scaleMax;		// upper limit of output scale
+	float	scalePixelCount;	// viewport pixel count at a scale of 1.0
+	float	shadedPixelCost;	// GPU time per pixel shader invocation of the scaled passes, 0 if unknown
+	float	overdraw;			// pixel shader invocations per viewport pixel of the scaled passes, 0 if unknown
+};
+
+//--------------------------------------------------------------------------------------
+// Per axis limits for AxisScaleSelector
+//--------------------------------------------------------------------------------------
+struct AxisScaleLimits
+{
+	float	minX;
+	float	maxX;
+	float	minY;
+	float	maxY;
+};
+
+//--------------------------------------------------------------------------------------
+// Combines GPU and CPU frame times into the single time the controllers act on.
+// This is the measurement logic ControlResolution() has always used, kept here so
+// offline tools use exactly the same signal.
+//--------------------------------------------------------------------------------------
+float CalculateControlTime( float gpuFrameTime, float cpuFrameTime );
+
+//--------------------------------------------------------------------------------------
+// Interface for resolution control policies. A controller takes the measured and
+// target frame times and returns the scale to use next frame.
+//--------------------------------------------------------------------------------------
+class IResolutionController
+{
+public:
+	virtual ~IResolutionController() {}
+
+	// Reset any internal state, e.g. when the control mode changes
+	virtual void Reset( float currentScale ) = 0;
+
+	// Returns the new scale, clamped to [scaleMin, scaleMax]
+	virtual float Update( const ResolutionControlInput& input ) = 0;
+
+	virtual const wchar_t* GetName() const = 0;
+};
+
+//--------------------------------------------------------------------------------------
+// Original sample controller: a fixed rate step proportional to the relative error
+// between the control and target times.
+//--------------------------------------------------------------------------------------
+class ProportionalResolutionController : public IResolutionController
+{
+public:
+	ProportionalResolutionController( float rateOfChange = 0.01f );
+
+	virtual void Reset( float currentScale );
+	virtual float Update( const ResolutionControlInput& input );
+	virtual const wchar_t* GetName() const
+	{
+		return L"Proportional";
+	}
+
+	float	m_RateOfChange;
+};
+
+//--------------------------------------------------------------------------------------
+// PID controller in incremental (velocity) form, acting on the relative error
+// e = 1 - controlTime/targetTime. The incremental form means clamping the output
+// scale also prevents integral windup.
+//--------------------------------------------------------------------------------------
+class PIDResolutionController : public IResolutionController
+{
+public:
+	PIDResolutionController( float kp = 0.2f, float ki = 0.05f, float kd = 0.05f );
+
+	virtual void Reset( float currentScale );
+	virtual float Update( const ResolutionControlInput& input );
+	virtual const wchar_t* GetName() const
+	{
+		return L"PID";
+	}
+
+	float	m_Kp;
+	float	m_Ki;
+	float	m_Kd;
+	float	m_MaxStep;		// limit on relative change per frame
+
+private:
+	float	m_PrevError;
+	float	m_PrevPrevError;
+};
+
+//--------------------------------------------------------------------------------------
+// Deadband controller with hysteresis. Holds the scale while the relative error is
+// inside the outer band, and once engaged keeps adjusting until the error falls
+// inside the inner band. Reduces the resolution swimming seen with a static camera.
+//--------------------------------------------------------------------------------------
+class DeadbandResolutionController : public IResolutionController
+{
+public:
+	DeadbandResolutionController( float outerBand = 0.08f, float innerBand = 0.02f, float rateOfChange = 0.05f );
+
+	virtual void Reset( float currentScale );
+	virtual float Update( const ResolutionControlInput& input );
+	virtual const wchar_t* GetName() const
+	{
+		return L"Deadband";
+	}
+
+	bool IsEngaged() const
+	{
+		return m_bEngaged;
+	}
+
+	float	m_OuterBand;
+	float	m_InnerBand;
+	float	m_RateOfChange;
+
+private:
+	bool	m_bEngaged;
+};
+
+//--------------------------------------------------------------------------------------
+// Slew limited controller. Assumes frame time is dominated by pixel cost, so the
+// scale which meets the target is currentScale * sqrt( target / control ). The
+// move towards that scale is limited per frame, with a faster limit downwards so
+// heavy camera cuts recover in a few frames while increases stay gradual.
+//--------------------------------------------------------------------------------------
+class SlewLimitedResolutionController : public IResolutionController
+{
+public:
+	SlewLimitedResolutionController( float maxStepDown = 0.15f, float maxStepUp = 0.02f );
+
+	virtual void Reset( float currentScale );
+	virtual float Update( const ResolutionControlInput& input );
+	virtual const wchar_t* GetName() const
+	{
+		return L"Slew Limited";
+	}
+
+	float	m_MaxStepDown;	// maximum relative decrease per frame
+	float	m_MaxStepUp;	// maximum relative increase per frame
+};
+
+//--------------------------------------------------------------------------------------
+// Predictive controller. Uses a FrameCostModel fitted to the per pass GPU timings to
+// find the pixel count which meets the target time, and jumps straight to the matching
+// scale. Increases are limited per frame as the model extrapolates upwards from the
+// pixel counts it has seen. Until the model is valid it uses the shaded pixel cost and
+// overdraw from pipeline statistics, when known, taking the rest of the control time as
+// fixed, and otherwise falls back to the slew limited square root estimate.
+//--------------------------------------------------------------------------------------
+class PredictiveResolutionController : public IResolutionController
+{
+public:
+	PredictiveResolutionController( const FrameCostModel* pCostModel, float headroom = 0.95f, float maxStepUp = 0.05f );
+
+	virtual void Reset( float currentScale );
+	virtual float Update( const ResolutionControlInput& input );
+	virtual const wchar_t* GetName() const
+	{
+		return L"Predictive";
+	}
+
+	const FrameCostModel*	m_pCostModel;
+	float					m_Headroom;		// fraction of the target time to aim for
+	float					m_MaxStepUp;	// maximum relative increase per frame
+	float					m_MaxStepDown;	// maximum relative decrease per frame when falling back
+};
+
+//--------------------------------------------------------------------------------------
+// Splits the single scale chosen by a controller into separate X and Y scales, keeping
+// scaleX * scaleY equal to scale * scale so the pixel count, and therefore the cost,
+// is unchanged. The axis with more screen space motion loses resolution first, as that
+// detail is lost to motion blur anyway. The bias is smoothed over frames to avoid the
+// aspect ratio swimming, and either axis may be limited separately.
+//--------------------------------------------------------------------------------------
+class AxisScaleSelector
+{
+public:
+	AxisScaleSelector( float maxAxisRatio = 2.0f, float motionThreshold = 4.0f, float smoothing = 0.1f );
+
+	void Reset();
+
+	// Per frame screen space motion on each axis, in pixels
+	void UpdateMotion( float motionX, float motionY );
+
+	void Select( float scale, const AxisScaleLimits& limits, float* pScaleX, float* pScaleY ) const;
+
+	// -1 favours resolution in X, +1 favours resolution in Y
+	float GetAxisBias() const
+	{
+		return m_AxisBias;
+	}
+
+	float	m_MaxAxisRatio;		// largest ratio between the two axis scales
+	float	m_MotionThreshold;	// motion in pixels below which there is little bias
+	float	m_Smoothing;		// weight of the new bias each frame
+
+private:
+	float	m_AxisBias;
+};
+
+//--------------------------------------------------------------------------------------
+// Motion adaptive policy applied to the scale chosen by a controller. When there is
+// almost no screen space motion resolution changes are visible as swimming, so the
+// scale is locked unless the frame is well over budget. During fast motion detail is
+// hidden by motion blur, so the lower scale limit is reduced towards m_FastScaleMin.
+// Lock and unlock speeds differ to give hysteresis. Speeds are in back buffer pixels
+// per frame, e.g. VelocityStatistics::meanSpeed.
+//--------------------------------------------------------------------------------------
+class MotionAdaptivePolicy
+{
+public:
+	MotionAdaptivePolicy( float lockSpeed = 0.25f, float unlockSpeed = 1.0f, float fastSpeed = 16.0f, float fastScaleMin = 0.2f );
+
+	void Reset();
+
+	void UpdateMotion( float meanSpeed );
+
+	// Lower scale limit for this frame, between scaleMin and m_FastScaleMin
+	float GetScaleMin( float scaleMin ) const;
+
+	// Returns the scale to use given the controller's choice of newScale
+	float Apply( const ResolutionControlInput& input, float newScale ) const;
+
+	bool IsLocked() const
+	{
+		return m_bLocked;
+	}
+	float GetSpeed() const
+	{
+		return m_Speed;
+	}
+
+	float	m_LockSpeed;		// speed below which the scale is locked
+	float	m_UnlockSpeed;		// speed above which a locked scale is released
+	float	m_FastSpeed;		// speed at which the scale floor reaches m_FastScaleMin
+	float	m_FastScaleMin;		// lowest scale floor during fast motion
+	float	m_LockOverBudget;	// relative error beyond which a locked scale may still decrease
+	float	m_Smoothing;		// weight of the new speed each frame
+
+private:
+	float	m_Speed;
+	bool	m_bLocked;
+};
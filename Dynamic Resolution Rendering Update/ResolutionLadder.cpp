@@ -0,0 +1,70 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "ResolutionLadder.h"
+
+//--------------------------------------------------------------------------------------
+// Fill in the rungs for one axis in increasing size. The back buffer size and render
+// target size are always included, even if not tile multiples, so a scale of 1.0 and
+// the maximum scale remain reachable.
+//--------------------------------------------------------------------------------------
+unsigned int BuildResolutionLadder( ResolutionRung* pRungs, unsigned int backBufferSize, unsigned int dynamicRTSize, float maxScaling,
+									unsigned int tileSize )
+{
+	unsigned int numRungs = 0;
+	unsigned int size = tileSize < dynamicRTSize ? tileSize : dynamicRTSize;
+	while( size )
+	{
+		pRungs[ numRungs ].size		= size;
+		pRungs[ numRungs ].rtScale	= size / (float)dynamicRTSize;
+		pRungs[ numRungs ].scale	= pRungs[ numRungs ].rtScale * maxScaling;
+		++numRungs;
+
+		// next tile multiple, stopping at the back buffer and render target sizes
+		unsigned int next = ( size / tileSize + 1 ) * tileSize;
+		if( size < backBufferSize && next > backBufferSize )
+		{
+			next = backBufferSize;
+		}
+		if( next > dynamicRTSize )
+		{
+			next = size < dynamicRTSize ? dynamicRTSize : 0;
+		}
+		size = next;
+	}
+	return numRungs;
+}
+
+//--------------------------------------------------------------------------------------
+// Binary search, the rungs being in increasing size
+//--------------------------------------------------------------------------------------
+unsigned int FindResolutionRung( const ResolutionRung* pRungs, unsigned int numRungs, float size )
+{
+	unsigned int low = 0;
+	unsigned int high = numRungs;
+	while( high - low > 1 )
+	{
+		unsigned int mid = ( low + high ) / 2;
+		if( (float)pRungs[ mid ].size <= size )
+		{
+			low = mid;
+		}
+		else
+		{
+			high = mid;
+		}
+	}
+	return low;
+}
@@ -0,0 +1,47 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Note: like ResolutionController.h this file has no D3D or DXUT dependencies.
+
+//--------------------------------------------------------------------------------------
+// One step of the resolution ladder for a single axis, with derived values cached
+//--------------------------------------------------------------------------------------
+struct ResolutionRung
+{
+	unsigned int	size;		// viewport size in pixels
+	float			scale;		// scale relative to the back buffer
+	float			rtScale;	// scale relative to the dynamic render target
+};
+
+//--------------------------------------------------------------------------------------
+// Ladder of viewport sizes for one axis, used by DynamicResolution when a tile size is
+// set. The rungs are the multiples of the tile size up to the dynamic render target
+// size, plus the back buffer size and render target size, in increasing size.
+//--------------------------------------------------------------------------------------
+
+// Rungs needed at most for a ladder, for sizing the array given to BuildResolutionLadder()
+inline unsigned int GetMaxResolutionRungs( unsigned int dynamicRTSize, unsigned int tileSize )
+{
+	return dynamicRTSize / tileSize + 2;
+}
+
+// Fill in pRungs, returning the number of rungs
+unsigned int BuildResolutionLadder( ResolutionRung* pRungs, unsigned int backBufferSize, unsigned int dynamicRTSize, float maxScaling,
+									unsigned int tileSize );
+
+// Index of the largest rung no bigger than size, or the smallest rung
+unsigned int FindResolutionRung( const ResolutionRung* pRungs, unsigned int numRungs, float size );
@@ -14,13 +14,55 @@
 // limitations under the License.
 /////////////////////////////////////////////////////////////////////////////////////////////
 #include "SDKMeshExt.h"
+#include "AnimationKernels.h"
 
+namespace
+{
+	// Offsets of the animation streams, in streams of m_NumAnimatedEntries floats. The
+	// sampled local transforms overwrite the previous key, and the composed local
+	// transforms are stored one after another rather than by component.
+	const UINT cStreamTranslationPrev	= 0;
+	const UINT cStreamRotationPrev		= 3;
+	const UINT cStreamScalePrev			= 7;
+	const UINT cStreamTranslationNext	= 10;
+	const UINT cStreamRotationNext		= 13;
+	const UINT cStreamScaleNext			= 17;
+	const UINT cStreamLocalTransforms	= 20;
+	const UINT cNumStreams				= cStreamLocalTransforms + cAffineTransformFloats;
+
+	Vector3Streams GetVector3Streams( float* pStreams, UINT count, UINT stream )
+	{
+		float* pFirst = pStreams + stream * count;
+		Vector3Streams streams = { pFirst, pFirst + count, pFirst + 2 * count };
+		return streams;
+	}
+
+	QuaternionStreams GetQuaternionStreams( float* pStreams, UINT count, UINT stream )
+	{
+		float* pFirst = pStreams + stream * count;
+		QuaternionStreams streams = { pFirst, pFirst + count, pFirst + 2 * count, pFirst + 3 * count };
+		return streams;
+	}
+
+	const WCHAR cCompressedAnimationExtension[] = L".sdkmesh_canim";
+
+	// Compressed keys are decoded straight into SDKMesh keys
+	typedef char AnimationKeyLayoutCheck[ sizeof( AnimationKey ) == sizeof( SDKANIMATION_DATA ) ? 1 : -1 ];
+}
 
 //--------------------------------------------------------------------------------------
 // CTor
 //--------------------------------------------------------------------------------------
 CDXUTSDKMeshExt::CDXUTSDKMeshExt()
 	: m_pbFrameOfMatrix( NULL )
+	, m_NumHierarchyFrames( 0 )
+	, m_pHierarchyFrames( NULL )
+	, m_pHierarchyParents( NULL )
+	, m_pHierarchyAnimation( NULL )
+	, m_pHierarchyLocalMatrices( NULL )
+	, m_NumAnimatedEntries( 0 )
+	, m_pAnimatedEntries( NULL )
+	, m_pAnimationStreams( NULL )
 {
 }
 
@@ -31,17 +73,344 @@ CDXUTSDKMeshExt::CDXUTSDKMeshExt()
 CDXUTSDKMeshExt::~CDXUTSDKMeshExt()
 {
 	delete[] m_pbFrameOfMatrix;
+	ReleaseFrameHierarchy();
+}
+
+//--------------------------------------------------------------------------------------
+// Loading an animation changes which frames are animated, and destroying the mesh
+// removes the frames, so both drop the flattened hierarchy
+//--------------------------------------------------------------------------------------
+HRESULT CDXUTSDKMeshExt::LoadAnimation( WCHAR* szFileName )
+{
+	ReleaseFrameHierarchy();
+	m_CompressedAnimation.Clear();
+	if( m_pAnimationHeader == &m_CompressedAnimationHeader )
+	{
+		m_pAnimationHeader = NULL;
+	}
+
+	size_t length = wcslen( szFileName );
+	size_t extensionLength = wcslen( cCompressedAnimationExtension );
+	if( length >= extensionLength && 0 == _wcsicmp( szFileName + length - extensionLength, cCompressedAnimationExtension ) )
+	{
+		return LoadCompressedAnimation( szFileName );
+	}
+	return CDXUTSDKMesh::LoadAnimation( szFileName );
+}
+
+void CDXUTSDKMeshExt::Destroy()
+{
+	ReleaseFrameHierarchy();
+	m_CompressedAnimation.Clear();
+	delete[] m_pbFrameOfMatrix;
+	m_pbFrameOfMatrix = NULL;
+	CDXUTSDKMesh::Destroy();
+}
+
+//--------------------------------------------------------------------------------------
+// Reads the whole file and hands it to the decoder, then stands in an animation header
+// and binds the tracks to frames by name, as the SDKMesh loader does
+//--------------------------------------------------------------------------------------
+HRESULT CDXUTSDKMeshExt::LoadCompressedAnimation( WCHAR* szFileName )
+{
+	HRESULT hr = S_OK;
+	WCHAR strPath[MAX_PATH];
+	V_RETURN( DXUTFindDXSDKMediaFileCch( strPath, MAX_PATH, szFileName ) );
+
+	HANDLE hFile = CreateFile( strPath, FILE_READ_DATA, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+							   FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+	if( INVALID_HANDLE_VALUE == hFile )
+		return DXUTERR_MEDIANOTFOUND;
+
+	LARGE_INTEGER fileSize;
+	BYTE* pData = NULL;
+	DWORD dwBytesRead = 0;
+	if( GetFileSizeEx( hFile, &fileSize ) && 0 == fileSize.HighPart )
+	{
+		pData = new BYTE[ fileSize.LowPart ];
+		if( !ReadFile( hFile, pData, fileSize.LowPart, &dwBytesRead, NULL ) )
+		{
+			dwBytesRead = 0;
+		}
+	}
+	CloseHandle( hFile );
+
+	bool bLoaded = pData && dwBytesRead == fileSize.LowPart && m_CompressedAnimation.SetData( pData, dwBytesRead );
+	delete[] pData;
+	if( !bLoaded )
+		return E_FAIL;
+
+	// the compressed animation replaces any SDKMesh animation
+	SAFE_DELETE_ARRAY( m_pAnimationData );
+	m_pAnimationFrameData = NULL;
+
+	ZeroMemory( &m_CompressedAnimationHeader, sizeof( m_CompressedAnimationHeader ) );
+	m_CompressedAnimationHeader.Version = SDKMESH_FILE_VERSION;
+	m_CompressedAnimationHeader.FrameTransformType = m_CompressedAnimation.GetFrameTransformType();
+	m_CompressedAnimationHeader.NumFrames = m_CompressedAnimation.GetNumTracks();
+	m_CompressedAnimationHeader.NumAnimationKeys = m_CompressedAnimation.GetNumKeys();
+	m_CompressedAnimationHeader.AnimationFPS = m_CompressedAnimation.GetFPS();
+	m_pAnimationHeader = &m_CompressedAnimationHeader;
+
+	for( UINT i = 0; i < m_CompressedAnimationHeader.NumFrames; i++ )
+	{
+		char name[ MAX_FRAME_NAME ];
+		strncpy_s( name, MAX_FRAME_NAME, m_CompressedAnimation.GetTrack( i ).name, _TRUNCATE );
+		SDKMESH_FRAME* pFrame = FindFrame( name );
+		if( pFrame )
+		{
+			pFrame->AnimationDataIndex = i;
+		}
+	}
+
+	return S_OK;
+}
+
+//--------------------------------------------------------------------------------------
+// Key of an animation track, decoded if the animation is compressed
+//--------------------------------------------------------------------------------------
+void CDXUTSDKMeshExt::GetAnimationKey( UINT animation, UINT key, SDKANIMATION_DATA* pKey ) const
+{
+	if( m_CompressedAnimation.IsValid() )
+	{
+		m_CompressedAnimation.DecodeKey( animation, key, reinterpret_cast<AnimationKey*>( pKey ) );
+	}
+	else
+	{
+		*pKey = m_pAnimationFrameData[ animation ].pAnimationData[ key ];
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Flatten the frame hierarchy with an iterative walk from frame 0. Siblings share a
+// parent, and a frame is always emitted before its children. Frames not reached from
+// frame 0 are not transformed, as with the recursive transform.
+//--------------------------------------------------------------------------------------
+void CDXUTSDKMeshExt::BuildFrameHierarchy()
+{
+	ReleaseFrameHierarchy();
+	UINT numFrames = GetNumFrames();
+	if( 0 == numFrames )
+	{
+		return;
+	}
+
+	m_pHierarchyFrames			= new UINT[ numFrames ];
+	m_pHierarchyParents			= new UINT[ numFrames ];
+	m_pHierarchyAnimation		= new UINT[ numFrames ];
+	m_pHierarchyLocalMatrices	= new D3DXMATRIX[ numFrames ];
+
+	// each frame popped pushes at most its sibling and child, so the stack never holds
+	// more than one frame beyond those emitted
+	UINT* pStackFrames = new UINT[ numFrames + 1 ];
+	UINT* pStackParents = new UINT[ numFrames + 1 ];
+	UINT stackSize = 0;
+	pStackFrames[ stackSize ] = 0;
+	pStackParents[ stackSize ] = INVALID_FRAME;
+	++stackSize;
+	while( stackSize && m_NumHierarchyFrames < numFrames )
+	{
+		--stackSize;
+		UINT frame = pStackFrames[ stackSize ];
+		UINT parent = pStackParents[ stackSize ];
+		const SDKMESH_FRAME& rFrame = m_pFrameArray[ frame ];
+
+		UINT entry = m_NumHierarchyFrames++;
+		m_pHierarchyFrames[ entry ]			= frame;
+		m_pHierarchyParents[ entry ]		= parent;
+		m_pHierarchyAnimation[ entry ]		= m_pAnimationHeader ? rFrame.AnimationDataIndex : INVALID_ANIMATION_DATA;
+		m_pHierarchyLocalMatrices[ entry ]	= rFrame.Matrix;
+
+		if( INVALID_FRAME != rFrame.SiblingFrame )
+		{
+			pStackFrames[ stackSize ] = rFrame.SiblingFrame;
+			pStackParents[ stackSize ] = parent;
+			++stackSize;
+		}
+		if( INVALID_FRAME != rFrame.ChildFrame )
+		{
+			pStackFrames[ stackSize ] = rFrame.ChildFrame;
+			pStackParents[ stackSize ] = frame;
+			++stackSize;
+		}
+	}
+	delete[] pStackFrames;
+	delete[] pStackParents;
+
+	for( UINT entry = 0; entry < m_NumHierarchyFrames; ++entry )
+	{
+		if( INVALID_ANIMATION_DATA != m_pHierarchyAnimation[ entry ] )
+		{
+			++m_NumAnimatedEntries;
+		}
+	}
+	if( m_NumAnimatedEntries )
+	{
+		m_pAnimatedEntries = new UINT[ m_NumAnimatedEntries ];
+		m_pAnimationStreams = new float[ m_NumAnimatedEntries * cNumStreams ];
+		UINT animated = 0;
+		for( UINT entry = 0; entry < m_NumHierarchyFrames; ++entry )
+		{
+			if( INVALID_ANIMATION_DATA != m_pHierarchyAnimation[ entry ] )
+			{
+				m_pAnimatedEntries[ animated++ ] = entry;
+			}
+		}
+	}
+}
+
+void CDXUTSDKMeshExt::ReleaseFrameHierarchy()
+{
+	m_NumHierarchyFrames = 0;
+	SAFE_DELETE_ARRAY( m_pHierarchyFrames );
+	SAFE_DELETE_ARRAY( m_pHierarchyParents );
+	SAFE_DELETE_ARRAY( m_pHierarchyAnimation );
+	SAFE_DELETE_ARRAY( m_pHierarchyLocalMatrices );
+	m_NumAnimatedEntries = 0;
+	SAFE_DELETE_ARRAY( m_pAnimatedEntries );
+	SAFE_DELETE_ARRAY( m_pAnimationStreams );
 }
 
 //--------------------------------------------------------------------------------------
 // Transform the mesh with linear interpolation between animation frames
 // - does not support skinned meshes (support could be added)
+// The animated frames' keys are gathered into streams and sampled in batches, then the
+// hierarchy is composed in a single pass, each entry's parent already transformed. The
+// batch slerp uses polynomial approximations, so results match those of
+// TransformFrameWithInterpolation() to float precision rather than exactly.
 //--------------------------------------------------------------------------------------
 void CDXUTSDKMeshExt::TransformMeshWithInterpolation( D3DXMATRIX* pWorld, double fTime )
+{
+	if( 0 == m_NumHierarchyFrames )
+	{
+		BuildFrameHierarchy();
+	}
+
+	if( m_pAnimationHeader && m_NumAnimatedEntries )
+	{
+		// Calculate previous and current keys, and interpolant between them, once for all frames
+		double keyFrameNumActual = m_pAnimationHeader->AnimationFPS * fTime;
+		double KeyFrameNumPrev = floor( keyFrameNumActual );
+		UINT iTickPrev = UINT( KeyFrameNumPrev + 0.1 ) % m_pAnimationHeader->NumAnimationKeys; // keyFrameNumPrev is integer, but need to add small value to get correct rounding
+		UINT iTickNext = ( iTickPrev + 1 ) % m_pAnimationHeader->NumAnimationKeys;
+		float interpolant = (float)( keyFrameNumActual - KeyFrameNumPrev );
+
+		UINT count = m_NumAnimatedEntries;
+		Vector3Streams translationPrev		= GetVector3Streams( m_pAnimationStreams, count, cStreamTranslationPrev );
+		QuaternionStreams rotationPrev		= GetQuaternionStreams( m_pAnimationStreams, count, cStreamRotationPrev );
+		Vector3Streams scalePrev			= GetVector3Streams( m_pAnimationStreams, count, cStreamScalePrev );
+		Vector3Streams translationNext		= GetVector3Streams( m_pAnimationStreams, count, cStreamTranslationNext );
+		QuaternionStreams rotationNext		= GetQuaternionStreams( m_pAnimationStreams, count, cStreamRotationNext );
+		Vector3Streams scaleNext			= GetVector3Streams( m_pAnimationStreams, count, cStreamScaleNext );
+
+		// Gather the keys either side of the time into streams
+		for( UINT i = 0; i < count; ++i )
+		{
+			UINT animation = m_pHierarchyAnimation[ m_pAnimatedEntries[ i ] ];
+			SDKANIMATION_DATA dataPrev;
+			SDKANIMATION_DATA dataNext;
+			GetAnimationKey( animation, iTickPrev, &dataPrev );
+			GetAnimationKey( animation, iTickNext, &dataNext );
+			const SDKANIMATION_DATA* pDataPrev = &dataPrev;
+			const SDKANIMATION_DATA* pDataNext = &dataNext;
+
+			translationPrev.x[i]	= pDataPrev->Translation.x;
+			translationPrev.y[i]	= pDataPrev->Translation.y;
+			translationPrev.z[i]	= pDataPrev->Translation.z;
+			rotationPrev.x[i]		= pDataPrev->Orientation.x;
+			rotationPrev.y[i]		= pDataPrev->Orientation.y;
+			rotationPrev.z[i]		= pDataPrev->Orientation.z;
+			rotationPrev.w[i]		= pDataPrev->Orientation.w;
+			scalePrev.x[i]			= pDataPrev->Scaling.x;
+			scalePrev.y[i]			= pDataPrev->Scaling.y;
+			scalePrev.z[i]			= pDataPrev->Scaling.z;
+
+			translationNext.x[i]	= pDataNext->Translation.x;
+			translationNext.y[i]	= pDataNext->Translation.y;
+			translationNext.z[i]	= pDataNext->Translation.z;
+			rotationNext.x[i]		= pDataNext->Orientation.x;
+			rotationNext.y[i]		= pDataNext->Orientation.y;
+			rotationNext.z[i]		= pDataNext->Orientation.z;
+			rotationNext.w[i]		= pDataNext->Orientation.w;
+			scaleNext.x[i]			= pDataNext->Scaling.x;
+			scaleNext.y[i]			= pDataNext->Scaling.y;
+			scaleNext.z[i]			= pDataNext->Scaling.z;
+		}
+
+		// Sample all animated frames at once, into the previous key's streams
+		NormalizeQuaternions( count, rotationPrev );
+		NormalizeQuaternions( count, rotationNext );
+		LerpVector3s( count, interpolant, translationPrev, translationNext, translationPrev );
+		SlerpQuaternions( count, interpolant, rotationPrev, rotationNext, rotationPrev );
+		LerpVector3s( count, interpolant, scalePrev, scaleNext, scalePrev );
+		ComposeAffineTransforms( count, scalePrev, rotationPrev, translationPrev, m_pAnimationStreams + cStreamLocalTransforms * count );
+	}
+
+	// local transforms of animated entries are in entry order
+	const float* pLocalTransform = m_pAnimationStreams + cStreamLocalTransforms * m_NumAnimatedEntries;
+	for( UINT entry = 0; entry < m_NumHierarchyFrames; ++entry )
+	{
+		UINT parent = m_pHierarchyParents[ entry ];
+		const D3DXMATRIX* pParentWorld = INVALID_FRAME != parent ? &m_pWorldPoseFrameMatrices[ parent ] : pWorld;
+
+		D3DXMATRIX transform;
+		if( m_pAnimationHeader && INVALID_ANIMATION_DATA != m_pHierarchyAnimation[ entry ] )
+		{
+			const float* m = pLocalTransform;
+			pLocalTransform += cAffineTransformFloats;
+			D3DXMATRIX local(	m[0], m[1], m[2], 0.0f,
+								m[3], m[4], m[5], 0.0f,
+								m[6], m[7], m[8], 0.0f,
+								m[9], m[10], m[11], 1.0f );
+			D3DXMatrixMultiply( &transform, &local, pParentWorld );
+		}
+		else
+		{
+			D3DXMatrixMultiply( &transform, &m_pHierarchyLocalMatrices[ entry ], pParentWorld );
+		}
+
+		UINT frame = m_pHierarchyFrames[ entry ];
+		m_pTransformedFrameMatrices[ frame ] = transform;
+		m_pWorldPoseFrameMatrices[ frame ] = transform;
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Reference transform, recursing over the frame links
+//--------------------------------------------------------------------------------------
+void CDXUTSDKMeshExt::TransformMeshWithInterpolationReference( D3DXMATRIX* pWorld, double fTime )
 {
 	TransformFrameWithInterpolation( 0, pWorld, fTime );
 }
 
+float CDXUTSDKMeshExt::CompareWithReferenceTransform( D3DXMATRIX* pWorld, double fTime )
+{
+	UINT numFrames = GetNumFrames();
+	if( 0 == numFrames )
+	{
+		return 0.0f;
+	}
+	TransformMeshWithInterpolation( pWorld, fTime );
+	D3DXMATRIX* pFlattened = new D3DXMATRIX[ numFrames ];
+	memcpy( pFlattened, m_pWorldPoseFrameMatrices, numFrames * sizeof( D3DXMATRIX ) );
+
+	TransformMeshWithInterpolationReference( pWorld, fTime );
+	float maxDifference = 0.0f;
+	for( UINT entry = 0; entry < m_NumHierarchyFrames; ++entry )
+	{
+		UINT frame = m_pHierarchyFrames[ entry ];
+		for( int i = 0; i < 16; ++i )
+		{
+			float reference = m_pWorldPoseFrameMatrices[ frame ][i];
+			float scale = fabs( reference ) > 1.0f ? fabs( reference ) : 1.0f;
+			float difference = fabs( pFlattened[ frame ][i] - reference ) / scale;
+			maxDifference = difference > maxDifference ? difference : maxDifference;
+		}
+	}
+	delete[] pFlattened;
+	return maxDifference;
+}
+
 //--------------------------------------------------------------------------------------
 // Transform the mesh frames along with their siblings and children,
 // using linearly interpolated animation frames for smoother animation and motion blur
@@ -61,9 +430,12 @@ void CDXUTSDKMeshExt::TransformFrameWithInterpolation( UINT iFrame, D3DXMATRIX*
 		UINT iTickNext = ( iTickPrev + 1 ) % m_pAnimationHeader->NumAnimationKeys;
 		float interpolant = (float)( keyFrameNumActual - KeyFrameNumPrev );
 
-        SDKANIMATION_FRAME_DATA* pAnimFrameData = &m_pAnimationFrameData[ m_pFrameArray[iFrame].AnimationDataIndex ];
-        SDKANIMATION_DATA* pDataPrev = &pAnimFrameData->pAnimationData[ iTickPrev ];
-        SDKANIMATION_DATA* pDataNext = &pAnimFrameData->pAnimationData[ iTickNext ];
+        SDKANIMATION_DATA dataPrev;
+        SDKANIMATION_DATA dataNext;
+        GetAnimationKey( m_pFrameArray[iFrame].AnimationDataIndex, iTickPrev, &dataPrev );
+        GetAnimationKey( m_pFrameArray[iFrame].AnimationDataIndex, iTickNext, &dataNext );
+        SDKANIMATION_DATA* pDataPrev = &dataPrev;
+        SDKANIMATION_DATA* pDataNext = &dataNext;
 
         // Interpolate the positions based on interpolant
 		D3DXVECTOR3 translatePos = ( 1.0f - interpolant ) * pDataPrev->Translation + interpolant * pDataNext->Translation;
@@ -141,6 +513,26 @@ void CDXUTSDKMeshExt::TransformFrameWithInterpolation( UINT iFrame, D3DXMATRIX*
 }
 
 
+//--------------------------------------------------------------------------------------
+// Frames are animated by loading animation data with a matching frame name, so an
+// animation file that names none of the frames leaves the mesh static
+//--------------------------------------------------------------------------------------
+bool CDXUTSDKMeshExt::IsAnimated() const
+{
+	if( !m_pAnimationHeader )
+	{
+		return false;
+	}
+	for( UINT frame = 0; frame < m_pMeshHeader->NumFrames; ++frame )
+	{
+		if( INVALID_ANIMATION_DATA != m_pFrameArray[ frame ].AnimationDataIndex )
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
 //--------------------------------------------------------------------------------------
 // Updating shader constants potentially expensive, so we
 // check if consequtive frames have the same matrix
@@ -150,10 +542,9 @@ void CDXUTSDKMeshExt::TransformFrameWithInterpolation( UINT iFrame, D3DXMATRIX*
 //--------------------------------------------------------------------------------------
 void CDXUTSDKMeshExt::CheckForRedundantMatrices( float epsilon )
 {
-	if( m_pAnimationHeader )
+	if( IsAnimated() )
     {
-		// if we have an animation header we assume that the mesh animation means
-		// frame matrices could change, so this is not true
+		// the mesh animation means frame matrices could change, so this is not true
 		return;
 	}
 
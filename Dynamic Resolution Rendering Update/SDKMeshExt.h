@@ -18,11 +18,22 @@
 #include "DXUT.h"
 #include "SDKmesh.h"
 #include "SDKmisc.h"
+#include "AnimationCompression.h"
 
 //--------------------------------------------------------------------------------------
 // Extended version of SDKMesh supporting extra functionality, such as
 // interpolated animation and correct animation scaling.
 //
+// The frame hierarchy is flattened on first use into arrays in topological order, so
+// transforming the mesh is a linear loop rather than a recursion over sibling and
+// child links. Keyframes of the animated frames are gathered into float streams and
+// sampled for all frames at once with the batch kernels in AnimationKernels.h. The
+// recursive transform is kept as a reference for checking it.
+//
+// Animation can also be loaded from .sdkmesh_canim files written by AnimationCompressor.
+// Only the two keys either side of the sampled time are decoded for each frame, so the
+// keys are not held uncompressed. The base class TransformMesh does not support this.
+//
 // This version only supports non skinned meshes.
 //--------------------------------------------------------------------------------------
 class CDXUTSDKMeshExt :
@@ -32,9 +43,23 @@ public:
 	CDXUTSDKMeshExt();
 	~CDXUTSDKMeshExt();
 
+	// Loads compressed animation for .sdkmesh_canim files, SDKMesh animation otherwise
+	virtual HRESULT                 LoadAnimation( WCHAR* szFileName );
+	virtual void                    Destroy();
 
 	void                            TransformMeshWithInterpolation( D3DXMATRIX* pWorld, double fTime );
 
+	// Recursive transform over the frame links, the original implementation
+	void                            TransformMeshWithInterpolationReference( D3DXMATRIX* pWorld, double fTime );
+
+	// Transforms with both implementations and returns the largest difference of any
+	// matrix element, relative to the reference element where that is above one, leaving
+	// the reference results. For tests, see UnitTests/MeshTests.cpp, as it allocates.
+	float                           CompareWithReferenceTransform( D3DXMATRIX* pWorld, double fTime );
+
+	// Whether any frame has animation data, otherwise the frame matrices never change
+	bool							IsAnimated() const;
+
 	void							CheckForRedundantMatrices( float epsilon );
 
 	//--------------------------------------------------------------------------------------
@@ -58,8 +83,30 @@ public:
 
 protected:
 	void                            TransformFrameWithInterpolation( UINT iFrame, D3DXMATRIX* pParentWorld, double fTime );
+	void                            BuildFrameHierarchy();
+	void                            ReleaseFrameHierarchy();
+	HRESULT                         LoadCompressedAnimation( WCHAR* szFileName );
+	void                            GetAnimationKey( UINT animation, UINT key, SDKANIMATION_DATA* pKey ) const;
 	UINT*							m_pbFrameOfMatrix;
 
+	// Flattened frame hierarchy, parents before children. Entries are in walk order and
+	// hold frame indices, with INVALID_FRAME as the parent of root frames.
+	UINT							m_NumHierarchyFrames;
+	UINT*							m_pHierarchyFrames;
+	UINT*							m_pHierarchyParents;
+	UINT*							m_pHierarchyAnimation;		// animation data index, INVALID_ANIMATION_DATA for static frames
+	D3DXMATRIX*						m_pHierarchyLocalMatrices;	// local matrix of static frames
+
+	// Animated entries in walk order, and their keyframe and local transform streams,
+	// each m_NumAnimatedEntries long, laid out as the cStream constants in SDKMeshExt.cpp
+	UINT							m_NumAnimatedEntries;
+	UINT*							m_pAnimatedEntries;
+	float*							m_pAnimationStreams;
+
+	// Compressed animation, and the animation header standing in for the SDKMesh one
+	CompressedAnimation				m_CompressedAnimation;
+	SDKANIMATION_FILE_HEADER		m_CompressedAnimationHeader;
+
 	//prevent assign and copy
 	CDXUTSDKMeshExt( const CDXUTSDKMeshExt& rhs );
 	CDXUTSDKMeshExt& operator=( const CDXUTSDKMeshExt& rhs );
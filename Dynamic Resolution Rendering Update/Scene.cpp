@@ -17,6 +17,7 @@
 #include "Scene.h"
 
 #include "Utility.h"
+#include <malloc.h>
 
 
 static const float          LIGHT_RADIUS = 300.0f; // Large enough to enclose th scene
@@ -57,22 +58,18 @@ public:
 
 	ModelContainer()
 		:  m_Type( LIT )
+		, m_bStatic( false )
 	{
-		for(int i=0; i<3; i++)
-			m_pmWorldViewProjections[i]=NULL;
 	}
 	~ModelContainer()
 	{
 		m_Mesh.Destroy();
-		for(int i=0; i<3; i++)
-			delete[] m_pmWorldViewProjections[i];
 	}
 
+	// the model's frame matrices are in the scene's matrix arena
 	CDXUTSDKMeshExt             m_Mesh;
-	D3DXMATRIX*					m_pmWorldViewProjections[3];
-	D3DXMATRIX*					m_pmWorldCurrViewProjections;
-	D3DXMATRIX*					m_pmWorldPrevViewProjections;
 	Type						m_Type;
+	bool						m_bStatic;				// no animated frames, so the world matrices are fixed after load
 
 private:
 	//prevent assign and copy
@@ -105,6 +102,17 @@ public:
 	}
 };
 
+//--------------------------------------------------------------------------------------
+// A frame with a mesh, as an item of the frustum culling hierarchy
+//--------------------------------------------------------------------------------------
+struct CullItem
+{
+	UINT	model;
+	UINT	frame;							// counting all models' frames, as in the matrix arena
+	UINT	numDraws;						// subsets of the mesh
+	float	localBounds[ cBoundsFloats ];	// mesh bounding box in the frame's space
+};
+
 
 //--------------------------------------------------------------------------------------
 // Scene Ctor
@@ -134,10 +142,189 @@ Scene::Scene()
 	, m_pDepthStencilStateDecal( NULL )
 	, m_NumCameras( 1 )
 	, m_CurrentCamera( 0 )
+	, m_SimTime( 0.0 )
+	, m_SimStateIndex( 0 )
+	, m_Interpolation( 0.0f )
+	, m_pTaskPool( NULL )
+	, m_pModelFrameStart( NULL )
+	, m_NumStaticFrames( 0 )
+	, m_pMatrixArena( NULL )
+	, m_CurrViewProjSlot( 0 )
+	, m_PrevViewProjSlot( 0 )
+	, m_NumMatricesRecomputing( 0 )
+	, m_NumMatricesRecomputed( 0 )
+	, m_bFrustumCulling( true )
+	, m_NumCullItems( 0 )
+	, m_NumDynamicCullItems( 0 )
+	, m_pCullItems( NULL )
+	, m_pCullItemBounds( NULL )
+	, m_pCullItemVisible( NULL )
+	, m_pFrameVisible( NULL )
+	, m_NumDraws( 0 )
+	, m_NumCulledDraws( 0 )
+	, m_CullTime( 0.0 )
 
 
 {
 	D3DXMatrixIdentity( &m_mCenter );
+	D3DXMatrixIdentity( &m_mViewProj );
+	D3DXMatrixIdentity( &m_mPrevViewProj );
+	D3DXMatrixIdentity( &m_mCameraWorld[0] );
+	D3DXMatrixIdentity( &m_mCameraWorld[1] );
+	D3DXMatrixIdentity( &m_mFrameCameraWorld );
+	D3DXMatrixIdentity( &m_mFrameView );
+	D3DXMatrixIdentity( &m_mFrameProj );
+	for( int i = 0; i < 3; i++ )
+	{
+		D3DXMatrixIdentity( &m_mSlotViewProj[i] );
+		m_bSlotViewProjValid[i] = false;
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Interpolate between two transforms. The rotation is interpolated as a quaternion so
+// it keeps its length, and transforms which can't be decomposed are interpolated
+// linearly.
+//--------------------------------------------------------------------------------------
+static void InterpolateMatrix( D3DXMATRIX* pOut, const D3DXMATRIX* pA, const D3DXMATRIX* pB, float t )
+{
+	if( t <= 0.0f || *pA == *pB )
+	{
+		// static nodes, and any frame landing exactly on a step
+		*pOut = *pA;
+		return;
+	}
+
+	D3DXVECTOR3 scaleA, scaleB, translationA, translationB;
+	D3DXQUATERNION rotationA, rotationB;
+	if( SUCCEEDED( D3DXMatrixDecompose( &scaleA, &rotationA, &translationA, pA ) ) &&
+		SUCCEEDED( D3DXMatrixDecompose( &scaleB, &rotationB, &translationB, pB ) ) )
+	{
+		D3DXVECTOR3 scale, translation;
+		D3DXQUATERNION rotation;
+		D3DXVec3Lerp( &scale, &scaleA, &scaleB, t );
+		D3DXQuaternionSlerp( &rotation, &rotationA, &rotationB, t );
+		D3DXVec3Lerp( &translation, &translationA, &translationB, t );
+		D3DXMatrixTransformation( pOut, NULL, NULL, &scale, NULL, &rotation, &translation );
+	}
+	else
+	{
+		*pOut = *pA + ( *pB - *pA ) * t;
+	}
+}
+
+namespace
+{
+	// Frames of the model matrix update per task, enough to keep the task overhead low
+	// while still splitting scenes of a few large models
+	const UINT cFramesPerTask = 256;
+
+	// Sections of the matrix arena, each holding one matrix for every frame of all models
+	const UINT cNumViewProjectionSlots		= 3;	// ring of world view projections, current, previous and history
+	const UINT cSectionWorldViewProjections	= 0;	// a section per ring slot
+	const UINT cSectionSimWorlds			= cSectionWorldViewProjections + cNumViewProjectionSlots;	// a section per simulated state
+	const UINT cSectionWorlds				= cSectionSimWorlds + 2;	// interpolated for this frame
+	const UINT cNumMatrixSections			= cSectionWorlds + 1;
+
+	// Culling benchmark steps along the camera path, and repeats of each timed cull so
+	// the timer resolution does not dominate
+	const double cCullBenchmarkStepTime		= 1.0 / 60.0;
+	const UINT cCullBenchmarkRepeats		= 16;
+
+	//--------------------------------------------------------------------------------------
+	// Per model update jobs for the task pool. Each task writes only its own model's or
+	// frame range's matrices.
+	//--------------------------------------------------------------------------------------
+	struct TransformModelsJob
+	{
+		ModelContainer*		pModels;
+		const UINT*			pModelFrameStart;
+		D3DXMATRIX*			pWorld;
+		double				time;
+		D3DXMATRIX*			pSimWorlds;		// the simulation state's section of the arena
+	};
+
+	// Animate one model and store its world matrices into the simulation state. Static
+	// models keep the matrices stored on load in both states.
+	void TransformModelTask( void* pArg, int threadIndex, UINT task, UINT taskCount )
+	{
+		const TransformModelsJob* pJob = (const TransformModelsJob*)pArg;
+		ModelContainer& rModel = pJob->pModels[ task ];
+		if( rModel.m_bStatic )
+		{
+			return;
+		}
+		rModel.m_Mesh.TransformMeshWithInterpolation( pJob->pWorld, pJob->time );
+
+		D3DXMATRIX* pSimWorlds = pJob->pSimWorlds + pJob->pModelFrameStart[ task ];
+		for( UINT frame = 0; frame < rModel.m_Mesh.GetNumFrames(); ++frame )
+		{
+			pSimWorlds[ frame ] = *rModel.m_Mesh.GetWorldMatrix( frame );
+		}
+	}
+
+	struct UpdateMatricesJob
+	{
+		const ModelContainer* pModels;
+		const UINT*			pModelFrameStart;
+		UINT				numModels;
+		const D3DXMATRIX*	pPrevSimWorlds;
+		const D3DXMATRIX*	pCurrSimWorlds;
+		D3DXMATRIX*			pWorlds;
+		D3DXMATRIX*			pWorldViewProjections;	// the ring slot being written
+		float				interpolation;
+		D3DXMATRIX			viewProj;
+		bool				bUpdateStatic;
+	};
+
+	// Interpolate and project a range of cFramesPerTask frames, which may span models, so
+	// a linear range of each arena section. Static models' world matrices are fixed, so
+	// they are only reprojected if bUpdateStatic.
+	void UpdateMatricesTask( void* pArg, int threadIndex, UINT task, UINT taskCount )
+	{
+		const UpdateMatricesJob* pJob = (const UpdateMatricesJob*)pArg;
+		UINT begin = task * cFramesPerTask;
+		UINT end = begin + cFramesPerTask;
+		if( end > pJob->pModelFrameStart[ pJob->numModels ] )
+		{
+			end = pJob->pModelFrameStart[ pJob->numModels ];
+		}
+
+		// last model starting at or before the range
+		UINT model = 0;
+		UINT modelAfter = pJob->numModels;
+		while( modelAfter - model > 1 )
+		{
+			UINT middle = ( model + modelAfter ) / 2;
+			if( pJob->pModelFrameStart[ middle ] <= begin )
+			{
+				model = middle;
+			}
+			else
+			{
+				modelAfter = middle;
+			}
+		}
+
+		for( UINT index = begin; index < end; ++model )
+		{
+			UINT modelEnd = pJob->pModelFrameStart[ model + 1 ] < end ? pJob->pModelFrameStart[ model + 1 ] : end;
+			if( pJob->pModels[ model ].m_bStatic )
+			{
+				for( ; pJob->bUpdateStatic && index < modelEnd; ++index )
+				{
+					pJob->pWorldViewProjections[ index ] = pJob->pWorlds[ index ] * pJob->viewProj;
+				}
+				index = modelEnd;
+				continue;
+			}
+			for( ; index < modelEnd; ++index )
+			{
+				InterpolateMatrix( &pJob->pWorlds[ index ], &pJob->pPrevSimWorlds[ index ], &pJob->pCurrSimWorlds[ index ], pJob->interpolation );
+				pJob->pWorldViewProjections[ index ] = pJob->pWorlds[ index ] * pJob->viewProj;
+			}
+		}
+	}
 }
 
 //--------------------------------------------------------------------------------------
@@ -150,14 +337,16 @@ Scene::~Scene()
 }
 
 //--------------------------------------------------------------------------------------
-// D3DDevice dependant initialization
+// Load the scene description's models and set up the simulation and culling, which
+// need no device resources. With a NULL device the meshes are loaded without buffers
+// or textures, for running the scene's CPU work headless.
 //--------------------------------------------------------------------------------------
-HRESULT Scene::OnD3D11CreateDevice(ID3D11Device* pD3DDevice, ID3D11DeviceContext* pImmediateContext)
+HRESULT Scene::LoadModels( ID3D11Device* pD3DDevice, wchar_t* pSceneDescriptionPath )
 {
 	HRESULT hr = S_OK;
 
 	// Load scene description
-	m_SceneDesc.LoadFromFile( L"scene_description.txt" );
+	m_SceneDesc.LoadFromFile( pSceneDescriptionPath );
 
     // Load model and textures resources
 	delete[] m_pModels;
@@ -168,7 +357,7 @@ HRESULT Scene::OnD3D11CreateDevice(ID3D11Device* pD3DDevice, ID3D11DeviceContext
 		const wchar_t* pModelFilename = m_SceneDesc.GetModelPath( model );
 		if( pModelFilename )
 		{
-			m_pModels[model].m_Mesh.Create( pD3DDevice, pModelFilename, true );
+			V_RETURN( m_pModels[model].m_Mesh.Create( pD3DDevice, pModelFilename, true ) );
 		}
 		//need to cast away const due to SDKMesh loadanimation 
 		wchar_t* pAnimationPath = (wchar_t*)m_SceneDesc.GetAnimationPath( model );
@@ -176,6 +365,7 @@ HRESULT Scene::OnD3D11CreateDevice(ID3D11Device* pD3DDevice, ID3D11DeviceContext
 		{
 			m_pModels[model].m_Mesh.LoadAnimation( pAnimationPath );
 		}
+		m_pModels[model].m_bStatic = !m_pModels[model].m_Mesh.IsAnimated();
 
 		const wchar_t* pParams = m_SceneDesc.GetParams( model );
 		if( pParams )
@@ -308,16 +498,91 @@ HRESULT Scene::OnD3D11CreateDevice(ID3D11Device* pD3DDevice, ID3D11DeviceContext
 	m_pCinematicCamera->SetNumberOfFramesToSmoothMouseData( 2 );
 
 
+	delete[] m_pModelFrameStart;
+	m_pModelFrameStart = new UINT[ m_NumModels + 1 ];
+	m_pModelFrameStart[ 0 ] = 0;
+	m_NumStaticFrames = 0;
 	for( UINT model = 0; model < m_NumModels; ++model )
 	{
-		UINT numFrames = m_pModels[model].m_Mesh.GetNumFrames();
-		for(int i=0; i<3; i++)
+		m_pModelFrameStart[ model + 1 ] = m_pModelFrameStart[ model ] + m_pModels[model].m_Mesh.GetNumFrames();
+		if( m_pModels[model].m_bStatic )
 		{
-			delete[] m_pModels[model].m_pmWorldViewProjections[i];
-			m_pModels[model].m_pmWorldViewProjections[i] = new D3DXMATRIX[ numFrames ];
+			m_NumStaticFrames += m_pModels[model].m_Mesh.GetNumFrames();
+		}
+	}
+
+	_aligned_free( m_pMatrixArena );
+	m_pMatrixArena = (D3DXMATRIX*)_aligned_malloc( cNumMatrixSections * m_pModelFrameStart[ m_NumModels ] * sizeof( D3DXMATRIX ), 16 );
+	memset( m_pMatrixArena, 0, cNumMatrixSections * m_pModelFrameStart[ m_NumModels ] * sizeof( D3DXMATRIX ) );
+
+	// Frustum culling items, the frames with a mesh, dynamic models' then static models'
+	m_NumCullItems = 0;
+	m_NumDynamicCullItems = 0;
+	for( UINT model = 0; model < m_NumModels; ++model )
+	{
+		for( UINT frame = 0; frame < m_pModels[model].m_Mesh.GetNumFrames(); ++frame )
+		{
+			if( INVALID_MESH != m_pModels[model].m_Mesh.GetFrame( frame )->Mesh )
+			{
+				++m_NumCullItems;
+				m_NumDynamicCullItems += m_pModels[model].m_bStatic ? 0 : 1;
+			}
+		}
+	}
+	delete[] m_pCullItems;
+	delete[] m_pCullItemBounds;
+	delete[] m_pCullItemVisible;
+	delete[] m_pFrameVisible;
+	m_pCullItems = new CullItem[ m_NumCullItems ];
+	m_pCullItemBounds = new float[ m_NumCullItems * cBoundsFloats ];
+	m_pCullItemVisible = new unsigned char[ m_NumCullItems ];
+	m_pFrameVisible = new unsigned char[ m_pModelFrameStart[ m_NumModels ] ];
+	memset( m_pFrameVisible, 1, m_pModelFrameStart[ m_NumModels ] );
+	UINT item = 0;
+	for( UINT pass = 0; pass < 2; ++pass )
+	{
+		for( UINT model = 0; model < m_NumModels; ++model )
+		{
+			if( m_pModels[model].m_bStatic != ( 1 == pass ) )
+			{
+				continue;
+			}
+			CDXUTSDKMeshExt& rMesh = m_pModels[model].m_Mesh;
+			for( UINT frame = 0; frame < rMesh.GetNumFrames(); ++frame )
+			{
+				UINT mesh = rMesh.GetFrame( frame )->Mesh;
+				if( INVALID_MESH == mesh )
+				{
+					continue;
+				}
+				CullItem& rItem = m_pCullItems[ item++ ];
+				rItem.model = model;
+				rItem.frame = m_pModelFrameStart[ model ] + frame;
+				rItem.numDraws = rMesh.GetNumSubsets( mesh );
+				D3DXVECTOR3 center = rMesh.GetMeshBBoxCenter( mesh );
+				D3DXVECTOR3 extents = rMesh.GetMeshBBoxExtents( mesh );
+				rItem.localBounds[0] = center.x;
+				rItem.localBounds[1] = center.y;
+				rItem.localBounds[2] = center.z;
+				rItem.localBounds[3] = extents.x;
+				rItem.localBounds[4] = extents.y;
+				rItem.localBounds[5] = extents.z;
+			}
 		}
 	}
 
+	return hr;
+}
+
+//--------------------------------------------------------------------------------------
+// D3DDevice dependant initialization
+//--------------------------------------------------------------------------------------
+HRESULT Scene::OnD3D11CreateDevice(ID3D11Device* pD3DDevice, ID3D11DeviceContext* pImmediateContext)
+{
+	HRESULT hr = S_OK;
+
+	V_RETURN( LoadModels( pD3DDevice, L"scene_description.txt" ) );
+
 	// Load textures (TODO: wrong textures at this point)
     V_RETURN( D3DX11CreateShaderResourceViewFromFile( pD3DDevice, L"media\\white.png", NULL, NULL, &m_pDiffuseTextureSRV, NULL ) );
 	V_RETURN( D3DX11CreateShaderResourceViewFromFile( pD3DDevice, L"media\\flat_normal.png", NULL, NULL, &m_pNormalTextureSRV, NULL ) );
@@ -426,6 +691,21 @@ void    Scene::OnD3D11DestroyDevice()
 {
 	delete[] m_pModels;
 	m_pModels = NULL;
+	delete[] m_pModelFrameStart;
+	m_pModelFrameStart = NULL;
+	_aligned_free( m_pMatrixArena );
+	m_pMatrixArena = NULL;
+	delete[] m_pCullItems;
+	m_pCullItems = NULL;
+	delete[] m_pCullItemBounds;
+	m_pCullItemBounds = NULL;
+	delete[] m_pCullItemVisible;
+	m_pCullItemVisible = NULL;
+	delete[] m_pFrameVisible;
+	m_pFrameVisible = NULL;
+	m_NumCullItems = 0;
+	m_NumDynamicCullItems = 0;
+	m_CullHierarchy.Build( 0, NULL );
 
 	//reset cameras
 	m_NumCameras = 1;
@@ -467,24 +747,51 @@ HRESULT Scene::OnD3D11ResizedSwapChain( ID3D11Device* pD3DDevice,
     float fAspectRatio = pBackBufferSurfaceDesc->Width / ( float )pBackBufferSurfaceDesc->Height;
     m_pCinematicCamera->SetProjParams( D3DX_PI / 4.0f, fAspectRatio, 20.0f, 400000.0f ); // setting near/ far planes TODO Make dependant on model sizes
 
-	//ensure prev worldviewposition updated to prevent motion blur smear on first frame
-	D3DXMATRIX mViewProj;
-    mViewProj = *m_pCinematicCamera->GetViewMatrix() * *m_pCinematicCamera->GetProjMatrix();
+	//restart the simulation with both states at the latest time, so there is nothing to interpolate
 	for( UINT model = 0; model < m_NumModels; ++model )
 	{
-		m_pModels[model].m_Mesh.TransformMeshWithInterpolation( &m_mCenter, 0.0f );
+		m_pModels[model].m_Mesh.TransformMeshWithInterpolation( &m_mCenter, m_SimTime );
+	}
+	StoreSimulationState( 0 );
+	StoreSimulationState( 1 );
+	D3DXMATRIX mView;
+	D3DXMatrixInverse( &mView, NULL, &m_mCameraWorld[ m_SimStateIndex ] );
+	m_pCinematicCamera->SetViewMatrix( &mView );
 
-		for( UINT frame = 0; frame < m_pModels[model].m_Mesh.GetNumFrames(); ++frame )
+	//ensure prev worldviewposition updated to prevent motion blur smear on first frame
+	D3DXMATRIX mViewProj;
+    mViewProj = mView * *m_pCinematicCamera->GetProjMatrix();
+	m_mViewProj = mViewProj;
+	m_mPrevViewProj = mViewProj;
+	m_mFrameCameraWorld = m_mCameraWorld[ m_SimStateIndex ];
+	m_mFrameView = mView;
+	m_mFrameProj = *m_pCinematicCamera->GetProjMatrix();
+
+	//the two history slots written below hold all models projected with this view projection
+	for( int i = 0; i < 3; i++ )
+	{
+		m_mSlotViewProj[i] = mViewProj;
+		m_bSlotViewProjValid[i] = ( i == m_CurrentFrameIndex || i == m_CurrentFrameIndex + 1 );
+	}
+	m_CurrViewProjSlot = m_CurrentFrameIndex;
+	m_PrevViewProjSlot = m_CurrentFrameIndex + 1;
+	if( m_pMatrixArena )
+	{
+		const D3DXMATRIX* pSimWorlds = GetMatrixSection( cSectionSimWorlds + m_SimStateIndex );
+		D3DXMATRIX* pWorlds = GetMatrixSection( cSectionWorlds );
+		D3DXMATRIX* pCurrViewProjs = GetMatrixSection( cSectionWorldViewProjections + m_CurrViewProjSlot );
+		D3DXMATRIX* pPrevViewProjs = GetMatrixSection( cSectionWorldViewProjections + m_PrevViewProjSlot );
+		for( UINT index = 0; index < m_pModelFrameStart[ m_NumModels ]; ++index )
 		{
-			const D3DXMATRIX* pMat = m_pModels[model].m_Mesh.GetWorldMatrix( frame );
-
-			m_pModels[model].m_pmWorldCurrViewProjections = m_pModels[model].m_pmWorldViewProjections[m_CurrentFrameIndex];
-			m_pModels[model].m_pmWorldPrevViewProjections = m_pModels[model].m_pmWorldViewProjections[m_CurrentFrameIndex+1];
-
-			m_pModels[model].m_pmWorldCurrViewProjections[ frame ] = *pMat * mViewProj;
-			m_pModels[model].m_pmWorldPrevViewProjections[ frame ] = m_pModels[model].m_pmWorldCurrViewProjections[ frame ];
-
+			pWorlds[ index ] = pSimWorlds[ index ];
+			pCurrViewProjs[ index ] = pSimWorlds[ index ] * mViewProj;
+			pPrevViewProjs[ index ] = pCurrViewProjs[ index ];
 		}
+
+		//the culling hierarchy is built over the restarted state, and refit from it
+		UpdateCullItemBounds( pWorlds, m_NumCullItems );
+		m_CullHierarchy.Build( m_NumCullItems, m_pCullItemBounds );
+		UpdateVisibility();
 	}
 
 	m_ViewportWidth = (float)pBackBufferSurfaceDesc->Width;
@@ -511,18 +818,359 @@ void    Scene::OnFramePaused( int RT )
 	int CurrentFrameIndex = m_TrackIndex[RT];
 	int PrevFrameIndex = (CurrentFrameIndex+2)%3;
 
+	m_CurrViewProjSlot = CurrentFrameIndex;
+	m_PrevViewProjSlot = PrevFrameIndex;
+}
+
+//--------------------------------------------------------------------------------------
+// Copy the mesh transforms and camera into simulation state 'state'
+//--------------------------------------------------------------------------------------
+void    Scene::StoreSimulationState( UINT state )
+{
+	for( UINT model = 0; model < m_NumModels && m_pMatrixArena; ++model )
+	{
+		D3DXMATRIX* pSimWorlds = GetMatrixSection( cSectionSimWorlds + state ) + m_pModelFrameStart[ model ];
+		for( UINT frame = 0; frame < m_pModels[model].m_Mesh.GetNumFrames(); ++frame )
+		{
+			pSimWorlds[ frame ] = *m_pModels[model].m_Mesh.GetWorldMatrix( frame );
+		}
+	}
+
+	StoreCameraState( state );
+}
+
+void    Scene::StoreCameraState( UINT state )
+{
+	//cinematic camera
+	if( m_pCinematicCamera->m_bValidModel )
+	{
+		m_mCameraWorld[ state ] = GetSimWorld( state, m_pCinematicCamera->m_ModelNum, m_pCinematicCamera->m_FrameNum );
+	}
+	else
+	{
+		m_mCameraWorld[ state ] = *m_pCinematicCamera->GetWorldMatrix();
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Simulation step - not called when scene paused
+//--------------------------------------------------------------------------------------
+void    Scene::Simulate( double fTime, float fStepTime )
+{
+	m_SimTime = fTime;
+	m_SimStateIndex = 1 - m_SimStateIndex;
+
+	//transform all models first, storing their state
+	m_NumMatricesRecomputing += TransformModels( fTime, m_SimStateIndex );
+
+	//free camera input is integrated at the step rate too
+	if( !m_pCinematicCamera->m_bValidModel )
+	{
+		m_pCinematicCamera->FrameMove( fStepTime );
+	}
+
+	StoreCameraState( m_SimStateIndex );
+}
+
+//--------------------------------------------------------------------------------------
+// Animate all models at time fTime into simulation state 'state', a task per model.
+// Returns the number of frame matrices transformed.
+//--------------------------------------------------------------------------------------
+UINT    Scene::TransformModels( double fTime, UINT state )
+{
+	if( !m_pMatrixArena )
+	{
+		return 0;
+	}
+	TransformModelsJob job;
+	job.pModels = m_pModels;
+	job.pModelFrameStart = m_pModelFrameStart;
+	job.pWorld = &m_mCenter;
+	job.time = fTime;
+	job.pSimWorlds = GetMatrixSection( cSectionSimWorlds + state );
+	RunTasks( TransformModelTask, &job, m_NumModels );
+	return m_pModelFrameStart[ m_NumModels ] - m_NumStaticFrames;
+}
+
+//--------------------------------------------------------------------------------------
+// Interpolate the simulated states and project all models' frames into frame
+// 'frameIndex' of the view projection history, in tasks of cFramesPerTask frames.
+// Returns the number of matrices interpolated or projected.
+//--------------------------------------------------------------------------------------
+UINT    Scene::UpdateModelMatrices( float interpolation, int frameIndex )
+{
+	if( !m_pMatrixArena )
+	{
+		return 0;
+	}
+	bool bUpdateStatic = !m_bSlotViewProjValid[ frameIndex ] || m_mSlotViewProj[ frameIndex ] != m_mViewProj;
+	m_mSlotViewProj[ frameIndex ] = m_mViewProj;
+	m_bSlotViewProjValid[ frameIndex ] = true;
+
+
+	UpdateMatricesJob job;
+	job.pModels = m_pModels;
+	job.pModelFrameStart = m_pModelFrameStart;
+	job.numModels = m_NumModels;
+	job.pPrevSimWorlds = GetMatrixSection( cSectionSimWorlds + 1 - m_SimStateIndex );
+	job.pCurrSimWorlds = GetMatrixSection( cSectionSimWorlds + m_SimStateIndex );
+	job.pWorlds = GetMatrixSection( cSectionWorlds );
+	job.pWorldViewProjections = GetMatrixSection( cSectionWorldViewProjections + frameIndex );
+	job.interpolation = interpolation;
+	job.viewProj = m_mViewProj;
+	job.bUpdateStatic = bUpdateStatic;
+	UINT numFrames = m_pModelFrameStart[ m_NumModels ];
+	RunTasks( UpdateMatricesTask, &job, ( numFrames + cFramesPerTask - 1 ) / cFramesPerTask );
+
+	// dynamic frames are interpolated then projected
+	UINT numDynamicFrames = numFrames - m_NumStaticFrames;
+	return 2 * numDynamicFrames + ( bUpdateStatic ? m_NumStaticFrames : 0 );
+}
+
+//--------------------------------------------------------------------------------------
+// Matrix arena access. A section holds a matrix for every frame of all models, with
+// each model's frames starting at m_pModelFrameStart.
+//--------------------------------------------------------------------------------------
+D3DXMATRIX* Scene::GetMatrixSection( UINT section ) const
+{
+	return m_pMatrixArena + section * m_pModelFrameStart[ m_NumModels ];
+}
+
+const D3DXMATRIX& Scene::GetSimWorld( UINT state, UINT model, UINT frame ) const
+{
+	return GetMatrixSection( cSectionSimWorlds + state )[ m_pModelFrameStart[ model ] + frame ];
+}
 
+bool    Scene::LatestSimulationStateMatchesMeshes() const
+{
+	if( !m_pMatrixArena )
+	{
+		return false;
+	}
 	for( UINT model = 0; model < m_NumModels; ++model )
 	{
-		m_pModels[model].m_pmWorldCurrViewProjections = m_pModels[model].m_pmWorldViewProjections[CurrentFrameIndex];
-		m_pModels[model].m_pmWorldPrevViewProjections = m_pModels[model].m_pmWorldViewProjections[PrevFrameIndex];
+		for( UINT frame = 0; frame < m_pModels[model].m_Mesh.GetNumFrames(); ++frame )
+		{
+			if( GetSimWorld( m_SimStateIndex, model, frame ) != *m_pModels[model].m_Mesh.GetWorldMatrix( frame ) )
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void    Scene::RunTasks( TaskPoolFunc pFunc, void* pArg, UINT taskCount )
+{
+	if( m_pTaskPool )
+	{
+		m_pTaskPool->Run( pFunc, pArg, taskCount );
+		return;
+	}
+	for( UINT task = 0; task < taskCount; ++task )
+	{
+		pFunc( pArg, 0, task, taskCount );
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Repeat the last model updates, at the latest simulated time and this frame's
+// interpolation, so the same matrices are written again
+//--------------------------------------------------------------------------------------
+double  Scene::BenchmarkModelUpdate( UINT iterations )
+{
+	if( 0 == iterations )
+	{
+		return 0.0;
+	}
+
+	CDXUTTimer* pTimer = DXUTGetGlobalTimer();
+	double startTime = pTimer->GetAbsoluteTime();
+	for( UINT iteration = 0; iteration < iterations; ++iteration )
+	{
+		TransformModels( m_SimTime, m_SimStateIndex );
+		UpdateModelMatrices( m_Interpolation, m_CurrentFrameIndex );
+	}
+	return ( pTimer->GetAbsoluteTime() - startTime ) / iterations;
+}
+
+//--------------------------------------------------------------------------------------
+// World bounds of the first numItems culling items from their frames' world matrices
+//--------------------------------------------------------------------------------------
+void    Scene::UpdateCullItemBounds( const D3DXMATRIX* pWorlds, UINT numItems )
+{
+	for( UINT item = 0; item < numItems; ++item )
+	{
+		const CullItem& rItem = m_pCullItems[ item ];
+		TransformBounds( rItem.localBounds, (const float*)&pWorlds[ rItem.frame ], m_pCullItemBounds + item * cBoundsFloats );
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Refit the culling hierarchy to the dynamic models' world matrices this frame and cull
+// it against the camera, marking the frames RenderScene draws
+//--------------------------------------------------------------------------------------
+void    Scene::UpdateVisibility()
+{
+	if( !m_pMatrixArena || m_CullHierarchy.GetNumItems() != m_NumCullItems )
+	{
+		return;
+	}
+
+	CDXUTTimer* pTimer = DXUTGetGlobalTimer();
+	double startTime = pTimer->GetAbsoluteTime();
+	if( m_NumDynamicCullItems )
+	{
+		UpdateCullItemBounds( GetMatrixSection( cSectionWorlds ), m_NumDynamicCullItems );
+		m_CullHierarchy.Refit( m_pCullItemBounds );
+	}
+	Frustum frustum;
+	ExtractFrustum( (const float*)&m_mViewProj, &frustum );
+	m_CullHierarchy.Cull( frustum, m_pCullItemVisible );
+	m_CullTime = pTimer->GetAbsoluteTime() - startTime;
+
+	for( UINT item = 0; item < m_NumCullItems; ++item )
+	{
+		m_pFrameVisible[ m_pCullItems[ item ].frame ] = m_pCullItemVisible[ item ];
+	}
+	CountCulledDraws( m_pCullItemVisible, &m_NumDraws, &m_NumCulledDraws );
+}
+
+void    Scene::CountCulledDraws( const unsigned char* pVisible, UINT* pNumDraws, UINT* pNumCulledDraws ) const
+{
+	UINT numDraws = 0;
+	UINT numCulledDraws = 0;
+	for( UINT item = 0; item < m_NumCullItems; ++item )
+	{
+		const CullItem& rItem = m_pCullItems[ item ];
+		if( !m_bShowCameras && ModelContainer::CAMERA == m_pModels[ rItem.model ].m_Type )
+		{
+			continue;
+		}
+		numDraws += rItem.numDraws;
+		numCulledDraws += pVisible[ item ] ? 0 : rItem.numDraws;
+	}
+	*pNumDraws = numDraws;
+	*pNumCulledDraws = numCulledDraws;
+}
+
+void    Scene::SetFrustumCulling( bool bValue )
+{
+	m_bFrustumCulling = bValue;
+	if( m_bFrustumCulling )
+	{
+		UpdateVisibility();
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Each step animates the models and the camera into the latest simulation state, as
+// Simulate() would, then times the refit and the culls of that step. The latest state
+// is transformed again at the end.
+//--------------------------------------------------------------------------------------
+bool    Scene::BenchmarkCulling( CullingBenchmarkResults* pResults )
+{
+	memset( pResults, 0, sizeof( *pResults ) );
+	if( !m_pMatrixArena || m_CullHierarchy.GetNumItems() != m_NumCullItems )
+	{
+		return false;
+	}
+
+	// the first camera with an animated path
+	UINT cameraModel = 0;
+	while( cameraModel < m_NumModels &&
+		( ModelContainer::CAMERA != m_pModels[ cameraModel ].m_Type || m_pModels[ cameraModel ].m_bStatic ) )
+	{
+		++cameraModel;
 	}
+	UINT numKeys = 0;
+	float keyTime = 0.0f;
+	if( cameraModel == m_NumModels || !m_pModels[ cameraModel ].m_Mesh.GetAnimationProperties( &numKeys, &keyTime ) )
+	{
+		return false;
+	}
+	UINT cameraFrame = GetCameraFrame( cameraModel );
+
+	pResults->numSteps = (UINT)( numKeys * keyTime / cCullBenchmarkStepTime );
+	if( 0 == pResults->numSteps )
+	{
+		pResults->numSteps = 1;
+	}
+	pResults->numItems = m_NumCullItems;
+	pResults->numNodes = m_CullHierarchy.GetNumNodes();
+	pResults->bResultsMatch = true;
+
+	unsigned char* pScalarVisible = new unsigned char[ 2 * m_NumCullItems ];
+	unsigned char* pBruteForceVisible = pScalarVisible + m_NumCullItems;
+	const D3DXMATRIX* pSimWorlds = GetMatrixSection( cSectionSimWorlds + m_SimStateIndex );
+	CDXUTTimer* pTimer = DXUTGetGlobalTimer();
+	double culledDraws = 0.0;
+	for( UINT step = 0; step < pResults->numSteps; ++step )
+	{
+		TransformModels( step * cCullBenchmarkStepTime, m_SimStateIndex );
+
+		double startTime = pTimer->GetAbsoluteTime();
+		UpdateCullItemBounds( pSimWorlds, m_NumDynamicCullItems );
+		m_CullHierarchy.Refit( m_pCullItemBounds );
+		pResults->refitTime += pTimer->GetAbsoluteTime() - startTime;
+
+		D3DXMATRIX mView;
+		D3DXMatrixInverse( &mView, NULL, &GetSimWorld( m_SimStateIndex, cameraModel, cameraFrame ) );
+		D3DXMATRIX mViewProj = mView * *m_pCinematicCamera->GetProjMatrix();
+		Frustum frustum;
+		ExtractFrustum( (const float*)&mViewProj, &frustum );
+
+		startTime = pTimer->GetAbsoluteTime();
+		for( UINT repeat = 0; repeat < cCullBenchmarkRepeats; ++repeat )
+		{
+			m_CullHierarchy.Cull( frustum, m_pCullItemVisible );
+		}
+		double endTime = pTimer->GetAbsoluteTime();
+		pResults->hierarchyTime += ( endTime - startTime ) / cCullBenchmarkRepeats;
+
+		startTime = endTime;
+		for( UINT repeat = 0; repeat < cCullBenchmarkRepeats; ++repeat )
+		{
+			m_CullHierarchy.CullScalar( frustum, pScalarVisible );
+		}
+		endTime = pTimer->GetAbsoluteTime();
+		pResults->hierarchyScalarTime += ( endTime - startTime ) / cCullBenchmarkRepeats;
+
+		startTime = endTime;
+		for( UINT repeat = 0; repeat < cCullBenchmarkRepeats; ++repeat )
+		{
+			BoundingVolumeHierarchy::CullItems( m_NumCullItems, m_pCullItemBounds, frustum, pBruteForceVisible );
+		}
+		endTime = pTimer->GetAbsoluteTime();
+		pResults->bruteForceTime += ( endTime - startTime ) / cCullBenchmarkRepeats;
+
+		if( 0 != memcmp( m_pCullItemVisible, pScalarVisible, m_NumCullItems ) ||
+			0 != memcmp( m_pCullItemVisible, pBruteForceVisible, m_NumCullItems ) )
+		{
+			pResults->bResultsMatch = false;
+		}
+		UINT numCulledDraws = 0;
+		CountCulledDraws( m_pCullItemVisible, &pResults->numDraws, &numCulledDraws );
+		culledDraws += numCulledDraws;
+	}
+	delete[] pScalarVisible;
+
+	pResults->averageCulledDraws = culledDraws / pResults->numSteps;
+	pResults->refitTime /= pResults->numSteps;
+	pResults->hierarchyTime /= pResults->numSteps;
+	pResults->hierarchyScalarTime /= pResults->numSteps;
+	pResults->bruteForceTime /= pResults->numSteps;
+
+	//back to the latest simulated state, and this frame's visibility
+	TransformModels( m_SimTime, m_SimStateIndex );
+	UpdateVisibility();
+	return true;
 }
 
 //--------------------------------------------------------------------------------------
 // Frame move - not updated when scene paused
 //--------------------------------------------------------------------------------------
-void    Scene::OnFrameMove( double fTime, float fElapsedTime, int RT )
+void    Scene::OnFrameMove( float interpolation, int RT )
 {
 
 	int PrevFrameIndex = m_CurrentFrameIndex;
@@ -530,43 +1178,94 @@ void    Scene::OnFrameMove( double fTime, float fElapsedTime, int RT )
 
 	m_TrackIndex[RT] = m_CurrentFrameIndex;
 
+	UINT currState = m_SimStateIndex;
+	UINT prevState = 1 - m_SimStateIndex;
 
-	//transform all models first
-	for( UINT model = 0; model < m_NumModels; ++model )
+	//camera, the free camera's movement is from its own position so is unaffected by setting the view
+	D3DXMATRIX cameraWorld;
+	InterpolateMatrix( &cameraWorld, &m_mCameraWorld[ prevState ], &m_mCameraWorld[ currState ], interpolation );
+	m_mPrevViewProj = m_mViewProj;
+	if( cameraWorld != m_mFrameCameraWorld || *m_pCinematicCamera->GetProjMatrix() != m_mFrameProj )
 	{
-		m_pModels[model].m_Mesh.TransformMeshWithInterpolation( &m_mCenter, fTime );
+		m_mFrameCameraWorld = cameraWorld;
+		m_mFrameProj = *m_pCinematicCamera->GetProjMatrix();
+		D3DXMatrixInverse( &m_mFrameView, NULL, &cameraWorld );
+		m_mViewProj = m_mFrameView * m_mFrameProj;
+		m_NumMatricesRecomputing += 2;
 	}
+	m_pCinematicCamera->SetViewMatrix( &m_mFrameView );
 
-	//cinematic camera
-	if( m_pCinematicCamera->m_bValidModel )
-	{
-		const D3DXMATRIX* pWorld = m_pModels[m_pCinematicCamera->m_ModelNum].m_Mesh.GetWorldMatrix( m_pCinematicCamera->m_FrameNum );
-		 D3DXMATRIX View;
-		//set camera world matrix from this.
-		D3DXMatrixInverse( &View, NULL, pWorld );
-		m_pCinematicCamera->SetViewMatrix( &View );
-	}
-	else
+	//update model matrices
+	m_Interpolation = interpolation;
+	m_CurrViewProjSlot = m_CurrentFrameIndex;
+	m_PrevViewProjSlot = PrevFrameIndex;
+
+	//now do actual curr update, across the task pool
+	m_NumMatricesRecomputing += UpdateModelMatrices( interpolation, m_CurrentFrameIndex );
+	m_NumMatricesRecomputed = m_NumMatricesRecomputing;
+	m_NumMatricesRecomputing = 0;
+
+	if( m_bFrustumCulling )
 	{
-		  m_pCinematicCamera->FrameMove( fElapsedTime );
+		UpdateVisibility();
 	}
+}
 
-	//update model matrices
-	D3DXMATRIX mViewProj;
-    mViewProj = *m_pCinematicCamera->GetViewMatrix() * *m_pCinematicCamera->GetProjMatrix();
-	for( UINT model = 0; model < m_NumModels; ++model )
+//--------------------------------------------------------------------------------------
+// Estimate camera motion by reprojecting a grid of screen points at the depth of the
+// scene centre into last frame's view. Cheaper than reading back the velocity buffer
+// and sufficient to tell which screen axis has more motion blur.
+//--------------------------------------------------------------------------------------
+void	Scene::GetCameraScreenMotion( float* pMotionX, float* pMotionY ) const
+{
+	float motionX = 0.0f;
+	float motionY = 0.0f;
+
+	D3DXMATRIX mInvViewProj;
+	if( D3DXMatrixInverse( &mInvViewProj, NULL, &m_mViewProj ) )
 	{
-		m_pModels[model].m_pmWorldCurrViewProjections = m_pModels[model].m_pmWorldViewProjections[m_CurrentFrameIndex];
-		m_pModels[model].m_pmWorldPrevViewProjections = m_pModels[model].m_pmWorldViewProjections[PrevFrameIndex];
-		
-		for( UINT frame = 0; frame < m_pModels[model].m_Mesh.GetNumFrames(); ++frame )
+		D3DXMATRIX mReproject = mInvViewProj * m_mPrevViewProj;
+
+		// models are centred on the origin, so use its depth
+		D3DXVECTOR4 center;
+		D3DXVECTOR3 origin( 0.0f, 0.0f, 0.0f );
+		D3DXVec3Transform( &center, &origin, &m_mViewProj );
+		float depth = 0.99f;
+		if( center.w > 0.0f && center.z > 0.0f && center.z < center.w )
 		{
-			//now do actual curr update
-			const D3DXMATRIX* pMat = m_pModels[model].m_Mesh.GetWorldMatrix( frame );
-			m_pModels[model].m_pmWorldCurrViewProjections[ frame ] = *pMat * mViewProj;
+			depth = center.z / center.w;
+		}
+
+		static const float gridPoints[3] = { -0.5f, 0.0f, 0.5f };
+		UINT numPoints = 0;
+		for( UINT y = 0; y < 3; ++y )
+		{
+			for( UINT x = 0; x < 3; ++x )
+			{
+				D3DXVECTOR3 curr( gridPoints[x], gridPoints[y], depth );
+				D3DXVECTOR4 prev;
+				D3DXVec3Transform( &prev, &curr, &mReproject );
+				if( prev.w <= 0.0f )
+				{
+					// behind the camera last frame
+					continue;
+				}
+				motionX += fabs( prev.x / prev.w - curr.x );
+				motionY += fabs( prev.y / prev.w - curr.y );
+				++numPoints;
+			}
+		}
+
+		if( numPoints )
+		{
+			// NDC covers two units across the back buffer
+			motionX *= 0.5f * m_ViewportWidth / numPoints;
+			motionY *= 0.5f * m_ViewportHeight / numPoints;
 		}
 	}
 
+	*pMotionX = motionX;
+	*pMotionY = motionY;
 }
 
 //--------------------------------------------------------------------------------------
@@ -628,6 +1327,12 @@ void    Scene::RenderScene( ID3D11Device* pD3DDevice, ID3D11DeviceContext* pD3DI
 		}
 
 
+		// this model's frames in the arena sections
+		const D3DXMATRIX* pWorlds = GetMatrixSection( cSectionWorlds ) + m_pModelFrameStart[ model ];
+		const D3DXMATRIX* pCurrViewProjs = GetMatrixSection( cSectionWorldViewProjections + m_CurrViewProjSlot ) + m_pModelFrameStart[ model ];
+		const D3DXMATRIX* pPrevViewProjs = GetMatrixSection( cSectionWorldViewProjections + m_PrevViewProjSlot ) + m_pModelFrameStart[ model ];
+		const unsigned char* pFrameVisible = m_pFrameVisible + m_pModelFrameStart[ model ];
+
 		int lastSetMatrixFrame = -1;
 		for( UINT frame = 0; frame < rModel.m_Mesh.GetNumFrames(); ++frame )
 		{
@@ -637,11 +1342,14 @@ void    Scene::RenderScene( ID3D11Device* pD3DDevice, ID3D11DeviceContext* pD3DI
 			{
 				continue;
 			}
-
+			if( m_bFrustumCulling && !pFrameVisible[ frame ] )
+			{
+				continue;
+			}
 
 			// Camera world view matrices
 			D3DXMATRIX mWorld, mView;
-			mWorld = *rMesh.GetWorldMatrix( frame );
+			mWorld = pWorlds[ frame ];
 			mView = *m_pCinematicCamera->GetViewMatrix();
 			D3DXMATRIX mWorldView;
 			mWorldView = mWorld * mView;
@@ -666,7 +1374,7 @@ void    Scene::RenderScene( ID3D11Device* pD3DDevice, ID3D11DeviceContext* pD3DI
 				}
 				else
 				{
-					D3DXMATRIX mWorldViewProj  = rModel.m_pmWorldCurrViewProjections[ frame ];
+					D3DXMATRIX mWorldViewProj  = pCurrViewProjs[ frame ];
 					D3DXVECTOR3 meshCenterProj;
 					D3DXVec3TransformCoord(  &meshCenterProj, &meshCenterOrig, &mWorldViewProj );
 					D3DXVECTOR3 meshExtents = rMesh.GetMeshBBoxExtents( meshIndex );
@@ -695,15 +1403,15 @@ void    Scene::RenderScene( ID3D11Device* pD3DDevice, ID3D11DeviceContext* pD3DI
 					//have a jitter vector, so jitter both matrices to prevent motion blur smearing of jitter
 					D3DXMATRIX jitterMatrix;
 					D3DXMatrixTranslation( &jitterMatrix, 2.0f*pJitter->x, 2.0f*pJitter->y, 0.0f );
-					D3DXMATRIX jitteredMatrix = rModel.m_pmWorldCurrViewProjections[ frame ] * jitterMatrix;
+					D3DXMATRIX jitteredMatrix = pCurrViewProjs[ frame ] * jitterMatrix;
 					D3DXMatrixTranspose( &pVSPerObject->m_mWorldViewProj, &jitteredMatrix );
-					jitteredMatrix = rModel.m_pmWorldPrevViewProjections[ frame ] * jitterMatrix;
+					jitteredMatrix = pPrevViewProjs[ frame ] * jitterMatrix;
 					D3DXMatrixTranspose( &pVSPerObject->m_mPrevWorldViewProj, &jitteredMatrix );
 				}
 				else
 				{
-						D3DXMatrixTranspose( &pVSPerObject->m_mWorldViewProj, &rModel.m_pmWorldCurrViewProjections[ frame ] );
-						D3DXMatrixTranspose( &pVSPerObject->m_mPrevWorldViewProj, &rModel.m_pmWorldPrevViewProjections[ frame ]  );
+						D3DXMatrixTranspose( &pVSPerObject->m_mWorldViewProj, &pCurrViewProjs[ frame ] );
+						D3DXMatrixTranspose( &pVSPerObject->m_mPrevWorldViewProj, &pPrevViewProjs[ frame ]  );
 				}
 				D3DXMatrixTranspose( &pVSPerObject->m_mWorld, &mWorld );
 				pVSPerObject->m_vEyePos = D3DXVECTOR4( m_pCinematicCamera->GetEyePt()->x, m_pCinematicCamera->GetEyePt()->y, m_pCinematicCamera->GetEyePt()->z,
@@ -794,6 +1502,24 @@ UINT Scene::GetCameraModel( UINT camera ) const
 
 }
 
+//--------------------------------------------------------------------------------------
+// Returns the frame of a camera model the view is taken from, its last frame with a mesh
+//--------------------------------------------------------------------------------------
+UINT Scene::GetCameraFrame( UINT model ) const
+{
+	UINT cameraFrame = 0;	//ensure we have a fallback in case of no models
+	for( UINT frame = 0; frame < m_pModels[model].m_Mesh.GetNumFrames(); ++frame )
+	{
+		// Camera world view matrices
+		UINT mesh = m_pModels[model].m_Mesh.GetFrame( frame )->Mesh;
+		if( INVALID_MESH != mesh )
+		{
+			cameraFrame = frame;
+		}
+	}
+	return cameraFrame;
+}
+
 
 //--------------------------------------------------------------------------------------
 // Returns name of camera from index
@@ -828,18 +1554,22 @@ void	Scene::SetCamera( UINT camera )
 		{
 			m_pCinematicCamera->m_bValidModel = true;
 			m_pCinematicCamera->m_ModelNum = model;
-			m_pCinematicCamera->m_FrameNum = 0;	//ensure we have a fallback in case of no models
-			for( UINT frame = 0; frame < m_pModels[m_pCinematicCamera->m_ModelNum].m_Mesh.GetNumFrames(); ++frame )
-			{
-				// Camera world view matrices
-				UINT mesh = m_pModels[m_pCinematicCamera->m_ModelNum].m_Mesh.GetFrame( frame )->Mesh;
-				if( INVALID_MESH != mesh )
-				{
-					m_pCinematicCamera->m_FrameNum = frame;
-				}
-			}
-
+			m_pCinematicCamera->m_FrameNum = GetCameraFrame( model );
 		}
 	}
 
+	//set both simulated states from the new camera, so there is no interpolation from the old one
+	if( m_pCinematicCamera->m_bValidModel )
+	{
+		for( UINT state = 0; state < 2; ++state )
+		{
+			m_mCameraWorld[ state ] = GetSimWorld( state, m_pCinematicCamera->m_ModelNum, m_pCinematicCamera->m_FrameNum );
+		}
+	}
+	else
+	{
+		//the free camera's world matrix is its own, unlike the view matrix rendering overrides
+		m_mCameraWorld[0] = *m_pCinematicCamera->GetWorldMatrix();
+		m_mCameraWorld[1] = m_mCameraWorld[0];
+	}
 }
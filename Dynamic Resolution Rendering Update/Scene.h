@@ -19,10 +19,31 @@
 #include "DXUTmisc.h"
 #include "DXUTcamera.h"
 #include "SceneDescription.h"
+#include "TaskPool.h"
+#include "FrustumCulling.h"
 
 // Forward declarations
 class ModelContainer;
 class CinematicCamera;
+struct CullItem;
+
+//--------------------------------------------------------------------------------------
+// Frustum culling along the cinematic camera's path, per step of the path. The times
+// are seconds per step, the cull times not including the refit.
+//--------------------------------------------------------------------------------------
+struct CullingBenchmarkResults
+{
+	UINT	numSteps;
+	UINT	numItems;				// frames with a mesh
+	UINT	numNodes;
+	UINT	numDraws;				// subsets of the shown models
+	double	averageCulledDraws;
+	double	refitTime;
+	double	hierarchyTime;			// SSE where available
+	double	hierarchyScalarTime;
+	double	bruteForceTime;			// every item tested
+	bool	bResultsMatch;			// all three culled the same items at every step
+};
 
 //--------------------------------------------------------------------------------------
 // Basic Scene handling - 
@@ -38,6 +59,10 @@ public:
 	~Scene();
 
     HRESULT OnD3D11CreateDevice(ID3D11Device* pD3DDevice, ID3D11DeviceContext* pImmediateContext);
+	// The part of OnD3D11CreateDevice() which creates no device resources, loading the
+	// models and setting up the simulation. With a NULL device the scene simulates and
+	// culls but can't render, as in the unit tests.
+	HRESULT LoadModels( ID3D11Device* pD3DDevice, wchar_t* pSceneDescriptionPath );
     void    OnD3D11ReleasingSwapChain();
     void    OnD3D11DestroyDevice();
 
@@ -46,7 +71,13 @@ public:
 												const DXGI_SURFACE_DESC* pBackBufferSurfaceDesc );
 
 	void	HandleMessages( HWND hWnd, UINT uMsg, WPARAM wParam, LPARAM lParam );
-	void    OnFrameMove( double fTime, float fElapsedTime, int RT );
+
+	// Advance the simulation one fixed step to time fTime. The last two simulated states
+	// are kept for OnFrameMove() to interpolate between.
+	void    Simulate( double fTime, float fStepTime );
+	// Set up this frame's matrices, interpolation of 0 to 1 from the previous simulated
+	// state to the latest
+	void    OnFrameMove( float interpolation, int RT );
 	void    OnFramePaused(int RT );
 	
 	void    RenderScene( ID3D11Device* pD3DDevice, ID3D11DeviceContext* pD3DImmediateContext, const D3DXVECTOR2* pJitter );
@@ -69,11 +100,75 @@ public:
 	const wchar_t* GetCameraName( UINT camera ) const;
 	void SetCamera( UINT camera );
 
+	// Average screen space motion in back buffer pixels due to the camera over the last frame
+	void GetCameraScreenMotion( float* pMotionX, float* pMotionY ) const;
+
+	// Pool for the per model animation and matrix updates, which run on the calling thread
+	// without one. The results are the same whatever the number of threads.
+	void SetTaskPool( TaskPool* pTaskPool )
+	{
+		m_pTaskPool = pTaskPool;
+	}
+
+	// Seconds per update of the model animation and matrices, averaged over iterations.
+	// Repeats the last updates, so leaves the scene unchanged.
+	double BenchmarkModelUpdate( UINT iterations );
+
+	// Matrices recomputed for the last frame, by its simulation steps and frame move.
+	// Static models are transformed on load and only reprojected when the camera moves.
+	UINT GetNumMatricesRecomputed() const
+	{
+		return m_NumMatricesRecomputed;
+	}
+	// Whether the latest simulated state holds every model's world matrices as its mesh
+	// was last transformed. For tests, see UnitTests/MeshTests.cpp.
+	bool LatestSimulationStateMatchesMeshes() const;
+
+	// Frustum culling of the frames with a mesh against the camera, with a bounding
+	// volume hierarchy over their world bounds refit each frame for animated models.
+	// Frames culled are not drawn.
+	void SetFrustumCulling( bool bValue );
+	bool GetFrustumCulling() const
+	{
+		return m_bFrustumCulling;
+	}
+	// Draws of the shown models this frame, each subset of a mesh, and those culled
+	UINT GetNumDraws() const
+	{
+		return m_NumDraws;
+	}
+	UINT GetNumCulledDraws() const
+	{
+		return m_NumCulledDraws;
+	}
+	// Seconds refitting and culling this frame
+	double GetCullTime() const
+	{
+		return m_CullTime;
+	}
+
+	// Steps the cinematic camera and animated models along the camera's path at 60Hz
+	// without rendering, timing the culling of each step with the hierarchy and by
+	// testing every item. Restores the scene's state. Returns false without a camera path.
+	// Run by UnitTests/MeshTests.cpp.
+	bool BenchmarkCulling( CullingBenchmarkResults* pResults );
+
 	int							m_CurrentFrameIndex;
 	int							m_TrackIndex[2];
 
 private:
 	UINT GetCameraModel( UINT camera ) const;
+	UINT GetCameraFrame( UINT model ) const;
+	void StoreSimulationState( UINT state );
+	void StoreCameraState( UINT state );
+	UINT TransformModels( double fTime, UINT state );
+	UINT UpdateModelMatrices( float interpolation, int frameIndex );
+	void RunTasks( TaskPoolFunc pFunc, void* pArg, UINT taskCount );
+	D3DXMATRIX* GetMatrixSection( UINT section ) const;
+	const D3DXMATRIX& GetSimWorld( UINT state, UINT model, UINT frame ) const;
+	void UpdateCullItemBounds( const D3DXMATRIX* pWorlds, UINT numItems );
+	void UpdateVisibility();
+	void CountCulledDraws( const unsigned char* pVisible, UINT* pNumDraws, UINT* pNumCulledDraws ) const;
 
 	// Model related
 	SceneDescription			m_SceneDesc;
@@ -81,9 +176,55 @@ private:
 	ModelContainer*				m_pModels;
 
 	D3DXMATRIX					m_mCenter;
+	D3DXMATRIX					m_mViewProj;		// camera view projection this frame
+	D3DXMATRIX					m_mPrevViewProj;	// and last frame
 	D3DXVECTOR3					m_Center; 
 	D3DXVECTOR3					m_Extents;
 
+	// Simulation state
+	double						m_SimTime;				// time of the latest simulated state
+	UINT						m_SimStateIndex;		// latest of the two simulated states
+	D3DXMATRIX					m_mCameraWorld[2];		// simulated camera, as the inverse view matrix
+	float						m_Interpolation;		// between the simulated states, this frame
+
+	// Per model updates
+	TaskPool*					m_pTaskPool;
+	UINT*						m_pModelFrameStart;		// first frame of each model counting all models' frames, then the total
+	UINT						m_NumStaticFrames;		// frames of static models
+
+	// One 16 byte aligned allocation for all models' frame matrices, in the sections of
+	// the cSection constants in Scene.cpp: the ring of world view projections indexed
+	// by history slot, the two simulated states and this frame's world matrices
+	D3DXMATRIX*					m_pMatrixArena;
+	int							m_CurrViewProjSlot;		// ring slots rendered as the current and previous
+	int							m_PrevViewProjSlot;		// world view projections
+
+	// Dirty tracking. Static models' projections in a history slot are up to date while
+	// the view projection is the one they were projected with, and the camera matrices
+	// are kept while the interpolated camera and projection are unchanged.
+	D3DXMATRIX					m_mSlotViewProj[3];		// view projection of the static models in each history slot
+	bool						m_bSlotViewProjValid[3];
+	D3DXMATRIX					m_mFrameCameraWorld;	// interpolated camera this frame
+	D3DXMATRIX					m_mFrameView;
+	D3DXMATRIX					m_mFrameProj;
+	UINT						m_NumMatricesRecomputing;	// since the last frame move
+	UINT						m_NumMatricesRecomputed;	// for the last frame
+
+	// Frustum culling. The items are the frames with a mesh, dynamic models' first so the
+	// bounds recomputed each frame are a range, and the hierarchy is built over them on
+	// resize, when the camera projection is set up.
+	BoundingVolumeHierarchy		m_CullHierarchy;
+	bool						m_bFrustumCulling;
+	UINT						m_NumCullItems;
+	UINT						m_NumDynamicCullItems;
+	CullItem*					m_pCullItems;
+	float*						m_pCullItemBounds;		// world bounds of each item, cBoundsFloats each
+	unsigned char*				m_pCullItemVisible;
+	unsigned char*				m_pFrameVisible;		// per frame counting all models' frames
+	UINT						m_NumDraws;
+	UINT						m_NumCulledDraws;
+	double						m_CullTime;
+
 	ID3D11InputLayout*          m_pVertexLayout;
 
 	// Camera and light related
@@ -0,0 +1,325 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "StreamingStats.h"
+
+#include <algorithm>
+
+//--------------------------------------------------------------------------------------
+// P-squared quantile estimator
+//--------------------------------------------------------------------------------------
+P2Quantile::P2Quantile( float quantile )
+	: m_Quantile( quantile )
+{
+	Reset();
+}
+
+void P2Quantile::Reset()
+{
+	float p = m_Quantile;
+	for( int marker = 0; marker < 5; ++marker )
+	{
+		m_Heights[ marker ] = 0.0f;
+		m_Positions[ marker ] = marker;
+	}
+	m_Desired[0] = 0.0f;
+	m_Desired[1] = 2.0f * p;
+	m_Desired[2] = 4.0f * p;
+	m_Desired[3] = 2.0f + 2.0f * p;
+	m_Desired[4] = 4.0f;
+	m_Increments[0] = 0.0f;
+	m_Increments[1] = p / 2.0f;
+	m_Increments[2] = p;
+	m_Increments[3] = ( 1.0f + p ) / 2.0f;
+	m_Increments[4] = 1.0f;
+	m_NumSamples = 0;
+}
+
+void P2Quantile::AddSample( float value )
+{
+	if( m_NumSamples < 5 )
+	{
+		// keep the first samples sorted, they become the initial marker heights
+		int marker = (int)m_NumSamples;
+		while( marker > 0 && m_Heights[ marker - 1 ] > value )
+		{
+			m_Heights[ marker ] = m_Heights[ marker - 1 ];
+			--marker;
+		}
+		m_Heights[ marker ] = value;
+		++m_NumSamples;
+		return;
+	}
+
+	// find the cell containing the sample, extending the extremes if needed
+	int cell;
+	if( value < m_Heights[0] )
+	{
+		m_Heights[0] = value;
+		cell = 0;
+	}
+	else if( value >= m_Heights[4] )
+	{
+		m_Heights[4] = value;
+		cell = 3;
+	}
+	else
+	{
+		cell = 0;
+		while( value >= m_Heights[ cell + 1 ] )
+		{
+			++cell;
+		}
+	}
+
+	for( int marker = cell + 1; marker < 5; ++marker )
+	{
+		++m_Positions[ marker ];
+	}
+	for( int marker = 0; marker < 5; ++marker )
+	{
+		m_Desired[ marker ] += m_Increments[ marker ];
+	}
+
+	// move the middle markers towards their desired positions
+	for( int marker = 1; marker < 4; ++marker )
+	{
+		float offset = m_Desired[ marker ] - (float)m_Positions[ marker ];
+		if( ( offset >= 1.0f && m_Positions[ marker + 1 ] - m_Positions[ marker ] > 1 ) ||
+			( offset <= -1.0f && m_Positions[ marker - 1 ] - m_Positions[ marker ] < -1 ) )
+		{
+			int direction = offset > 0.0f ? 1 : -1;
+			float height = Parabolic( marker, (float)direction );
+			if( m_Heights[ marker - 1 ] < height && height < m_Heights[ marker + 1 ] )
+			{
+				m_Heights[ marker ] = height;
+			}
+			else
+			{
+				m_Heights[ marker ] = Linear( marker, direction );
+			}
+			m_Positions[ marker ] += direction;
+		}
+	}
+	++m_NumSamples;
+}
+
+float P2Quantile::Parabolic( int marker, float direction ) const
+{
+	float n0 = (float)m_Positions[ marker - 1 ];
+	float n1 = (float)m_Positions[ marker ];
+	float n2 = (float)m_Positions[ marker + 1 ];
+	float q0 = m_Heights[ marker - 1 ];
+	float q1 = m_Heights[ marker ];
+	float q2 = m_Heights[ marker + 1 ];
+	return q1 + direction / ( n2 - n0 ) *
+		( ( n1 - n0 + direction ) * ( q2 - q1 ) / ( n2 - n1 ) + ( n2 - n1 - direction ) * ( q1 - q0 ) / ( n1 - n0 ) );
+}
+
+float P2Quantile::Linear( int marker, int direction ) const
+{
+	return m_Heights[ marker ] + (float)direction * ( m_Heights[ marker + direction ] - m_Heights[ marker ] ) /
+		(float)( m_Positions[ marker + direction ] - m_Positions[ marker ] );
+}
+
+float P2Quantile::GetValue() const
+{
+	if( 0 == m_NumSamples )
+	{
+		return 0.0f;
+	}
+	if( m_NumSamples < 5 )
+	{
+		// nearest rank of the sorted samples
+		unsigned int rank = (unsigned int)( m_Quantile * (float)m_NumSamples + 0.999f );
+		return m_Heights[ rank > 1 ? std::min( rank, m_NumSamples ) - 1 : 0 ];
+	}
+	return m_Heights[2];
+}
+
+
+//--------------------------------------------------------------------------------------
+// Streaming statistics
+//--------------------------------------------------------------------------------------
+StreamingStats::StreamingStats( unsigned int windowSize, float emaWeight )
+	: m_EMAWeight( emaWeight )
+	, m_pSamples( NULL )
+	, m_WindowSize( windowSize ? windowSize : 1 )
+	, m_pMinQueue( NULL )
+	, m_pMaxQueue( NULL )
+{
+	m_pSamples = new float[ m_WindowSize ];
+	m_pMinQueue = new unsigned int[ m_WindowSize ];
+	m_pMaxQueue = new unsigned int[ m_WindowSize ];
+
+	static const float quantiles[ QUANTILE_COUNT ] = { 0.5f, 0.95f, 0.99f };
+	for( unsigned int set = 0; set < 2; ++set )
+	{
+		for( unsigned int quantile = 0; quantile < QUANTILE_COUNT; ++quantile )
+		{
+			m_Quantiles[ set ][ quantile ].m_Quantile = quantiles[ quantile ];
+		}
+	}
+	Reset();
+}
+
+StreamingStats::~StreamingStats()
+{
+	delete[] m_pSamples;
+	delete[] m_pMinQueue;
+	delete[] m_pMaxQueue;
+}
+
+void StreamingStats::Reset()
+{
+	m_NumSamples	= 0;
+	m_Sequence		= 0;
+	m_Sum			= 0.0;
+	m_MinFront		= 0;
+	m_MinCount		= 0;
+	m_MaxFront		= 0;
+	m_MaxCount		= 0;
+	m_Last			= 0.0f;
+	m_EMA			= 0.0f;
+	for( unsigned int set = 0; set < 2; ++set )
+	{
+		for( unsigned int quantile = 0; quantile < QUANTILE_COUNT; ++quantile )
+		{
+			m_Quantiles[ set ][ quantile ].Reset();
+		}
+	}
+}
+
+void StreamingStats::AddSample( float value )
+{
+	m_EMA = m_Sequence ? m_EMA + m_EMAWeight * ( value - m_EMA ) : value;
+	m_Last = value;
+
+	// window ring and running sum
+	unsigned int slot = m_Sequence % m_WindowSize;
+	if( m_NumSamples == m_WindowSize )
+	{
+		m_Sum -= m_pSamples[ slot ];
+	}
+	else
+	{
+		++m_NumSamples;
+	}
+	m_pSamples[ slot ] = value;
+	m_Sum += value;
+
+	// drop queue entries which have left the window
+	unsigned int oldest = m_Sequence + 1 - m_NumSamples;
+	if( m_MinCount && m_pMinQueue[ m_MinFront ] < oldest )
+	{
+		m_MinFront = ( m_MinFront + 1 ) % m_WindowSize;
+		--m_MinCount;
+	}
+	if( m_MaxCount && m_pMaxQueue[ m_MaxFront ] < oldest )
+	{
+		m_MaxFront = ( m_MaxFront + 1 ) % m_WindowSize;
+		--m_MaxCount;
+	}
+
+	// entries the new sample dominates can never be the min / max again
+	while( m_MinCount && m_pSamples[ m_pMinQueue[ ( m_MinFront + m_MinCount - 1 ) % m_WindowSize ] % m_WindowSize ] >= value )
+	{
+		--m_MinCount;
+	}
+	m_pMinQueue[ ( m_MinFront + m_MinCount++ ) % m_WindowSize ] = m_Sequence;
+	while( m_MaxCount && m_pSamples[ m_pMaxQueue[ ( m_MaxFront + m_MaxCount - 1 ) % m_WindowSize ] % m_WindowSize ] <= value )
+	{
+		--m_MaxCount;
+	}
+	m_pMaxQueue[ ( m_MaxFront + m_MaxCount++ ) % m_WindowSize ] = m_Sequence;
+
+	// restart each estimator set every window, the second set half a window after the first
+	for( unsigned int set = 0; set < 2; ++set )
+	{
+		if( m_Quantiles[ set ][0].GetNumSamples() >= m_WindowSize ||
+			( 1 == set && m_Sequence == m_WindowSize / 2 ) )
+		{
+			for( unsigned int quantile = 0; quantile < QUANTILE_COUNT; ++quantile )
+			{
+				m_Quantiles[ set ][ quantile ].Reset();
+			}
+		}
+		for( unsigned int quantile = 0; quantile < QUANTILE_COUNT; ++quantile )
+		{
+			m_Quantiles[ set ][ quantile ].AddSample( value );
+		}
+	}
+
+	++m_Sequence;
+}
+
+float StreamingStats::GetMean() const
+{
+	return m_NumSamples ? (float)( m_Sum / (double)m_NumSamples ) : 0.0f;
+}
+
+float StreamingStats::GetMin() const
+{
+	return m_MinCount ? m_pSamples[ m_pMinQueue[ m_MinFront ] % m_WindowSize ] : 0.0f;
+}
+
+float StreamingStats::GetMax() const
+{
+	return m_MaxCount ? m_pSamples[ m_pMaxQueue[ m_MaxFront ] % m_WindowSize ] : 0.0f;
+}
+
+const P2Quantile& StreamingStats::GetQuantile( unsigned int quantile ) const
+{
+	unsigned int set = m_Quantiles[0][ quantile ].GetNumSamples() >= m_Quantiles[1][ quantile ].GetNumSamples() ? 0 : 1;
+	return m_Quantiles[ set ][ quantile ];
+}
+
+float StreamingStats::GetMedian() const
+{
+	return GetQuantile( QUANTILE_MEDIAN ).GetValue();
+}
+
+//--------------------------------------------------------------------------------------
+// The estimators are independent, so on a narrow distribution a higher quantile can come
+// out slightly below a lower one. Keep them ordered for the controller inputs.
+//--------------------------------------------------------------------------------------
+float StreamingStats::GetP95() const
+{
+	return std::max( GetQuantile( QUANTILE_P95 ).GetValue(), GetMedian() );
+}
+
+float StreamingStats::GetP99() const
+{
+	return std::max( GetQuantile( QUANTILE_P99 ).GetValue(), GetP95() );
+}
+
+float StreamingStats::GetPercentile( float percentile ) const
+{
+	const float percentiles[5] = { 0.0f, 50.0f, 95.0f, 99.0f, 100.0f };
+	const float values[5] = { GetMin(), GetMedian(), GetP95(), GetP99(), GetMax() };
+	if( percentile <= percentiles[0] )
+	{
+		return values[0];
+	}
+	for( int point = 1; point < 5; ++point )
+	{
+		if( percentile <= percentiles[ point ] )
+		{
+			float t = ( percentile - percentiles[ point - 1 ] ) / ( percentiles[ point ] - percentiles[ point - 1 ] );
+			return values[ point - 1 ] + t * ( values[ point ] - values[ point - 1 ] );
+		}
+	}
+	return values[4];
+}
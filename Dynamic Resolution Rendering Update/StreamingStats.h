@@ -0,0 +1,133 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Note: like ResolutionController.h this file has no D3D or DXUT dependencies.
+
+//--------------------------------------------------------------------------------------
+// Streaming estimate of a single quantile using the P-squared algorithm (Jain and
+// Chlamtac, 1985). Five markers track the minimum, the quantile, the maximum and two
+// points either side, adjusted with a piecewise parabolic fit as samples arrive, so
+// each sample is O(1) with no storage beyond the markers. Exact until five samples.
+//--------------------------------------------------------------------------------------
+class P2Quantile
+{
+public:
+	P2Quantile( float quantile = 0.5f );
+
+	void Reset();
+	void AddSample( float value );
+
+	// 0 if there are no samples
+	float GetValue() const;
+	unsigned int GetNumSamples() const
+	{
+		return m_NumSamples;
+	}
+
+	float	m_Quantile;		// in [0,1]
+
+private:
+	float Parabolic( int marker, float direction ) const;
+	float Linear( int marker, int direction ) const;
+
+	float			m_Heights[5];
+	int				m_Positions[5];
+	float			m_Desired[5];
+	float			m_Increments[5];
+	unsigned int	m_NumSamples;
+};
+
+//--------------------------------------------------------------------------------------
+// Allocation free streaming statistics for timings. All memory is allocated at
+// construction, and each sample is O(1) (amortised for min / max):
+// - exponential moving average
+// - mean, min and max over the last windowSize samples, from a ring with a running sum
+//   and monotonic queues
+// - median, p95 and p99 from P2Quantile estimators. P-squared cannot forget samples, so
+//   two sets of estimators are restarted every windowSize samples half a window apart,
+//   and the older set is used. Percentiles cover between a half and a whole window.
+//--------------------------------------------------------------------------------------
+class StreamingStats
+{
+public:
+	StreamingStats( unsigned int windowSize = 120, float emaWeight = 0.1f );
+	~StreamingStats();
+
+	void Reset();
+	void AddSample( float value );
+
+	// Statistics of the samples so far, 0 if there are none
+	float GetLast() const
+	{
+		return m_Last;
+	}
+	float GetEMA() const
+	{
+		return m_EMA;
+	}
+	float GetMean() const;
+	float GetMin() const;
+	float GetMax() const;
+	float GetMedian() const;
+	float GetP95() const;
+	float GetP99() const;
+
+	// Percentile in [0,100]. 0, 50, 95, 99 and 100 are tracked, other percentiles are
+	// interpolated between them.
+	float GetPercentile( float percentile ) const;
+
+	// Samples in the window
+	unsigned int GetNumSamples() const
+	{
+		return m_NumSamples;
+	}
+	unsigned int GetWindowSize() const
+	{
+		return m_WindowSize;
+	}
+
+	float	m_EMAWeight;	// weight of a new sample in the moving average
+
+private:
+	enum { QUANTILE_MEDIAN, QUANTILE_P95, QUANTILE_P99, QUANTILE_COUNT };
+
+	const P2Quantile& GetQuantile( unsigned int quantile ) const;
+
+	// window ring, the sample with sequence number s is at s % m_WindowSize
+	float*			m_pSamples;
+	unsigned int	m_WindowSize;
+	unsigned int	m_NumSamples;
+	unsigned int	m_Sequence;		// sequence number of the next sample
+	double			m_Sum;
+
+	// monotonic queues of sequence numbers, the front is the window min / max
+	unsigned int*	m_pMinQueue;
+	unsigned int*	m_pMaxQueue;
+	unsigned int	m_MinFront;
+	unsigned int	m_MinCount;
+	unsigned int	m_MaxFront;
+	unsigned int	m_MaxCount;
+
+	P2Quantile		m_Quantiles[2][ QUANTILE_COUNT ];
+
+	float			m_Last;
+	float			m_EMA;
+
+	//prevent assign and copy
+	StreamingStats( const StreamingStats& rhs );
+	StreamingStats& operator=( const StreamingStats& rhs );
+};
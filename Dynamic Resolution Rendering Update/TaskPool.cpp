@@ -0,0 +1,178 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "TaskPool.h"
+
+#include <stddef.h>
+
+//--------------------------------------------------------------------------------------
+// Ctor and Dtor
+//--------------------------------------------------------------------------------------
+TaskPool::TaskPool()
+	: m_NumWorkers( 0 )
+	, m_ActiveThreads( 1 )
+	, m_pWorkers( NULL )
+	, m_WorkersToWake( 0 )
+	, m_WorkersRemaining( 0 )
+	, m_bShutdown( false )
+	, m_pFunc( NULL )
+	, m_pArg( NULL )
+	, m_TaskCount( 0 )
+	, m_NextTask( 0 )
+{
+}
+
+TaskPool::~TaskPool()
+{
+	Shutdown();
+}
+
+//--------------------------------------------------------------------------------------
+// Start and stop the workers
+//--------------------------------------------------------------------------------------
+void TaskPool::Init( unsigned int numThreads )
+{
+	Shutdown();
+
+	if( 0 == numThreads )
+	{
+		numThreads = std::thread::hardware_concurrency();
+	}
+	if( numThreads <= 1 )
+	{
+		return;
+	}
+
+	m_bShutdown = false;
+	m_NumWorkers = numThreads - 1;
+	m_pWorkers = new std::thread[ m_NumWorkers ];
+	for( unsigned int worker = 0; worker < m_NumWorkers; ++worker )
+	{
+		m_pWorkers[ worker ] = std::thread( &TaskPool::WorkerThread, this, (int)worker + 1 );
+	}
+	m_ActiveThreads = numThreads;
+}
+
+void TaskPool::Shutdown()
+{
+	if( m_NumWorkers )
+	{
+		{
+			std::lock_guard<std::mutex> lock( m_Mutex );
+			m_bShutdown = true;
+		}
+		m_WorkCondition.notify_all();
+		for( unsigned int worker = 0; worker < m_NumWorkers; ++worker )
+		{
+			m_pWorkers[ worker ].join();
+		}
+	}
+	delete[] m_pWorkers;
+	m_pWorkers = NULL;
+	m_NumWorkers = 0;
+	m_ActiveThreads = 1;
+}
+
+void TaskPool::SetActiveThreads( unsigned int numThreads )
+{
+	m_ActiveThreads = numThreads < 1 ? 1 : ( numThreads > m_NumWorkers + 1 ? m_NumWorkers + 1 : numThreads );
+}
+
+//--------------------------------------------------------------------------------------
+// Run a job. Only as many workers as there are tasks beyond the first are woken, and
+// the job is complete once each woken worker has found no task left, so no worker is
+// still reading this job when the next starts.
+//--------------------------------------------------------------------------------------
+void TaskPool::Run( TaskPoolFunc pFunc, void* pArg, unsigned int taskCount )
+{
+	if( 0 == taskCount )
+	{
+		return;
+	}
+
+	unsigned int numWorkers = m_ActiveThreads - 1;
+	if( numWorkers > taskCount - 1 )
+	{
+		numWorkers = taskCount - 1;
+	}
+
+	m_pFunc = pFunc;
+	m_pArg = pArg;
+	m_TaskCount = taskCount;
+	m_NextTask = 0;
+	if( numWorkers )
+	{
+		{
+			std::lock_guard<std::mutex> lock( m_Mutex );
+			m_WorkersToWake = numWorkers;
+			m_WorkersRemaining = numWorkers;
+		}
+		m_WorkCondition.notify_all();
+	}
+
+	DoTasks( 0 );
+
+	if( numWorkers )
+	{
+		std::unique_lock<std::mutex> lock( m_Mutex );
+		while( m_WorkersRemaining )
+		{
+			m_JobCompleteCondition.wait( lock );
+		}
+	}
+}
+
+void TaskPool::DoTasks( int threadIndex )
+{
+	for( ;; )
+	{
+		unsigned int task = m_NextTask++;
+		if( task >= m_TaskCount )
+		{
+			break;
+		}
+		m_pFunc( m_pArg, threadIndex, task, m_TaskCount );
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Worker, joins a job when woken for one. The mutex orders Run()'s writes of the job
+// before the worker's reads of it.
+//--------------------------------------------------------------------------------------
+void TaskPool::WorkerThread( int threadIndex )
+{
+	std::unique_lock<std::mutex> lock( m_Mutex );
+	for( ;; )
+	{
+		while( !m_WorkersToWake && !m_bShutdown )
+		{
+			m_WorkCondition.wait( lock );
+		}
+		if( m_bShutdown )
+		{
+			break;
+		}
+		--m_WorkersToWake;
+		lock.unlock();
+
+		DoTasks( threadIndex );
+
+		lock.lock();
+		if( 0 == --m_WorkersRemaining )
+		{
+			m_JobCompleteCondition.notify_one();
+		}
+	}
+}
@@ -0,0 +1,92 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Note: like TelemetryLogger.h this file has no D3D or DXUT dependencies, the workers
+// are std::threads, so the pool is tested with the CPU only unit tests.
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+//--------------------------------------------------------------------------------------
+// Task callback, with the same signature as TaskMgrTbb's TASKSETFUNC so work can move
+// to it in samples which link TBB. threadIndex is 0 for the thread calling Run().
+//--------------------------------------------------------------------------------------
+typedef void (*TaskPoolFunc)( void* pArg, int threadIndex, unsigned int task, unsigned int taskCount );
+
+//--------------------------------------------------------------------------------------
+// Minimal pool of worker threads for data parallel jobs, for samples which are built
+// without TBB. Run() splits a job into tasks, hands them to the workers and the calling
+// thread in order, and returns when all are complete.
+//
+// Tasks may complete in any order and on any thread, so each should write only its own
+// results. Results are then the same whatever the number of threads.
+//
+// Like TaskMgrTbb, the pool is used from one thread only.
+//--------------------------------------------------------------------------------------
+class TaskPool
+{
+public:
+	TaskPool();
+	~TaskPool();
+
+	// Start the workers, numThreads - 1 of them as the calling thread also runs tasks.
+	// 0 uses one thread per logical processor.
+	void	Init( unsigned int numThreads = 0 );
+	void	Shutdown();
+
+	void	Run( TaskPoolFunc pFunc, void* pArg, unsigned int taskCount );
+
+	// Threads Run() uses, from 1 (calling thread only) to GetNumThreads(), for comparing
+	// scaling without restarting the workers
+	void	SetActiveThreads( unsigned int numThreads );
+	unsigned int	GetActiveThreads() const
+	{
+		return m_ActiveThreads;
+	}
+	unsigned int	GetNumThreads() const
+	{
+		return m_NumWorkers + 1;
+	}
+
+private:
+	void	DoTasks( int threadIndex );
+	void	WorkerThread( int threadIndex );
+
+	unsigned int			m_NumWorkers;
+	unsigned int			m_ActiveThreads;
+	std::thread*			m_pWorkers;
+
+	// guards the counts below, which the conditions wait on
+	std::mutex				m_Mutex;
+	std::condition_variable	m_WorkCondition;		// workers wait for m_WorkersToWake
+	std::condition_variable	m_JobCompleteCondition;	// Run() waits for m_WorkersRemaining to reach 0
+	unsigned int			m_WorkersToWake;		// workers still to join the current job
+	unsigned int			m_WorkersRemaining;		// woken workers yet to finish the current job
+	bool					m_bShutdown;
+
+	// current job, written by Run() before any worker is woken for it
+	TaskPoolFunc			m_pFunc;
+	void*					m_pArg;
+	unsigned int			m_TaskCount;
+	std::atomic<unsigned int>	m_NextTask;
+
+	//prevent assign and copy
+	TaskPool( const TaskPool& rhs );
+	TaskPool& operator=( const TaskPool& rhs );
+};
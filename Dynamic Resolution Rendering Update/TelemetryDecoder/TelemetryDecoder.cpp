@@ -0,0 +1,121 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------
+// Telemetry log decoder.
+//
+// Converts a binary log written by TelemetryLogger to CSV, one frame per line, with
+// times in milliseconds. With -sim the output is instead the ControllerSimulator CSV
+// trace format, so captured frames can be replayed through the controllers offline.
+//--------------------------------------------------------------------------------------
+
+#include "TelemetryReader.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+
+namespace
+{
+	void PrintUsage()
+	{
+		printf( "Usage: TelemetryDecoder [options] telemetry.bin [output.csv]\n"
+				"Options:\n"
+				"  -sim                                              write a ControllerSimulator trace\n"
+				"The output is written to stdout if no output file is given.\n" );
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Main function
+//--------------------------------------------------------------------------------------
+int main( int argc, char* argv[] )
+{
+	const char* pInputName = NULL;
+	const char* pOutputName = NULL;
+	bool bSimulatorTrace = false;
+
+	for( int arg = 1; arg < argc; ++arg )
+	{
+		if( 0 == strcmp( argv[arg], "-sim" ) )
+		{
+			bSimulatorTrace = true;
+		}
+		else if( '-' == argv[arg][0] )
+		{
+			PrintUsage();
+			return 1;
+		}
+		else if( !pInputName )
+		{
+			pInputName = argv[arg];
+		}
+		else if( !pOutputName )
+		{
+			pOutputName = argv[arg];
+		}
+		else
+		{
+			PrintUsage();
+			return 1;
+		}
+	}
+
+	if( !pInputName )
+	{
+		PrintUsage();
+		return 1;
+	}
+
+	std::vector<TelemetryRecord> records;
+	TelemetryFileHeader header;
+	if( !LoadTelemetry( pInputName, records, &header ) )
+	{
+		printf( "Failed to load telemetry %s\n", pInputName );
+		return 1;
+	}
+	if( header.numRecords && records.size() < header.numRecords )
+	{
+		printf( "Warning: %s is truncated, %u of %u records read\n", pInputName, (unsigned int)records.size(), header.numRecords );
+	}
+
+	FILE* pOutput = stdout;
+	if( pOutputName )
+	{
+		pOutput = fopen( pOutputName, "w" );
+		if( !pOutput )
+		{
+			printf( "Failed to create %s\n", pOutputName );
+			return 1;
+		}
+	}
+
+	if( bSimulatorTrace )
+	{
+		WriteTelemetrySimulatorTrace( pOutput, records );
+	}
+	else
+	{
+		WriteTelemetryCSV( pOutput, records );
+	}
+
+	if( pOutputName )
+	{
+		fclose( pOutput );
+		printf( "%u records written to %s\n", (unsigned int)records.size(), pOutputName );
+	}
+	return 0;
+}
@@ -0,0 +1,156 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "TelemetryLogger.h"
+
+#include <stddef.h>
+#include <chrono>
+
+namespace
+{
+	// how long the writer sleeps when the pipe is empty
+	const unsigned int cWriterSleepMilliseconds = 5;
+}
+
+//--------------------------------------------------------------------------------------
+// Ctor / dtor
+//--------------------------------------------------------------------------------------
+TelemetryLogger::TelemetryLogger()
+	: m_pFile( NULL )
+	, m_bStop( false )
+	, m_NumWrittenRecords( 0 )
+	, m_NumDroppedRecords( 0 )
+{
+}
+
+TelemetryLogger::~TelemetryLogger()
+{
+	Close();
+}
+
+//--------------------------------------------------------------------------------------
+// Open and close
+//--------------------------------------------------------------------------------------
+bool TelemetryLogger::Open( const char* pFileName )
+{
+	if( m_pFile )
+	{
+		return false;
+	}
+#ifdef _MSC_VER
+	if( 0 != fopen_s( &m_pFile, pFileName, "wb" ) )
+	{
+		m_pFile = NULL;
+	}
+#else
+	m_pFile = fopen( pFileName, "wb" );
+#endif
+	if( !m_pFile )
+	{
+		return false;
+	}
+
+	TelemetryFileHeader header;
+	header.magic		= cTelemetryMagic;
+	header.version		= cTelemetryVersion;
+	header.recordSize	= sizeof( TelemetryRecord );
+	header.numRecords	= 0;
+	fwrite( &header, sizeof( header ), 1, m_pFile );
+
+	m_NumWrittenRecords	= 0;
+	m_NumDroppedRecords	= 0;
+	m_bStop				= false;
+	m_Writer			= std::thread( &TelemetryLogger::WriterThread, this );
+	return true;
+}
+
+void TelemetryLogger::Close()
+{
+	if( !m_pFile )
+	{
+		return;
+	}
+	m_bStop = true;
+	m_Writer.join();
+
+	// the record count lets readers tell a complete log from a truncated one
+	unsigned int numRecords = m_NumWrittenRecords.load();
+	if( 0 == fseek( m_pFile, offsetof( TelemetryFileHeader, numRecords ), SEEK_SET ) )
+	{
+		fwrite( &numRecords, sizeof( numRecords ), 1, m_pFile );
+	}
+	fclose( m_pFile );
+	m_pFile = NULL;
+}
+
+//--------------------------------------------------------------------------------------
+// Render thread
+//--------------------------------------------------------------------------------------
+bool TelemetryLogger::Push( const TelemetryRecord& record )
+{
+	if( !m_pFile )
+	{
+		return false;
+	}
+	if( !m_Pipe.Write( &record, sizeof( record ) ) )
+	{
+		++m_NumDroppedRecords;
+		return false;
+	}
+	return true;
+}
+
+//--------------------------------------------------------------------------------------
+// Writer thread
+//--------------------------------------------------------------------------------------
+void TelemetryLogger::WriterThread()
+{
+	while( !m_bStop.load() )
+	{
+		if( !WriteRecords() )
+		{
+			std::this_thread::sleep_for( std::chrono::milliseconds( cWriterSleepMilliseconds ) );
+		}
+	}
+
+	// the render thread has stopped pushing, so this empties the pipe
+	WriteRecords();
+	fflush( m_pFile );
+}
+
+bool TelemetryLogger::WriteRecords()
+{
+	// batch records so the file is written in large blocks
+	TelemetryRecord records[ 64 ];
+	unsigned int numRecords = 0;
+	bool bWritten = false;
+	while( m_Pipe.Read( &records[ numRecords ], sizeof( TelemetryRecord ) ) )
+	{
+		if( ++numRecords == sizeof( records ) / sizeof( records[0] ) )
+		{
+			fwrite( records, sizeof( TelemetryRecord ), numRecords, m_pFile );
+			m_NumWrittenRecords += numRecords;
+			numRecords = 0;
+			bWritten = true;
+		}
+	}
+	if( numRecords )
+	{
+		fwrite( records, sizeof( TelemetryRecord ), numRecords, m_pFile );
+		m_NumWrittenRecords += numRecords;
+		bWritten = true;
+	}
+	return bWritten;
+}
@@ -0,0 +1,133 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Note: like ResolutionController.h this file has no D3D or DXUT dependencies beyond the
+// portable DXUTLockFreePipe, so logs can be written and decoded on any platform.
+
+#include "DXUTLockFreePipe.h"
+
+#include <stdio.h>
+#include <atomic>
+#include <thread>
+
+//--------------------------------------------------------------------------------------
+// Telemetry file format, little endian:
+//   TelemetryFileHeader followed by TelemetryFileHeader::numRecords records of
+//   TelemetryFileHeader::recordSize bytes. numRecords is written when the log is closed,
+//   and is 0 if the application did not close it, in which case readers should use the
+//   file size. Later versions only append fields to TelemetryRecord, so a reader can
+//   read the prefix it knows of a larger record.
+//--------------------------------------------------------------------------------------
+const unsigned int	cTelemetryMagic		= 0x4c545244;	// 'DRTL'
+const unsigned int	cTelemetryVersion	= 1;
+
+struct TelemetryFileHeader
+{
+	unsigned int	magic;
+	unsigned int	version;
+	unsigned int	recordSize;
+	unsigned int	numRecords;
+};
+
+// TelemetryRecord::flags
+enum TELEMETRY_FLAGS
+{
+	TELEMETRY_FLAG_DYNAMIC_RESOLUTION	= 0x01,	// dynamic resolution enabled
+	TELEMETRY_FLAG_GPU_TIMES			= 0x02,	// pass times are from a resolved GPU frame
+	TELEMETRY_FLAG_MOTION_LOCKED		= 0x04,	// motion adaptive policy holding the scale
+	TELEMETRY_FLAG_BOUND_GATING			= 0x08,	// decreases only allowed when GPU bound
+};
+
+//--------------------------------------------------------------------------------------
+// One frame of telemetry. Times are in seconds. Pass times are from the latest GPU
+// profiler results, which lag the frame by the profiler's latency.
+//--------------------------------------------------------------------------------------
+struct TelemetryRecord
+{
+	unsigned int	frame;
+	float			cpuFrameTime;
+	float			gpuFrameTime;
+	float			clearTime;
+	float			sceneTime;
+	float			postProcTime;
+	float			scaleTime;
+	float			scaleX;
+	float			scaleY;
+	float			controlTime;		// time the controller acted on, 0 when not controlling
+	float			targetTime;
+	unsigned short	viewportWidth;
+	unsigned short	viewportHeight;
+	unsigned char	resolveMode;		// RESOLVE_MODE
+	unsigned char	controlMode;		// CONTROL_MODE
+	unsigned char	controllerType;		// CONTROLLER_TYPE
+	unsigned char	frameBound;			// FRAME_BOUND
+	unsigned char	flags;				// TELEMETRY_FLAGS
+	unsigned char	reserved[3];
+};
+
+//--------------------------------------------------------------------------------------
+// Per frame telemetry logger. The render thread pushes fixed size records into a single
+// producer, single consumer lock free pipe, and a writer thread drains the pipe to the
+// file, so the render thread never blocks on file IO. If the writer falls behind far
+// enough to fill the pipe, records are dropped and counted rather than waiting.
+//--------------------------------------------------------------------------------------
+class TelemetryLogger
+{
+public:
+	TelemetryLogger();
+	~TelemetryLogger();
+
+	// Create pFileName and start the writer thread. Returns false if the file can't be
+	// created or a log is already open.
+	bool Open( const char* pFileName );
+
+	// Write any records still in the pipe, then close the file
+	void Close();
+
+	bool IsOpen() const
+	{
+		return NULL != m_pFile;
+	}
+
+	// Render thread only, never blocks. Returns false if the record was dropped.
+	bool Push( const TelemetryRecord& record );
+
+	unsigned int GetNumDroppedRecords() const
+	{
+		return m_NumDroppedRecords;
+	}
+	unsigned int GetNumWrittenRecords() const
+	{
+		return m_NumWrittenRecords.load();
+	}
+
+private:
+	void WriterThread();
+	bool WriteRecords();
+
+	// 64KB, over a thousand records or many seconds of frames
+	DXUTLockFreePipe< 16 >		m_Pipe;
+	FILE*						m_pFile;
+	std::thread					m_Writer;
+	std::atomic<bool>			m_bStop;
+	std::atomic<unsigned int>	m_NumWrittenRecords;
+	unsigned int				m_NumDroppedRecords;
+
+	//prevent assign and copy
+	TelemetryLogger( const TelemetryLogger& rhs );
+	TelemetryLogger& operator=( const TelemetryLogger& rhs );
+};
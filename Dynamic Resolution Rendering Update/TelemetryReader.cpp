@@ -0,0 +1,98 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "TelemetryReader.h"
+
+#include <string.h>
+
+//--------------------------------------------------------------------------------------
+// Load a log. numRecords is 0 if the application exited without closing the log, in
+// which case every complete record in the file is read.
+//--------------------------------------------------------------------------------------
+bool LoadTelemetry( const char* pFileName, std::vector<TelemetryRecord>& records, TelemetryFileHeader* pHeader )
+{
+	FILE* pFile = fopen( pFileName, "rb" );
+	if( !pFile )
+	{
+		return false;
+	}
+
+	TelemetryFileHeader& header = *pHeader;
+	if( 1 != fread( &header, sizeof( header ), 1, pFile ) || cTelemetryMagic != header.magic
+		|| header.version < 1 || header.version > cTelemetryVersion || 0 == header.recordSize )
+	{
+		fclose( pFile );
+		return false;
+	}
+
+	std::vector<unsigned char> buffer( header.recordSize );
+	size_t copySize = header.recordSize < sizeof( TelemetryRecord ) ? header.recordSize : sizeof( TelemetryRecord );
+	while( ( 0 == header.numRecords || records.size() < header.numRecords )
+		&& 1 == fread( &buffer[0], header.recordSize, 1, pFile ) )
+	{
+		TelemetryRecord record;
+		memset( &record, 0, sizeof( record ) );
+		memcpy( &record, &buffer[0], copySize );
+		records.push_back( record );
+	}
+	fclose( pFile );
+	return true;
+}
+
+//--------------------------------------------------------------------------------------
+// Write as CSV
+//--------------------------------------------------------------------------------------
+void WriteTelemetryCSV( FILE* pFile, const std::vector<TelemetryRecord>& records )
+{
+	fprintf( pFile, "frame,cpuFrameTime,gpuFrameTime,clearTime,sceneTime,postProcTime,scaleTime,"
+					"scaleX,scaleY,viewportWidth,viewportHeight,controlTime,targetTime,"
+					"resolveMode,controlMode,controllerType,frameBound,"
+					"dynamicResolution,gpuTimes,motionLocked,boundGating\n" );
+	for( size_t i = 0; i < records.size(); ++i )
+	{
+		const TelemetryRecord& record = records[i];
+		fprintf( pFile, "%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.4f,%.4f,%u,%u,%.3f,%.3f,%u,%u,%u,%u,%u,%u,%u,%u\n",
+				record.frame,
+				1000.0f * record.cpuFrameTime, 1000.0f * record.gpuFrameTime,
+				1000.0f * record.clearTime, 1000.0f * record.sceneTime,
+				1000.0f * record.postProcTime, 1000.0f * record.scaleTime,
+				record.scaleX, record.scaleY,
+				(unsigned int)record.viewportWidth, (unsigned int)record.viewportHeight,
+				1000.0f * record.controlTime, 1000.0f * record.targetTime,
+				(unsigned int)record.resolveMode, (unsigned int)record.controlMode,
+				(unsigned int)record.controllerType, (unsigned int)record.frameBound,
+				( record.flags & TELEMETRY_FLAG_DYNAMIC_RESOLUTION ) ? 1u : 0u,
+				( record.flags & TELEMETRY_FLAG_GPU_TIMES ) ? 1u : 0u,
+				( record.flags & TELEMETRY_FLAG_MOTION_LOCKED ) ? 1u : 0u,
+				( record.flags & TELEMETRY_FLAG_BOUND_GATING ) ? 1u : 0u );
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Write as a ControllerSimulator trace
+//--------------------------------------------------------------------------------------
+void WriteTelemetrySimulatorTrace( FILE* pFile, const std::vector<TelemetryRecord>& records )
+{
+	fprintf( pFile, "gpuFrameInnerWorkTime,cpuFrameTime,viewportWidth,viewportHeight\n" );
+	for( size_t i = 0; i < records.size(); ++i )
+	{
+		const TelemetryRecord& record = records[i];
+		if( record.flags & TELEMETRY_FLAG_GPU_TIMES )
+		{
+			fprintf( pFile, "%.6f,%.6f,%u,%u\n", record.gpuFrameTime, record.cpuFrameTime,
+					(unsigned int)record.viewportWidth, (unsigned int)record.viewportHeight );
+		}
+	}
+}
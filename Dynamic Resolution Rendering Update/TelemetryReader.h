@@ -0,0 +1,39 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Note: like TelemetryLogger.h this file has no D3D or DXUT dependencies.
+
+#include "TelemetryLogger.h"
+
+#include <stdio.h>
+#include <vector>
+
+//--------------------------------------------------------------------------------------
+// Reading logs written by TelemetryLogger, for TelemetryDecoder
+//--------------------------------------------------------------------------------------
+
+// Load a telemetry log. Records written by a later version are truncated to the fields
+// this version knows of. The file's header is returned in pHeader, if the log is
+// truncated its numRecords is more than the records read.
+bool LoadTelemetry( const char* pFileName, std::vector<TelemetryRecord>& records, TelemetryFileHeader* pHeader );
+
+// CSV, one frame per line, with times in milliseconds
+void WriteTelemetryCSV( FILE* pFile, const std::vector<TelemetryRecord>& records );
+
+// ControllerSimulator CSV trace: gpuFrameInnerWorkTime,cpuFrameTime,viewportWidth,viewportHeight
+// in seconds. Frames before the first GPU result have no GPU time and are skipped.
+void WriteTelemetrySimulatorTrace( FILE* pFile, const std::vector<TelemetryRecord>& records );
@@ -0,0 +1,332 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "TraceRecorder.h"
+#include "GPUProfiler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <wchar.h>
+
+TraceRecorder* TraceRecorder::s_pActive = NULL;
+
+//--------------------------------------------------------------------------------------
+// Ctor, the event buffer is allocated here
+//--------------------------------------------------------------------------------------
+TraceRecorder::TraceRecorder( ITraceClock* pClock, unsigned int maxEvents )
+	: m_pClock( pClock )
+	, m_MaxEvents( maxEvents ? maxEvents : 1 )
+	, m_NumEvents( 0 )
+	, m_NumDroppedEvents( 0 )
+	, m_State( STATE_IDLE )
+	, m_NumFrames( 0 )
+	, m_FrameCount( 0 )
+	, m_DrainCount( 0 )
+	, m_CaptureStart( 0.0 )
+	, m_ThreadId( 0 )
+	, m_bWritten( false )
+	, m_ScopeDepth( 0 )
+	, m_FrameEvent( 0 )
+	, m_GPUFrameCount( 0 )
+	, m_FirstGPUFrame( 0 )
+	, m_EndGPUFrame( 0 )
+{
+	m_pEvents = new Event[ m_MaxEvents ];
+	m_FileName[0] = 0;
+}
+
+//--------------------------------------------------------------------------------------
+// Dtor, waits for any capture being written
+//--------------------------------------------------------------------------------------
+TraceRecorder::~TraceRecorder()
+{
+	if( s_pActive == this )
+	{
+		s_pActive = NULL;
+	}
+	WaitForWriter();
+	delete[] m_pEvents;
+}
+
+//--------------------------------------------------------------------------------------
+// Capture control
+//--------------------------------------------------------------------------------------
+bool TraceRecorder::Start( const wchar_t* pFileName, unsigned int numFrames )
+{
+	if( STATE_IDLE != m_State || 0 == numFrames )
+	{
+		return false;
+	}
+#ifdef _MSC_VER
+	wcsncpy_s( m_FileName, pFileName, _TRUNCATE );
+#else
+	wcsncpy( m_FileName, pFileName, MAX_FILE_NAME - 1 );
+	m_FileName[ MAX_FILE_NAME - 1 ] = 0;
+#endif
+	m_NumFrames			= numFrames;
+	m_FrameCount		= 0;
+	m_DrainCount		= 0;
+	m_NumEvents			= 0;
+	m_NumDroppedEvents	= 0;
+	m_ScopeDepth		= 0;
+	m_ThreadId			= m_pClock->GetThreadId();
+	m_State				= STATE_PENDING;
+	return true;
+}
+
+void TraceRecorder::Stop()
+{
+	if( STATE_PENDING == m_State )
+	{
+		m_State = STATE_IDLE;
+	}
+	else if( STATE_RECORDING == m_State )
+	{
+		m_NumFrames = m_FrameCount;
+	}
+}
+
+void TraceRecorder::BeginFrame( double frameStartTime )
+{
+	switch( m_State )
+	{
+	case STATE_PENDING:
+		m_State			= STATE_RECORDING;
+		m_CaptureStart	= frameStartTime;
+		m_FirstGPUFrame	= m_GPUFrameCount;
+		break;
+
+	case STATE_RECORDING:
+		m_pEvents[ m_FrameEvent ].duration = frameStartTime - m_pEvents[ m_FrameEvent ].start;
+		if( ++m_FrameCount >= m_NumFrames )
+		{
+			// results for the last frames arrive up to the GPU profiler's latency later
+			m_State			= STATE_DRAINING;
+			m_EndGPUFrame	= m_GPUFrameCount;
+			return;
+		}
+		break;
+
+	case STATE_DRAINING:
+		if( ++m_DrainCount >= MAX_GPU_LATENCY )
+		{
+			FinishCapture();
+		}
+		return;
+
+	case STATE_WRITING:
+		if( m_bWritten.load() )
+		{
+			WaitForWriter();
+		}
+		return;
+
+	default:
+		return;
+	}
+
+	Event* pFrame = AddEvent( "Frame", frameStartTime, m_ThreadId );
+	if( !pFrame )
+	{
+		// nowhere to put the rest of the capture
+		m_State			= STATE_DRAINING;
+		m_EndGPUFrame	= m_GPUFrameCount;
+		return;
+	}
+	m_FrameEvent = (unsigned int)( pFrame - m_pEvents );
+}
+
+//--------------------------------------------------------------------------------------
+// CPU events
+//--------------------------------------------------------------------------------------
+TraceRecorder::Event* TraceRecorder::AddEvent( const char* pName, double start, unsigned int threadId )
+{
+	if( m_NumEvents >= m_MaxEvents )
+	{
+		++m_NumDroppedEvents;
+		return NULL;
+	}
+	Event& event	= m_pEvents[ m_NumEvents++ ];
+	event.pName		= pName;
+	event.start		= start;
+	event.duration	= 0.0;
+	event.threadId	= threadId;
+	return &event;
+}
+
+void TraceRecorder::BeginScope( const char* pName )
+{
+	Event* pEvent = NULL;
+	if( STATE_RECORDING == m_State )
+	{
+		pEvent = AddEvent( pName, m_pClock->GetTime(), m_pClock->GetThreadId() );
+	}
+	if( m_ScopeDepth < MAX_SCOPE_DEPTH )
+	{
+		m_ScopeStack[ m_ScopeDepth ] = pEvent ? (unsigned int)( pEvent - m_pEvents ) : m_MaxEvents;
+	}
+	++m_ScopeDepth;
+}
+
+void TraceRecorder::EndScope()
+{
+	if( 0 == m_ScopeDepth )
+	{
+		return;
+	}
+	--m_ScopeDepth;
+	if( m_ScopeDepth < MAX_SCOPE_DEPTH && m_ScopeStack[ m_ScopeDepth ] < m_MaxEvents && STATE_WRITING != m_State )
+	{
+		Event& event = m_pEvents[ m_ScopeStack[ m_ScopeDepth ] ];
+		event.duration = m_pClock->GetTime() - event.start;
+	}
+}
+
+void TraceRecorder::AddCPUEvent( const char* pName, double startTime, double endTime )
+{
+	if( STATE_RECORDING != m_State || startTime < m_CaptureStart )
+	{
+		return;
+	}
+	Event* pEvent = AddEvent( pName, startTime, m_pClock->GetThreadId() );
+	if( pEvent )
+	{
+		pEvent->duration = endTime - startTime;
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// GPU events
+//--------------------------------------------------------------------------------------
+void TraceRecorder::MarkGPUFrameStart()
+{
+	if( STATE_RECORDING == m_State )
+	{
+		m_GPUFrameStarts[ m_GPUFrameCount % MAX_GPU_LATENCY ] = m_pClock->GetTime();
+	}
+	++m_GPUFrameCount;
+}
+
+void TraceRecorder::AddGPUFrame( unsigned int latency, const GPUProfileResult* pResults, unsigned int numResults )
+{
+	if( ( STATE_RECORDING != m_State && STATE_DRAINING != m_State ) || latency >= MAX_GPU_LATENCY )
+	{
+		return;
+	}
+	AddGPUFrame( latency, m_GPUFrameStarts[ ( m_GPUFrameCount - 1 - latency ) % MAX_GPU_LATENCY ], pResults, numResults );
+}
+
+void TraceRecorder::AddGPUFrame( unsigned int latency, double gpuFrameStart, const GPUProfileResult* pResults, unsigned int numResults )
+{
+	if( ( STATE_RECORDING != m_State && STATE_DRAINING != m_State ) || latency >= MAX_GPU_LATENCY )
+	{
+		return;
+	}
+
+	// the frame the results belong to must have been recorded
+	unsigned int gpuFrame = m_GPUFrameCount - 1 - latency;
+	if( (int)( gpuFrame - m_FirstGPUFrame ) < 0 ||
+		( STATE_DRAINING == m_State && (int)( gpuFrame - m_EndGPUFrame ) >= 0 ) )
+	{
+		return;
+	}
+
+	for( unsigned int result = 0; result < numResults; ++result )
+	{
+		Event* pEvent = AddEvent( pResults[ result ].pName, gpuFrameStart + pResults[ result ].start, 0 );
+		if( !pEvent )
+		{
+			return;
+		}
+		pEvent->duration = pResults[ result ].time;
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Writing
+//--------------------------------------------------------------------------------------
+void TraceRecorder::FinishCapture()
+{
+	m_State		= STATE_WRITING;
+	m_bWritten	= false;
+	m_Writer	= std::thread( &TraceRecorder::WriterThread, this );
+}
+
+void TraceRecorder::WaitForWriter()
+{
+	if( m_Writer.joinable() )
+	{
+		m_Writer.join();
+		m_State = STATE_IDLE;
+	}
+}
+
+void TraceRecorder::WriterThread()
+{
+	Write();
+	m_bWritten = true;
+}
+
+void TraceRecorder::Write()
+{
+	FILE* pFile = NULL;
+#ifdef _MSC_VER
+	if( 0 != _wfopen_s( &pFile, m_FileName, L"w" ) )
+	{
+		pFile = NULL;
+	}
+#else
+	char fileName[ MAX_FILE_NAME * 4 ];
+	if( (size_t)-1 != wcstombs( fileName, m_FileName, sizeof( fileName ) - 1 ) )
+	{
+		fileName[ sizeof( fileName ) - 1 ] = 0;
+		pFile = fopen( fileName, "w" );
+	}
+#endif
+	if( !pFile )
+	{
+		return;
+	}
+
+	// complete ("X") events, times in microseconds from the start of the capture
+	fprintf( pFile, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n" );
+	fprintf( pFile, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"DynamicResolutionRendering\"}},\n" );
+	fprintf( pFile, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"CPU Render\"}},\n", m_ThreadId );
+	fprintf( pFile, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"GPU\"}}" );
+	for( unsigned int eventIndex = 0; eventIndex < m_NumEvents; ++eventIndex )
+	{
+		const Event& event = m_pEvents[ eventIndex ];
+		fprintf( pFile, ",\n{\"name\":\"" );
+		for( const char* pChar = event.pName; *pChar; ++pChar )
+		{
+			if( (unsigned char)*pChar < 0x20 )
+			{
+				// control characters are not allowed in JSON strings
+				fprintf( pFile, "\\u%04x", (unsigned int)*pChar );
+				continue;
+			}
+			if( '"' == *pChar || '\\' == *pChar )
+			{
+				fputc( '\\', pFile );
+			}
+			fputc( *pChar, pFile );
+		}
+		fprintf( pFile, "\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+			event.threadId ? "cpu" : "gpu", event.threadId,
+			( event.start - m_CaptureStart ) * 1.0e6, event.duration * 1.0e6 );
+	}
+	fprintf( pFile, "\n]}\n" );
+	fclose( pFile );
+}
@@ -0,0 +1,209 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Note: like TelemetryLogger.h this file has no D3D or DXUT dependencies, the clock and
+// thread ids come from an ITraceClock so the recorder can be tested headless.
+
+#include <atomic>
+#include <thread>
+
+struct GPUProfileResult;
+
+//--------------------------------------------------------------------------------------
+// Source of times and thread ids for a TraceRecorder. The sample's uses the DXUT global
+// timer, so explicit events can use the same times the sample already measures.
+//--------------------------------------------------------------------------------------
+class ITraceClock
+{
+public:
+	virtual ~ITraceClock() {}
+
+	// Absolute time in seconds
+	virtual double			GetTime() = 0;
+
+	// Id of the calling thread, not 0, which is the GPU track
+	virtual unsigned int	GetThreadId() = 0;
+};
+
+//--------------------------------------------------------------------------------------
+// Records CPU scopes and GPU profiler intervals for a number of frames, then writes them
+// on a background thread as Chrome trace event JSON, which loads in chrome://tracing and
+// Perfetto. Times are in the clock's absolute time.
+//
+// Recording is from the render thread only. The event buffer is allocated at
+// construction, and when not recording a CPU scope costs a single test.
+//
+// GPU intervals are placed on their own track. GPU timestamps are not in CPU time, so
+// each frame starts at the CPU time its submission began (see MarkGPUFrameStart()),
+// unless the CPU time the GPU started it is known from a GPUClockCalibration.
+//--------------------------------------------------------------------------------------
+class TraceRecorder
+{
+public:
+	enum { MAX_SCOPE_DEPTH = 32, MAX_GPU_LATENCY = 8, MAX_FILE_NAME = 260 };
+
+	TraceRecorder( ITraceClock* pClock, unsigned int maxEvents = 65536 );
+	~TraceRecorder();
+
+	// Record the next numFrames frames to pFileName. Returns false if a capture is in
+	// progress or the last one is still being written.
+	bool Start( const wchar_t* pFileName, unsigned int numFrames );
+
+	// End the capture early, writing what has been recorded
+	void Stop();
+
+	bool IsCapturing() const
+	{
+		return STATE_IDLE != m_State;
+	}
+	bool IsRecording() const
+	{
+		return STATE_RECORDING == m_State;
+	}
+
+	// Call at the start of each frame with the clock's absolute time
+	void BeginFrame( double frameStartTime );
+
+	// CPU scopes, must nest
+	void BeginScope( const char* pName );
+	void EndScope();
+
+	// CPU event with absolute times, for work outside a scope such as Present
+	void AddCPUEvent( const char* pName, double startTime, double endTime );
+
+	// Call each frame where the GPU profiler frame begins, after GPUProfiler::BeginFrame()
+	void MarkGPUFrameStart();
+
+	// GPU results of the frame which began latency frames ago, e.g. from
+	// GPUProfiler::GetLastLatency() when GPUProfiler::HaveNewResults()
+	void AddGPUFrame( unsigned int latency, const GPUProfileResult* pResults, unsigned int numResults );
+
+	// As above, with the frame placed at gpuFrameStart, the absolute time at which the
+	// GPU began the frame's first scope
+	void AddGPUFrame( unsigned int latency, double gpuFrameStart, const GPUProfileResult* pResults, unsigned int numResults );
+
+	// Events recorded, and not recorded as the buffer was full, for the last capture
+	unsigned int GetNumEvents() const
+	{
+		return m_NumEvents;
+	}
+	unsigned int GetNumDroppedEvents() const
+	{
+		return m_NumDroppedEvents;
+	}
+
+	// Recorder used by TRACE_CPU_SCOPE, may be NULL
+	static void SetActive( TraceRecorder* pRecorder )
+	{
+		s_pActive = pRecorder;
+	}
+	static TraceRecorder* GetActiveRecording()
+	{
+		return s_pActive && s_pActive->IsRecording() ? s_pActive : NULL;
+	}
+
+private:
+	enum STATE
+	{
+		STATE_IDLE,
+		STATE_PENDING,		// started, waiting for the first frame
+		STATE_RECORDING,
+		STATE_DRAINING,		// frames done, waiting for GPU results of the last frames
+		STATE_WRITING,
+	};
+
+	struct Event
+	{
+		const char*		pName;
+		double			start;		// absolute time
+		double			duration;
+		unsigned int	threadId;	// 0 for the GPU
+	};
+
+	Event* AddEvent( const char* pName, double start, unsigned int threadId );
+	void FinishCapture();
+	void WaitForWriter();
+	void Write();
+	void WriterThread();
+
+	ITraceClock*	m_pClock;
+	Event*			m_pEvents;
+	unsigned int	m_MaxEvents;
+	unsigned int	m_NumEvents;
+	unsigned int	m_NumDroppedEvents;
+
+	STATE			m_State;
+	wchar_t			m_FileName[ MAX_FILE_NAME ];
+	unsigned int	m_NumFrames;		// frames to record
+	unsigned int	m_FrameCount;		// frames recorded
+	unsigned int	m_DrainCount;
+	double			m_CaptureStart;
+	unsigned int	m_ThreadId;
+	std::thread		m_Writer;
+	std::atomic<bool> m_bWritten;		// set by the writer thread when done
+
+	// open CPU scopes, MAX_EVENTS for scopes which were dropped
+	unsigned int	m_ScopeStack[ MAX_SCOPE_DEPTH ];
+	unsigned int	m_ScopeDepth;
+	unsigned int	m_FrameEvent;
+
+	// CPU time each GPU frame began, by GPU frame count
+	double			m_GPUFrameStarts[ MAX_GPU_LATENCY ];
+	unsigned int	m_GPUFrameCount;
+	unsigned int	m_FirstGPUFrame;	// first GPU frame of the capture
+	unsigned int	m_EndGPUFrame;		// GPU frame count when the capture stopped recording
+
+	static TraceRecorder*	s_pActive;
+
+	//prevent assign and copy
+	TraceRecorder( const TraceRecorder& rhs );
+	TraceRecorder& operator=( const TraceRecorder& rhs );
+};
+
+//--------------------------------------------------------------------------------------
+// CPU scope for the active recorder, closed when it goes out of scope
+//--------------------------------------------------------------------------------------
+class TraceScope
+{
+public:
+	TraceScope( const char* pName )
+		: m_pRecorder( TraceRecorder::GetActiveRecording() )
+	{
+		if( m_pRecorder )
+		{
+			m_pRecorder->BeginScope( pName );
+		}
+	}
+	~TraceScope()
+	{
+		if( m_pRecorder )
+		{
+			m_pRecorder->EndScope();
+		}
+	}
+
+private:
+	TraceRecorder*	m_pRecorder;
+
+	//prevent assign and copy
+	TraceScope( const TraceScope& rhs );
+	TraceScope& operator=( const TraceScope& rhs );
+};
+
+#define TRACE_CPU_SCOPE_JOIN2( a, b )	a##b
+#define TRACE_CPU_SCOPE_JOIN( a, b )	TRACE_CPU_SCOPE_JOIN2( a, b )
+#define TRACE_CPU_SCOPE( name )			TraceScope TRACE_CPU_SCOPE_JOIN( traceScope, __LINE__ )( name )
@@ -0,0 +1,267 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "UnitTest.h"
+#include "AnimationCompression.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+namespace
+{
+	const unsigned int cNumKeys	= 50;
+	const float cMaxError		= 0.001f;
+
+	float RandomRange( float minValue, float maxValue )
+	{
+		return minValue + ( maxValue - minValue ) * (float)rand() / (float)RAND_MAX;
+	}
+
+	void RandomRotation( float* pRotation )
+	{
+		float lengthSq = 0.0f;
+		for( unsigned int i = 0; i < 4; ++i )
+		{
+			pRotation[i] = RandomRange( -1.0f, 1.0f );
+			lengthSq += pRotation[i] * pRotation[i];
+		}
+		float invLength = 1.0f / sqrtf( lengthSq );
+		for( unsigned int i = 0; i < 4; ++i )
+		{
+			pRotation[i] *= invLength;
+		}
+	}
+
+	// Largest component difference, after flipping the decoded rotation into the
+	// original's hemisphere as q and -q are the same rotation
+	float RotationError( const float* pRotation, const float* pDecoded )
+	{
+		float dot = 0.0f;
+		for( unsigned int i = 0; i < 4; ++i )
+		{
+			dot += pRotation[i] * pDecoded[i];
+		}
+		float sign = dot < 0.0f ? -1.0f : 1.0f;
+		float maxError = 0.0f;
+		for( unsigned int i = 0; i < 4; ++i )
+		{
+			float error = fabsf( pRotation[i] - sign * pDecoded[i] );
+			maxError = error > maxError ? error : maxError;
+		}
+		return maxError;
+	}
+
+	float VectorError( const float* pValue, const float* pDecoded )
+	{
+		float maxError = 0.0f;
+		for( unsigned int i = 0; i < 3; ++i )
+		{
+			float error = fabsf( pValue[i] - pDecoded[i] );
+			maxError = error > maxError ? error : maxError;
+		}
+		return maxError;
+	}
+
+	// Compress tracks and return the largest errors of their decoded keys
+	void RoundTrip( const CompressedAnimation& animation, const std::vector<AnimationKey>& keys,
+					float* pTranslationError, float* pRotationError, float* pScaleError )
+	{
+		*pTranslationError = *pRotationError = *pScaleError = 0.0f;
+		for( unsigned int track = 0; track < animation.GetNumTracks(); ++track )
+		{
+			for( unsigned int key = 0; key < animation.GetNumKeys(); ++key )
+			{
+				const AnimationKey& rKey = keys[ track * animation.GetNumKeys() + key ];
+				AnimationKey decoded;
+				animation.DecodeKey( track, key, &decoded );
+
+				float error = VectorError( rKey.translation, decoded.translation );
+				*pTranslationError = error > *pTranslationError ? error : *pTranslationError;
+				error = RotationError( rKey.rotation, decoded.rotation );
+				*pRotationError = error > *pRotationError ? error : *pRotationError;
+				error = VectorError( rKey.scale, decoded.scale );
+				*pScaleError = error > *pScaleError ? error : *pScaleError;
+			}
+		}
+	}
+}
+
+UNIT_TEST( AnimationCompressionRoundTripWithinError )
+{
+	// keyed tracks decode within half a quantization step of their range
+	const unsigned int numTracks = 8;
+	const char* names[ numTracks ] = { "root", "spine", "neck", "head", "arm_l", "arm_r", "leg_l", "leg_r" };
+	std::vector<AnimationKey> keys( numTracks * cNumKeys );
+	srand( 11 );
+	for( unsigned int i = 0; i < keys.size(); ++i )
+	{
+		for( unsigned int c = 0; c < 3; ++c )
+		{
+			keys[i].translation[c] = RandomRange( -5.0f, 5.0f );
+			keys[i].scale[c] = RandomRange( 0.5f, 2.0f );
+		}
+		RandomRotation( keys[i].rotation );
+	}
+
+	CompressedAnimation animation;
+	animation.Compress( numTracks, cNumKeys, 30, 0, names, &keys[0], cMaxError );
+	CHECK( animation.IsValid() );
+	CHECK( numTracks == animation.GetNumTracks() );
+	CHECK( cNumKeys == animation.GetNumKeys() );
+	CHECK( 30 == animation.GetFPS() );
+	CHECK( 0 == strcmp( "arm_r", animation.GetTrack( 5 ).name ) );
+
+	float translationError, rotationError, scaleError;
+	RoundTrip( animation, keys, &translationError, &rotationError, &scaleError );
+	CHECK( translationError <= 0.5f * 10.0f / 0xffff + 1e-5f );
+	CHECK( scaleError <= 0.5f * 1.5f / 0xffff + 1e-5f );
+	CHECK( rotationError <= 1e-4f );
+
+	// 16 bit translation and scale and a 6 byte rotation
+	CHECK( ( COMPRESSED_TRACK_KEYED_TRANSLATION | COMPRESSED_TRACK_KEYED_ROTATION | COMPRESSED_TRACK_KEYED_SCALE ) == animation.GetTrack( 0 ).flags );
+	CHECK( 18 == animation.GetTrack( 0 ).keySize );
+}
+
+UNIT_TEST( AnimationCompressionConstantPartsExact )
+{
+	// parts the same in every key are stored once and decode exactly, and all zero
+	// rotations decode as the identity
+	const char* names[ 2 ] = { "still", "moving" };
+	std::vector<AnimationKey> keys( 2 * cNumKeys );
+	srand( 13 );
+	for( unsigned int key = 0; key < cNumKeys; ++key )
+	{
+		AnimationKey& rStill = keys[ key ];
+		rStill.translation[0] = 1.25f; rStill.translation[1] = -3.7f; rStill.translation[2] = 0.1f;
+		memset( rStill.rotation, 0, sizeof( rStill.rotation ) );
+		rStill.scale[0] = rStill.scale[1] = rStill.scale[2] = 1.0f;
+
+		AnimationKey& rMoving = keys[ cNumKeys + key ];
+		rMoving.translation[0] = rMoving.translation[1] = rMoving.translation[2] = 2.0f;
+		RandomRotation( rMoving.rotation );
+		rMoving.scale[0] = rMoving.scale[1] = rMoving.scale[2] = 1.0f;
+	}
+
+	CompressedAnimation animation;
+	animation.Compress( 2, cNumKeys, 30, 0, names, &keys[0], cMaxError );
+	CHECK( 0 == animation.GetTrack( 0 ).flags );
+	CHECK( 0 == animation.GetTrack( 0 ).keySize );
+	CHECK( COMPRESSED_TRACK_KEYED_ROTATION == animation.GetTrack( 1 ).flags );
+	CHECK( 6 == animation.GetTrack( 1 ).keySize );
+
+	bool bExact = true;
+	for( unsigned int key = 0; key < cNumKeys; ++key )
+	{
+		AnimationKey decoded;
+		animation.DecodeKey( 0, key, &decoded );
+		bExact &= 0 == memcmp( keys[ key ].translation, decoded.translation, sizeof( decoded.translation ) );
+		bExact &= 0 == memcmp( keys[ key ].scale, decoded.scale, sizeof( decoded.scale ) );
+		bExact &= 0.0f == decoded.rotation[0] && 0.0f == decoded.rotation[1] && 0.0f == decoded.rotation[2] && 1.0f == decoded.rotation[3];
+
+		animation.DecodeKey( 1, key, &decoded );
+		bExact &= 2.0f == decoded.translation[0] && 2.0f == decoded.translation[1] && 2.0f == decoded.translation[2];
+		bExact &= 1.0f == decoded.scale[0] && 1.0f == decoded.scale[1] && 1.0f == decoded.scale[2];
+	}
+	CHECK( bExact );
+}
+
+UNIT_TEST( AnimationCompressionWidensLargeRanges )
+{
+	// a range too large for 16 bits within maxError is stored in 32 bits
+	const char* names[ 1 ] = { "far" };
+	std::vector<AnimationKey> keys( cNumKeys );
+	srand( 17 );
+	for( unsigned int key = 0; key < cNumKeys; ++key )
+	{
+		for( unsigned int c = 0; c < 3; ++c )
+		{
+			keys[ key ].translation[c] = RandomRange( -1000.0f, 1000.0f );
+			keys[ key ].scale[c] = RandomRange( 0.9f, 1.1f );
+		}
+		keys[ key ].rotation[0] = keys[ key ].rotation[1] = keys[ key ].rotation[2] = 0.0f;
+		keys[ key ].rotation[3] = 1.0f;
+	}
+
+	CompressedAnimation animation;
+	animation.Compress( 1, cNumKeys, 30, 0, names, &keys[0], cMaxError );
+	const CompressedAnimationTrack& rTrack = animation.GetTrack( 0 );
+	CHECK( 0 != ( rTrack.flags & COMPRESSED_TRACK_WIDE_TRANSLATION ) );
+	CHECK( 0 == ( rTrack.flags & COMPRESSED_TRACK_WIDE_SCALE ) );
+	CHECK( 0 == ( rTrack.flags & COMPRESSED_TRACK_KEYED_ROTATION ) );
+	CHECK( 18 == rTrack.keySize );
+
+	float translationError, rotationError, scaleError;
+	RoundTrip( animation, keys, &translationError, &rotationError, &scaleError );
+	CHECK( translationError <= cMaxError );
+	CHECK( scaleError <= cMaxError );
+	CHECK( 0.0f == rotationError );
+}
+
+UNIT_TEST( AnimationCompressionSetDataValidates )
+{
+	// file data round trips through SetData, and truncated or foreign data is rejected
+	const char* names[ 2 ] = { "a", "b" };
+	std::vector<AnimationKey> keys( 2 * cNumKeys );
+	srand( 19 );
+	for( unsigned int i = 0; i < keys.size(); ++i )
+	{
+		for( unsigned int c = 0; c < 3; ++c )
+		{
+			keys[i].translation[c] = RandomRange( -1.0f, 1.0f );
+			keys[i].scale[c] = 1.0f;
+		}
+		RandomRotation( keys[i].rotation );
+	}
+
+	CompressedAnimation animation;
+	animation.Compress( 2, cNumKeys, 24, 1, names, &keys[0], cMaxError );
+	std::vector<unsigned char> data( animation.GetData(), animation.GetData() + animation.GetDataSize() );
+
+	CompressedAnimation loaded;
+	CHECK( loaded.SetData( &data[0], data.size() ) );
+	CHECK( data.size() == loaded.GetDataSize() );
+	CHECK( 0 == memcmp( &data[0], loaded.GetData(), data.size() ) );
+	CHECK( 24 == loaded.GetFPS() );
+	CHECK( 1 == loaded.GetFrameTransformType() );
+
+	bool bSameKeys = true;
+	for( unsigned int track = 0; track < 2; ++track )
+	{
+		for( unsigned int key = 0; key < cNumKeys; ++key )
+		{
+			AnimationKey expected, decoded;
+			animation.DecodeKey( track, key, &expected );
+			loaded.DecodeKey( track, key, &decoded );
+			bSameKeys &= 0 == memcmp( &expected, &decoded, sizeof( decoded ) );
+		}
+	}
+	CHECK( bSameKeys );
+
+	CHECK( !loaded.SetData( &data[0], data.size() - 1 ) );
+	CHECK( !loaded.IsValid() );
+	CHECK( !loaded.SetData( NULL, 0 ) );
+
+	std::vector<unsigned char> foreign( data );
+	foreign[0] ^= 0xff;
+	CHECK( !loaded.SetData( &foreign[0], foreign.size() ) );
+
+	// a track claiming keys past the key data
+	std::vector<unsigned char> overrun( data );
+	CompressedAnimationTrack* pTrack = (CompressedAnimationTrack*)( &overrun[0] + sizeof( CompressedAnimationFileHeader ) ) + 1;
+	pTrack->keyOffset += pTrack->keySize;
+	CHECK( !loaded.SetData( &overrun[0], overrun.size() ) );
+}
@@ -0,0 +1,260 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "UnitTest.h"
+#include "AnimationKernels.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace
+{
+	// Value of output guards, which no kernel would write from inputs guarded by zeros
+	const float cGuard = -12345.0f;
+
+	// Streams with a guard float in front of each and after the last, so the kernels see
+	// unaligned data and writes outside a stream can be detected
+	struct TrackData
+	{
+		explicit TrackData( unsigned int count, float guard = 0.0f )
+			: m_Data( 4 * ( count + 1 ) + 1, guard )
+			, m_Count( count )
+			, m_Guard( guard )
+		{
+		}
+
+		Vector3Streams Vector3()
+		{
+			Vector3Streams streams = { Stream( 0 ), Stream( 1 ), Stream( 2 ) };
+			return streams;
+		}
+		QuaternionStreams Quaternion()
+		{
+			QuaternionStreams streams = { Stream( 0 ), Stream( 1 ), Stream( 2 ), Stream( 3 ) };
+			return streams;
+		}
+		float* Stream( unsigned int component )
+		{
+			return &m_Data[ component * ( m_Count + 1 ) + 1 ];
+		}
+		bool GuardsIntact() const
+		{
+			bool bIntact = m_Guard == m_Data.back();
+			for( unsigned int component = 0; component < 4; ++component )
+			{
+				bIntact &= m_Guard == m_Data[ component * ( m_Count + 1 ) ];
+			}
+			return bIntact;
+		}
+
+		std::vector<float>	m_Data;
+		unsigned int		m_Count;
+		float				m_Guard;
+	};
+
+	float RandomFloat( float minValue, float maxValue )
+	{
+		return minValue + ( maxValue - minValue ) * (float)rand() / (float)RAND_MAX;
+	}
+
+	void RandomVector3s( TrackData* pData )
+	{
+		for( unsigned int i = 0; i < pData->m_Count; ++i )
+		{
+			pData->Stream( 0 )[i] = RandomFloat( -10.0f, 10.0f );
+			pData->Stream( 1 )[i] = RandomFloat( -10.0f, 10.0f );
+			pData->Stream( 2 )[i] = RandomFloat( -10.0f, 10.0f );
+		}
+	}
+
+	// Unit quaternions, every fourth one close to the previous key of its track
+	void RandomQuaternions( TrackData* pData, const TrackData* pNear )
+	{
+		for( unsigned int i = 0; i < pData->m_Count; ++i )
+		{
+			float q[4];
+			float length = 0.0f;
+			for( unsigned int c = 0; c < 4; ++c )
+			{
+				q[c] = RandomFloat( -1.0f, 1.0f );
+				if( pNear && 0 == i % 4 )
+				{
+					q[c] = const_cast<TrackData*>( pNear )->Stream( c )[i] + 1.0e-4f * q[c];
+				}
+				length += q[c] * q[c];
+			}
+			length = sqrtf( length );
+			for( unsigned int c = 0; c < 4; ++c )
+			{
+				pData->Stream( c )[i] = q[c] / length;
+			}
+		}
+	}
+
+	float MaxDifference( const std::vector<float>& a, const std::vector<float>& b )
+	{
+		float maxDifference = 0.0f;
+		for( unsigned int i = 0; i < a.size(); ++i )
+		{
+			float difference = fabsf( a[i] - b[i] );
+			maxDifference = difference > maxDifference ? difference : maxDifference;
+		}
+		return maxDifference;
+	}
+
+	// Slerp in double precision with acos and sin, along the shorter arc
+	void ReferenceSlerp( const double* a, const double* b, double t, double* pOut )
+	{
+		double dot = a[0]*b[0] + a[1]*b[1] + a[2]*b[2] + a[3]*b[3];
+		double sign = dot < 0.0 ? -1.0 : 1.0;
+		dot *= sign;
+		double wa = 1.0 - t;
+		double wb = t;
+		if( dot < 1.0 - 1.0e-9 )
+		{
+			double angle = acos( dot );
+			wa = sin( ( 1.0 - t ) * angle ) / sin( angle );
+			wb = sin( t * angle ) / sin( angle );
+		}
+		for( unsigned int c = 0; c < 4; ++c )
+		{
+			pOut[c] = wa * a[c] + sign * wb * b[c];
+		}
+	}
+}
+
+UNIT_TEST( AnimationKernelsMatchScalar )
+{
+	// every count up to three blocks of four, so all tail lengths are covered
+	srand( 5 );
+	bool bMatch = true;
+	for( unsigned int count = 0; count <= 12; ++count )
+	{
+		TrackData va( count ), vb( count ), qa( count ), qb( count );
+		RandomVector3s( &va );
+		RandomVector3s( &vb );
+		RandomQuaternions( &qa, NULL );
+		RandomQuaternions( &qb, &qa );
+
+		TrackData out( count, cGuard ), outScalar( count, cGuard );
+		LerpVector3s( count, 0.3f, va.Vector3(), vb.Vector3(), out.Vector3() );
+		LerpVector3sScalar( count, 0.3f, va.Vector3(), vb.Vector3(), outScalar.Vector3() );
+		bMatch &= MaxDifference( out.m_Data, outScalar.m_Data ) < 1.0e-5f;
+		bMatch &= out.GuardsIntact();
+
+		NlerpQuaternions( count, 0.3f, qa.Quaternion(), qb.Quaternion(), out.Quaternion() );
+		NlerpQuaternionsScalar( count, 0.3f, qa.Quaternion(), qb.Quaternion(), outScalar.Quaternion() );
+		bMatch &= MaxDifference( out.m_Data, outScalar.m_Data ) < 1.0e-6f;
+
+		SlerpQuaternions( count, 0.7f, qa.Quaternion(), qb.Quaternion(), out.Quaternion() );
+		SlerpQuaternionsScalar( count, 0.7f, qa.Quaternion(), qb.Quaternion(), outScalar.Quaternion() );
+		bMatch &= MaxDifference( out.m_Data, outScalar.m_Data ) < 1.0e-6f;
+
+		std::vector<float> transforms( count * cAffineTransformFloats + 2, cGuard );
+		std::vector<float> transformsScalar( count * cAffineTransformFloats + 2, cGuard );
+		ComposeAffineTransforms( count, va.Vector3(), qa.Quaternion(), vb.Vector3(), &transforms[1] );
+		ComposeAffineTransformsScalar( count, va.Vector3(), qa.Quaternion(), vb.Vector3(), &transformsScalar[1] );
+		bMatch &= MaxDifference( transforms, transformsScalar ) < 1.0e-5f;
+
+		// writes stay within the streams
+		bMatch &= out.GuardsIntact();
+		bMatch &= cGuard == transforms.front() && cGuard == transforms.back();
+	}
+	CHECK( bMatch );
+}
+
+UNIT_TEST( AnimationKernelsSlerpMatchesReference )
+{
+	const unsigned int count = 64;
+	srand( 9 );
+	TrackData qa( count ), qb( count ), out( count );
+	RandomQuaternions( &qa, NULL );
+	RandomQuaternions( &qb, &qa );
+
+	const float times[] = { 0.0f, 0.25f, 0.5f, 0.9f, 1.0f };
+	float maxError = 0.0f;
+	for( unsigned int time = 0; time < sizeof( times ) / sizeof( times[0] ); ++time )
+	{
+		SlerpQuaternions( count, times[ time ], qa.Quaternion(), qb.Quaternion(), out.Quaternion() );
+		for( unsigned int i = 0; i < count; ++i )
+		{
+			double a[4], b[4], expected[4];
+			for( unsigned int c = 0; c < 4; ++c )
+			{
+				a[c] = qa.Stream( c )[i];
+				b[c] = qb.Stream( c )[i];
+			}
+			ReferenceSlerp( a, b, times[ time ], expected );
+			for( unsigned int c = 0; c < 4; ++c )
+			{
+				float error = (float)fabs( out.Stream( c )[i] - expected[c] );
+				maxError = error > maxError ? error : maxError;
+			}
+		}
+	}
+	CHECK( maxError < 1.0e-5f );
+}
+
+UNIT_TEST( AnimationKernelsNormalize )
+{
+	TrackData q( 5 );
+	q.Stream( 0 )[0] = 3.0f;
+	q.Stream( 3 )[0] = 4.0f;
+	q.Stream( 1 )[4] = -2.0f;
+	NormalizeQuaternions( 5, q.Quaternion() );
+	CHECK_CLOSE( q.Stream( 0 )[0], 0.6, 1.0e-6 );
+	CHECK_CLOSE( q.Stream( 3 )[0], 0.8, 1.0e-6 );
+	CHECK_CLOSE( q.Stream( 1 )[4], -1.0, 1.0e-6 );
+
+	// all zero quaternions are no rotation
+	for( unsigned int i = 1; i < 4; ++i )
+	{
+		CHECK( 0.0f == q.Stream( 0 )[i] && 0.0f == q.Stream( 1 )[i] && 0.0f == q.Stream( 2 )[i] );
+		CHECK_CLOSE( q.Stream( 3 )[i], 1.0, 1.0e-6 );
+	}
+}
+
+UNIT_TEST( AnimationKernelsCompose )
+{
+	// scale x by 2, rotate 90 degrees about z, then translate: row vectors, so the
+	// x axis becomes 2 * ( 0, 1, 0 )
+	TrackData scale( 1 ), rotation( 1 ), translation( 1 );
+	scale.Stream( 0 )[0] = 2.0f;
+	scale.Stream( 1 )[0] = 1.0f;
+	scale.Stream( 2 )[0] = 1.0f;
+	rotation.Stream( 2 )[0] = sqrtf( 0.5f );
+	rotation.Stream( 3 )[0] = sqrtf( 0.5f );
+	translation.Stream( 0 )[0] = 1.0f;
+	translation.Stream( 1 )[0] = 2.0f;
+	translation.Stream( 2 )[0] = 3.0f;
+
+	float transform[ cAffineTransformFloats ];
+	ComposeAffineTransforms( 1, scale.Vector3(), rotation.Quaternion(), translation.Vector3(), transform );
+	const float expected[ cAffineTransformFloats ] =
+	{
+		0.0f, 2.0f, 0.0f,
+		-1.0f, 0.0f, 0.0f,
+		0.0f, 0.0f, 1.0f,
+		1.0f, 2.0f, 3.0f,
+	};
+	float maxError = 0.0f;
+	for( unsigned int i = 0; i < cAffineTransformFloats; ++i )
+	{
+		float error = fabsf( transform[i] - expected[i] );
+		maxError = error > maxError ? error : maxError;
+	}
+	CHECK( maxError < 1.0e-6f );
+}
@@ -0,0 +1,103 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "UnitTest.h"
+#include "FixedTimestep.h"
+
+#include <stdlib.h>
+
+UNIT_TEST( FixedTimestepStepsIndependentOfFrameTimes )
+{
+	// the same simulated time in steady and uneven frames gives identical step times
+	FixedTimestep steady( 60.0f, 1000 );
+	FixedTimestep uneven( 60.0f, 1000 );
+	srand( 7 );
+	double unevenTime = 0.0;
+	bool bStepTimesMatch = true;
+	for( unsigned int frame = 0; frame < 600; ++frame )
+	{
+		float elapsedTime = ( 5.0f + 45.0f * (float)rand() / (float)RAND_MAX ) * 0.001f;
+		unsigned int numSteps = uneven.Advance( elapsedTime );
+		unevenTime += elapsedTime;
+		for( unsigned int step = 0; step < numSteps; ++step )
+		{
+			unsigned long long stepNumber = uneven.GetNumSteps() - numSteps + step + 1;
+			bStepTimesMatch &= uneven.GetStepEndTime( step ) == stepNumber * (double)uneven.GetStepTime();
+		}
+	}
+	while( steady.GetNumSteps() < uneven.GetNumSteps() )
+	{
+		steady.Advance( steady.GetStepTime() );
+	}
+	CHECK( bStepTimesMatch );
+	CHECK( steady.GetTime() == uneven.GetTime() );
+	CHECK( 0 == uneven.GetNumDroppedSteps() );
+	CHECK_CLOSE( uneven.GetTime() + uneven.GetInterpolation() * uneven.GetStepTime(), unevenTime, 1.0e-4 );
+}
+
+UNIT_TEST( FixedTimestepInterpolation )
+{
+	FixedTimestep timestep( 40.0f, 4 );
+	CHECK( 0 == timestep.Advance( 0.0125f ) );
+	CHECK_CLOSE( timestep.GetInterpolation(), 0.5, 1.0e-5 );
+	CHECK( 1 == timestep.Advance( 0.025f ) );
+	CHECK_CLOSE( timestep.GetInterpolation(), 0.5, 1.0e-5 );
+	CHECK_CLOSE( timestep.GetTime(), 0.025, 1.0e-7 );
+	CHECK_CLOSE( timestep.GetStepEndTime( 0 ), 0.025, 1.0e-7 );
+
+	// negative frame times are ignored
+	CHECK( 0 == timestep.Advance( -1.0f ) );
+	CHECK_CLOSE( timestep.GetInterpolation(), 0.5, 1.0e-5 );
+}
+
+UNIT_TEST( FixedTimestepLimitsStepsPerFrame )
+{
+	// a 6.6 step hitch simulates 4 steps and drops 2, keeping the fraction
+	FixedTimestep timestep( 40.0f, 4 );
+	CHECK( 4 == timestep.Advance( 0.165f ) );
+	CHECK( 2 == timestep.GetNumDroppedSteps() );
+	CHECK( 4 == timestep.GetNumSteps() );
+	CHECK_CLOSE( timestep.GetInterpolation(), 0.6, 1.0e-4 );
+	CHECK_CLOSE( timestep.GetStepEndTime( 3 ), 0.1, 1.0e-7 );
+
+	timestep.SetMaxStepsPerFrame( 0 );
+	CHECK( 1 == timestep.GetMaxStepsPerFrame() );
+	CHECK( 1 == timestep.Advance( 0.05f ) );
+	CHECK( 3 == timestep.GetNumDroppedSteps() );
+}
+
+UNIT_TEST( FixedTimestepRateChangeKeepsTime )
+{
+	FixedTimestep timestep( 40.0f, 4 );
+	CHECK( 2 == timestep.Advance( 0.0625f ) );
+	timestep.SetStepRate( 20.0f );
+	CHECK_CLOSE( timestep.GetTime(), 0.05, 1.0e-7 );
+	CHECK_CLOSE( timestep.GetInterpolation(), 0.5, 1.0e-5 );
+	CHECK_CLOSE( timestep.GetStepTime(), 0.05, 1.0e-7 );
+
+	// the half step kept is a half step at the new rate
+	CHECK( 1 == timestep.Advance( 0.03f ) );
+	CHECK_CLOSE( timestep.GetTime(), 0.1, 1.0e-7 );
+	CHECK_CLOSE( timestep.GetInterpolation(), 0.1, 1.0e-4 );
+
+	// invalid rates are ignored
+	timestep.SetStepRate( 0.0f );
+	CHECK( 20.0f == timestep.GetStepRate() );
+
+	timestep.Reset( 2.0 );
+	CHECK( 2.0 == timestep.GetTime() );
+	CHECK( 0 == timestep.GetNumSteps() );
+	CHECK( 0.0f == timestep.GetInterpolation() );
+}
@@ -0,0 +1,97 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "UnitTest.h"
+#include "FrameBoundClassifier.h"
+
+namespace
+{
+	const float cVSyncTime = 1.0f / 60.0f;
+
+	FrameBoundInput MakeInput( float frameTime, float gpuTime, float cpuTime, float targetTime )
+	{
+		FrameBoundInput input;
+		input.frameTime			= frameTime;
+		input.gpuTime			= gpuTime;
+		input.cpuUpdateTime		= 0.25f * cpuTime;
+		input.cpuSubmitTime		= 0.75f * cpuTime;
+		input.cpuPresentTime	= frameTime - cpuTime;
+		input.targetTime		= targetTime;
+		return input;
+	}
+
+	FRAME_BOUND Classify( FrameBoundClassifier* pClassifier, const FrameBoundInput& input, unsigned int numFrames )
+	{
+		for( unsigned int frame = 0; frame < numFrames; ++frame )
+		{
+			pClassifier->Update( input );
+		}
+		return pClassifier->GetBound();
+	}
+}
+
+UNIT_TEST( FrameBoundClassifierLabels )
+{
+	FrameBoundClassifier classifier;
+	CHECK( FRAME_BOUND_UNKNOWN == classifier.GetBound() );
+	CHECK( FRAME_BOUND_GPU == Classify( &classifier, MakeInput( 0.020f, 0.019f, 0.005f, 0.0f ), 1 ) );
+
+	classifier.Reset();
+	CHECK( FRAME_BOUND_CPU == Classify( &classifier, MakeInput( 0.020f, 0.006f, 0.019f, 0.0f ), 1 ) );
+
+	classifier.Reset();
+	CHECK( FRAME_BOUND_PRESENT == Classify( &classifier, MakeInput( cVSyncTime, 0.008f, 0.004f, cVSyncTime ), 1 ) );
+
+	// frames without a frame time are ignored
+	classifier.Reset();
+	CHECK( FRAME_BOUND_UNKNOWN == Classify( &classifier, MakeInput( 0.0f, 0.008f, 0.004f, cVSyncTime ), 10 ) );
+}
+
+UNIT_TEST( FrameBoundClassifierMissedVSync )
+{
+	// a GPU just over the vsync interval doubles the frame time, which must read as GPU
+	// bound rather than waiting in Present
+	FrameBoundClassifier classifier;
+	CHECK( FRAME_BOUND_GPU == Classify( &classifier, MakeInput( 2.0f * cVSyncTime, 0.018f, 0.004f, cVSyncTime ), 1 ) );
+	CHECK( classifier.IsDecreaseAllowed( 0.018f, cVSyncTime ) );
+
+	// without the target the same frame looks idle
+	classifier.Reset();
+	CHECK( FRAME_BOUND_PRESENT == Classify( &classifier, MakeInput( 2.0f * cVSyncTime, 0.018f, 0.004f, 0.0f ), 1 ) );
+}
+
+UNIT_TEST( FrameBoundClassifierNeedsPersistentChange )
+{
+	FrameBoundClassifier classifier( 0.8f, 5, 1.0f );
+	CHECK( FRAME_BOUND_PRESENT == Classify( &classifier, MakeInput( cVSyncTime, 0.008f, 0.004f, cVSyncTime ), 10 ) );
+	CHECK( FRAME_BOUND_PRESENT == Classify( &classifier, MakeInput( cVSyncTime, 0.016f, 0.004f, cVSyncTime ), 4 ) );
+	CHECK( FRAME_BOUND_GPU == Classify( &classifier, MakeInput( cVSyncTime, 0.016f, 0.004f, cVSyncTime ), 1 ) );
+}
+
+UNIT_TEST( FrameBoundGatingAllowsDecreases )
+{
+	// unknown and GPU bound frames may always lower the scale
+	FrameBoundClassifier classifier;
+	CHECK( classifier.IsDecreaseAllowed( 0.0f, cVSyncTime ) );
+	Classify( &classifier, MakeInput( 0.020f, 0.019f, 0.005f, cVSyncTime ), 1 );
+	CHECK( classifier.IsDecreaseAllowed( 0.010f, cVSyncTime ) );
+
+	// CPU bound frames only when the GPU alone is over the target
+	classifier.Reset();
+	CHECK( FRAME_BOUND_CPU == Classify( &classifier, MakeInput( 0.025f, 0.010f, 0.024f, cVSyncTime ), 1 ) );
+	CHECK( !classifier.IsDecreaseAllowed( 0.010f, cVSyncTime ) );
+	CHECK( classifier.IsDecreaseAllowed( 0.020f, cVSyncTime ) );
+	CHECK( !classifier.IsDecreaseAllowed( 0.020f, 0.0f ) );
+}
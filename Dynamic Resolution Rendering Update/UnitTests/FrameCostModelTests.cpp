@@ -0,0 +1,134 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "UnitTest.h"
+#include "FrameCostModel.h"
+
+namespace
+{
+	const float cFullScalePixels	= 1280.0f * 720.0f;
+
+	// 1.5ms fixed and 10ms at full scale
+	const float cFixedCost			= 0.0015f;
+	const float cPerPixelCost		= 0.010f / cFullScalePixels;
+
+	float GetLoadTime( float pixelCount )
+	{
+		return cFixedCost + cPerPixelCost * pixelCount;
+	}
+
+	// pixel counts for a scale swept between 0.5 and 1
+	float GetSweepPixelCount( unsigned int sample )
+	{
+		float scale = 0.5f + 0.05f * ( sample % 11 );
+		return cFullScalePixels * scale * scale;
+	}
+}
+
+UNIT_TEST( LinearCostModelFitsPixelBoundLoad )
+{
+	LinearCostModel model;
+	for( unsigned int sample = 0; sample < 50; ++sample )
+	{
+		float pixelCount = GetSweepPixelCount( sample );
+		model.AddSample( pixelCount, GetLoadTime( pixelCount ) );
+	}
+	CHECK( 50 == model.GetNumSamples() );
+	CHECK_CLOSE( model.GetFixedCost(), cFixedCost, 1.0e-5f );
+	CHECK_CLOSE( model.GetPerPixelCost() / cPerPixelCost, 1.0f, 1.0e-3f );
+	CHECK_CLOSE( model.Predict( 0.25f * cFullScalePixels ), GetLoadTime( 0.25f * cFullScalePixels ), 1.0e-5f );
+}
+
+UNIT_TEST( LinearCostModelAssumesPixelBoundWithoutSlope )
+{
+	// a stationary scale cannot separate the terms, so all the time is per pixel
+	LinearCostModel model;
+	for( unsigned int sample = 0; sample < 10; ++sample )
+	{
+		model.AddSample( cFullScalePixels, GetLoadTime( cFullScalePixels ) );
+	}
+	CHECK( 0.0f == model.GetFixedCost() );
+	CHECK_CLOSE( model.GetPerPixelCost() * cFullScalePixels, GetLoadTime( cFullScalePixels ), 1.0e-6f );
+}
+
+UNIT_TEST( LinearCostModelKeepsSlopeWhenStationary )
+{
+	LinearCostModel model;
+	for( unsigned int sample = 0; sample < 50; ++sample )
+	{
+		float pixelCount = GetSweepPixelCount( sample );
+		model.AddSample( pixelCount, GetLoadTime( pixelCount ) );
+	}
+
+	// once the scale settles the variance decays away but the fitted slope is kept
+	float pixelCount = 0.75f * cFullScalePixels;
+	for( unsigned int sample = 0; sample < 200; ++sample )
+	{
+		model.AddSample( pixelCount, GetLoadTime( pixelCount ) );
+	}
+	CHECK_CLOSE( model.GetPerPixelCost() / cPerPixelCost, 1.0f, 1.0e-3f );
+	CHECK_CLOSE( model.GetFixedCost(), cFixedCost, 1.0e-5f );
+
+	// a scene change at the settled scale still gives the right time at that pixel count
+	for( unsigned int sample = 0; sample < 200; ++sample )
+	{
+		model.AddSample( pixelCount, GetLoadTime( pixelCount ) + 0.002f );
+	}
+	CHECK_CLOSE( model.Predict( pixelCount ), GetLoadTime( pixelCount ) + 0.002f, 1.0e-5f );
+}
+
+UNIT_TEST( LinearCostModelRejectsNegativeTerms )
+{
+	// time falling as the pixel count rises has no physical slope
+	LinearCostModel model;
+	for( unsigned int sample = 0; sample < 20; ++sample )
+	{
+		float pixelCount = GetSweepPixelCount( sample );
+		model.AddSample( pixelCount, 0.02f - cPerPixelCost * pixelCount );
+	}
+	CHECK( model.GetPerPixelCost() >= 0.0f );
+	CHECK( model.GetFixedCost() >= 0.0f );
+
+	// invalid samples are ignored
+	unsigned int numSamples = model.GetNumSamples();
+	model.AddSample( 0.0f, 0.01f );
+	model.AddSample( cFullScalePixels, -0.01f );
+	CHECK( numSamples == model.GetNumSamples() );
+}
+
+UNIT_TEST( FrameCostModelSumsPasses )
+{
+	// a scaling pass and a resolve pass at a fixed 1ms
+	FrameCostModel model( 2 );
+	CHECK( !model.IsValid() );
+	float pixelCount = 0.0f;
+	CHECK( !model.GetPixelCountForTime( 1.0f / 60.0f, &pixelCount ) );
+
+	for( unsigned int sample = 0; sample < 50; ++sample )
+	{
+		float passTimes[2] = { GetLoadTime( GetSweepPixelCount( sample ) ), 0.001f };
+		model.AddSample( GetSweepPixelCount( sample ), passTimes );
+	}
+	CHECK( model.IsValid() );
+	CHECK_CLOSE( model.GetPassModel( 1 ).GetPerPixelCost(), 0.0f, 1.0e-12f );
+	CHECK_CLOSE( model.GetFixedCost(), cFixedCost + 0.001f, 1.0e-5f );
+	CHECK_CLOSE( model.PredictFrameTime( cFullScalePixels ), GetLoadTime( cFullScalePixels ) + 0.001f, 1.0e-5f );
+
+	// the pixel count for a time inverts the prediction
+	CHECK( model.GetPixelCountForTime( 0.008f, &pixelCount ) );
+	CHECK_CLOSE( model.PredictFrameTime( pixelCount ), 0.008f, 1.0e-6f );
+	CHECK( model.GetPixelCountForTime( 0.0f, &pixelCount ) );
+	CHECK( 0.0f == pixelCount );
+}
@@ -0,0 +1,206 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "UnitTest.h"
+#include "FrustumCulling.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <vector>
+
+namespace
+{
+	const unsigned int cNumItems	= 5000;
+	const float cNearPlane			= 1.0f;
+	const float cFarPlane			= 200.0f;
+
+	float RandomRange( float minValue, float maxValue )
+	{
+		return minValue + ( maxValue - minValue ) * (float)rand() / (float)RAND_MAX;
+	}
+
+	void Multiply( const float* pA, const float* pB, float* pOut )
+	{
+		for( unsigned int row = 0; row < 4; ++row )
+		{
+			for( unsigned int column = 0; column < 4; ++column )
+			{
+				float sum = 0.0f;
+				for( unsigned int i = 0; i < 4; ++i )
+				{
+					sum += pA[ row * 4 + i ] * pB[ i * 4 + column ];
+				}
+				pOut[ row * 4 + column ] = sum;
+			}
+		}
+	}
+
+	// Frustum of a camera at x, z turned yaw radians about y, as D3DXMatrixLookAtLH
+	// and D3DXMatrixPerspectiveFovLH would give
+	void CameraFrustum( float x, float z, float yaw, Frustum* pFrustum )
+	{
+		float c = cosf( yaw ), s = sinf( yaw );
+		float view[16] =
+		{
+			c,						0.0f,	s,						0.0f,
+			0.0f,					1.0f,	0.0f,					0.0f,
+			-s,						0.0f,	c,						0.0f,
+			-( x * c - z * s ),		0.0f,	-( x * s + z * c ),		1.0f,
+		};
+		float yScale = 1.0f / tanf( 0.4f ), xScale = yScale / 1.5f;
+		float zScale = cFarPlane / ( cFarPlane - cNearPlane );
+		float proj[16] =
+		{
+			xScale,	0.0f,	0.0f,						0.0f,
+			0.0f,	yScale,	0.0f,						0.0f,
+			0.0f,	0.0f,	zScale,						1.0f,
+			0.0f,	0.0f,	-cNearPlane * zScale,		0.0f,
+		};
+		float viewProj[16];
+		Multiply( view, proj, viewProj );
+		ExtractFrustum( viewProj, pFrustum );
+	}
+
+	void RandomBounds( unsigned int numItems, std::vector<float>& bounds )
+	{
+		bounds.resize( numItems * cBoundsFloats );
+		for( unsigned int item = 0; item < numItems; ++item )
+		{
+			for( unsigned int axis = 0; axis < 3; ++axis )
+			{
+				bounds[ item * cBoundsFloats + axis ] = RandomRange( -200.0f, 200.0f );
+				bounds[ item * cBoundsFloats + 3 + axis ] = RandomRange( 0.0f, 5.0f );
+			}
+		}
+	}
+
+	// Cull with the hierarchy, SSE and scalar, and check both match testing every box
+	bool CullMatchesBruteForce( const BoundingVolumeHierarchy& bvh, const std::vector<float>& bounds, const Frustum& frustum,
+								unsigned int* pNumVisible )
+	{
+		unsigned int numItems = (unsigned int)( bounds.size() / cBoundsFloats );
+		std::vector<unsigned char> visible( numItems + 1, 0xcd ), visibleScalar( numItems + 1, 0xcd ), expected( numItems + 1, 0xcd );
+		unsigned int numVisible = bvh.Cull( frustum, &visible[0] );
+		unsigned int numVisibleScalar = bvh.CullScalar( frustum, &visibleScalar[0] );
+		*pNumVisible = BoundingVolumeHierarchy::CullItems( numItems, numItems ? &bounds[0] : NULL, frustum, &expected[0] );
+		return numVisible == *pNumVisible && numVisibleScalar == *pNumVisible
+			&& visible == expected && visibleScalar == expected && 0xcd == expected.back();
+	}
+}
+
+UNIT_TEST( FrustumCullingHierarchyMatchesBruteForce )
+{
+	// the hierarchy culls exactly the boxes testing each box does, as the camera moves
+	// and turns, and after items move and the tree is refit
+	std::vector<float> bounds;
+	srand( 23 );
+	RandomBounds( cNumItems, bounds );
+	BoundingVolumeHierarchy bvh;
+	bvh.Build( cNumItems, &bounds[0] );
+	CHECK( cNumItems == bvh.GetNumItems() );
+	CHECK( bvh.GetNumNodes() > 1 );
+
+	bool bMatch = true;
+	unsigned int minVisible = cNumItems, maxVisible = 0;
+	for( unsigned int frame = 0; frame < 200; ++frame )
+	{
+		if( 0 == frame % 50 )
+		{
+			for( unsigned int i = 0; i < bounds.size(); i += cBoundsFloats )
+			{
+				bounds[ i ] += RandomRange( -20.0f, 20.0f );
+				bounds[ i + 2 ] += RandomRange( -20.0f, 20.0f );
+			}
+			bvh.Refit( &bounds[0] );
+		}
+
+		Frustum frustum;
+		CameraFrustum( 50.0f * sinf( frame * 0.05f ), 50.0f * cosf( frame * 0.03f ), frame * 0.1f, &frustum );
+		unsigned int numVisible;
+		bMatch &= CullMatchesBruteForce( bvh, bounds, frustum, &numVisible );
+		minVisible = numVisible < minVisible ? numVisible : minVisible;
+		maxVisible = numVisible > maxVisible ? numVisible : maxVisible;
+	}
+	CHECK( bMatch );
+
+	// the frustum keeps some but not all boxes, so both sides of the test were exercised
+	CHECK( minVisible > 0 );
+	CHECK( maxVisible < cNumItems );
+}
+
+UNIT_TEST( FrustumCullingSmallHierarchies )
+{
+	// no items, and fewer items than a leaf holds
+	Frustum frustum;
+	CameraFrustum( 0.0f, 0.0f, 0.0f, &frustum );
+	srand( 29 );
+	bool bMatch = true;
+	for( unsigned int numItems = 0; numItems < 20; ++numItems )
+	{
+		std::vector<float> bounds;
+		RandomBounds( numItems, bounds );
+		BoundingVolumeHierarchy bvh;
+		bvh.Build( numItems, numItems ? &bounds[0] : NULL );
+		unsigned int numVisible;
+		bMatch &= CullMatchesBruteForce( bvh, bounds, frustum, &numVisible );
+	}
+	CHECK( bMatch );
+}
+
+UNIT_TEST( FrustumCullingClassifiesBoxes )
+{
+	// a camera at the origin looking down z
+	Frustum frustum;
+	CameraFrustum( 0.0f, 0.0f, 0.0f, &frustum );
+	const float bounds[] =
+	{
+		0.0f,		0.0f,	10.0f,		1.0f, 1.0f, 1.0f,	// ahead
+		0.0f,		0.0f,	-10.0f,		1.0f, 1.0f, 1.0f,	// behind
+		0.0f,		0.0f,	250.0f,		1.0f, 1.0f, 1.0f,	// past the far plane
+		0.0f,		0.0f,	199.5f,		1.0f, 1.0f, 1.0f,	// straddling the far plane
+		100.0f,		0.0f,	10.0f,		1.0f, 1.0f, 1.0f,	// far to the right
+		0.0f,		0.0f,	0.0f,		2.0f, 2.0f, 2.0f,	// around the camera
+	};
+	const unsigned char expected[] = { 1, 0, 0, 1, 0, 1 };
+	const unsigned int numItems = sizeof( expected );
+	unsigned char visible[ numItems ];
+	CHECK( 3 == BoundingVolumeHierarchy::CullItems( numItems, bounds, frustum, visible ) );
+	bool bMatch = true;
+	for( unsigned int item = 0; item < numItems; ++item )
+	{
+		bMatch &= expected[ item ] == visible[ item ];
+	}
+	CHECK( bMatch );
+}
+
+UNIT_TEST( FrustumCullingTransformBounds )
+{
+	// a quarter turn about z swaps the x and y extents, and the scale and translation apply
+	float bounds[ cBoundsFloats ] = { 1.0f, 2.0f, 3.0f, 1.0f, 0.5f, 0.25f };
+	const float matrix[16] =
+	{
+		0.0f,	1.0f,	0.0f,	0.0f,
+		-1.0f,	0.0f,	0.0f,	0.0f,
+		0.0f,	0.0f,	2.0f,	0.0f,
+		10.0f,	0.0f,	0.0f,	1.0f,
+	};
+	TransformBounds( bounds, matrix, bounds );
+	CHECK_CLOSE( bounds[0], 8.0f, 1e-5f );
+	CHECK_CLOSE( bounds[1], 1.0f, 1e-5f );
+	CHECK_CLOSE( bounds[2], 6.0f, 1e-5f );
+	CHECK_CLOSE( bounds[3], 0.5f, 1e-5f );
+	CHECK_CLOSE( bounds[4], 1.0f, 1e-5f );
+	CHECK_CLOSE( bounds[5], 0.5f, 1e-5f );
+}
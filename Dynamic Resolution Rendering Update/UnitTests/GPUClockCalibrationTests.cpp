@@ -0,0 +1,128 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "UnitTest.h"
+#include "GPUClockCalibration.h"
+
+#include <math.h>
+#include <stdlib.h>
+
+namespace
+{
+	const unsigned long long cFrequency = 25000000;		// 25MHz GPU timestamp clock
+	const double cGPUStart = 86400.0;					// GPU clock a day ahead of the CPU
+
+	// GPU clock with a fixed start offset and a drift relative to the CPU clock
+	unsigned long long GPUTicks( double cpuTime, double drift )
+	{
+		return (unsigned long long)( ( cGPUStart + cpuTime * ( 1.0 + drift ) ) * (double)cFrequency );
+	}
+
+	// A sample taken at cpuTime, bracketed by CPU times up to maxBracket apart
+	void AddSample( GPUClockCalibration* pCalibration, double cpuTime, double drift, double maxBracket )
+	{
+		double before = maxBracket * (double)rand() / (double)RAND_MAX;
+		double after = maxBracket * (double)rand() / (double)RAND_MAX;
+		pCalibration->AddSample( cpuTime - before, cpuTime + after, GPUTicks( cpuTime, drift ), cFrequency );
+	}
+}
+
+UNIT_TEST( GPUClockCalibrationOffset )
+{
+	GPUClockCalibration calibration( 16, 1.0 );
+	CHECK( !calibration.IsValid() );
+	calibration.AddSample( 10.0 - 5.0e-6, 10.0 + 5.0e-6, GPUTicks( 10.0, 0.0 ), cFrequency );
+	CHECK( calibration.IsValid() );
+	CHECK( cFrequency == calibration.GetFrequency() );
+	CHECK( 0.0 == calibration.GetDrift() );
+	CHECK_CLOSE( calibration.GetOffset( 10.0 ), cGPUStart, 1.0e-6 );
+	CHECK_CLOSE( calibration.GPUToCPUTime( GPUTicks( 10.5, 0.0 ) ), 10.5, 1.0e-6 );
+}
+
+UNIT_TEST( GPUClockCalibrationRecoversDrift )
+{
+	// 20ppm drift, sampled every 2 seconds with brackets up to 100us wide
+	const double drift = 20.0e-6;
+	GPUClockCalibration calibration( 16, 1.0 );
+	srand( 11 );
+	for( unsigned int sample = 0; sample < 32; ++sample )
+	{
+		AddSample( &calibration, 100.0 + 2.0 * sample, drift, 1.0e-4 );
+	}
+	CHECK( 16 == calibration.GetNumSamples() );
+	CHECK_CLOSE( calibration.GetDrift(), drift, 2.0e-6 );
+	CHECK( calibration.GetResidual() < 1.0e-4 );
+
+	// conversions within the bracket width, also a little past the last sample
+	double maxError = 0.0;
+	for( double cpuTime = 130.0; cpuTime < 170.0; cpuTime += 0.25 )
+	{
+		double error = fabs( calibration.GPUToCPUTime( GPUTicks( cpuTime, drift ) ) - cpuTime );
+		maxError = error > maxError ? error : maxError;
+	}
+	CHECK( maxError < 1.0e-4 );
+}
+
+UNIT_TEST( GPUClockCalibrationNoDriftOverShortSpan )
+{
+	// samples less than minDriftSpan apart give only an offset
+	GPUClockCalibration calibration( 16, 1.0 );
+	calibration.AddSample( 10.0, 10.0 + 1.0e-5, GPUTicks( 10.0, 1.0e-4 ), cFrequency );
+	calibration.AddSample( 10.5, 10.5 + 1.0e-5, GPUTicks( 10.5, 1.0e-4 ), cFrequency );
+	CHECK( 0.0 == calibration.GetDrift() );
+	calibration.AddSample( 11.0, 11.0 + 1.0e-5, GPUTicks( 11.0, 1.0e-4 ), cFrequency );
+	CHECK_CLOSE( calibration.GetDrift(), 1.0e-4, 1.0e-5 );
+}
+
+UNIT_TEST( GPUClockCalibrationWeightsByBracket )
+{
+	// a sample bracketed 1000 times more loosely, and 1ms off, barely moves the offset
+	GPUClockCalibration calibration( 16, 100.0 );
+	calibration.AddSample( 10.0 - 1.0e-6, 10.0 + 1.0e-6, GPUTicks( 10.0, 0.0 ), cFrequency );
+	calibration.AddSample( 11.0 - 1.0e-3, 11.0 + 1.0e-3, GPUTicks( 11.001, 0.0 ), cFrequency );
+	CHECK_CLOSE( calibration.GetOffset( 10.0 ), cGPUStart, 1.0e-8 );
+}
+
+UNIT_TEST( GPUClockCalibrationRestarts )
+{
+	GPUClockCalibration calibration( 16, 1.0 );
+	calibration.AddSample( 10.0, 10.0 + 1.0e-5, GPUTicks( 10.0, 0.0 ), cFrequency );
+	calibration.AddSample( 12.0, 12.0 + 1.0e-5, GPUTicks( 12.0, 0.0 ), cFrequency );
+	CHECK( 2 == calibration.GetNumSamples() );
+
+	// invalid samples are ignored
+	calibration.AddSample( 14.0, 14.0 + 1.0e-5, GPUTicks( 14.0, 0.0 ), 0 );
+	calibration.AddSample( 14.0, 13.0, GPUTicks( 14.0, 0.0 ), cFrequency );
+	CHECK( 2 == calibration.GetNumSamples() );
+
+	// a new frequency starts again
+	calibration.AddSample( 14.0, 14.0 + 1.0e-5, 14000, 1000 );
+	CHECK( 1 == calibration.GetNumSamples() );
+	CHECK( 1000 == calibration.GetFrequency() );
+	CHECK_CLOSE( calibration.GetOffset( 14.0 ), 0.0, 1.0e-5 );
+
+	calibration.Reset();
+	CHECK( !calibration.IsValid() );
+	CHECK( 0.0 == calibration.GPUToCPUTime( 14000 ) );
+}
+
+UNIT_TEST( GPUClockCalibrationTicksToSeconds )
+{
+	// a year of ticks at 1GHz keeps the fraction of a second
+	unsigned long long ticks = 31536000ULL * 1000000000ULL + 123456789ULL;
+	double seconds = GPUClockCalibration::TicksToSeconds( ticks, 1000000000ULL );
+	CHECK( 31536000.0 == floor( seconds ) );
+	CHECK_CLOSE( seconds - 31536000.0, 0.123456789, 1.0e-8 );
+}
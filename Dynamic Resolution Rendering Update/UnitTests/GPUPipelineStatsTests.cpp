@@ -0,0 +1,213 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "UnitTest.h"
+#include "GPUPipelineStats.h"
+#include "MockGPUQueryBackend.h"
+
+namespace
+{
+	// An interval whose query ends with the given pixel shader invocations, and vertex
+	// shader invocations and primitives derived from them so every count is checked
+	bool RecordInterval( GPUPipelineStats* pStats, MockGPUQueryBackend* pBackend, unsigned long long psInvocations )
+	{
+		if( !pStats->Begin() )
+		{
+			return false;
+		}
+		pBackend->m_NextPipelineCounts.vsInvocations = 3 * psInvocations;
+		pBackend->m_NextPipelineCounts.primitives = psInvocations;
+		pBackend->m_NextPipelineCounts.psInvocations = psInvocations;
+		return pStats->End();
+	}
+
+	bool CountsMatch( const GPUPipelineCounts& counts, unsigned long long psInvocations )
+	{
+		return 3 * psInvocations == counts.vsInvocations &&
+			psInvocations == counts.primitives &&
+			psInvocations == counts.psInvocations;
+	}
+}
+
+UNIT_TEST( GPUPipelineStatsReadsLateResults )
+{
+	MockGPUQueryBackend backend;
+	GPUPipelineStats stats( 4, 4 );
+	CHECK( stats.Create( &backend ) );
+	CHECK( 1 == backend.m_NumPipelineStatsCreates );
+	CHECK( 4 == backend.m_PipelineCounts.size() );
+	CHECK( !stats.IsPending() );
+
+	// not ready, the interval stays pending and nothing is read
+	GPUPipelineCounts counts;
+	CHECK( RecordInterval( &stats, &backend, 100 ) );
+	CHECK( stats.IsPending() );
+	CHECK( !stats.GetStatistics( &counts ) );
+	CHECK( RecordInterval( &stats, &backend, 200 ) );
+	CHECK( !stats.GetStatistics( &counts ) );
+
+	// once complete the results are read in the order they were issued
+	backend.Complete();
+	CHECK( RecordInterval( &stats, &backend, 300 ) );
+	CHECK( stats.GetStatistics( &counts ) );
+	CHECK( CountsMatch( counts, 100 ) );
+	CHECK( 2 == stats.GetLastLatency() );
+	CHECK( stats.GetStatistics( &counts ) );
+	CHECK( CountsMatch( counts, 200 ) );
+	CHECK( 1 == stats.GetLastLatency() );
+	CHECK( 2 == stats.GetMaxLatency() );
+	CHECK( !stats.GetStatistics( &counts ) );
+	CHECK( stats.IsPending() );
+
+	backend.Complete();
+	CHECK( stats.GetStatistics( &counts ) );
+	CHECK( CountsMatch( counts, 300 ) );
+	CHECK( !stats.IsPending() );
+	CHECK( 0 == backend.m_NumPipelineStatsGrows );
+
+	stats.Release();
+	CHECK( 1 == backend.m_NumPipelineStatsReleases );
+	CHECK( !stats.Begin() );
+}
+
+UNIT_TEST( GPUPipelineStatsPairsBeginAndEnd )
+{
+	MockGPUQueryBackend backend;
+	GPUPipelineStats stats( 2, 2 );
+	CHECK( stats.Create( &backend ) );
+	CHECK( !stats.End() );
+	CHECK( stats.Begin() );
+	CHECK( !stats.Begin() );
+	CHECK( stats.End() );
+	CHECK( !stats.End() );
+	CHECK( 0 == stats.GetNumDroppedBegins() );
+}
+
+UNIT_TEST( GPUPipelineStatsGrowsWhenGPUBehind )
+{
+	MockGPUQueryBackend backend;
+	GPUPipelineStats stats( 2, 8 );
+	CHECK( stats.Create( &backend ) );
+
+	// read the first interval so the pending ones wrap around the end of the pool
+	GPUPipelineCounts counts;
+	CHECK( RecordInterval( &stats, &backend, 1 ) );
+	CHECK( RecordInterval( &stats, &backend, 2 ) );
+	backend.Complete();
+	CHECK( stats.GetStatistics( &counts ) );
+	CHECK( CountsMatch( counts, 1 ) );
+	CHECK( RecordInterval( &stats, &backend, 3 ) );
+
+	// the GPU falls behind, the pool doubles twice rather than drop intervals
+	for( unsigned long long interval = 4; interval <= 8; ++interval )
+	{
+		CHECK( RecordInterval( &stats, &backend, interval ) );
+	}
+	CHECK( 8 == stats.GetPipelineDepth() );
+	CHECK( 2 == backend.m_NumPipelineStatsGrows );
+	CHECK( 8 == backend.m_PipelineCounts.size() );
+	CHECK( 0 == stats.GetNumDroppedBegins() );
+
+	// every interval still comes back, in the order it was issued
+	backend.Complete();
+	for( unsigned long long interval = 2; interval <= 8; ++interval )
+	{
+		CHECK( stats.GetStatistics( &counts ) );
+		CHECK( CountsMatch( counts, interval ) );
+	}
+	CHECK( !stats.GetStatistics( &counts ) );
+	CHECK( !stats.IsPending() );
+	CHECK( 6 == stats.GetMaxLatency() );
+
+	// a recreated pool keeps the grown depth
+	CHECK( stats.Create( &backend ) );
+	CHECK( 8 == backend.m_PipelineCounts.size() );
+	CHECK( !stats.IsPending() );
+}
+
+UNIT_TEST( GPUPipelineStatsDropsWhenGPUBehind )
+{
+	MockGPUQueryBackend backend;
+	GPUPipelineStats stats( 2, 4 );
+	CHECK( stats.Create( &backend ) );
+
+	backend.m_bFailGrow = true;
+	CHECK( RecordInterval( &stats, &backend, 1 ) );
+	CHECK( RecordInterval( &stats, &backend, 2 ) );
+	CHECK( !RecordInterval( &stats, &backend, 3 ) );
+	CHECK( !stats.End() );
+	CHECK( 1 == stats.GetNumDroppedBegins() );
+	CHECK( 2 == stats.GetPipelineDepth() );
+
+	// at the maximum depth the pool does not try to grow
+	backend.m_bFailGrow = false;
+	CHECK( RecordInterval( &stats, &backend, 3 ) );
+	CHECK( RecordInterval( &stats, &backend, 4 ) );
+	CHECK( 4 == stats.GetPipelineDepth() );
+	CHECK( !RecordInterval( &stats, &backend, 5 ) );
+	CHECK( 2 == stats.GetNumDroppedBegins() );
+	CHECK( 1 == backend.m_NumPipelineStatsGrows );
+
+	// the dropped intervals are skipped, the rest read back in order
+	GPUPipelineCounts counts;
+	backend.Complete();
+	for( unsigned long long interval = 1; interval <= 4; ++interval )
+	{
+		CHECK( stats.GetStatistics( &counts ) );
+		CHECK( CountsMatch( counts, interval ) );
+	}
+	CHECK( !stats.IsPending() );
+	CHECK( RecordInterval( &stats, &backend, 6 ) );
+}
+
+UNIT_TEST( AveragedGPUPipelineStatsDrainsEveryResult )
+{
+	MockGPUQueryBackend backend;
+	AveragedGPUPipelineStats stats( 4, 2 );
+	CHECK( stats.Create( &backend ) );
+
+	PipelineStatistics average;
+	CHECK( !stats.HaveUpdatedAveragedStatistics( &average ) );
+	CHECK( !stats.HaveAveragedStatistics() );
+	CHECK( 0.0f == average.psInvocations );
+
+	// several results arriving at once are all read by one update, so one average
+	// completes and the pool is left empty instead of growing every frame
+	for( unsigned long long interval = 1; interval <= 5; ++interval )
+	{
+		CHECK( RecordInterval( &stats, &backend, 100 * interval ) );
+	}
+	CHECK( 8 == stats.GetPipelineDepth() );
+	backend.Complete();
+	CHECK( stats.HaveUpdatedAveragedStatistics( &average ) );
+	CHECK( stats.HaveAveragedStatistics() );
+	CHECK( !stats.IsPending() );
+	CHECK_CLOSE( average.psInvocations, 250.0, 1.0e-3 );
+	CHECK_CLOSE( average.primitives, 250.0, 1.0e-3 );
+	CHECK_CLOSE( average.vsInvocations, 750.0, 1.0e-3 );
+
+	// the fifth result is held over into the next average
+	CHECK( !stats.HaveUpdatedAveragedStatistics( &average ) );
+	CHECK_CLOSE( average.psInvocations, 250.0, 1.0e-3 );
+	for( unsigned long long interval = 6; interval <= 8; ++interval )
+	{
+		CHECK( RecordInterval( &stats, &backend, 100 * interval ) );
+		backend.Complete();
+		CHECK( ( 8 == interval ) == stats.HaveUpdatedAveragedStatistics( &average ) );
+	}
+	CHECK_CLOSE( average.psInvocations, 650.0, 1.0e-3 );
+	CHECK( 8 == stats.GetPipelineDepth() );
+	CHECK( 0 == stats.GetNumDroppedBegins() );
+}
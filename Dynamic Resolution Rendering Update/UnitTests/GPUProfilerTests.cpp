@@ -0,0 +1,265 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "UnitTest.h"
+#include "GPUProfiler.h"
+#include "MockGPUQueryBackend.h"
+
+namespace
+{
+	// A frame with a root scope holding scene and post process scopes of the given lengths
+	void RecordFrame( GPUProfiler* pProfiler, MockGPUQueryBackend* pBackend, unsigned long long sceneTicks, unsigned long long postTicks )
+	{
+		pProfiler->BeginFrame();
+		pProfiler->BeginScope( "Frame" );
+		pBackend->Advance( 100 );
+		pProfiler->BeginScope( "Scene" );
+		pBackend->Advance( sceneTicks );
+		pProfiler->EndScope();
+		pProfiler->BeginScope( "Post" );
+		pBackend->Advance( postTicks );
+		pProfiler->EndScope();
+		pProfiler->EndScope();
+		pProfiler->EndFrame();
+		pBackend->Advance( 1000 );
+	}
+}
+
+UNIT_TEST( GPUProfilerResolvesNestedScopes )
+{
+	MockGPUQueryBackend backend;
+	GPUProfiler profiler( 8, 3, 10 );
+	CHECK( profiler.Create( &backend ) );
+	CHECK( 1 == backend.m_NumCreates );
+	CHECK( 2 * 8 * 3 == backend.m_Ticks.size() );
+
+	RecordFrame( &profiler, &backend, 2000, 500 );
+	backend.Complete();
+	profiler.BeginFrame();
+	profiler.EndFrame();
+
+	CHECK( profiler.HaveNewResults() );
+	CHECK( 1 == profiler.GetLastLatency() );
+	CHECK( 3 == profiler.GetNumResults() );
+	const GPUProfileResult& frame = profiler.GetResult( 0 );
+	const GPUProfileResult& scene = profiler.GetResult( 1 );
+	const GPUProfileResult& post = profiler.GetResult( 2 );
+	CHECK( GPUProfiler::INVALID_SCOPE == frame.parent );
+	CHECK( 0 == frame.depth );
+	CHECK( 0 == scene.parent && 1 == scene.depth );
+	CHECK( 0 == post.parent && 1 == post.depth );
+	CHECK_CLOSE( frame.time, 0.0026, 1.0e-7 );
+	CHECK_CLOSE( scene.time, 0.0020, 1.0e-7 );
+	CHECK_CLOSE( scene.start, 0.0001, 1.0e-7 );
+	CHECK_CLOSE( post.time, 0.0005, 1.0e-7 );
+	CHECK_CLOSE( post.start, 0.0021, 1.0e-7 );
+	CHECK( 2 == profiler.FindResult( "Post" ) );
+	CHECK( GPUProfiler::INVALID_SCOPE == profiler.FindResult( "Shadows" ) );
+	CHECK( cMockGPUFrequency == profiler.GetResultFrequency() );
+	CHECK( profiler.GetResultEndTicks() - profiler.GetResultStartTicks() == 2600 );
+
+	profiler.Release();
+	CHECK( 1 == backend.m_NumReleases );
+}
+
+UNIT_TEST( GPUProfilerKeepsResultsUntilFrameComplete )
+{
+	MockGPUQueryBackend backend;
+	GPUProfiler profiler( 8, 3, 10 );
+	CHECK( profiler.Create( &backend ) );
+	RecordFrame( &profiler, &backend, 2000, 500 );
+	backend.Complete();
+	RecordFrame( &profiler, &backend, 4000, 800 );
+	CHECK( 3 == profiler.GetNumResults() );
+
+	// the frame query of the second frame completes before its last timestamps
+	backend.Complete();
+	backend.m_bTimestampAvailable[ 2 * 8 + 5 ] = false;
+	profiler.BeginFrame();
+	profiler.EndFrame();
+	CHECK( !profiler.HaveNewResults() );
+	CHECK( 3 == profiler.GetNumResults() );
+	CHECK_CLOSE( profiler.GetResult( 0 ).time, 0.0026, 1.0e-7 );
+	CHECK_CLOSE( profiler.GetResult( 1 ).time, 0.0020, 1.0e-7 );
+	CHECK_CLOSE( profiler.GetResult( 2 ).time, 0.0005, 1.0e-7 );
+
+	// the frame stays pending and resolves once all of it is available, the empty frame
+	// recorded meanwhile is still in flight
+	backend.Complete();
+	backend.m_bFrameAvailable[2] = false;
+	profiler.BeginFrame();
+	profiler.EndFrame();
+	CHECK( profiler.HaveNewResults() );
+	CHECK( 2 == profiler.GetLastLatency() );
+	CHECK( 3 == profiler.GetNumResults() );
+	CHECK_CLOSE( profiler.GetResult( 1 ).time, 0.0040, 1.0e-7 );
+	CHECK_CLOSE( profiler.GetResult( 2 ).time, 0.0008, 1.0e-7 );
+}
+
+UNIT_TEST( GPUProfilerGrowsWhenGPUBehind )
+{
+	MockGPUQueryBackend backend;
+	GPUProfiler profiler( 8, 2, 4, 8 );
+	CHECK( profiler.Create( &backend ) );
+	RecordFrame( &profiler, &backend, 1000, 500 );
+	backend.Complete();
+	RecordFrame( &profiler, &backend, 2000, 500 );
+	RecordFrame( &profiler, &backend, 3000, 500 );
+	CHECK( 2 == profiler.GetFrameLatency() );
+
+	// both slots are in flight, the oldest in the second slot, so the pool doubles and
+	// the frame is profiled
+	RecordFrame( &profiler, &backend, 4000, 500 );
+	CHECK( 4 == profiler.GetFrameLatency() );
+	CHECK( 1 == backend.m_NumGrows );
+	CHECK( 2 * 8 * 4 == backend.m_Ticks.size() );
+	CHECK( 0 == profiler.GetNumDroppedFrames() );
+
+	// the frames resolve in the order they were issued, each with its own timestamps,
+	// with the frame in the new slot still in flight at first
+	backend.Complete();
+	backend.m_bFrameAvailable[2] = false;
+	profiler.BeginFrame();
+	profiler.EndFrame();
+	CHECK( profiler.HaveNewResults() );
+	CHECK( 2 == profiler.GetLastLatency() );
+	CHECK_CLOSE( profiler.GetResult( 1 ).time, 0.003, 1.0e-7 );
+
+	backend.Complete();
+	backend.m_bFrameAvailable[3] = false;
+	profiler.BeginFrame();
+	profiler.EndFrame();
+	CHECK( profiler.HaveNewResults() );
+	CHECK( 2 == profiler.GetLastLatency() );
+	CHECK_CLOSE( profiler.GetResult( 1 ).time, 0.004, 1.0e-7 );
+	float time;
+	CHECK( profiler.GetAveragedTime( "Scene", &time ) );
+	CHECK_CLOSE( time, 0.0025, 1.0e-7 );
+	CHECK_CLOSE( profiler.GetStats( "Scene" )->GetMin(), 0.001, 1.0e-7 );
+	CHECK_CLOSE( profiler.GetStats( "Scene" )->GetMax(), 0.004, 1.0e-7 );
+}
+
+UNIT_TEST( GPUProfilerDropsFramesAtMaxLatency )
+{
+	MockGPUQueryBackend backend;
+	GPUProfiler profiler( 8, 2, 10, 4 );
+	CHECK( profiler.Create( &backend ) );
+	for( unsigned int frame = 0; frame < 4; ++frame )
+	{
+		RecordFrame( &profiler, &backend, 2000, 500 );
+	}
+	CHECK( 4 == profiler.GetFrameLatency() );
+	CHECK( 0 == profiler.GetNumDroppedFrames() );
+
+	RecordFrame( &profiler, &backend, 2000, 500 );
+	CHECK( 4 == profiler.GetFrameLatency() );
+	CHECK( 1 == profiler.GetNumDroppedFrames() );
+
+	backend.Complete();
+	profiler.BeginFrame();
+	profiler.EndFrame();
+	CHECK( profiler.HaveResults() );
+	CHECK( 5 == profiler.GetMaxLatency() );
+}
+
+UNIT_TEST( GPUProfilerDropsFramesWhenGPUBehind )
+{
+	// the backend cannot add queries, so the pool stays at its initial size
+	MockGPUQueryBackend backend;
+	backend.m_bFailGrow = true;
+	GPUProfiler profiler( 8, 2, 10 );
+	CHECK( profiler.Create( &backend ) );
+	RecordFrame( &profiler, &backend, 2000, 500 );
+	RecordFrame( &profiler, &backend, 2000, 500 );
+	CHECK( 0 == profiler.GetNumDroppedFrames() );
+
+	// both slots are in flight, so this frame is not profiled
+	RecordFrame( &profiler, &backend, 2000, 500 );
+	CHECK( 1 == profiler.GetNumDroppedFrames() );
+	CHECK( 2 == profiler.GetFrameLatency() );
+	CHECK( !profiler.HaveResults() );
+
+	backend.Complete();
+	profiler.BeginFrame();
+	profiler.EndFrame();
+	CHECK( profiler.HaveResults() );
+	CHECK( 1 == profiler.GetNumDroppedFrames() );
+	CHECK( 3 == profiler.GetMaxLatency() );
+}
+
+UNIT_TEST( GPUProfilerDiscardsDisjointFrames )
+{
+	MockGPUQueryBackend backend;
+	GPUProfiler profiler( 8, 3, 10 );
+	CHECK( profiler.Create( &backend ) );
+	backend.m_bDisjoint = true;
+	RecordFrame( &profiler, &backend, 2000, 500 );
+	backend.Complete();
+	backend.m_bDisjoint = false;
+	profiler.BeginFrame();
+	profiler.EndFrame();
+	CHECK( 1 == profiler.GetNumDisjointFrames() );
+	CHECK( !profiler.HaveResults() );
+}
+
+UNIT_TEST( GPUProfilerAveragesByName )
+{
+	MockGPUQueryBackend backend;
+	GPUProfiler profiler( 8, 3, 2 );
+	CHECK( profiler.Create( &backend ) );
+	float time = 1.0f;
+	CHECK( !profiler.GetAveragedTime( "Scene", &time ) );
+	CHECK( 0.0f == time );
+	CHECK( NULL == profiler.GetStats( "Scene" ) );
+
+	RecordFrame( &profiler, &backend, 2000, 500 );
+	backend.Complete();
+	RecordFrame( &profiler, &backend, 4000, 500 );
+	CHECK( !profiler.HaveUpdatedAverages() );
+	CHECK( !profiler.GetAveragedTime( "Scene", &time ) );
+	CHECK( NULL != profiler.GetStats( "Scene" ) );
+
+	backend.Complete();
+	profiler.BeginFrame();
+	profiler.EndFrame();
+	CHECK( profiler.HaveUpdatedAverages() );
+	CHECK( profiler.GetAveragedTime( "Scene", &time ) );
+	CHECK_CLOSE( time, 0.003, 1.0e-7 );
+	CHECK( 2 == profiler.GetStats( "Scene" )->GetNumSamples() );
+	CHECK_CLOSE( profiler.GetStats( "Scene" )->GetMax(), 0.004, 1.0e-7 );
+}
+
+UNIT_TEST( GPUProfilerLimitsScopes )
+{
+	// scopes past the limit are not timed, but still nest correctly
+	MockGPUQueryBackend backend;
+	GPUProfiler profiler( 2, 2, 10 );
+	CHECK( profiler.Create( &backend ) );
+	profiler.BeginFrame();
+	profiler.BeginScope( "Frame" );
+	profiler.BeginScope( "Scene" );
+	profiler.BeginScope( "Opaque" );
+	backend.Advance( 100 );
+	profiler.EndScope();
+	profiler.EndScope();
+	profiler.EndScope();
+	profiler.EndFrame();
+	backend.Complete();
+	profiler.BeginFrame();
+	profiler.EndFrame();
+	CHECK( 2 == profiler.GetNumResults() );
+	CHECK( GPUProfiler::INVALID_SCOPE == profiler.FindResult( "Opaque" ) );
+	CHECK_CLOSE( profiler.GetResult( 1 ).time, 0.0001, 1.0e-7 );
+}
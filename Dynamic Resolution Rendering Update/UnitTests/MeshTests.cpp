@@ -0,0 +1,372 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "UnitTest.h"
+#include "SDKMeshExt.h"
+#include "SceneDescription.h"
+#include "Scene.h"
+
+#include <vector>
+#include <stdio.h>
+
+//--------------------------------------------------------------------------------------
+// Tests of the scene and its meshes. These need DXUT, so are built by MeshTests_2015.vcxproj
+// rather than with the CPU only tests, but no device: the meshes are loaded with a NULL
+// device, which reads the frame hierarchy and animation and creates no buffers.
+//--------------------------------------------------------------------------------------
+
+namespace
+{
+	// Transforms of every mesh timed by the transform benchmark, a 60Hz step apart so
+	// they land between keys and run through the whole animation
+	const UINT cTransformBenchmarkIterations = 2000;
+	const double cTransformBenchmarkStepTime = 1.0 / 60.0;
+
+	// Model updates timed per thread count by the scaling benchmark, as in the sample
+	const UINT cModelUpdateBenchmarkIterations = 50;
+
+	// Back buffer size the scene is set up for
+	const UINT cBackBufferWidth = 1280;
+	const UINT cBackBufferHeight = 720;
+
+	// Finds and loads the sample's scene description, false if it is not found
+	bool LoadSceneDescription( SceneDescription* pSceneDesc )
+	{
+		WCHAR sceneDescPath[ MAX_PATH ];
+		if( FAILED( DXUTFindDXSDKMediaFileCch( sceneDescPath, MAX_PATH, L"scene_description.txt" ) ) )
+		{
+			return false;
+		}
+		pSceneDesc->LoadFromFile( sceneDescPath );
+		return true;
+	}
+
+	// Sizes the scene for the back buffer as the sample does on a resize, which restarts
+	// the simulation
+	void ResizeScene( Scene* pScene )
+	{
+		DXGI_SURFACE_DESC backBufferDesc;
+		ZeroMemory( &backBufferDesc, sizeof( backBufferDesc ) );
+		backBufferDesc.Width = cBackBufferWidth;
+		backBufferDesc.Height = cBackBufferHeight;
+		backBufferDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		backBufferDesc.SampleDesc.Count = 1;
+		pScene->OnD3D11ResizedSwapChain( NULL, NULL, &backBufferDesc );
+	}
+
+	// Loads the scene without a device and sizes it for the back buffer. False if it
+	// fails to load.
+	bool LoadScene( Scene* pScene )
+	{
+		WCHAR sceneDescPath[ MAX_PATH ];
+		bool bFoundScene = SUCCEEDED( DXUTFindDXSDKMediaFileCch( sceneDescPath, MAX_PATH, L"scene_description.txt" ) );
+		CHECK( bFoundScene );
+		if( !bFoundScene )
+		{
+			return false;
+		}
+		bool bLoaded = SUCCEEDED( pScene->LoadModels( NULL, sceneDescPath ) );
+		CHECK( bLoaded );
+		if( !bLoaded )
+		{
+			return false;
+		}
+		ResizeScene( pScene );
+		return true;
+	}
+
+	// Moves the scene on a frame, returning the matrices recomputed for it
+	UINT NextFrame( Scene* pScene, float interpolation )
+	{
+		pScene->OnFrameMove( interpolation, 0 );
+		return pScene->GetNumMatricesRecomputed();
+	}
+
+	// Loads one model of the scene and its animation, NULL if it has no file or fails to load
+	CDXUTSDKMeshExt* LoadSceneMesh( const SceneDescription& sceneDesc, UINT model )
+	{
+		const wchar_t* pModelFilename = sceneDesc.GetModelPath( model );
+		if( !pModelFilename )
+		{
+			return NULL;
+		}
+		CDXUTSDKMeshExt* pMesh = new CDXUTSDKMeshExt;
+		bool bLoaded = SUCCEEDED( pMesh->Create( (ID3D11Device*)NULL, pModelFilename, false ) );
+		CHECK( bLoaded );
+		if( !bLoaded )
+		{
+			delete pMesh;
+			return NULL;
+		}
+		//need to cast away const due to SDKMesh loadanimation
+		wchar_t* pAnimationPath = (wchar_t*)sceneDesc.GetAnimationPath( model );
+		if( pAnimationPath )
+		{
+			CHECK( SUCCEEDED( pMesh->LoadAnimation( pAnimationPath ) ) );
+		}
+		return pMesh;
+	}
+
+	// Loads every model of the scene which loads, false if there is no scene
+	bool LoadSceneMeshes( std::vector<CDXUTSDKMeshExt*>* pMeshes )
+	{
+		SceneDescription sceneDesc;
+		bool bFoundScene = LoadSceneDescription( &sceneDesc );
+		CHECK( bFoundScene );
+		if( !bFoundScene )
+		{
+			return false;
+		}
+		CHECK( sceneDesc.GetNumModels() > 0 );
+		for( UINT model = 0; model < sceneDesc.GetNumModels(); ++model )
+		{
+			CDXUTSDKMeshExt* pMesh = LoadSceneMesh( sceneDesc, model );
+			if( pMesh )
+			{
+				pMeshes->push_back( pMesh );
+			}
+		}
+		return true;
+	}
+
+	void DeleteSceneMeshes( std::vector<CDXUTSDKMeshExt*>* pMeshes )
+	{
+		for( size_t mesh = 0; mesh < pMeshes->size(); ++mesh )
+		{
+			delete (*pMeshes)[ mesh ];
+		}
+		pMeshes->clear();
+	}
+}
+
+UNIT_TEST( SDKMeshFlattenedTransformMatchesReference )
+{
+	std::vector<CDXUTSDKMeshExt*> meshes;
+	if( !LoadSceneMeshes( &meshes ) )
+	{
+		return;
+	}
+
+	// the flattened frame hierarchy must match the recursive transform, on keys and
+	// between them, and past the end of the animation where it wraps
+	const double times[] = { 0.0, 0.37, 1.0, 2.25, 7.91, 1000.0 };
+	D3DXMATRIX identity;
+	D3DXMatrixIdentity( &identity );
+	for( size_t mesh = 0; mesh < meshes.size(); ++mesh )
+	{
+		for( unsigned int time = 0; time < sizeof( times ) / sizeof( times[0] ); ++time )
+		{
+			CHECK( meshes[ mesh ]->CompareWithReferenceTransform( &identity, times[ time ] ) < 1.0e-4f );
+		}
+	}
+	DeleteSceneMeshes( &meshes );
+}
+
+UNIT_TEST( SDKMeshFlattenedTransformBenchmark )
+{
+	std::vector<CDXUTSDKMeshExt*> meshes;
+	if( !LoadSceneMeshes( &meshes ) )
+	{
+		return;
+	}
+	UINT numFrames = 0;
+	for( size_t mesh = 0; mesh < meshes.size(); ++mesh )
+	{
+		numFrames += meshes[ mesh ]->GetNumFrames();
+	}
+	CHECK( numFrames > 0 );
+
+	// the same transforms with each implementation, the flattened one first so the
+	// hierarchy is built before it is timed
+	D3DXMATRIX identity;
+	D3DXMatrixIdentity( &identity );
+	for( size_t mesh = 0; mesh < meshes.size(); ++mesh )
+	{
+		meshes[ mesh ]->TransformMeshWithInterpolation( &identity, 0.0 );
+	}
+	CDXUTTimer* pTimer = DXUTGetGlobalTimer();
+	double startTime = pTimer->GetAbsoluteTime();
+	for( UINT iteration = 0; iteration < cTransformBenchmarkIterations; ++iteration )
+	{
+		for( size_t mesh = 0; mesh < meshes.size(); ++mesh )
+		{
+			meshes[ mesh ]->TransformMeshWithInterpolation( &identity, iteration * cTransformBenchmarkStepTime );
+		}
+	}
+	double flattenedTime = ( pTimer->GetAbsoluteTime() - startTime ) / cTransformBenchmarkIterations;
+
+	startTime = pTimer->GetAbsoluteTime();
+	for( UINT iteration = 0; iteration < cTransformBenchmarkIterations; ++iteration )
+	{
+		for( size_t mesh = 0; mesh < meshes.size(); ++mesh )
+		{
+			meshes[ mesh ]->TransformMeshWithInterpolationReference( &identity, iteration * cTransformBenchmarkStepTime );
+		}
+	}
+	double referenceTime = ( pTimer->GetAbsoluteTime() - startTime ) / cTransformBenchmarkIterations;
+
+	printf( "  %u frames, flattened: %.1f us, recursive: %.1f us per transform of every mesh\n",
+		numFrames, flattenedTime * 1.0e6, referenceTime * 1.0e6 );
+	CHECK( flattenedTime > 0.0 && referenceTime > 0.0 );
+	DeleteSceneMeshes( &meshes );
+}
+
+UNIT_TEST( SceneModelUpdateThreadScaling )
+{
+	Scene scene;
+	if( !LoadScene( &scene ) )
+	{
+		return;
+	}
+	TaskPool taskPool;
+	taskPool.Init();
+	scene.SetTaskPool( &taskPool );
+	scene.OnFrameMove( 0.0f, 0 );
+
+	// the sample's scaling benchmark, with 1 to all of the pool's threads
+	UINT numThreads = taskPool.GetNumThreads();
+	double singleThreadTime = 0.0;
+	for( UINT threads = 1; threads <= numThreads; ++threads )
+	{
+		taskPool.SetActiveThreads( threads );
+		double time = scene.BenchmarkModelUpdate( cModelUpdateBenchmarkIterations );
+		if( 1 == threads )
+		{
+			singleThreadTime = time;
+		}
+		printf( "  %u threads: %.3f ms %.2fx per model update\n",
+			threads, time * 1000.0, time > 0.0 ? singleThreadTime / time : 0.0 );
+		CHECK( time > 0.0 );
+	}
+	scene.SetTaskPool( NULL );
+}
+
+UNIT_TEST( SceneMatricesRecomputedPerFrame )
+{
+	// frames of the animated and static models, counted from the meshes as the scene
+	// classifies them
+	std::vector<CDXUTSDKMeshExt*> meshes;
+	if( !LoadSceneMeshes( &meshes ) )
+	{
+		return;
+	}
+	UINT numDynamicFrames = 0;
+	UINT numStaticFrames = 0;
+	for( size_t mesh = 0; mesh < meshes.size(); ++mesh )
+	{
+		if( meshes[ mesh ]->IsAnimated() )
+		{
+			numDynamicFrames += meshes[ mesh ]->GetNumFrames();
+		}
+		else
+		{
+			numStaticFrames += meshes[ mesh ]->GetNumFrames();
+		}
+	}
+	DeleteSceneMeshes( &meshes );
+	CHECK( numDynamicFrames > 0 && numStaticFrames > 0 );
+
+	Scene scene;
+	if( !LoadScene( &scene ) )
+	{
+		return;
+	}
+
+	// After the resize the first two history slots hold the static models projected with
+	// the camera, the third none. With the camera still, animated models are interpolated
+	// and projected each frame and static models are projected once, into the third slot.
+	CHECK( 2 * numDynamicFrames == NextFrame( &scene, 0.0f ) );
+	CHECK( 2 * numDynamicFrames + numStaticFrames == NextFrame( &scene, 0.0f ) );
+	for( UINT frame = 0; frame < 6; ++frame )
+	{
+		CHECK( 2 * numDynamicFrames == NextFrame( &scene, 0.0f ) );
+	}
+
+	// Moving the camera recomputes its matrices, and static models are reprojected into
+	// each slot in turn until all three hold the new view projection. Camera 2 is a
+	// camera model which isn't animated, so the camera stays there.
+	CHECK( scene.GetNumCameras() > 2 );
+	scene.SetCamera( 2 );
+	CHECK( 2 * numDynamicFrames + numStaticFrames + 2 == NextFrame( &scene, 0.0f ) );
+	CHECK( 2 * numDynamicFrames + numStaticFrames == NextFrame( &scene, 0.0f ) );
+	CHECK( 2 * numDynamicFrames + numStaticFrames == NextFrame( &scene, 0.0f ) );
+	CHECK( 2 * numDynamicFrames == NextFrame( &scene, 0.0f ) );
+
+	// A simulation step transforms only the animated models, and the frame after it
+	// interpolates them
+	scene.Simulate( 1.0 / 60.0, 1.0f / 60.0f );
+	CHECK( 3 * numDynamicFrames == NextFrame( &scene, 0.5f ) );
+	CHECK( 2 * numDynamicFrames == NextFrame( &scene, 0.5f ) );
+
+	// A resize restarts the history as on load, with the third slot invalid
+	ResizeScene( &scene );
+	CHECK( 2 * numDynamicFrames == NextFrame( &scene, 0.0f ) );
+	CHECK( 2 * numDynamicFrames + numStaticFrames == NextFrame( &scene, 0.0f ) );
+	CHECK( 2 * numDynamicFrames == NextFrame( &scene, 0.0f ) );
+}
+
+UNIT_TEST( SceneSimulationStateMatchesMeshes )
+{
+	Scene scene;
+	if( !LoadScene( &scene ) )
+	{
+		return;
+	}
+
+	// both states are stored on the resize, then each step stores the state it simulates,
+	// from the free camera and from a camera model
+	CHECK( scene.LatestSimulationStateMatchesMeshes() );
+	for( UINT step = 1; step <= 4; ++step )
+	{
+		scene.Simulate( step / 60.0, 1.0f / 60.0f );
+		CHECK( scene.LatestSimulationStateMatchesMeshes() );
+		scene.OnFrameMove( 0.5f, 0 );
+	}
+	scene.SetCamera( 1 );
+	for( UINT step = 5; step <= 8; ++step )
+	{
+		scene.Simulate( step / 60.0, 1.0f / 60.0f );
+		CHECK( scene.LatestSimulationStateMatchesMeshes() );
+		scene.OnFrameMove( 0.5f, 0 );
+	}
+
+	// and the benchmark repeats the latest step
+	scene.BenchmarkModelUpdate( 1 );
+	CHECK( scene.LatestSimulationStateMatchesMeshes() );
+}
+
+UNIT_TEST( SceneCullingBenchmark )
+{
+	Scene scene;
+	if( !LoadScene( &scene ) )
+	{
+		return;
+	}
+
+	// the hierarchy, its scalar path and testing every item must cull the same frames at
+	// every step of the camera path
+	CullingBenchmarkResults results;
+	CHECK( scene.BenchmarkCulling( &results ) );
+	CHECK( results.bResultsMatch );
+	CHECK( results.numSteps > 0 && results.numItems > 0 && results.numNodes > 0 );
+	CHECK( results.averageCulledDraws <= results.numDraws );
+	CHECK( scene.LatestSimulationStateMatchesMeshes() );
+
+	printf( "  %u steps, %u items, %u nodes, culled draws: %.1f of %u\n",
+		results.numSteps, results.numItems, results.numNodes, results.averageCulledDraws, results.numDraws );
+	printf( "  refit: %.2f us, hierarchy: %.2f us, scalar: %.2f us, brute force: %.2f us per step\n",
+		results.refitTime * 1.0e6, results.hierarchyTime * 1.0e6, results.hierarchyScalarTime * 1.0e6,
+		results.bruteForceTime * 1.0e6 );
+}
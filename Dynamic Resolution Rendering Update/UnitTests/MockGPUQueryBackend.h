@@ -0,0 +1,204 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+#include "GPUProfiler.h"
+
+#include <vector>
+
+const unsigned long long cMockGPUFrequency = 1000000;	// 1 tick per microsecond
+
+//--------------------------------------------------------------------------------------
+// Query backend with a simulated GPU clock. Timestamps take the clock value when
+// issued, and frames and timestamps only become available when the test completes
+// them, so the profilers can be run against any GPU latency. Growing keeps the state
+// of the existing queries, as the D3D11 backend does. Pipeline statistics queries take
+// m_NextPipelineCounts when they end.
+//--------------------------------------------------------------------------------------
+class MockGPUQueryBackend : public IGPUQueryBackend
+{
+public:
+	MockGPUQueryBackend()
+		: m_Clock( 1000 )
+		, m_bDisjoint( false )
+		, m_bFailGrow( false )
+		, m_NumCreates( 0 )
+		, m_NumReleases( 0 )
+		, m_NumGrows( 0 )
+		, m_NumPipelineStatsCreates( 0 )
+		, m_NumPipelineStatsReleases( 0 )
+		, m_NumPipelineStatsGrows( 0 )
+	{
+		m_NextPipelineCounts.vsInvocations = 0;
+		m_NextPipelineCounts.primitives = 0;
+		m_NextPipelineCounts.psInvocations = 0;
+	}
+
+	virtual bool Create( unsigned int numTimestamps, unsigned int numFrames )
+	{
+		++m_NumCreates;
+		m_Ticks.assign( numTimestamps, 0 );
+		m_bTimestampAvailable.assign( numTimestamps, false );
+		m_bFrameEnded.assign( numFrames, false );
+		m_bFrameAvailable.assign( numFrames, false );
+		m_bFrameDisjoint.assign( numFrames, false );
+		return true;
+	}
+	virtual void Release()
+	{
+		++m_NumReleases;
+	}
+	virtual bool Grow( unsigned int numTimestamps, unsigned int numFrames )
+	{
+		if( m_bFailGrow )
+		{
+			return false;
+		}
+		++m_NumGrows;
+		m_Ticks.resize( numTimestamps, 0 );
+		m_bTimestampAvailable.resize( numTimestamps, false );
+		m_bFrameEnded.resize( numFrames, false );
+		m_bFrameAvailable.resize( numFrames, false );
+		m_bFrameDisjoint.resize( numFrames, false );
+		return true;
+	}
+
+	virtual void BeginFrame( unsigned int frame )
+	{
+		m_bFrameEnded[ frame ] = false;
+		m_bFrameAvailable[ frame ] = false;
+		m_bFrameDisjoint[ frame ] = m_bDisjoint;
+	}
+	virtual void EndFrame( unsigned int frame )
+	{
+		m_bFrameEnded[ frame ] = true;
+	}
+	virtual void IssueTimestamp( unsigned int timestamp )
+	{
+		m_Ticks[ timestamp ] = m_Clock;
+		m_bTimestampAvailable[ timestamp ] = false;
+	}
+
+	virtual bool GetFrameData( unsigned int frame, unsigned long long* pFrequency, bool* pbDisjoint )
+	{
+		if( !m_bFrameAvailable[ frame ] )
+		{
+			return false;
+		}
+		*pFrequency = cMockGPUFrequency;
+		*pbDisjoint = m_bFrameDisjoint[ frame ];
+		return true;
+	}
+	virtual bool GetTimestamp( unsigned int timestamp, unsigned long long* pTicks )
+	{
+		if( !m_bTimestampAvailable[ timestamp ] )
+		{
+			return false;
+		}
+		*pTicks = m_Ticks[ timestamp ];
+		return true;
+	}
+
+	virtual bool CreatePipelineStats( unsigned int numQueries )
+	{
+		++m_NumPipelineStatsCreates;
+		m_PipelineCounts.assign( numQueries, GPUPipelineCounts() );
+		m_bPipelineStatsEnded.assign( numQueries, false );
+		m_bPipelineStatsAvailable.assign( numQueries, false );
+		return true;
+	}
+	virtual void ReleasePipelineStats()
+	{
+		++m_NumPipelineStatsReleases;
+	}
+	virtual bool GrowPipelineStats( unsigned int numQueries )
+	{
+		if( m_bFailGrow )
+		{
+			return false;
+		}
+		++m_NumPipelineStatsGrows;
+		m_PipelineCounts.resize( numQueries, GPUPipelineCounts() );
+		m_bPipelineStatsEnded.resize( numQueries, false );
+		m_bPipelineStatsAvailable.resize( numQueries, false );
+		return true;
+	}
+	virtual void BeginPipelineStats( unsigned int query )
+	{
+		m_bPipelineStatsEnded[ query ] = false;
+		m_bPipelineStatsAvailable[ query ] = false;
+	}
+	virtual void EndPipelineStats( unsigned int query )
+	{
+		m_PipelineCounts[ query ] = m_NextPipelineCounts;
+		m_bPipelineStatsEnded[ query ] = true;
+	}
+	virtual bool GetPipelineStats( unsigned int query, GPUPipelineCounts* pCounts )
+	{
+		if( !m_bPipelineStatsAvailable[ query ] )
+		{
+			return false;
+		}
+		*pCounts = m_PipelineCounts[ query ];
+		return true;
+	}
+
+	// GPU work between timestamps
+	void Advance( unsigned long long ticks )
+	{
+		m_Clock += ticks;
+	}
+
+	// The GPU finishes every ended frame and pipeline statistics query
+	void Complete()
+	{
+		for( unsigned int frame = 0; frame < m_bFrameEnded.size(); ++frame )
+		{
+			if( m_bFrameEnded[ frame ] )
+			{
+				m_bFrameAvailable[ frame ] = true;
+			}
+		}
+		m_bTimestampAvailable.assign( m_bTimestampAvailable.size(), true );
+		for( unsigned int query = 0; query < m_bPipelineStatsEnded.size(); ++query )
+		{
+			if( m_bPipelineStatsEnded[ query ] )
+			{
+				m_bPipelineStatsAvailable[ query ] = true;
+			}
+		}
+	}
+
+	unsigned long long	m_Clock;
+	bool				m_bDisjoint;		// disjoint state of frames begun from now on
+	bool				m_bFailGrow;
+	unsigned int		m_NumCreates;
+	unsigned int		m_NumReleases;
+	unsigned int		m_NumGrows;
+	std::vector<unsigned long long>	m_Ticks;
+	std::vector<bool>	m_bTimestampAvailable;
+	std::vector<bool>	m_bFrameEnded;
+	std::vector<bool>	m_bFrameAvailable;
+	std::vector<bool>	m_bFrameDisjoint;
+
+	GPUPipelineCounts	m_NextPipelineCounts;	// counts of pipeline statistics queries ended from now on
+	unsigned int		m_NumPipelineStatsCreates;
+	unsigned int		m_NumPipelineStatsReleases;
+	unsigned int		m_NumPipelineStatsGrows;
+	std::vector<GPUPipelineCounts>	m_PipelineCounts;
+	std::vector<bool>	m_bPipelineStatsEnded;
+	std::vector<bool>	m_bPipelineStatsAvailable;
+};
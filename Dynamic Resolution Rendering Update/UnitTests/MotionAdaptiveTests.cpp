@@ -0,0 +1,157 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "UnitTest.h"
+#include "ResolutionController.h"
+#include "VelocityStats.h"
+
+#include <vector>
+
+namespace
+{
+	const unsigned int	cBufferSize		= 64;
+	const unsigned int	cNumTexels		= VelocityReduceConsts::cReducedSize * VelocityReduceConsts::cReducedSize;
+	const float			cPixelsX		= 1280.0f;
+	const float			cPixelsY		= 720.0f;
+
+	// Velocity buffer with motion ( velocityX, velocityY ) left of splitX and none to the right
+	std::vector<float> MakeVelocityBuffer( float velocityX, float velocityY, unsigned int splitX )
+	{
+		std::vector<float> velocity( 2 * cBufferSize * cBufferSize, 0.0f );
+		for( unsigned int y = 0; y < cBufferSize; ++y )
+		{
+			for( unsigned int x = 0; x < splitX; ++x )
+			{
+				velocity[ 2 * ( y * cBufferSize + x ) ] = velocityX;
+				velocity[ 2 * ( y * cBufferSize + x ) + 1 ] = velocityY;
+			}
+		}
+		return velocity;
+	}
+
+	VelocityStatistics GetStatistics( const std::vector<float>& velocity, float ratio )
+	{
+		std::vector<float> reduced( 4 * cNumTexels );
+		ReduceVelocity( &velocity[0], cBufferSize, cBufferSize, ratio, ratio, cPixelsX, cPixelsY,
+						VelocityReduceConsts::cReducedSize, &reduced[0] );
+		VelocityStatistics stats;
+		CalculateVelocityStatistics( &reduced[0], cNumTexels, &stats );
+		return stats;
+	}
+
+	ResolutionControlInput MakePolicyInput( float controlTime, float currentScale )
+	{
+		ResolutionControlInput input;
+		input.controlTime		= controlTime;
+		input.targetTime		= 1.0f / 60.0f;
+		input.currentScale		= currentScale;
+		input.scaleMin			= 0.3f;
+		input.scaleMax			= 1.0f;
+		input.scalePixelCount	= 1280.0f * 720.0f;
+		input.shadedPixelCost	= 0.0f;
+		input.overdraw			= 0.0f;
+		return input;
+	}
+
+	void UpdateMotion( MotionAdaptivePolicy* pPolicy, float meanSpeed, unsigned int numFrames )
+	{
+		for( unsigned int frame = 0; frame < numFrames; ++frame )
+		{
+			pPolicy->UpdateMotion( meanSpeed );
+		}
+	}
+}
+
+UNIT_TEST( VelocityStatisticsUniformMotion )
+{
+	VelocityStatistics stats = GetStatistics( MakeVelocityBuffer( 0.01f, -0.005f, cBufferSize ), 1.0f );
+	CHECK_CLOSE( stats.meanAbsX, 12.8f, 1.0e-4f );
+	CHECK_CLOSE( stats.meanAbsY, 3.6f, 1.0e-4f );
+	CHECK_CLOSE( stats.meanSpeed, sqrtf( 12.8f * 12.8f + 3.6f * 3.6f ), 1.0e-4f );
+	CHECK_CLOSE( stats.maxSpeed, stats.meanSpeed, 1.0e-4f );
+}
+
+UNIT_TEST( VelocityStatisticsPartialMotion )
+{
+	// the left half moves, so the mean halves but the max does not
+	VelocityStatistics stats = GetStatistics( MakeVelocityBuffer( 0.01f, 0.0f, cBufferSize / 2 ), 1.0f );
+	CHECK_CLOSE( stats.meanAbsX, 6.4f, 1.0e-4f );
+	CHECK( 0.0f == stats.meanAbsY );
+	CHECK_CLOSE( stats.meanSpeed, 6.4f, 1.0e-4f );
+	CHECK_CLOSE( stats.maxSpeed, 12.8f, 1.0e-4f );
+}
+
+UNIT_TEST( VelocityStatisticsOnlySampleViewport )
+{
+	// at half scale the right half of the buffer is outside the dynamic viewport
+	VelocityStatistics stats = GetStatistics( MakeVelocityBuffer( 0.01f, 0.0f, cBufferSize / 2 ), 0.5f );
+	CHECK_CLOSE( stats.meanAbsX, 12.8f, 1.0e-4f );
+	CHECK_CLOSE( stats.maxSpeed, 12.8f, 1.0e-4f );
+
+	CalculateVelocityStatistics( NULL, 0, &stats );
+	CHECK( 0.0f == stats.meanSpeed );
+	CHECK( 0.0f == stats.maxSpeed );
+}
+
+UNIT_TEST( MotionPolicyLockHysteresis )
+{
+	MotionAdaptivePolicy policy( 0.25f, 1.0f );
+	CHECK( !policy.IsLocked() );
+	UpdateMotion( &policy, 0.0f, 10 );
+	CHECK( policy.IsLocked() );
+
+	// between the lock and unlock speeds the state is kept either way
+	UpdateMotion( &policy, 0.5f, 30 );
+	CHECK( policy.IsLocked() );
+	UpdateMotion( &policy, 2.0f, 30 );
+	CHECK( !policy.IsLocked() );
+	UpdateMotion( &policy, 0.5f, 30 );
+	CHECK( !policy.IsLocked() );
+
+	policy.Reset();
+	CHECK( !policy.IsLocked() );
+	CHECK( 0.0f == policy.GetSpeed() );
+}
+
+UNIT_TEST( MotionPolicyLockedHoldsScale )
+{
+	MotionAdaptivePolicy policy;
+	UpdateMotion( &policy, 0.0f, 10 );
+	CHECK( policy.IsLocked() );
+
+	// increases and small decreases are held, a frame well over budget may still decrease
+	CHECK( 0.7f == policy.Apply( MakePolicyInput( 0.010f, 0.7f ), 0.75f ) );
+	CHECK( 0.7f == policy.Apply( MakePolicyInput( 0.017f, 0.7f ), 0.69f ) );
+	CHECK( 0.6f == policy.Apply( MakePolicyInput( 0.020f, 0.7f ), 0.6f ) );
+
+	// no target, no policy
+	ResolutionControlInput input = MakePolicyInput( 0.010f, 0.7f );
+	input.targetTime = 0.0f;
+	CHECK( 0.75f == policy.Apply( input, 0.75f ) );
+}
+
+UNIT_TEST( MotionPolicyLowersScaleFloorInFastMotion )
+{
+	MotionAdaptivePolicy policy( 0.25f, 1.0f, 16.0f, 0.2f );
+	UpdateMotion( &policy, 1.0f, 100 );
+	CHECK_CLOSE( policy.GetScaleMin( 0.5f ), 0.5f, 1.0e-4f );
+	UpdateMotion( &policy, 8.5f, 100 );
+	CHECK_CLOSE( policy.GetScaleMin( 0.5f ), 0.35f, 1.0e-4f );
+	UpdateMotion( &policy, 40.0f, 100 );
+	CHECK_CLOSE( policy.GetScaleMin( 0.5f ), 0.2f, 1.0e-6f );
+
+	// a floor already below the fast floor is kept
+	CHECK( 0.1f == policy.GetScaleMin( 0.1f ) );
+}
@@ -0,0 +1,112 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "UnitTest.h"
+#include "RenderTargetBudget.h"
+
+namespace
+{
+	const unsigned int cBackBufferWidth		= 1280;
+	const unsigned int cBackBufferHeight	= 720;
+
+	// The sample's dynamic targets: depth, color, two velocity and two final color
+	// targets at 4 bytes per pixel, with a downsample pyramid for each final target
+	void AddSampleTargets( RenderTargetBudget* pBudget )
+	{
+		const char* pNames[] = { "Depth", "Color", "Velocity 0", "Velocity 1", "Final 0", "Final 1" };
+		for( unsigned int target = 0; target < sizeof( pNames ) / sizeof( pNames[0] ); ++target )
+		{
+			CHECK( pBudget->AddTarget( pNames[ target ], 4 ) );
+		}
+		pBudget->SetDownsampleChains( 4, 2 );
+	}
+}
+
+UNIT_TEST( DownsampleStepsStopAtTwiceBackBuffer )
+{
+	CHECK( 0 == RenderTargetBudget::CalculateDownsampleSteps( 1280, 720, cBackBufferWidth, cBackBufferHeight ) );
+	CHECK( 0 == RenderTargetBudget::CalculateDownsampleSteps( 2560, 1440, cBackBufferWidth, cBackBufferHeight ) );
+	CHECK( 1 == RenderTargetBudget::CalculateDownsampleSteps( 3840, 2160, cBackBufferWidth, cBackBufferHeight ) );
+	CHECK( 1 == RenderTargetBudget::CalculateDownsampleSteps( 5120, 2880, cBackBufferWidth, cBackBufferHeight ) );
+
+	// both axes halve together, so one axis at the back buffer size stops the pyramid
+	CHECK( 0 == RenderTargetBudget::CalculateDownsampleSteps( 5120, 720, cBackBufferWidth, cBackBufferHeight ) );
+}
+
+UNIT_TEST( RenderTargetBudgetAddTarget )
+{
+	RenderTargetBudget budget;
+	budget.Reset( 1000 );
+	CHECK( 1000 == budget.GetBudget() );
+	CHECK( !budget.AddTarget( "Empty", 0 ) );
+	for( unsigned int target = 0; target < RenderTargetBudget::MAX_TARGETS; ++target )
+	{
+		CHECK( budget.AddTarget( "Target", 1 + target % 4 ) );
+	}
+	CHECK( !budget.AddTarget( "Extra", 4 ) );
+	CHECK( RenderTargetBudget::MAX_TARGETS == budget.GetNumTargets() );
+	CHECK( 3 == budget.GetTargetBytesPerPixel( 2 ) );
+	CHECK( 40 == budget.GetBytesPerPixel() );
+	CHECK( 3ull * 100 * 10 == budget.GetTargetBytes( 2, 100, 10 ) );
+
+	budget.Reset( 1000 );
+	CHECK( 0 == budget.GetNumTargets() );
+}
+
+UNIT_TEST( RenderTargetBudgetFindsLargestScaling )
+{
+	RenderTargetBudget budget;
+	budget.Reset( 150000000ull );
+	AddSampleTargets( &budget );
+
+	// 2x is 88MB with no downsampling, 3x is 199MB plus a 16MB pyramid
+	RenderTargetBudgetResult result;
+	budget.Calculate( cBackBufferWidth, cBackBufferHeight, 8192, 8192, 4, &result );
+	CHECK( result.bWithinBudget );
+	CHECK( 2 == result.maxScaling );
+	CHECK( 2560 == result.width );
+	CHECK( 1440 == result.height );
+	CHECK( 24ull * 2560 * 1440 == result.totalBytes );
+
+	budget.Reset( 250000000ull );
+	AddSampleTargets( &budget );
+	budget.Calculate( cBackBufferWidth, cBackBufferHeight, 8192, 8192, 4, &result );
+	CHECK( 3 == result.maxScaling );
+	CHECK( 24ull * 3840 * 2160 + 2ull * 4 * 1920 * 1080 == result.totalBytes );
+	CHECK( result.totalBytes == 6 * budget.GetTargetBytes( 0, 3840, 2160 ) +
+								budget.GetDownsampleBytes( 3840, 2160, cBackBufferWidth, cBackBufferHeight ) );
+}
+
+UNIT_TEST( RenderTargetBudgetLimits )
+{
+	// the maximum buffer size caps the buffer even when the budget allows more
+	RenderTargetBudget budget;
+	budget.Reset( 1000000000ull );
+	AddSampleTargets( &budget );
+	RenderTargetBudgetResult result;
+	budget.Calculate( cBackBufferWidth, cBackBufferHeight, 2560, 8192, 4, &result );
+	CHECK( result.bWithinBudget );
+	CHECK( 2560 == result.width );
+	CHECK( 2880 == result.height );
+
+	// a budget too small for the back buffer size still gives the back buffer size
+	budget.Reset( 1000 );
+	AddSampleTargets( &budget );
+	budget.Calculate( cBackBufferWidth, cBackBufferHeight, 8192, 8192, 4, &result );
+	CHECK( !result.bWithinBudget );
+	CHECK( 1 == result.maxScaling );
+	CHECK( cBackBufferWidth == result.width );
+	CHECK( cBackBufferHeight == result.height );
+}
@@ -0,0 +1,233 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "UnitTest.h"
+#include "ResolutionController.h"
+#include "FrameCostModel.h"
+
+namespace
+{
+	const float cTargetTime		= 1.0f / 60.0f;
+	const float cPixelCount		= 1280.0f * 720.0f;
+
+	ResolutionControlInput MakeInput( float controlTime, float currentScale )
+	{
+		ResolutionControlInput input;
+		input.controlTime		= controlTime;
+		input.targetTime		= cTargetTime;
+		input.currentScale		= currentScale;
+		input.scaleMin			= 0.3f;
+		input.scaleMax			= 1.0f;
+		input.scalePixelCount	= cPixelCount;
+		input.shadedPixelCost	= 0.0f;
+		input.overdraw			= 0.0f;
+		return input;
+	}
+
+	//--------------------------------------------------------------------------------------
+	// Synthetic pixel bound load: fixed time plus a cost per pixel at the given scale
+	//--------------------------------------------------------------------------------------
+	struct PixelBoundLoad
+	{
+		PixelBoundLoad( float fixedTime, float fullScaleTime )
+			: m_FixedTime( fixedTime )
+			, m_FullScaleTime( fullScaleTime )
+		{
+		}
+
+		float GetFrameTime( float scale ) const
+		{
+			return m_FixedTime + m_FullScaleTime * scale * scale;
+		}
+
+		// scale at which the frame time meets the target
+		float GetTargetScale() const
+		{
+			return sqrtf( ( cTargetTime - m_FixedTime ) / m_FullScaleTime );
+		}
+
+		float	m_FixedTime;
+		float	m_FullScaleTime;	// scaling time at a scale of 1
+	};
+
+	// Closed loop with the controller acting on the frame time of the previous frame's scale
+	float RunClosedLoop( IResolutionController* pController, const PixelBoundLoad& load, unsigned int numFrames, float scale )
+	{
+		for( unsigned int frame = 0; frame < numFrames; ++frame )
+		{
+			scale = pController->Update( MakeInput( load.GetFrameTime( scale ), scale ) );
+		}
+		return scale;
+	}
+
+	// Heavy camera cut: 2ms fixed and 24ms of pixel work at full scale
+	const PixelBoundLoad cHeavyLoad( 0.002f, 0.024f );
+}
+
+UNIT_TEST( ControllersHoldScaleWithoutTarget )
+{
+	ProportionalResolutionController	proportional;
+	PIDResolutionController				pid;
+	DeadbandResolutionController		deadband;
+	SlewLimitedResolutionController		slewLimited;
+	PredictiveResolutionController		predictive( NULL );
+	IResolutionController* controllers[] = { &proportional, &pid, &deadband, &slewLimited, &predictive };
+	for( unsigned int controller = 0; controller < sizeof( controllers ) / sizeof( controllers[0] ); ++controller )
+	{
+		ResolutionControlInput input = MakeInput( 0.03f, 0.6f );
+		input.targetTime = 0.0f;
+		CHECK( 0.6f == controllers[ controller ]->Update( input ) );
+	}
+}
+
+UNIT_TEST( ControllersClampToScaleLimits )
+{
+	ProportionalResolutionController	proportional( 0.5f );
+	SlewLimitedResolutionController		slewLimited( 0.9f, 0.9f );
+	IResolutionController* controllers[] = { &proportional, &slewLimited };
+	for( unsigned int controller = 0; controller < sizeof( controllers ) / sizeof( controllers[0] ); ++controller )
+	{
+		CHECK( 1.0f == controllers[ controller ]->Update( MakeInput( 0.001f, 0.95f ) ) );
+		CHECK( 0.3f == controllers[ controller ]->Update( MakeInput( 0.5f, 0.35f ) ) );
+	}
+}
+
+UNIT_TEST( ProportionalStepsWithRelativeError )
+{
+	ProportionalResolutionController controller( 0.01f );
+	CHECK_CLOSE( controller.Update( MakeInput( 2.0f * cTargetTime, 0.8f ) ), 0.8f * 0.99f, 1.0e-6f );
+	CHECK_CLOSE( controller.Update( MakeInput( 0.5f * cTargetTime, 0.8f ) ), 0.8f * 1.005f, 1.0e-6f );
+}
+
+UNIT_TEST( PIDConvergesOnPixelBoundLoad )
+{
+	PIDResolutionController controller;
+	controller.Reset( 1.0f );
+	float scale = RunClosedLoop( &controller, cHeavyLoad, 300, 1.0f );
+	CHECK_CLOSE( scale, cHeavyLoad.GetTargetScale(), 0.01f );
+}
+
+UNIT_TEST( PIDRecoversFromSaturation )
+{
+	// a load too heavy to meet at the lowest scale holds the controller at its limit
+	PIDResolutionController controller;
+	controller.Reset( 1.0f );
+	PixelBoundLoad overload( 0.03f, 0.024f );
+	float scale = RunClosedLoop( &controller, overload, 300, 1.0f );
+	CHECK( 0.3f == scale );
+
+	// the incremental form has no integral to unwind, so it leaves the limit straight away
+	scale = RunClosedLoop( &controller, cHeavyLoad, 10, scale );
+	CHECK( scale > 0.4f );
+	scale = RunClosedLoop( &controller, cHeavyLoad, 300, scale );
+	CHECK_CLOSE( scale, cHeavyLoad.GetTargetScale(), 0.01f );
+}
+
+UNIT_TEST( DeadbandHysteresis )
+{
+	DeadbandResolutionController controller( 0.08f, 0.02f, 0.05f );
+	controller.Reset( 1.0f );
+
+	// inside the outer band the scale holds
+	CHECK( 0.8f == controller.Update( MakeInput( 1.05f * cTargetTime, 0.8f ) ) );
+	CHECK( !controller.IsEngaged() );
+
+	// outside it the controller engages, and keeps adjusting until inside the inner band
+	CHECK( controller.Update( MakeInput( 1.1f * cTargetTime, 0.8f ) ) < 0.8f );
+	CHECK( controller.IsEngaged() );
+	CHECK( controller.Update( MakeInput( 1.05f * cTargetTime, 0.8f ) ) < 0.8f );
+	CHECK( controller.IsEngaged() );
+	CHECK( 0.8f == controller.Update( MakeInput( 1.01f * cTargetTime, 0.8f ) ) );
+	CHECK( !controller.IsEngaged() );
+
+	controller.Update( MakeInput( 1.5f * cTargetTime, 0.8f ) );
+	controller.Reset( 0.8f );
+	CHECK( !controller.IsEngaged() );
+}
+
+UNIT_TEST( SlewLimitedLimitsStepsEachWay )
+{
+	SlewLimitedResolutionController controller( 0.15f, 0.02f );
+	CHECK_CLOSE( controller.Update( MakeInput( 4.0f * cTargetTime, 0.8f ) ), 0.8f * 0.85f, 1.0e-6f );
+	CHECK_CLOSE( controller.Update( MakeInput( 0.25f * cTargetTime, 0.8f ) ), 0.8f * 1.02f, 1.0e-6f );
+
+	// inside the limits the step is the square root of the time ratio
+	CHECK_CLOSE( controller.Update( MakeInput( cTargetTime / 0.81f, 0.8f ) ), 0.8f * 0.9f, 1.0e-5f );
+}
+
+UNIT_TEST( SlewLimitedRecoversFromCameraCut )
+{
+	SlewLimitedResolutionController controller;
+	float scale = RunClosedLoop( &controller, cHeavyLoad, 5, 1.0f );
+	CHECK( cHeavyLoad.GetFrameTime( scale ) < 1.05f * cTargetTime );
+}
+
+UNIT_TEST( PredictiveUsesPipelineStatistics )
+{
+	PredictiveResolutionController controller( NULL, 0.95f );
+	ResolutionControlInput input = MakeInput( cHeavyLoad.GetFrameTime( 1.0f ), 1.0f );
+	input.overdraw			= 2.0f;
+	input.shadedPixelCost	= cHeavyLoad.m_FullScaleTime / ( input.overdraw * cPixelCount );
+
+	// the measured cost gives the scale for the headroom target in one step
+	float expected = sqrtf( ( 0.95f * cTargetTime - cHeavyLoad.m_FixedTime ) / cHeavyLoad.m_FullScaleTime );
+	CHECK_CLOSE( controller.Update( input ), expected, 1.0e-4f );
+}
+
+UNIT_TEST( PredictiveLimitsIncreases )
+{
+	PredictiveResolutionController controller( NULL, 0.95f, 0.05f );
+	ResolutionControlInput input = MakeInput( 0.004f, 0.5f );
+	input.overdraw			= 1.0f;
+	input.shadedPixelCost	= 0.001f / cPixelCount;
+	CHECK_CLOSE( controller.Update( input ), 0.5f * 1.05f, 1.0e-6f );
+}
+
+UNIT_TEST( PredictiveFallsBackWithoutCosts )
+{
+	PredictiveResolutionController predictive( NULL );
+	SlewLimitedResolutionController slewLimited( predictive.m_MaxStepDown, predictive.m_MaxStepUp );
+	ResolutionControlInput input = MakeInput( 1.3f * cTargetTime, 0.8f );
+	CHECK( slewLimited.Update( input ) == predictive.Update( input ) );
+}
+
+UNIT_TEST( CalculateControlTimeIgnoresCPUSpikes )
+{
+	CHECK_CLOSE( CalculateControlTime( 0.010f, 0.014f ), 0.012f, 1.0e-6f );
+	CHECK( 0.010f == CalculateControlTime( 0.010f, 0.025f ) );
+}
+
+UNIT_TEST( AxisScaleSelectorKeepsPixelCount )
+{
+	AxisScaleSelector selector( 2.0f, 4.0f, 1.0f );
+	AxisScaleLimits limits = { 0.3f, 1.0f, 0.3f, 1.0f };
+	float scaleX = 0.0f;
+	float scaleY = 0.0f;
+
+	selector.Select( 0.7f, limits, &scaleX, &scaleY );
+	CHECK_CLOSE( scaleX, 0.7f, 1.0e-6f );
+	CHECK_CLOSE( scaleY, 0.7f, 1.0e-6f );
+
+	// horizontal motion moves resolution to Y
+	selector.UpdateMotion( 40.0f, 0.0f );
+	selector.Select( 0.7f, limits, &scaleX, &scaleY );
+	CHECK( scaleX < scaleY );
+	CHECK_CLOSE( scaleX * scaleY, 0.49f, 1.0e-5f );
+
+	// with Y at its limit, X takes up what it can
+	selector.Select( 0.9f, limits, &scaleX, &scaleY );
+	CHECK( 1.0f == scaleY );
+	CHECK_CLOSE( scaleX, 0.81f, 1.0e-5f );
+}
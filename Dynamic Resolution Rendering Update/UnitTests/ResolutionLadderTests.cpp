@@ -0,0 +1,135 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "UnitTest.h"
+#include "ResolutionLadder.h"
+
+#include <vector>
+
+namespace
+{
+	const unsigned int cTileSizes[] = { 8, 16, 32, 64 };
+	const unsigned int cNumTileSizes = sizeof( cTileSizes ) / sizeof( cTileSizes[0] );
+
+	// Checks a ladder holds exactly the tile multiples up to the render target size and
+	// both endpoints, in increasing order with consistent scales
+	bool IsValidLadder( const ResolutionRung* pRungs, unsigned int numRungs, unsigned int backBufferSize, unsigned int dynamicRTSize,
+						float maxScaling, unsigned int tileSize )
+	{
+		unsigned int expectedRungs = dynamicRTSize / tileSize;
+		expectedRungs += dynamicRTSize % tileSize ? 1 : 0;
+		expectedRungs += backBufferSize % tileSize && backBufferSize < dynamicRTSize ? 1 : 0;
+		if( numRungs != expectedRungs || 0 == numRungs )
+		{
+			return false;
+		}
+
+		bool bValid = dynamicRTSize == pRungs[ numRungs - 1 ].size;
+		bool bHasBackBuffer = false;
+		for( unsigned int rung = 0; rung < numRungs; ++rung )
+		{
+			const ResolutionRung& rRung = pRungs[ rung ];
+			bValid &= 0 == rRung.size % tileSize || backBufferSize == rRung.size || dynamicRTSize == rRung.size;
+			bValid &= 0 == rung || rRung.size > pRungs[ rung - 1 ].size;
+			bValid &= fabs( rRung.rtScale - rRung.size / (double)dynamicRTSize ) < 1e-6;
+			bValid &= fabs( rRung.scale - rRung.rtScale * maxScaling ) < 1e-6;
+			bHasBackBuffer |= backBufferSize == rRung.size;
+		}
+		return bValid && bHasBackBuffer;
+	}
+}
+
+UNIT_TEST( ResolutionLadderRungs )
+{
+	// back buffers which are and are not tile multiples, super sampled and not
+	const unsigned int backBufferSizes[] = { 1280, 720, 1366, 768, 1050 };
+	const unsigned int maxScalings[] = { 1, 2 };
+	bool bValid = true;
+	for( unsigned int tile = 0; tile < cNumTileSizes; ++tile )
+	{
+		for( unsigned int bb = 0; bb < sizeof( backBufferSizes ) / sizeof( backBufferSizes[0] ); ++bb )
+		{
+			for( unsigned int scaling = 0; scaling < sizeof( maxScalings ) / sizeof( maxScalings[0] ); ++scaling )
+			{
+				unsigned int backBufferSize = backBufferSizes[ bb ];
+				unsigned int dynamicRTSize = backBufferSize * maxScalings[ scaling ];
+				float maxScaling = (float)maxScalings[ scaling ];
+				std::vector<ResolutionRung> rungs( GetMaxResolutionRungs( dynamicRTSize, cTileSizes[ tile ] ) );
+				unsigned int numRungs = BuildResolutionLadder( &rungs[0], backBufferSize, dynamicRTSize, maxScaling, cTileSizes[ tile ] );
+				bValid &= numRungs <= rungs.size();
+				bValid &= IsValidLadder( &rungs[0], numRungs, backBufferSize, dynamicRTSize, maxScaling, cTileSizes[ tile ] );
+
+				// the back buffer rung is a scale of 1
+				unsigned int backBufferRung = FindResolutionRung( &rungs[0], numRungs, (float)backBufferSize );
+				bValid &= backBufferSize == rungs[ backBufferRung ].size;
+				bValid &= fabs( rungs[ backBufferRung ].scale - 1.0f ) < 1e-6f;
+			}
+		}
+	}
+	CHECK( bValid );
+}
+
+UNIT_TEST( ResolutionLadderExample )
+{
+	// 1366 wide, 2x super sampled, 64 pixel tiles
+	std::vector<ResolutionRung> rungs( GetMaxResolutionRungs( 2732, 64 ) );
+	unsigned int numRungs = BuildResolutionLadder( &rungs[0], 1366, 2732, 2.0f, 64 );
+	CHECK( 44 == numRungs );
+	CHECK( 64 == rungs[0].size );
+	CHECK( 1344 == rungs[20].size );
+	CHECK( 1366 == rungs[21].size );
+	CHECK( 1408 == rungs[22].size );
+	CHECK( 2688 == rungs[42].size );
+	CHECK( 2732 == rungs[43].size );
+	CHECK_CLOSE( rungs[43].scale, 2.0f, 1e-6f );
+	CHECK_CLOSE( rungs[43].rtScale, 1.0f, 1e-6f );
+}
+
+UNIT_TEST( ResolutionLadderSmallerThanTile )
+{
+	// a render target smaller than one tile has the one rung
+	ResolutionRung rungs[ 2 ];
+	CHECK( GetMaxResolutionRungs( 40, 64 ) <= 2 );
+	CHECK( 1 == BuildResolutionLadder( rungs, 40, 40, 1.0f, 64 ) );
+	CHECK( 40 == rungs[0].size );
+	CHECK( 0 == FindResolutionRung( rungs, 1, 10.0f ) );
+	CHECK( 0 == FindResolutionRung( rungs, 1, 100.0f ) );
+}
+
+UNIT_TEST( ResolutionLadderFindRung )
+{
+	// at a rung gives that rung, between rungs the one below, and outside the ends the
+	// nearest end
+	bool bFound = true;
+	for( unsigned int tile = 0; tile < cNumTileSizes; ++tile )
+	{
+		std::vector<ResolutionRung> rungs( GetMaxResolutionRungs( 2100, cTileSizes[ tile ] ) );
+		unsigned int numRungs = BuildResolutionLadder( &rungs[0], 1050, 2100, 2.0f, cTileSizes[ tile ] );
+		for( unsigned int rung = 0; rung < numRungs; ++rung )
+		{
+			float size = (float)rungs[ rung ].size;
+			bFound &= rung == FindResolutionRung( &rungs[0], numRungs, size );
+			bFound &= rung == FindResolutionRung( &rungs[0], numRungs, size + 0.5f );
+			if( rung + 1 < numRungs )
+			{
+				bFound &= rung == FindResolutionRung( &rungs[0], numRungs, (float)rungs[ rung + 1 ].size - 1.0f );
+			}
+		}
+		bFound &= 0 == FindResolutionRung( &rungs[0], numRungs, 0.0f );
+		bFound &= 0 == FindResolutionRung( &rungs[0], numRungs, (float)cTileSizes[ tile ] - 1.0f );
+		bFound &= numRungs - 1 == FindResolutionRung( &rungs[0], numRungs, 5000.0f );
+	}
+	CHECK( bFound );
+}
@@ -0,0 +1,190 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "UnitTest.h"
+#include "StreamingStats.h"
+
+#include <algorithm>
+#include <vector>
+#include <stdio.h>
+#include <time.h>
+
+namespace
+{
+	// Repeatable frame times uniform in [minTime, maxTime)
+	class FrameTimeGenerator
+	{
+	public:
+		FrameTimeGenerator( float minTime, float maxTime )
+			: m_MinTime( minTime )
+			, m_MaxTime( maxTime )
+			, m_State( 12345 )
+		{
+		}
+
+		float Next()
+		{
+			m_State = m_State * 1664525u + 1013904223u;
+			return m_MinTime + ( m_MaxTime - m_MinTime ) * (float)( m_State >> 8 ) / (float)( 1 << 24 );
+		}
+
+	private:
+		float			m_MinTime;
+		float			m_MaxTime;
+		unsigned int	m_State;
+	};
+
+	// Seconds per AddSample() for a window of windowSize samples, reading the statistics
+	// the controller uses after every sample as the sample does
+	double MeasureSampleCost( unsigned int windowSize, unsigned int numSamples )
+	{
+		StreamingStats stats( windowSize );
+		FrameTimeGenerator generator( 0.010f, 0.030f );
+		volatile float sink = 0.0f;
+		clock_t start = clock();
+		for( unsigned int sample = 0; sample < numSamples; ++sample )
+		{
+			stats.AddSample( generator.Next() );
+			sink = sink + stats.GetMax() + stats.GetP99();
+		}
+		clock_t end = clock();
+		return (double)( end - start ) / CLOCKS_PER_SEC / numSamples;
+	}
+
+	// Nearest rank percentile of the last windowSize samples
+	float GetWindowPercentile( const std::vector<float>& samples, unsigned int windowSize, float percentile )
+	{
+		size_t count = std::min( samples.size(), (size_t)windowSize );
+		std::vector<float> window( samples.end() - count, samples.end() );
+		std::sort( window.begin(), window.end() );
+		size_t rank = (size_t)( percentile / 100.0f * (float)count + 0.999f );
+		return window[ rank > 1 ? std::min( rank, count ) - 1 : 0 ];
+	}
+}
+
+UNIT_TEST( StreamingStatsEmpty )
+{
+	StreamingStats stats( 16 );
+	CHECK( 0 == stats.GetNumSamples() );
+	CHECK( 0.0f == stats.GetMean() );
+	CHECK( 0.0f == stats.GetMin() );
+	CHECK( 0.0f == stats.GetMax() );
+	CHECK( 0.0f == stats.GetMedian() );
+	CHECK( 0.0f == stats.GetP99() );
+}
+
+UNIT_TEST( StreamingStatsWindowMatchesBruteForce )
+{
+	const unsigned int windowSize = 120;
+	StreamingStats stats( windowSize );
+	FrameTimeGenerator generator( 0.010f, 0.030f );
+	std::vector<float> samples;
+	for( unsigned int sample = 0; sample < 1000; ++sample )
+	{
+		samples.push_back( generator.Next() );
+		stats.AddSample( samples.back() );
+
+		unsigned int count = std::min( (unsigned int)samples.size(), windowSize );
+		std::vector<float>::iterator first = samples.end() - count;
+		double sum = 0.0;
+		for( std::vector<float>::iterator it = first; it != samples.end(); ++it )
+		{
+			sum += *it;
+		}
+		CHECK( count == stats.GetNumSamples() );
+		CHECK( samples.back() == stats.GetLast() );
+		CHECK_CLOSE( stats.GetMean(), sum / (double)count, 1.0e-6f );
+		CHECK( *std::min_element( first, samples.end() ) == stats.GetMin() );
+		CHECK( *std::max_element( first, samples.end() ) == stats.GetMax() );
+	}
+}
+
+UNIT_TEST( StreamingStatsExactForFewSamples )
+{
+	StreamingStats stats( 120 );
+	stats.AddSample( 0.020f );
+	stats.AddSample( 0.010f );
+	stats.AddSample( 0.030f );
+	CHECK( 0.020f == stats.GetMedian() );
+	CHECK( 0.030f == stats.GetP99() );
+	CHECK( 0.010f == stats.GetPercentile( 0.0f ) );
+	CHECK( 0.030f == stats.GetPercentile( 100.0f ) );
+}
+
+UNIT_TEST( StreamingStatsPercentilesTrackWindow )
+{
+	const unsigned int windowSize = 120;
+	StreamingStats stats( windowSize );
+	FrameTimeGenerator generator( 0.010f, 0.020f );
+	std::vector<float> samples;
+	for( unsigned int sample = 0; sample < 1000; ++sample )
+	{
+		samples.push_back( generator.Next() );
+		stats.AddSample( samples.back() );
+		if( sample >= windowSize )
+		{
+			// the estimators see between a half and a whole window, so allow for sampling error
+			CHECK_CLOSE( stats.GetMedian(), GetWindowPercentile( samples, windowSize, 50.0f ), 0.0015f );
+			CHECK_CLOSE( stats.GetP95(), GetWindowPercentile( samples, windowSize, 95.0f ), 0.001f );
+			CHECK( stats.GetMin() <= stats.GetMedian() );
+			CHECK( stats.GetMedian() <= stats.GetP95() );
+			CHECK( stats.GetP95() <= stats.GetP99() );
+			CHECK( stats.GetP99() <= stats.GetMax() );
+		}
+	}
+}
+
+UNIT_TEST( StreamingStatsHitchesLeaveWindow )
+{
+	// regular hitches show in the tail while they are in the window and not after
+	const unsigned int windowSize = 120;
+	StreamingStats stats( windowSize );
+	for( unsigned int sample = 0; sample < 4 * windowSize; ++sample )
+	{
+		stats.AddSample( 0 == sample % 20 ? 0.033f : 0.016f );
+	}
+	CHECK( 0.033f == stats.GetMax() );
+	CHECK_CLOSE( stats.GetP99(), 0.033f, 0.002f );
+	CHECK_CLOSE( stats.GetMedian(), 0.016f, 0.001f );
+
+	for( unsigned int sample = 0; sample < windowSize * 3 / 2; ++sample )
+	{
+		stats.AddSample( 0.016f );
+	}
+	CHECK( 0.016f == stats.GetMax() );
+	CHECK( 0.016f == stats.GetP99() );
+}
+
+UNIT_TEST( StreamingStatsMovingAverage )
+{
+	StreamingStats stats( 16, 0.5f );
+	stats.AddSample( 0.010f );
+	CHECK( 0.010f == stats.GetEMA() );
+	stats.AddSample( 0.020f );
+	CHECK_CLOSE( stats.GetEMA(), 0.015f, 1.0e-7f );
+	stats.Reset();
+	CHECK( 0 == stats.GetNumSamples() );
+	CHECK( 0.0f == stats.GetEMA() );
+}
+
+UNIT_TEST( StreamingStatsSampleCostIndependentOfWindow )
+{
+	// per sample cost benchmark, the cost must not grow with the window size
+	const unsigned int numSamples = 2000000;
+	double smallWindowCost = MeasureSampleCost( 120, numSamples );
+	double largeWindowCost = MeasureSampleCost( 12000, numSamples );
+	printf( "  window 120: %.1f ns/sample, window 12000: %.1f ns/sample\n", smallWindowCost * 1.0e9, largeWindowCost * 1.0e9 );
+	CHECK( largeWindowCost < 4.0 * smallWindowCost + 1.0e-8 );
+}
@@ -0,0 +1,187 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "UnitTest.h"
+#include "TaskPool.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// Enough matrices that every worker gets tasks, and a task count which does not
+	// divide evenly between the threads
+	const unsigned int cNumMatrices = 4099;
+	const unsigned int cMatricesPerTask = 64;
+	const unsigned int cNumTasks = ( cNumMatrices + cMatricesPerTask - 1 ) / cMatricesPerTask;
+	const unsigned int cNumFrames = 50;
+
+	// Stand in for Scene's model update: each frame, every matrix is composed with a
+	// per frame view projection, out = local * viewProj
+	struct MatrixUpdateJob
+	{
+		MatrixUpdateJob()
+			: m_Local( 16 * cNumMatrices )
+			, m_Out( 16 * cNumMatrices )
+			, m_TaskRuns( cNumTasks )
+			, m_NumThreads( 1 )
+			, m_bThreadIndicesValid( true )
+		{
+			srand( 1 );
+			for( size_t i = 0; i < m_Local.size(); ++i )
+			{
+				m_Local[i] = -1.0f + 2.0f * (float)rand() / (float)RAND_MAX;
+			}
+		}
+
+		std::vector<float>			m_Local;
+		std::vector<float>			m_Out;
+		std::vector<unsigned int>	m_TaskRuns;
+		float						m_ViewProj[16];
+		unsigned int				m_NumThreads;
+		bool						m_bThreadIndicesValid;	// only written when false, so racing writes agree
+	};
+
+	void MatrixUpdateTask( void* pArg, int threadIndex, unsigned int task, unsigned int taskCount )
+	{
+		MatrixUpdateJob* pJob = (MatrixUpdateJob*)pArg;
+		if( threadIndex < 0 || (unsigned int)threadIndex >= pJob->m_NumThreads || taskCount != cNumTasks )
+		{
+			pJob->m_bThreadIndicesValid = false;
+		}
+		++pJob->m_TaskRuns[ task ];
+
+		unsigned int end = ( task + 1 ) * cMatricesPerTask;
+		if( end > cNumMatrices )
+		{
+			end = cNumMatrices;
+		}
+		for( unsigned int matrix = task * cMatricesPerTask; matrix < end; ++matrix )
+		{
+			const float* pLocal = &pJob->m_Local[ 16 * matrix ];
+			float* pOut = &pJob->m_Out[ 16 * matrix ];
+			for( unsigned int row = 0; row < 4; ++row )
+			{
+				for( unsigned int column = 0; column < 4; ++column )
+				{
+					float sum = 0.0f;
+					for( unsigned int i = 0; i < 4; ++i )
+					{
+						sum += pLocal[ 4 * row + i ] * pJob->m_ViewProj[ 4 * i + column ];
+					}
+					pOut[ 4 * row + column ] = sum;
+				}
+			}
+		}
+	}
+
+	// Run the update for every frame, the view projection changing each, accumulating
+	// the output of each frame into the result so every job's output is compared.
+	// Returns the wall clock time the jobs took in seconds.
+	double RunMatrixUpdates( TaskPool* pPool, MatrixUpdateJob* pJob, std::vector<double>* pResult )
+	{
+		pResult->assign( 16 * cNumMatrices, 0.0 );
+		pJob->m_NumThreads = pPool->GetNumThreads();
+
+		double time = 0.0;
+		for( unsigned int frame = 0; frame < cNumFrames; ++frame )
+		{
+			for( unsigned int i = 0; i < 16; ++i )
+			{
+				pJob->m_ViewProj[i] = ( i % 5 ? 0.01f : 1.0f ) * (float)( frame + 1 ) + 0.001f * (float)i;
+			}
+			std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+			pPool->Run( MatrixUpdateTask, pJob, cNumTasks );
+			time += std::chrono::duration<double>( std::chrono::steady_clock::now() - start ).count();
+			for( size_t i = 0; i < pJob->m_Out.size(); ++i )
+			{
+				(*pResult)[i] += pJob->m_Out[i];
+			}
+		}
+		return time;
+	}
+}
+
+//--------------------------------------------------------------------------------------
+UNIT_TEST( TaskPoolRunsEveryTaskOnce )
+{
+	TaskPool pool;
+	pool.Init( 4 );
+	CHECK( 4 == pool.GetNumThreads() );
+	CHECK( 4 == pool.GetActiveThreads() );
+
+	MatrixUpdateJob job;
+	std::vector<double> result;
+	RunMatrixUpdates( &pool, &job, &result );
+
+	bool bAllOnce = true;
+	for( unsigned int task = 0; task < cNumTasks; ++task )
+	{
+		bAllOnce &= cNumFrames == job.m_TaskRuns[ task ];
+	}
+	CHECK( bAllOnce );
+	CHECK( job.m_bThreadIndicesValid );
+
+	// fewer tasks than threads, and no tasks
+	std::vector<unsigned int> runs( cNumTasks, 0 );
+	job.m_TaskRuns.swap( runs );
+	pool.Run( MatrixUpdateTask, &job, 0 );
+	CHECK( 0 == job.m_TaskRuns[0] );
+	pool.SetActiveThreads( 100 );
+	CHECK( 4 == pool.GetActiveThreads() );
+	pool.SetActiveThreads( 0 );
+	CHECK( 1 == pool.GetActiveThreads() );
+
+	pool.Shutdown();
+	CHECK( 1 == pool.GetNumThreads() );
+}
+
+//--------------------------------------------------------------------------------------
+UNIT_TEST( TaskPoolResultsMatchSingleThreaded )
+{
+	// At least 4 threads even on small machines, so the handoff between workers is
+	// exercised wherever the tests run
+	unsigned int maxThreads = std::thread::hardware_concurrency();
+	if( maxThreads < 4 )
+	{
+		maxThreads = 4;
+	}
+
+	TaskPool pool;
+	pool.Init( maxThreads );
+	CHECK( maxThreads == pool.GetNumThreads() );
+
+	MatrixUpdateJob job;
+	std::vector<double> reference;
+	pool.SetActiveThreads( 1 );
+	double singleThreadedTime = RunMatrixUpdates( &pool, &job, &reference );
+	printf( "  1 thread: %.2f ms\n", 1000.0 * singleThreadedTime );
+
+	for( unsigned int threads = 2; threads <= maxThreads; ++threads )
+	{
+		pool.SetActiveThreads( threads );
+		std::vector<double> result;
+		double time = RunMatrixUpdates( &pool, &job, &result );
+		printf( "  %u threads: %.2f ms\n", threads, 1000.0 * time );
+
+		// each matrix is computed by the same code whichever thread runs its task, so
+		// the results must be bit exact
+		CHECK( 0 == memcmp( &reference[0], &result[0], reference.size() * sizeof( double ) ) );
+	}
+	CHECK( job.m_bThreadIndicesValid );
+}
@@ -0,0 +1,263 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "UnitTest.h"
+#include "TelemetryReader.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	const char* const cTelemetryFileName = "UnitTestTelemetry.bin";
+
+	// Messages of 1 to 8 words, so writes wrap the end of the buffer at every offset
+	const unsigned int cMaxMessageWords = 8;
+
+	unsigned int MessageWords( unsigned int sequence )
+	{
+		return 1 + sequence % cMaxMessageWords;
+	}
+
+	void MakeMessage( unsigned int sequence, unsigned int* pWords )
+	{
+		pWords[0] = sequence;
+		for( unsigned int word = 1; word < MessageWords( sequence ); ++word )
+		{
+			pWords[ word ] = sequence * 31 + word;
+		}
+	}
+
+	struct PipeThreadTest
+	{
+		PipeThreadTest( unsigned int numMessages )
+			: m_NumMessages( numMessages )
+			, m_NumFull( 0 )
+			, m_bInOrder( true )
+		{
+		}
+
+		DXUTLockFreePipe< 16 >		m_Pipe;
+		unsigned int				m_NumMessages;
+		std::atomic<unsigned int>	m_NumFull;		// writes retried as the pipe was full
+		bool						m_bInOrder;
+	};
+
+	void ProduceMessages( PipeThreadTest* pTest )
+	{
+		unsigned int words[ cMaxMessageWords ];
+		for( unsigned int sequence = 0; sequence < pTest->m_NumMessages; ++sequence )
+		{
+			MakeMessage( sequence, words );
+			while( !pTest->m_Pipe.Write( words, MessageWords( sequence ) * sizeof( unsigned int ) ) )
+			{
+				++pTest->m_NumFull;
+				std::this_thread::yield();
+			}
+		}
+	}
+
+	void ConsumeMessages( PipeThreadTest* pTest )
+	{
+		while( 0 == pTest->m_NumFull.load() )
+		{
+			std::this_thread::yield();
+		}
+		unsigned int words[ cMaxMessageWords ], expected[ cMaxMessageWords ];
+		for( unsigned int sequence = 0; sequence < pTest->m_NumMessages; ++sequence )
+		{
+			// a message is published by a single write, so once its first word is
+			// readable the rest is
+			while( !pTest->m_Pipe.Read( words, sizeof( unsigned int ) ) )
+			{
+				std::this_thread::yield();
+			}
+			unsigned int numWords = MessageWords( sequence );
+			pTest->m_bInOrder &= numWords == 1 || pTest->m_Pipe.Read( words + 1, ( numWords - 1 ) * sizeof( unsigned int ) );
+			MakeMessage( sequence, expected );
+			pTest->m_bInOrder &= 0 == memcmp( words, expected, numWords * sizeof( unsigned int ) );
+		}
+	}
+
+	TelemetryRecord MakeRecord( unsigned int frame )
+	{
+		TelemetryRecord record;
+		memset( &record, 0, sizeof( record ) );
+		record.frame			= frame;
+		record.cpuFrameTime		= 0.010f + 0.001f * ( frame % 7 );
+		record.gpuFrameTime		= 0.012f + 0.001f * ( frame % 5 );
+		record.clearTime		= 0.0005f;
+		record.sceneTime		= 0.008f;
+		record.postProcTime		= 0.002f;
+		record.scaleTime		= 0.001f;
+		record.scaleX			= 0.5f + 0.0625f * ( frame % 8 );
+		record.scaleY			= 0.75f;
+		record.controlTime		= record.gpuFrameTime;
+		record.targetTime		= 1.0f / 60.0f;
+		record.viewportWidth	= (unsigned short)( 640 + frame % 640 );
+		record.viewportHeight	= 720;
+		record.resolveMode		= 1;
+		record.controlMode		= 2;
+		record.controllerType	= 3;
+		record.frameBound		= (unsigned char)( frame % 3 );
+		record.flags			= (unsigned char)( TELEMETRY_FLAG_DYNAMIC_RESOLUTION | ( frame & 1 ? TELEMETRY_FLAG_GPU_TIMES : 0 ) );
+		return record;
+	}
+}
+
+UNIT_TEST( LockFreePipeFillsAndWraps )
+{
+	// a full pipe refuses writes until read from, and data written across the end of
+	// the buffer reads back intact
+	DXUTLockFreePipe< 16 > pipe;
+	unsigned char block[ 16 ];
+	unsigned char read[ 24 ];
+
+	// start part way into the buffer, so the last block written wraps
+	CHECK( pipe.Write( block, 8 ) );
+	CHECK( pipe.Read( read, 8 ) );
+	bool bWritten = true;
+	for( unsigned int i = 0; i < pipe.GetBufferSize() / sizeof( block ); ++i )
+	{
+		memset( block, (int)( i & 0xff ), sizeof( block ) );
+		bWritten &= pipe.Write( block, sizeof( block ) );
+	}
+	CHECK( bWritten );
+	CHECK( pipe.GetBufferSize() == pipe.BytesAvailable() );
+	CHECK( !pipe.Write( block, 1 ) );
+
+	CHECK( pipe.Read( read, sizeof( read ) ) );
+	CHECK( 0 == read[0] && 1 == read[ 23 ] );
+	CHECK( !pipe.Write( block, 25 ) );
+
+	unsigned char wrapped[ 24 ];
+	for( unsigned int i = 0; i < sizeof( wrapped ); ++i )
+	{
+		wrapped[i] = (unsigned char)( 100 + i );
+	}
+	CHECK( pipe.Write( wrapped, sizeof( wrapped ) ) );
+	CHECK( !pipe.Write( block, 1 ) );
+
+	std::vector<unsigned char> rest( pipe.GetBufferSize() - sizeof( read ) );
+	CHECK( pipe.Read( &rest[0], (unsigned long)rest.size() ) );
+	bool bRestIntact = true;
+	for( unsigned int i = 0; i < rest.size(); ++i )
+	{
+		bRestIntact &= ( ( ( i + sizeof( read ) ) / sizeof( block ) ) & 0xff ) == rest[i];
+	}
+	CHECK( bRestIntact );
+	CHECK( pipe.Read( read, sizeof( read ) ) );
+	CHECK( 0 == memcmp( read, wrapped, sizeof( read ) ) );
+	CHECK( 0 == pipe.BytesAvailable() );
+	CHECK( !pipe.Read( read, 1 ) );
+}
+
+UNIT_TEST( LockFreePipeKeepsOrderAcrossThreads )
+{
+	// a producer thread writes numbered messages of varying size, retrying while the
+	// pipe is full, and a consumer thread reads them back in order. The consumer waits
+	// until the producer has found the pipe full before it starts reading.
+	PipeThreadTest test( 200000 );
+	std::thread producer( ProduceMessages, &test );
+	std::thread consumer( ConsumeMessages, &test );
+	producer.join();
+	consumer.join();
+	CHECK( test.m_bInOrder );
+	CHECK( test.m_NumFull.load() > 0 );
+	CHECK( 0 == test.m_Pipe.BytesAvailable() );
+}
+
+UNIT_TEST( TelemetryLoggerRoundTrip )
+{
+	// Records are pushed faster than the writer drains them, so some are dropped. The
+	// log holds exactly the records Push accepted, in order, and decodes to CSV.
+	TelemetryLogger logger;
+	CHECK( !logger.Push( MakeRecord( 0 ) ) );
+	CHECK( 0 == logger.GetNumDroppedRecords() );
+	CHECK( logger.Open( cTelemetryFileName ) );
+	CHECK( !logger.Open( cTelemetryFileName ) );
+
+	std::vector<TelemetryRecord> accepted;
+	for( unsigned int frame = 0; frame < 1000000 && ( frame < 5000 || 0 == logger.GetNumDroppedRecords() ); ++frame )
+	{
+		TelemetryRecord record = MakeRecord( frame );
+		if( logger.Push( record ) )
+		{
+			accepted.push_back( record );
+		}
+	}
+	unsigned int numDropped = logger.GetNumDroppedRecords();
+	logger.Close();
+	CHECK( !logger.IsOpen() );
+	CHECK( numDropped > 0 );
+	CHECK( accepted.size() == logger.GetNumWrittenRecords() );
+
+	std::vector<TelemetryRecord> records;
+	TelemetryFileHeader header;
+	CHECK( LoadTelemetry( cTelemetryFileName, records, &header ) );
+	remove( cTelemetryFileName );
+	CHECK( cTelemetryMagic == header.magic );
+	CHECK( cTelemetryVersion == header.version );
+	CHECK( sizeof( TelemetryRecord ) == header.recordSize );
+	CHECK( accepted.size() == header.numRecords );
+	CHECK( accepted.size() == records.size() );
+	CHECK( !records.empty() && 0 == memcmp( &accepted[0], &records[0], records.size() * sizeof( TelemetryRecord ) ) );
+
+	// CSV, times in milliseconds
+	FILE* pFile = tmpfile();
+	CHECK( NULL != pFile );
+	if( !pFile )
+	{
+		return;
+	}
+	WriteTelemetryCSV( pFile, records );
+	rewind( pFile );
+	char line[ 512 ];
+	CHECK( NULL != fgets( line, sizeof( line ), pFile ) );
+	CHECK( 0 == strncmp( line, "frame,cpuFrameTime,gpuFrameTime,", 32 ) );
+	unsigned int numLines = 0;
+	bool bFieldsMatch = true;
+	while( fgets( line, sizeof( line ), pFile ) )
+	{
+		const TelemetryRecord& rRecord = records[ numLines++ ];
+		unsigned int frame, viewportWidth, viewportHeight, resolveMode, controlMode, controllerType, frameBound;
+		unsigned int dynamicResolution, gpuTimes, motionLocked, boundGating;
+		float cpuFrameTime, gpuFrameTime, clearTime, sceneTime, postProcTime, scaleTime, scaleX, scaleY, controlTime, targetTime;
+		int numFields = sscanf( line, "%u,%f,%f,%f,%f,%f,%f,%f,%f,%u,%u,%f,%f,%u,%u,%u,%u,%u,%u,%u,%u",
+								&frame, &cpuFrameTime, &gpuFrameTime, &clearTime, &sceneTime, &postProcTime, &scaleTime,
+								&scaleX, &scaleY, &viewportWidth, &viewportHeight, &controlTime, &targetTime,
+								&resolveMode, &controlMode, &controllerType, &frameBound,
+								&dynamicResolution, &gpuTimes, &motionLocked, &boundGating );
+		bFieldsMatch &= 21 == numFields && rRecord.frame == frame;
+		bFieldsMatch &= fabs( cpuFrameTime - 1000.0f * rRecord.cpuFrameTime ) < 0.001f;
+		bFieldsMatch &= fabs( gpuFrameTime - 1000.0f * rRecord.gpuFrameTime ) < 0.001f;
+		bFieldsMatch &= fabs( sceneTime - 1000.0f * rRecord.sceneTime ) < 0.001f;
+		bFieldsMatch &= fabs( scaleX - rRecord.scaleX ) < 0.0001f;
+		bFieldsMatch &= fabs( targetTime - 1000.0f * rRecord.targetTime ) < 0.001f;
+		bFieldsMatch &= rRecord.viewportWidth == viewportWidth && rRecord.viewportHeight == viewportHeight;
+		bFieldsMatch &= rRecord.frameBound == frameBound && 3 == controllerType;
+		bFieldsMatch &= 1 == dynamicResolution && ( rRecord.frame & 1 ) == gpuTimes && 0 == motionLocked && 0 == boundGating;
+		if( numLines == records.size() )
+		{
+			break;
+		}
+	}
+	fclose( pFile );
+	CHECK( records.size() == numLines );
+	CHECK( bFieldsMatch );
+}
@@ -0,0 +1,579 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "UnitTest.h"
+#include "TraceRecorder.h"
+#include "GPUProfiler.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	const wchar_t* const	cTraceFileNameW	= L"UnitTestTrace.json";
+	const char* const		cTraceFileName	= "UnitTestTrace.json";
+	const unsigned int		cThreadId		= 7;
+
+	//--------------------------------------------------------------------------------------
+	// Clock the test sets, counting how often the recorder reads it
+	//--------------------------------------------------------------------------------------
+	class FakeTraceClock : public ITraceClock
+	{
+	public:
+		FakeTraceClock()
+			: m_Time( 0.0 )
+			, m_NumReads( 0 )
+		{
+		}
+
+		virtual double GetTime()
+		{
+			++m_NumReads;
+			return m_Time;
+		}
+		virtual unsigned int GetThreadId()
+		{
+			++m_NumReads;
+			return cThreadId;
+		}
+
+		double			m_Time;
+		unsigned int	m_NumReads;
+	};
+
+	//--------------------------------------------------------------------------------------
+	// Minimal JSON reader, enough to check the trace is well formed and read its events
+	//--------------------------------------------------------------------------------------
+	struct JSONValue
+	{
+		enum TYPE { TYPE_NULL, TYPE_BOOL, TYPE_NUMBER, TYPE_STRING, TYPE_ARRAY, TYPE_OBJECT };
+
+		JSONValue()
+			: type( TYPE_NULL )
+			, number( 0.0 )
+		{
+		}
+
+		// member of an object, NULL if missing
+		const JSONValue* Find( const char* pName ) const
+		{
+			for( unsigned int i = 0; i < names.size(); ++i )
+			{
+				if( names[i] == pName )
+				{
+					return &values[i];
+				}
+			}
+			return NULL;
+		}
+
+		TYPE					type;
+		double					number;		// TYPE_NUMBER and TYPE_BOOL
+		std::string				string;
+		std::vector<std::string>	names;	// of an object's members
+		std::vector<JSONValue>	values;		// array elements or object members
+	};
+
+	class JSONReader
+	{
+	public:
+		explicit JSONReader( const std::string& text )
+			: m_pChar( text.c_str() )
+		{
+		}
+
+		// The whole text must be one value
+		bool Read( JSONValue* pValue )
+		{
+			if( !ReadValue( pValue ) )
+			{
+				return false;
+			}
+			SkipSpace();
+			return 0 == *m_pChar;
+		}
+
+	private:
+		void SkipSpace()
+		{
+			while( ' ' == *m_pChar || '\t' == *m_pChar || '\n' == *m_pChar || '\r' == *m_pChar )
+			{
+				++m_pChar;
+			}
+		}
+
+		bool ReadValue( JSONValue* pValue )
+		{
+			SkipSpace();
+			if( '{' == *m_pChar )
+			{
+				pValue->type = JSONValue::TYPE_OBJECT;
+				return ReadMembers( pValue );
+			}
+			if( '[' == *m_pChar )
+			{
+				pValue->type = JSONValue::TYPE_ARRAY;
+				return ReadElements( pValue );
+			}
+			if( '"' == *m_pChar )
+			{
+				pValue->type = JSONValue::TYPE_STRING;
+				return ReadString( &pValue->string );
+			}
+			if( ReadWord( "true" ) )
+			{
+				pValue->type = JSONValue::TYPE_BOOL;
+				pValue->number = 1.0;
+				return true;
+			}
+			if( ReadWord( "false" ) )
+			{
+				pValue->type = JSONValue::TYPE_BOOL;
+				return true;
+			}
+			if( ReadWord( "null" ) )
+			{
+				pValue->type = JSONValue::TYPE_NULL;
+				return true;
+			}
+			return ReadNumber( pValue );
+		}
+
+		bool ReadWord( const char* pWord )
+		{
+			size_t length = strlen( pWord );
+			if( 0 != strncmp( m_pChar, pWord, length ) )
+			{
+				return false;
+			}
+			m_pChar += length;
+			return true;
+		}
+
+		bool ReadNumber( JSONValue* pValue )
+		{
+			// JSON numbers are a subset of strtod's, so check the characters first
+			const char* pStart = m_pChar;
+			if( '-' == *m_pChar )
+			{
+				++m_pChar;
+			}
+			if( *m_pChar < '0' || *m_pChar > '9' )
+			{
+				return false;
+			}
+			while( ( *m_pChar >= '0' && *m_pChar <= '9' ) || '.' == *m_pChar || 'e' == *m_pChar || 'E' == *m_pChar ||
+				   ( ( '+' == *m_pChar || '-' == *m_pChar ) && ( 'e' == m_pChar[-1] || 'E' == m_pChar[-1] ) ) )
+			{
+				++m_pChar;
+			}
+			char* pEnd = NULL;
+			pValue->type = JSONValue::TYPE_NUMBER;
+			pValue->number = strtod( pStart, &pEnd );
+			return pEnd == m_pChar;
+		}
+
+		bool ReadString( std::string* pString )
+		{
+			++m_pChar;
+			while( '"' != *m_pChar )
+			{
+				unsigned char c = (unsigned char)*m_pChar++;
+				if( c < 0x20 )
+				{
+					// includes the end of the text
+					return false;
+				}
+				if( '\\' != c )
+				{
+					*pString += (char)c;
+					continue;
+				}
+				c = (unsigned char)*m_pChar++;
+				switch( c )
+				{
+				case '"':	case '\\':	case '/':	*pString += (char)c;	break;
+				case 'b':	*pString += '\b';	break;
+				case 'f':	*pString += '\f';	break;
+				case 'n':	*pString += '\n';	break;
+				case 'r':	*pString += '\r';	break;
+				case 't':	*pString += '\t';	break;
+				case 'u':
+					{
+						unsigned int code = 0;
+						for( unsigned int digit = 0; digit < 4; ++digit )
+						{
+							char hex = *m_pChar++;
+							const char* pDigits = "0123456789abcdef0123456789ABCDEF";
+							const char* pDigit = hex ? strchr( pDigits, hex ) : NULL;
+							if( !pDigit )
+							{
+								return false;
+							}
+							code = code * 16 + (unsigned int)( pDigit - pDigits ) % 16;
+						}
+						if( code > 0x7f )
+						{
+							// trace names are ASCII
+							return false;
+						}
+						*pString += (char)code;
+					}
+					break;
+				default:
+					return false;
+				}
+			}
+			++m_pChar;
+			return true;
+		}
+
+		bool ReadElements( JSONValue* pValue )
+		{
+			++m_pChar;
+			SkipSpace();
+			if( ']' == *m_pChar )
+			{
+				++m_pChar;
+				return true;
+			}
+			for( ;; )
+			{
+				pValue->values.push_back( JSONValue() );
+				if( !ReadValue( &pValue->values.back() ) )
+				{
+					return false;
+				}
+				SkipSpace();
+				if( ']' == *m_pChar )
+				{
+					++m_pChar;
+					return true;
+				}
+				if( ',' != *m_pChar++ )
+				{
+					return false;
+				}
+			}
+		}
+
+		bool ReadMembers( JSONValue* pValue )
+		{
+			++m_pChar;
+			SkipSpace();
+			if( '}' == *m_pChar )
+			{
+				++m_pChar;
+				return true;
+			}
+			for( ;; )
+			{
+				SkipSpace();
+				pValue->names.push_back( std::string() );
+				pValue->values.push_back( JSONValue() );
+				if( '"' != *m_pChar || !ReadString( &pValue->names.back() ) )
+				{
+					return false;
+				}
+				SkipSpace();
+				if( ':' != *m_pChar++ || !ReadValue( &pValue->values.back() ) )
+				{
+					return false;
+				}
+				SkipSpace();
+				if( '}' == *m_pChar )
+				{
+					++m_pChar;
+					return true;
+				}
+				if( ',' != *m_pChar++ )
+				{
+					return false;
+				}
+			}
+		}
+
+		const char*	m_pChar;
+	};
+
+	//--------------------------------------------------------------------------------------
+	// A complete ("X") event, as written or expected
+	//--------------------------------------------------------------------------------------
+	struct TraceEvent
+	{
+		std::string		name;
+		unsigned int	tid;
+		double			ts;		// microseconds
+		double			dur;
+	};
+
+	bool operator<( const TraceEvent& lhs, const TraceEvent& rhs )
+	{
+		// parents before the children starting with them
+		return lhs.tid != rhs.tid ? lhs.tid < rhs.tid : ( lhs.ts != rhs.ts ? lhs.ts < rhs.ts : lhs.dur > rhs.dur );
+	}
+
+	// Run frames until the capture has been written
+	bool WaitForCapture( TraceRecorder& recorder, FakeTraceClock& clock )
+	{
+		for( unsigned int frame = 0; frame < 10000 && recorder.IsCapturing(); ++frame )
+		{
+			clock.m_Time += 0.1;
+			recorder.BeginFrame( clock.m_Time );
+			std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+		}
+		return !recorder.IsCapturing();
+	}
+
+	// Read the written trace, returning false if it is not valid JSON in the trace event
+	// format. The complete events are returned sorted.
+	bool ReadTrace( std::vector<TraceEvent>* pEvents )
+	{
+		std::string text;
+		FILE* pFile = fopen( cTraceFileName, "rb" );
+		if( !pFile )
+		{
+			return false;
+		}
+		char buffer[ 4096 ];
+		size_t size;
+		while( 0 != ( size = fread( buffer, 1, sizeof( buffer ), pFile ) ) )
+		{
+			text.append( buffer, size );
+		}
+		fclose( pFile );
+		remove( cTraceFileName );
+
+		JSONValue root;
+		if( !JSONReader( text ).Read( &root ) || JSONValue::TYPE_OBJECT != root.type )
+		{
+			return false;
+		}
+		const JSONValue* pTraceEvents = root.Find( "traceEvents" );
+		if( !pTraceEvents || JSONValue::TYPE_ARRAY != pTraceEvents->type )
+		{
+			return false;
+		}
+		for( unsigned int i = 0; i < pTraceEvents->values.size(); ++i )
+		{
+			const JSONValue& rEvent = pTraceEvents->values[i];
+			const JSONValue* pName = rEvent.Find( "name" );
+			const JSONValue* pPhase = rEvent.Find( "ph" );
+			if( !pName || !pPhase || JSONValue::TYPE_STRING != pName->type || JSONValue::TYPE_STRING != pPhase->type )
+			{
+				return false;
+			}
+			if( "X" != pPhase->string )
+			{
+				continue;
+			}
+			const JSONValue* pTid = rEvent.Find( "tid" );
+			const JSONValue* pTs = rEvent.Find( "ts" );
+			const JSONValue* pDur = rEvent.Find( "dur" );
+			if( !pTid || !pTs || !pDur || JSONValue::TYPE_NUMBER != pTid->type || JSONValue::TYPE_NUMBER != pTs->type ||
+				JSONValue::TYPE_NUMBER != pDur->type )
+			{
+				return false;
+			}
+			TraceEvent event;
+			event.name	= pName->string;
+			event.tid	= (unsigned int)pTid->number;
+			event.ts	= pTs->number;
+			event.dur	= pDur->number;
+			pEvents->push_back( event );
+		}
+		std::sort( pEvents->begin(), pEvents->end() );
+		return true;
+	}
+
+	// Events on each track nest, each ending before the enclosing event ends
+	bool AreBalanced( const std::vector<TraceEvent>& events )
+	{
+		const double cTolerance = 0.01;
+		std::vector<const TraceEvent*> stack;
+		for( unsigned int i = 0; i < events.size(); ++i )
+		{
+			const TraceEvent& rEvent = events[i];
+			if( rEvent.dur < 0.0 )
+			{
+				return false;
+			}
+			while( !stack.empty() && ( stack.back()->tid != rEvent.tid || stack.back()->ts + stack.back()->dur <= rEvent.ts + cTolerance ) )
+			{
+				stack.pop_back();
+			}
+			if( !stack.empty() && rEvent.ts + rEvent.dur > stack.back()->ts + stack.back()->dur + cTolerance )
+			{
+				return false;
+			}
+			stack.push_back( &rEvent );
+		}
+		return true;
+	}
+
+	void AddExpected( std::vector<TraceEvent>& events, const char* pName, unsigned int tid, double start, double duration )
+	{
+		TraceEvent event;
+		event.name	= pName;
+		event.tid	= tid;
+		event.ts	= ( start - 1.0 ) * 1.0e6;	// captures start at 1 second
+		event.dur	= duration * 1.0e6;
+		events.push_back( event );
+	}
+
+	GPUProfileResult GPUResult( const char* pName, unsigned int depth, float start, float time )
+	{
+		GPUProfileResult result;
+		result.pName	= pName;
+		result.parent	= depth ? 0 : (unsigned int)GPUProfiler::INVALID_SCOPE;
+		result.depth	= depth;
+		result.start	= start;
+		result.time		= time;
+		return result;
+	}
+}
+
+UNIT_TEST( TraceRecorderWritesNestedScopesAndGPUFrames )
+{
+	// Three frames, 0.1s apart from 1s. Each has a scope nested in another, a Present
+	// event and a GPU frame with a nested scope, whose results arrive a frame later.
+	const char* pEscapedName = "Say \"hi\" \\ \n";
+	GPUProfileResult gpuResults[ 2 ] = { GPUResult( "GPU Frame", 0, 0.0f, 0.02f ), GPUResult( "Scene", 1, 0.005f, 0.01f ) };
+
+	FakeTraceClock clock;
+	TraceRecorder recorder( &clock, 1024 );
+	clock.m_Time = 0.9;
+	recorder.MarkGPUFrameStart();
+	CHECK( recorder.Start( cTraceFileNameW, 3 ) );
+	CHECK( !recorder.Start( cTraceFileNameW, 3 ) );
+	CHECK( recorder.IsCapturing() );
+	CHECK( !recorder.IsRecording() );
+
+	std::vector<TraceEvent> expected;
+	for( unsigned int frame = 0; frame < 3 + TraceRecorder::MAX_GPU_LATENCY; ++frame )
+	{
+		double frameStart = 1.0 + 0.1 * frame;
+		clock.m_Time = frameStart;
+		recorder.BeginFrame( frameStart );
+		clock.m_Time = frameStart + 0.01;
+		recorder.BeginScope( "Update" );
+		clock.m_Time = frameStart + 0.02;
+		recorder.BeginScope( pEscapedName );
+		clock.m_Time = frameStart + 0.03;
+		recorder.EndScope();
+		clock.m_Time = frameStart + 0.04;
+		recorder.EndScope();
+		clock.m_Time = frameStart + 0.05;
+		recorder.MarkGPUFrameStart();
+		recorder.AddGPUFrame( 1, gpuResults, 2 );
+		recorder.AddGPUFrame( TraceRecorder::MAX_GPU_LATENCY, gpuResults, 2 );
+		recorder.AddCPUEvent( "Present", frameStart + 0.06, frameStart + 0.08 );
+		if( frame < 3 )
+		{
+			CHECK( recorder.IsRecording() );
+			AddExpected( expected, "Frame", cThreadId, frameStart, 0.1 );
+			AddExpected( expected, "Update", cThreadId, frameStart + 0.01, 0.03 );
+			AddExpected( expected, pEscapedName, cThreadId, frameStart + 0.02, 0.01 );
+			AddExpected( expected, "Present", cThreadId, frameStart + 0.06, 0.02 );
+			AddExpected( expected, "GPU Frame", 0, frameStart + 0.05, 0.02 );
+			AddExpected( expected, "Scene", 0, frameStart + 0.055, 0.01 );
+		}
+		else
+		{
+			// draining, only the GPU results of the last recorded frame are added
+			CHECK( !recorder.IsRecording() );
+		}
+	}
+	std::sort( expected.begin(), expected.end() );
+
+	// the frame before the capture, the latency too large and the frames after the
+	// capture are dropped
+	CHECK( expected.size() == recorder.GetNumEvents() );
+	CHECK( 0 == recorder.GetNumDroppedEvents() );
+
+	CHECK( WaitForCapture( recorder, clock ) );
+	std::vector<TraceEvent> events;
+	CHECK( ReadTrace( &events ) );
+	CHECK( AreBalanced( events ) );
+	CHECK( expected.size() == events.size() );
+	bool bMatch = expected.size() == events.size();
+	for( unsigned int i = 0; bMatch && i < events.size(); ++i )
+	{
+		bMatch &= expected[i].name == events[i].name && expected[i].tid == events[i].tid;
+		bMatch &= fabs( expected[i].ts - events[i].ts ) < 0.01 && fabs( expected[i].dur - events[i].dur ) < 0.01;
+	}
+	CHECK( bMatch );
+
+	// ready for another capture
+	CHECK( recorder.Start( cTraceFileNameW, 1 ) );
+	recorder.Stop();
+	CHECK( !recorder.IsCapturing() );
+}
+
+UNIT_TEST( TraceRecorderIdleAddsNothing )
+{
+	// when not capturing, scopes and events neither record nor read the clock
+	FakeTraceClock clock;
+	TraceRecorder recorder( &clock, 1024 );
+	TraceRecorder::SetActive( &recorder );
+	GPUProfileResult gpuResult = GPUResult( "GPU Frame", 0, 0.0f, 0.02f );
+	for( unsigned int frame = 0; frame < 100; ++frame )
+	{
+		recorder.BeginFrame( frame * 0.1 );
+		recorder.BeginScope( "Update" );
+		{
+			TRACE_CPU_SCOPE( "Nested" );
+		}
+		recorder.EndScope();
+		recorder.AddCPUEvent( "Present", frame * 0.1, frame * 0.1 + 0.01 );
+		recorder.AddGPUFrame( 1, frame * 0.1, &gpuResult, 1 );
+	}
+	TraceRecorder::SetActive( NULL );
+	CHECK( 0 == recorder.GetNumEvents() );
+	CHECK( 0 == clock.m_NumReads );
+	CHECK( NULL == TraceRecorder::GetActiveRecording() );
+}
+
+UNIT_TEST( TraceRecorderDropsEventsWhenFull )
+{
+	// a full buffer ends recording early and the trace written is still valid
+	FakeTraceClock clock;
+	TraceRecorder recorder( &clock, 10 );
+	CHECK( recorder.Start( cTraceFileNameW, 100 ) );
+	for( unsigned int frame = 0; frame < 10; ++frame )
+	{
+		clock.m_Time = 1.0 + 0.1 * frame;
+		recorder.BeginFrame( clock.m_Time );
+		recorder.BeginScope( "Update" );
+		recorder.BeginScope( "Inner" );
+		clock.m_Time += 0.01;
+		recorder.EndScope();
+		recorder.EndScope();
+	}
+	CHECK( 10 == recorder.GetNumEvents() );
+	CHECK( recorder.GetNumDroppedEvents() > 0 );
+
+	CHECK( WaitForCapture( recorder, clock ) );
+	std::vector<TraceEvent> events;
+	CHECK( ReadTrace( &events ) );
+	CHECK( 10 == events.size() );
+	CHECK( AreBalanced( events ) );
+}
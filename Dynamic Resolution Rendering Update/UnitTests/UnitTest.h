@@ -0,0 +1,55 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+//--------------------------------------------------------------------------------------
+// Minimal unit test support, with no D3D or DXUT dependencies. Tests register
+// themselves with UNIT_TEST, and UnitTests.cpp runs them all, or those whose name
+// contains the first command line argument.
+//
+//	UNIT_TEST( PIDConverges )
+//	{
+//		CHECK( ... );
+//		CHECK_CLOSE( scale, 0.5f, 0.01f );
+//	}
+//--------------------------------------------------------------------------------------
+
+#include <math.h>
+
+typedef void (*UnitTestFunc)();
+
+struct UnitTest
+{
+	UnitTest( const char* pName, UnitTestFunc pFunc );
+
+	const char*		m_pName;
+	UnitTestFunc	m_pFunc;
+	UnitTest*		m_pNext;
+};
+
+// Records a failed check in the running test
+void UnitTestFail( const char* pFile, int line, const char* pExpression );
+
+#define UNIT_TEST( name ) \
+	static void name(); \
+	static UnitTest name##Registration( #name, name ); \
+	static void name()
+
+#define CHECK( expression ) \
+	( ( expression ) ? (void)0 : UnitTestFail( __FILE__, __LINE__, #expression ) )
+
+#define CHECK_CLOSE( value, expected, tolerance ) \
+	CHECK( fabs( (double)( value ) - (double)( expected ) ) <= (double)( tolerance ) )
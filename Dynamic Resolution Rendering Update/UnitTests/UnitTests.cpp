@@ -0,0 +1,83 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+
+//--------------------------------------------------------------------------------------
+// Headless unit tests.
+//
+// Runs the tests linked with it: UnitTests_2015.vcxproj has the CPU only modules, which
+// build without DXUT or a D3D device, and MeshTests_2015.vcxproj the mesh code, which
+// links DXUT but loads without a device.
+// Usage: UnitTests [name filter]. Returns the number of failed tests.
+//--------------------------------------------------------------------------------------
+
+#include "UnitTest.h"
+
+#include <stdio.h>
+#include <string.h>
+
+namespace
+{
+	UnitTest*		s_pFirstTest	= NULL;
+	UnitTest*		s_pLastTest		= NULL;
+	unsigned int	s_NumFailures	= 0;	// failed checks in the running test
+}
+
+UnitTest::UnitTest( const char* pName, UnitTestFunc pFunc )
+	: m_pName( pName )
+	, m_pFunc( pFunc )
+	, m_pNext( NULL )
+{
+	// kept in registration order, so each file's tests run in the order written
+	if( s_pLastTest )
+	{
+		s_pLastTest->m_pNext = this;
+	}
+	else
+	{
+		s_pFirstTest = this;
+	}
+	s_pLastTest = this;
+}
+
+void UnitTestFail( const char* pFile, int line, const char* pExpression )
+{
+	printf( "  %s(%d): CHECK( %s ) failed\n", pFile, line, pExpression );
+	++s_NumFailures;
+}
+
+//--------------------------------------------------------------------------------------
+// Main function
+//--------------------------------------------------------------------------------------
+int main( int argc, char* argv[] )
+{
+	const char* pFilter = argc > 1 ? argv[1] : NULL;
+	int numFailedTests = 0;
+	unsigned int numTests = 0;
+	for( UnitTest* pTest = s_pFirstTest; pTest; pTest = pTest->m_pNext )
+	{
+		if( pFilter && !strstr( pTest->m_pName, pFilter ) )
+		{
+			continue;
+		}
+		s_NumFailures = 0;
+		pTest->m_pFunc();
+		printf( "%-48s %s\n", pTest->m_pName, s_NumFailures ? "FAILED" : "passed" );
+		numFailedTests += s_NumFailures ? 1 : 0;
+		++numTests;
+	}
+	printf( "\n%u tests, %d failed\n", numTests, numFailedTests );
+	return numFailedTests;
+}
@@ -0,0 +1,111 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#include "VelocityStats.h"
+
+#include <math.h>
+
+//--------------------------------------------------------------------------------------
+// Sample positions and texel lookup match the Load() based sampling in PSReduceVelocity
+//--------------------------------------------------------------------------------------
+void ReduceVelocity( const float* pVelocity, unsigned int width, unsigned int height,
+					 float ratioX, float ratioY, float pixelsX, float pixelsY,
+					 unsigned int reducedSize, float* pReduced )
+{
+	const unsigned int numSamples = VelocityReduceConsts::cSamplesPerAxis;
+	const float cellSizeX = ratioX / reducedSize;
+	const float cellSizeY = ratioY / reducedSize;
+	const float stepX = cellSizeX / numSamples;
+	const float stepY = cellSizeY / numSamples;
+
+	for( unsigned int cellY = 0; cellY < reducedSize; ++cellY )
+	{
+		for( unsigned int cellX = 0; cellX < reducedSize; ++cellX )
+		{
+			float sumAbsX = 0.0f;
+			float sumAbsY = 0.0f;
+			float sumSpeed = 0.0f;
+			float maxSpeed = 0.0f;
+			for( unsigned int sampleY = 0; sampleY < numSamples; ++sampleY )
+			{
+				for( unsigned int sampleX = 0; sampleX < numSamples; ++sampleX )
+				{
+					float u = cellX * cellSizeX + ( sampleX + 0.5f ) * stepX;
+					float v = cellY * cellSizeY + ( sampleY + 0.5f ) * stepY;
+					unsigned int texelX = (unsigned int)( u * width );
+					unsigned int texelY = (unsigned int)( v * height );
+					if( texelX >= width )
+					{
+						texelX = width - 1;
+					}
+					if( texelY >= height )
+					{
+						texelY = height - 1;
+					}
+
+					const float* pTexel = pVelocity + 2 * ( texelY * width + texelX );
+					float velocityX = pTexel[0] * pixelsX;
+					float velocityY = pTexel[1] * pixelsY;
+					float speed = sqrt( velocityX * velocityX + velocityY * velocityY );
+					sumAbsX += fabs( velocityX );
+					sumAbsY += fabs( velocityY );
+					sumSpeed += speed;
+					if( speed > maxSpeed )
+					{
+						maxSpeed = speed;
+					}
+				}
+			}
+
+			float* pOut = pReduced + 4 * ( cellY * reducedSize + cellX );
+			const float invNumSamples = 1.0f / ( numSamples * numSamples );
+			pOut[0] = sumAbsX * invNumSamples;
+			pOut[1] = sumAbsY * invNumSamples;
+			pOut[2] = sumSpeed * invNumSamples;
+			pOut[3] = maxSpeed;
+		}
+	}
+}
+
+//--------------------------------------------------------------------------------------
+// Every texel covers the same number of samples, so the mean of the texel means is the
+// mean over all samples.
+//--------------------------------------------------------------------------------------
+void CalculateVelocityStatistics( const float* pReduced, unsigned int numTexels, VelocityStatistics* pStats )
+{
+	pStats->meanAbsX = 0.0f;
+	pStats->meanAbsY = 0.0f;
+	pStats->meanSpeed = 0.0f;
+	pStats->maxSpeed = 0.0f;
+	if( !numTexels )
+	{
+		return;
+	}
+
+	for( unsigned int texel = 0; texel < numTexels; ++texel )
+	{
+		const float* pTexel = pReduced + 4 * texel;
+		pStats->meanAbsX += pTexel[0];
+		pStats->meanAbsY += pTexel[1];
+		pStats->meanSpeed += pTexel[2];
+		if( pTexel[3] > pStats->maxSpeed )
+		{
+			pStats->maxSpeed = pTexel[3];
+		}
+	}
+	pStats->meanAbsX /= numTexels;
+	pStats->meanAbsY /= numTexels;
+	pStats->meanSpeed /= numTexels;
+}
@@ -0,0 +1,56 @@
+/////////////////////////////////////////////////////////////////////////////////////////////
+// Copyright 2017 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or imlied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+/////////////////////////////////////////////////////////////////////////////////////////////
+#pragma once
+
+// Note: like ResolutionController.h this file has no D3D or DXUT dependencies.
+
+// Constants
+namespace VelocityReduceConsts
+{
+	const unsigned int cReducedSize		= 16;	// width and height of the reduced texture
+	const unsigned int cSamplesPerAxis	= 4;	// velocity samples per reduced texel on each axis, must match PSReduceVelocity
+};
+
+//--------------------------------------------------------------------------------------
+// Per frame screen space motion, in back buffer pixels per frame
+//--------------------------------------------------------------------------------------
+struct VelocityStatistics
+{
+	float	meanAbsX;	// mean of |motion.x|
+	float	meanAbsY;	// mean of |motion.y|
+	float	meanSpeed;	// mean of |motion|
+	float	maxSpeed;	// largest |motion| of the sampled pixels
+};
+
+//--------------------------------------------------------------------------------------
+// CPU reference of PSReduceVelocity in PostProcessDynamic.hlsl. Each reduced texel
+// takes a regular grid of cSamplesPerAxis^2 velocity samples over its share of the
+// dynamic viewport and outputs float4( mean |x|, mean |y|, mean speed, max speed ).
+//
+// pVelocity holds width * height float2 velocities as written to the velocity buffer,
+// ratioX/Y are the dynamic viewport size over the buffer size (GetRTScaleX/Y), and
+// pixelsX/Y convert velocity to back buffer pixels. pReduced receives reducedSize^2
+// float4 values.
+//--------------------------------------------------------------------------------------
+void ReduceVelocity( const float* pVelocity, unsigned int width, unsigned int height,
+					 float ratioX, float ratioY, float pixelsX, float pixelsY,
+					 unsigned int reducedSize, float* pReduced );
+
+//--------------------------------------------------------------------------------------
+// Final reduction of the numTexels float4 values output by PSReduceVelocity or
+// ReduceVelocity. Used for both the GPU readback and the CPU reference.
+//--------------------------------------------------------------------------------------
+void CalculateVelocityStatistics( const float* pReduced, unsigned int numTexels, VelocityStatistics* pStats );